@@ -225,11 +225,12 @@ def _manejar_reportes_admin(cliente):
     print("2. Reporte filtrado por usuario")
     print("3. Reporte filtrado por código de respuesta")
     print("4. Log CSV con filtros avanzados")
+    print("5. Exportar log a archivo (CSV/JSON/XML) en el servidor")
     
     tipo_reporte = _get_input_tipo(
-        "Seleccione tipo de reporte (1-4): ",
+        "Seleccione tipo de reporte (1-5): ",
         str,
-        ['1', '2', '3', '4']
+        ['1', '2', '3', '4', '5']
     )
     
     if tipo_reporte == '1':
@@ -254,6 +255,16 @@ def _manejar_reportes_admin(cliente):
         filtro_texto2 = input("Filtro de texto 2: ")
         
         cliente.reporte_log_csv(desde, hasta, filtro_usuario, filtro_codigo, filtro_texto1, filtro_texto2)
+    elif tipo_reporte == '5':
+        # Exportación del log filtrado
+        formato = _get_input_tipo("Formato (csv/json/xml): ", str, ['csv', 'json', 'xml'])
+        print("\nFiltros disponibles (deje en blanco para omitir):")
+        desde = input("Fecha desde (YYYY-MM-DD HH:MM:SS): ")
+        hasta = input("Fecha hasta (YYYY-MM-DD HH:MM:SS): ")
+        filtro_usuario = input("Usuario: ")
+        filtro_codigo = input("Código de respuesta: ")
+        
+        cliente.exportar_log(formato, desde, hasta, filtro_usuario, filtro_codigo)
 
 # --- Menú Principal ---
 
@@ -17,6 +17,9 @@ class ClienteRobotRPC:
         Inicializa el proxy del servidor.
         """
         self.url = f'http://{host}:{puerto}'
+        # Las suscripciones de larga espera van al servidor de eventos (puerto + 1)
+        self.url_eventos = f'http://{host}:{puerto + 1}'
+        self.servidor_eventos = None
         try:
             self.servidor = xmlrpc.client.ServerProxy(self.url)
             # Prueba una llamada simple para asegurar la conexión
@@ -159,7 +162,8 @@ class ClienteRobotRPC:
                 print(f"  Usuario: {resultado['usuario']}")
                 print(f"  Tiempo de conexión: {resultado['tiempoConexion'].strip()}")
                 print(f"  Estado del robot: {resultado['estadoRobot']}")
-                print(f"  Posición actual: {resultado['posicionActual']}")
+                fuente = resultado.get('fuentePosicion', '')
+                print(f"  Posición actual: {resultado['posicionActual']}" + (f" ({fuente})" if fuente else ""))
                 print(f"  Comandos ejecutados en sesión: {resultado['comandosEjecutados']}")
                 print(f"  Comandos erróneos en sesión: {resultado['comandosErroneos']}")
                 
@@ -295,16 +299,17 @@ class ClienteRobotRPC:
             print(f"✗ Error: {e}")
             return None
 
-    def ejecutar_archivo(self, nombre_archivo):
+    def ejecutar_archivo(self, nombre_archivo, desde_comando=1):
         """
-        Ejecuta un archivo G-Code previamente subido al servidor.
+        Inicia la ejecución de un archivo G-Code previamente subido al servidor.
+        La ejecución continúa en segundo plano; use control_ejecucion para seguirla.
         """
         if not self.esta_conectado():
             print("✗ Error: Debe iniciar sesión primero.")
             return False
             
         try:
-            resultado = self.servidor.EjecutarArchivo(self.session_id, nombre_archivo)
+            resultado = self.servidor.EjecutarArchivo(self.session_id, nombre_archivo, desde_comando)
             if resultado['exito']:
                 print(f"✓ {resultado['mensaje']}")
                 return True
@@ -315,6 +320,99 @@ class ClienteRobotRPC:
             print(f"✗ Error ejecutando archivo: {e}")
             return False
 
+    def control_ejecucion(self, accion):
+        """
+        Controla la ejecución en curso: 'pausar', 'reanudar', 'detener', 'paso' o 'estado'.
+        """
+        if not self.esta_conectado():
+            print("✗ Error: Debe iniciar sesión primero.")
+            return None
+            
+        try:
+            resultado = self.servidor.ControlEjecucion(self.session_id, accion)
+            simbolo = "✓" if resultado['exito'] else "✗"
+            print(f"{simbolo} {resultado['mensaje']}")
+            if 'estado' in resultado:
+                print(f"  Estado: {resultado['estado']} | Comando "
+                      f"{resultado['comandoActual']}/{resultado['totalComandos']}")
+            return resultado
+        except Exception as e:
+            print(f"✗ Error controlando ejecución: {e}")
+            return None
+
+    def suscribir_estado(self, ultima_version=0, timeout_ms=30000):
+        """
+        Espera hasta timeout_ms a que cambie el estado del robot (conexión, posición,
+        actividad o ejecución) y devuelve (version, cambios). 'cambios' contiene sólo
+        los campos modificados después de ultima_version; con 0 se recibe el estado completo.
+        """
+        if not self.esta_conectado():
+            print("✗ Error: Debe iniciar sesión primero.")
+            return ultima_version, {}
+
+        try:
+            if self.servidor_eventos is None:
+                self.servidor_eventos = xmlrpc.client.ServerProxy(self.url_eventos)
+            resultado = self.servidor_eventos.SuscribirEstado(self.session_id, ultima_version, timeout_ms)
+            if not resultado['exito']:
+                print(f"✗ {resultado['mensaje']}")
+                return ultima_version, {}
+            return resultado['version'], resultado.get('cambios', {})
+        except Exception as e:
+            print(f"✗ Error en suscripción de estado: {e}")
+            self.servidor_eventos = None
+            return ultima_version, {}
+
+    def parada_emergencia(self):
+        """
+        Detiene la ejecución, descarta los comandos en cola y desactiva efector y motores.
+        """
+        if not self.esta_conectado():
+            print("✗ Error: Debe iniciar sesión primero.")
+            return False
+
+        # Por el servidor de eventos (un hilo por conexión): el principal puede estar
+        # ocupado con otra petición, p. ej. un G28 manual
+        try:
+            if self.servidor_eventos is None:
+                self.servidor_eventos = xmlrpc.client.ServerProxy(self.url_eventos)
+            resultado = self.servidor_eventos.ParadaEmergencia(self.session_id)
+        except Exception:
+            self.servidor_eventos = None
+            try:
+                resultado = self.servidor.ParadaEmergencia(self.session_id)
+            except Exception as e:
+                print(f"✗ Error en parada de emergencia: {e}")
+                return False
+        simbolo = "✓" if resultado['exito'] else "✗"
+        print(f"{simbolo} {resultado['mensaje']}")
+        return resultado['exito']
+
+    def simular_archivo(self, nombre_archivo):
+        """
+        Estima duración, recorrido y alcance de un archivo G-Code sin mover el robot.
+        """
+        if not self.esta_conectado():
+            print("✗ Error: Debe iniciar sesión primero.")
+            return None
+            
+        try:
+            resultado = self.servidor.SimularArchivo(self.session_id, nombre_archivo)
+            if resultado['exito']:
+                print(f"✓ {resultado['mensaje']}")
+                print(f"  Duración estimada: {resultado['duracionSegundos']:.1f} s "
+                      f"(movimiento {resultado['tiempoMovimientoSegundos']:.1f} s, "
+                      f"latencias {resultado['tiempoLatenciaSegundos']:.1f} s)")
+                print(f"  Recorrido: {resultado['longitudRecorridoMm']:.1f} mm | "
+                      f"Alcance máximo: {resultado['alcanceMaximoMm']:.1f} mm")
+                return resultado
+            else:
+                print(f"✗ {resultado['mensaje']}")
+                return None
+        except Exception as e:
+            print(f"✗ Error simulando archivo: {e}")
+            return None
+
     def configurar_acceso_remoto(self, habilitar):
         """
         (Admin) Habilita o deshabilita el acceso remoto de otros usuarios.
@@ -413,103 +511,138 @@ class ClienteRobotRPC:
             print(f"✗ Error: {e}")
             return False
 
+    def _paginas_log(self, metodo, parametros, limite=500):
+        """
+        Recorre un reporte paginado del log: pide páginas pasando el cursor de
+        la anterior hasta que el servidor indica que no hay más, y entrega cada
+        respuesta apenas llega.
+        """
+        cursor = ''
+        while True:
+            resultado = metodo(self.session_id, *parametros, cursor, limite)
+            yield resultado
+            if not resultado['exito'] or not resultado.get('hayMas', False):
+                return
+            cursor = resultado['cursor']
+
     def reporte_admin(self, filtro1='', filtro2=''):
         """
         (Admin) Obtiene el reporte administrativo completo.
+        - filtro1: usuario; filtro2: código de respuesta
         """
         if not self.esta_conectado():
             print("✗ Error: Debe iniciar sesión primero.")
             return False
             
         try:
-            resultado = self.servidor.ReporteAdmin(self.session_id, filtro1, filtro2)
-            if resultado['exito']:
-                print(f"\n=== REPORTE ADMINISTRATIVO ===")
-                print(f"  Sesiones activas: {resultado['totalSesiones']}")
-                if 'sesiones' in resultado:
-                    for i in range(len(resultado['sesiones'])):
-                        sesion = resultado['sesiones'][i]
-                        print(f"  Sesión {i+1}: {sesion['usuario']}@{sesion['nodo']} (Cmds: {sesion['comandos']}, Errs: {sesion['errores']})")
-                
-                # Mostrar filtros aplicados
-                if filtro1 or filtro2:
-                    print(f"\n  Filtros aplicados: Usuario='{filtro1}', Código='{filtro2}'")
-                
-                # Mostrar reportes específicos si se aplicaron filtros
-                if 'reportePorUsuario' in resultado:
-                    print(f"\n--- LOG FILTRADO POR USUARIO '{filtro1}' ---")
-                    print(resultado['reportePorUsuario'])
-                
-                if 'reportePorCodigo' in resultado:
-                    print(f"\n--- LOG FILTRADO POR CÓDIGO '{filtro2}' ---")
-                    print(resultado['reportePorCodigo'])
-                
-                # Mostrar reporte completo si no hay filtros específicos
-                if not filtro1 and not filtro2 and 'reporteAdmin' in resultado:
-                    print(f"\n--- LOG COMPLETO DEL SERVIDOR ---")
-                    lineas = resultado['reporteAdmin'].split('\n')
-                    # Mostrar solo las últimas 10 líneas para no saturar la consola
-                    print("(Mostrando últimas 10 entradas)")
-                    for linea in lineas[-10:]:
-                        if linea.strip():
-                            print(linea)
-                
-                return True
+            # Sin filtros sólo se muestran las últimas 10 líneas: el servidor las lee
+            # desde el final del log en una sola petición
+            if filtro1 or filtro2:
+                respuestas = self._paginas_log(self.servidor.ReporteAdmin, (filtro1, filtro2))
             else:
-                print(f"✗ {resultado['mensaje']}")
-                return False
+                respuestas = [self.servidor.ReporteAdmin(self.session_id, '', '', '', 10, 10)]
+            primera = True
+            for resultado in respuestas:
+                if not resultado['exito']:
+                    print(f"✗ {resultado['mensaje']}")
+                    return False
+                if primera:
+                    primera = False
+                    print(f"\n=== REPORTE ADMINISTRATIVO ===")
+                    print(f"  Sesiones activas: {resultado['totalSesiones']}")
+                    if 'sesiones' in resultado:
+                        for i in range(len(resultado['sesiones'])):
+                            sesion = resultado['sesiones'][i]
+                            print(f"  Sesión {i+1}: {sesion['usuario']}@{sesion['nodo']} (Cmds: {sesion['comandos']}, Errs: {sesion['errores']})")
+                    
+                    # Mostrar filtros aplicados
+                    if filtro1 or filtro2:
+                        print(f"\n  Filtros aplicados: Usuario='{filtro1}', Código='{filtro2}'")
+                        print(f"\n--- LOG FILTRADO ---")
+                    else:
+                        print(f"\n--- LOG COMPLETO DEL SERVIDOR ---")
+                        # Mostrar solo las últimas 10 líneas para no saturar la consola
+                        print("(Mostrando últimas 10 entradas)")
+                
+                # Cada página se muestra apenas llega
+                for linea in resultado.get('reporteAdmin', '').split('\n'):
+                    if linea.strip():
+                        print(linea)
+            
+            return True
         except Exception as e:
             print(f"✗ Error: {e}")
             return False
 
-    def reporte_log_csv(self, desde='', hasta='', filtro_usuario='', filtro_codigo=''):
+    def reporte_log_csv(self, desde='', hasta='', filtro_usuario='', filtro_codigo='',
+                        filtro_texto1='', filtro_texto2=''):
         """
         (Admin) Obtiene el log CSV filtrado por múltiples criterios.
         - desde/hasta: fechas en formato YYYY-MM-DD HH:MM:SS
         - filtro_usuario: filtrar por nombre de usuario
         - filtro_codigo: filtrar por código de respuesta
+        - filtro_texto1/filtro_texto2: texto que debe aparecer en la línea
         """
         if not self.esta_conectado():
             print("✗ Error: Debe iniciar sesión primero.")
             return False
         
         try:
-            resultado = self.servidor.ReporteLogCsv(self.session_id, desde, hasta, filtro_usuario, filtro_codigo)
-            if resultado['exito']:
-                print(f"\n=== REPORTE LOG CSV FILTRADO ===")
-                
-                # Mostrar filtros aplicados
-                filtros = resultado['filtros']
-                print(f"Período: {filtros['desde']} a {filtros['hasta']}")
-                if filtros['usuario']:
-                    print(f"Usuario: {filtros['usuario']}")
-                if filtros['codigo']:
-                    print(f"Código: {filtros['codigo']}")
-                if 'texto1' in filtros and filtros['texto1']:
-                    print(f"Filtro texto 1: {filtros['texto1']}")
-                if 'texto2' in filtros and filtros['texto2']:
-                    print(f"Filtro texto 2: {filtros['texto2']}")
-                
-                # Mostrar el log CSV
-                if 'logCsv' in resultado and resultado['logCsv']:
+            parametros = (desde, hasta, filtro_usuario, filtro_codigo, filtro_texto1, filtro_texto2)
+            total = 0
+            primera = True
+            for resultado in self._paginas_log(self.servidor.ReporteLogCsv, parametros):
+                if not resultado['exito']:
+                    print(f"✗ {resultado['mensaje']}")
+                    return False
+                if primera:
+                    primera = False
+                    print(f"\n=== REPORTE LOG CSV FILTRADO ===")
+                    
+                    # Mostrar filtros aplicados
+                    filtros = resultado['filtros']
+                    print(f"Período: {filtros['desde']} a {filtros['hasta']}")
+                    if filtros['usuario']:
+                        print(f"Usuario: {filtros['usuario']}")
+                    if filtros['codigo']:
+                        print(f"Código: {filtros['codigo']}")
+                    if 'texto1' in filtros and filtros['texto1']:
+                        print(f"Filtro texto 1: {filtros['texto1']}")
+                    if 'texto2' in filtros and filtros['texto2']:
+                        print(f"Filtro texto 2: {filtros['texto2']}")
                     print(f"\n--- LOG CSV ---")
-                    lineas = resultado['logCsv'].split('\n')
-                    for linea in lineas:
-                        if linea.strip():
-                            print(linea)
-                else:
-                    print("No se encontraron registros con los criterios especificados.")
-                
-                # Mostrar resultados de filtro de texto si están presentes
-                if 'lineasFiltradas' in resultado:
-                    print(f"\n--- FILTRADO POR TEXTO ---")
-                    for i in range(len(resultado['lineasFiltradas'])):
-                        print(resultado['lineasFiltradas'][i])
                 
+                # Mostrar cada página del log CSV apenas llega
+                for linea in resultado.get('logCsv', '').split('\n'):
+                    if linea.strip():
+                        print(linea)
+                        total += 1
+            
+            if total == 0:
+                print("No se encontraron registros con los criterios especificados.")
+            return True
+        except Exception as e:
+            print(f"✗ Error: {e}")
+            return False
+
+    def exportar_log(self, formato='csv', desde='', hasta='', filtro_usuario='', filtro_codigo=''):
+        """
+        (Admin) Exporta el log filtrado a un archivo CSV, JSON o XML en el servidor.
+        - formato: 'csv', 'json' o 'xml'
+        El archivo queda en el servidor (carpeta exportaciones/); se informa su ruta.
+        """
+        if not self.esta_conectado():
+            print("✗ Error: Debe iniciar sesión primero.")
+            return False
+        
+        try:
+            resultado = self.servidor.ExportarLog(self.session_id, formato, desde, hasta,
+                                                  filtro_usuario, filtro_codigo)
+            if resultado['exito']:
+                print(f"✓ {resultado['mensaje']}: {resultado['archivo']} ({resultado['filas']} filas)")
                 return True
-            else:
-                print(f"✗ {resultado['mensaje']}")
-                return False
+            print(f"✗ {resultado['mensaje']}")
+            return False
         except Exception as e:
             print(f"✗ Error: {e}")
             return False
@@ -0,0 +1,224 @@
+#include "AlmacenGCode.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// SHA-256 (FIPS 180-4)
+const std::uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+inline std::uint32_t rotar(std::uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+void procesarBloque(std::uint32_t h[8], const unsigned char* b) {
+    std::uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (std::uint32_t(b[4 * i]) << 24) | (std::uint32_t(b[4 * i + 1]) << 16) |
+               (std::uint32_t(b[4 * i + 2]) << 8) | std::uint32_t(b[4 * i + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        std::uint32_t s0 = rotar(w[i - 15], 7) ^ rotar(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        std::uint32_t s1 = rotar(w[i - 2], 17) ^ rotar(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    std::uint32_t a = h[0], bb = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+    for (int i = 0; i < 64; ++i) {
+        std::uint32_t t1 = hh + (rotar(e, 6) ^ rotar(e, 11) ^ rotar(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+        std::uint32_t t2 = (rotar(a, 2) ^ rotar(a, 13) ^ rotar(a, 22)) + ((a & bb) ^ (a & c) ^ (bb & c));
+        hh = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = bb;
+        bb = a;
+        a = t1 + t2;
+    }
+    h[0] += a; h[1] += bb; h[2] += c; h[3] += d;
+    h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+}
+
+std::int64_t fechaDe(const struct stat& st) {
+    return static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+bool esHash(const std::string& s) {
+    if (s.size() != 64) return false;
+    for (char c : s) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::string AlmacenGCode::sha256(const std::string& datos) {
+    std::uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                          0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(datos.data());
+    std::size_t n = datos.size();
+    std::size_t completos = n / 64;
+    for (std::size_t i = 0; i < completos; ++i) procesarBloque(h, p + 64 * i);
+
+    // Relleno: 0x80, ceros y el largo en bits (big endian) en los últimos 8 bytes
+    unsigned char cola[128] = {0};
+    std::size_t resto = n - 64 * completos;
+    std::memcpy(cola, p + 64 * completos, resto);
+    cola[resto] = 0x80;
+    std::size_t largoCola = (resto < 56) ? 64 : 128;
+    std::uint64_t bits = static_cast<std::uint64_t>(n) * 8;
+    for (int i = 0; i < 8; ++i) cola[largoCola - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+    procesarBloque(h, cola);
+    if (largoCola == 128) procesarBloque(h, cola + 64);
+
+    char hex[65];
+    for (int i = 0; i < 8; ++i) std::snprintf(hex + 8 * i, 9, "%08x", h[i]);
+    return std::string(hex, 64);
+}
+
+AlmacenGCode::AlmacenGCode(const std::string& directorio) : directorio_(directorio) {
+    std::error_code ec;
+    fs::create_directories(directorio_, ec);
+    if (ec) {
+        std::cerr << "Error: no se pudo crear el almacén " << directorio_ << ": " << ec.message() << std::endl;
+    }
+    escanear();
+    recolectarLocked(); // lo que quedó huérfano mientras el servidor no corría
+}
+
+void AlmacenGCode::escanear() {
+    porInodo_.clear();
+    DIR* dir = opendir(directorio_.c_str());
+    if (!dir) return;
+    while (struct dirent* entrada = readdir(dir)) {
+        std::string nombre = entrada->d_name;
+        if (nombre.size() != 64 + 6 || nombre.compare(64, 6, ".gcode") != 0 || !esHash(nombre.substr(0, 64))) continue;
+        struct stat st;
+        if (stat(rutaObjeto(nombre.substr(0, 64)).c_str(), &st) == 0) {
+            porInodo_[{static_cast<std::uint64_t>(st.st_dev), static_cast<std::uint64_t>(st.st_ino)}] = nombre.substr(0, 64);
+        }
+    }
+    closedir(dir);
+}
+
+std::string AlmacenGCode::rutaObjeto(const std::string& hash) const {
+    return directorio_ + "/" + hash + ".gcode";
+}
+
+bool AlmacenGCode::enlazar(const std::string& objeto, const std::string& nombre, bool& copiado) const {
+    // El nombre anterior se reemplaza entero: escribir sobre él alteraría el
+    // objeto compartido. Se enlaza con un nombre temporal y se renombra, así
+    // nunca queda el nombre sin archivo.
+    std::string temporal = nombre + ".tmp";
+    std::remove(temporal.c_str());
+    copiado = link(objeto.c_str(), temporal.c_str()) != 0;
+    if (copiado) {
+        // Otro sistema de archivos u otro impedimento: se guarda una copia
+        std::error_code ec;
+        fs::copy_file(objeto, temporal, fs::copy_options::overwrite_existing, ec);
+        if (ec) {
+            std::cerr << "Error: no se pudo enlazar " << nombre << ": " << ec.message() << std::endl;
+            return false;
+        }
+    }
+    if (std::rename(temporal.c_str(), nombre.c_str()) != 0) {
+        std::cerr << "Error: no se pudo reemplazar " << nombre << ": " << std::strerror(errno) << std::endl;
+        std::remove(temporal.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string AlmacenGCode::guardar(const std::string& contenido, const std::string& nombre, bool& nuevo) {
+    std::string hash = sha256(contenido);
+    std::string objeto = rutaObjeto(hash);
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    struct stat st;
+    nuevo = stat(objeto.c_str(), &st) != 0;
+    if (nuevo) {
+        // Se escribe aparte y se publica con rename: nunca hay un objeto a medias
+        std::string temporal = objeto + ".tmp";
+        {
+            std::ofstream archivo(temporal, std::ios::binary | std::ios::trunc);
+            archivo.write(contenido.data(), static_cast<std::streamsize>(contenido.size()));
+            if (!archivo.flush()) {
+                std::cerr << "Error: no se pudo escribir " << temporal << std::endl;
+                std::remove(temporal.c_str());
+                return "";
+            }
+        }
+        chmod(temporal.c_str(), 0444);
+        if (std::rename(temporal.c_str(), objeto.c_str()) != 0 || stat(objeto.c_str(), &st) != 0) {
+            std::cerr << "Error: no se pudo guardar " << objeto << std::endl;
+            std::remove(temporal.c_str());
+            return "";
+        }
+        porInodo_[{static_cast<std::uint64_t>(st.st_dev), static_cast<std::uint64_t>(st.st_ino)}] = hash;
+    }
+    bool copiado = false;
+    if (!enlazar(objeto, nombre, copiado)) return "";
+    copias_.erase(nombre);
+    if (copiado && stat(nombre.c_str(), &st) == 0) {
+        copias_[nombre] = Copia{hash, fechaDe(st), static_cast<std::uint64_t>(st.st_size)};
+    }
+    // El nombre pudo apuntar a otro contenido que ahora queda sin enlaces
+    recolectarLocked();
+    return hash;
+}
+
+std::size_t AlmacenGCode::recolectar() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return recolectarLocked();
+}
+
+std::size_t AlmacenGCode::recolectarLocked() {
+    // Contenidos que siguen copiados tal cual bajo algún nombre
+    std::set<std::string> copiados;
+    for (auto it = copias_.begin(); it != copias_.end();) {
+        struct stat st;
+        if (stat(it->first.c_str(), &st) != 0 || fechaDe(st) != it->second.fecha ||
+            static_cast<std::uint64_t>(st.st_size) != it->second.bytes) {
+            it = copias_.erase(it); // borrada o modificada
+            continue;
+        }
+        copiados.insert(it->second.hash);
+        ++it;
+    }
+
+    std::size_t borrados = 0;
+    for (auto it = porInodo_.begin(); it != porInodo_.end();) {
+        std::string objeto = rutaObjeto(it->second);
+        struct stat st;
+        if (stat(objeto.c_str(), &st) != 0) {
+            it = porInodo_.erase(it); // lo borró otro
+            continue;
+        }
+        if (st.st_nlink <= 1 && !copiados.count(it->second) && std::remove(objeto.c_str()) == 0) {
+            it = porInodo_.erase(it);
+            ++borrados;
+            continue;
+        }
+        ++it;
+    }
+    return borrados;
+}
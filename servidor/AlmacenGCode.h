@@ -0,0 +1,54 @@
+#ifndef ALMACENGCODE_H
+#define ALMACENGCODE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+// Almacén de programas G-Code direccionado por contenido: cada contenido
+// distinto se guarda una sola vez como <directorio>/<sha256>.gcode (de sólo
+// lectura) y los nombres de usuario (<nombre>_<usuario>.gcode) son enlaces
+// duros a ese objeto. Así el resto del servidor sigue abriendo los archivos
+// por nombre, y dos subidas iguales comparten disco y hash.
+class AlmacenGCode {
+private:
+    std::string directorio_;
+    std::map<std::pair<std::uint64_t, std::uint64_t>, std::string> porInodo_; // (dispositivo, inodo) -> hash
+
+    // Nombres que no se pudieron enlazar y quedaron como copia: mientras la copia
+    // siga igual (fecha y tamaño) su objeto cuenta como usado
+    struct Copia {
+        std::string hash;
+        std::int64_t fecha;
+        std::uint64_t bytes;
+    };
+    std::map<std::string, Copia> copias_;
+    std::mutex mtx_;
+
+    void escanear();
+    std::size_t recolectarLocked();
+    std::string rutaObjeto(const std::string& hash) const;
+    bool enlazar(const std::string& objeto, const std::string& nombre, bool& copiado) const;
+
+public:
+    explicit AlmacenGCode(const std::string& directorio = "gcode_almacen");
+
+    AlmacenGCode(const AlmacenGCode&) = delete;
+    AlmacenGCode& operator=(const AlmacenGCode&) = delete;
+
+    // Guarda el contenido (si no estaba) y deja 'nombre' apuntando a él.
+    // Devuelve el hash, o "" si falló; 'nuevo' indica si el contenido no estaba.
+    std::string guardar(const std::string& contenido, const std::string& nombre, bool& nuevo);
+
+    // Borra los objetos que ya no tienen ningún nombre enlazado (sólo les queda
+    // el enlace del almacén) ni copia vigente; devuelve cuántos borró. Se llama en
+    // cada guardar. Las copias no se recuerdan entre reinicios.
+    std::size_t recolectar();
+
+    static std::string sha256(const std::string& datos);
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "ArchivoMapeado.h"
+#include <algorithm>
+#include <iostream>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+ArchivoMapeado::ArchivoMapeado() : datos_(nullptr), tamano_(0), abierto_(false) {
+}
+
+ArchivoMapeado::ArchivoMapeado(const std::string &ruta) : ArchivoMapeado() {
+    abrir(ruta);
+}
+
+ArchivoMapeado::~ArchivoMapeado() {
+    cerrar();
+}
+
+bool ArchivoMapeado::abrir(const std::string &ruta) {
+    cerrar();
+#ifdef _WIN32
+    std::ifstream f(ruta, std::ios::binary | std::ios::ate);
+    if (!f) return false;
+    copia_.resize(static_cast<std::size_t>(f.tellg()));
+    f.seekg(0);
+    if (!f.read(&copia_[0], static_cast<std::streamsize>(copia_.size()))) return false;
+    datos_ = copia_.data();
+    tamano_ = copia_.size();
+#else
+    int fd = ::open(ruta.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    tamano_ = static_cast<std::size_t>(st.st_size);
+    // Un archivo vacío no se puede mapear: queda abierto con la vista vacía
+    if (tamano_ > 0) {
+        void *p = ::mmap(nullptr, tamano_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            std::cerr << "Error: no se pudo mapear " << ruta << std::endl;
+            ::close(fd);
+            tamano_ = 0;
+            return false;
+        }
+        ::madvise(p, tamano_, MADV_SEQUENTIAL);
+        datos_ = static_cast<const char *>(p);
+    }
+    ::close(fd); // el mapeo sigue valiendo sin el descriptor
+#endif
+    abierto_ = true;
+    return true;
+}
+
+void ArchivoMapeado::cerrar() {
+#ifdef _WIN32
+    copia_.clear();
+    copia_.shrink_to_fit();
+#else
+    if (datos_) ::munmap(const_cast<char *>(datos_), tamano_);
+#endif
+    datos_ = nullptr;
+    tamano_ = 0;
+    abierto_ = false;
+}
+
+void ArchivoMapeado::liberarHasta(std::size_t offset) {
+#ifdef _WIN32
+    (void)offset;
+#else
+    static const std::size_t pagina = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::size_t bytes = std::min(offset, tamano_) / pagina * pagina;
+    if (datos_ && bytes > 0) ::madvise(const_cast<char *>(datos_), bytes, MADV_DONTNEED);
+#endif
+}
@@ -0,0 +1,42 @@
+#ifndef ARCHIVOMAPEADO_H
+#define ARCHIVOMAPEADO_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Archivo de sólo lectura mapeado en memoria: contenido() es una vista de todo
+// el archivo sin copiarlo, válida mientras el objeto siga abierto. Si el archivo
+// se trunca mientras está mapeado, leer la parte que ya no existe es un error;
+// por eso GestorArchivos nunca reescribe un archivo en su lugar (escribe un
+// temporal y lo renombra) y el mapeo sigue viendo el contenido anterior.
+class ArchivoMapeado {
+private:
+    const char *datos_;
+    std::size_t tamano_;
+    bool abierto_;
+#ifdef _WIN32
+    std::string copia_; // sin mmap, el archivo se lee una sola vez
+#endif
+
+public:
+    ArchivoMapeado();
+    explicit ArchivoMapeado(const std::string &ruta);
+    ~ArchivoMapeado();
+
+    ArchivoMapeado(const ArchivoMapeado &) = delete;
+    ArchivoMapeado &operator=(const ArchivoMapeado &) = delete;
+
+    bool abrir(const std::string &ruta);
+    void cerrar();
+    bool abierto() const { return abierto_; }
+
+    std::string_view contenido() const { return std::string_view(datos_, tamano_); }
+
+    // Avisa que ya no se va a leer antes de 'offset': las páginas se devuelven
+    // al sistema (y se vuelven a leer del disco si se las vuelve a tocar). Así un
+    // recorrido secuencial de un archivo enorme no acumula memoria residente.
+    void liberarHasta(std::size_t offset);
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef BUFFERCIRCULAR_H
+#define BUFFERCIRCULAR_H
+
+#include <vector>
+#include <cstddef>
+
+// Buffer de capacidad fija: al llenarse, cada inserción pisa el elemento más
+// antiguo. La memoria se reserva una sola vez y no crece con el uso.
+template <typename T>
+class BufferCircular {
+private:
+    std::vector<T> datos_;
+    std::size_t inicio_;   // posición del elemento más antiguo
+    std::size_t tamano_;
+
+public:
+    explicit BufferCircular(std::size_t capacidad = 0)
+        : datos_(capacidad), inicio_(0), tamano_(0) {}
+
+    std::size_t capacidad() const { return datos_.size(); }
+    std::size_t tamano() const { return tamano_; }
+    bool vacio() const { return tamano_ == 0; }
+    bool lleno() const { return tamano_ == datos_.size(); }
+
+    // Devuelve true si se descartó el elemento más antiguo para hacer lugar
+    bool agregar(T valor) {
+        if (datos_.empty()) return true;
+        if (tamano_ < datos_.size()) {
+            datos_[(inicio_ + tamano_) % datos_.size()] = std::move(valor);
+            ++tamano_;
+            return false;
+        }
+        datos_[inicio_] = std::move(valor);
+        inicio_ = (inicio_ + 1) % datos_.size();
+        return true;
+    }
+
+    // i = 0 es el más antiguo
+    const T& operator[](std::size_t i) const {
+        return datos_[(inicio_ + i) % datos_.size()];
+    }
+
+    void limpiar() {
+        inicio_ = 0;
+        tamano_ = 0;
+    }
+
+    // Recorre del más antiguo al más reciente
+    template <typename F>
+    void paraCada(F f) const {
+        for (std::size_t i = 0; i < tamano_; ++i) {
+            f((*this)[i]);
+        }
+    }
+};
+
+#endif
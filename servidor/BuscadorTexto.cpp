@@ -0,0 +1,84 @@
+#include "BuscadorTexto.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+inline unsigned char minuscula(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c | 0x20) : c;
+}
+
+inline bool esLetra(unsigned char c) {
+    return (c >= 'a' && c <= 'z');
+}
+
+// texto[0, n) coincide con el patrón (ya en minúsculas)
+inline bool igualSinMayusculas(const char *texto, const char *patron, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if (minuscula(static_cast<unsigned char>(texto[i])) != static_cast<unsigned char>(patron[i])) return false;
+    }
+    return true;
+}
+
+std::size_t buscarEscalar(const char *texto, std::size_t n, std::size_t desde, const std::string &patron) {
+    const std::size_t k = patron.size();
+    const unsigned char primero = static_cast<unsigned char>(patron[0]);
+    for (std::size_t i = desde; i + k <= n; ++i) {
+        if (minuscula(static_cast<unsigned char>(texto[i])) == primero &&
+            igualSinMayusculas(texto + i + 1, patron.data() + 1, k - 1)) {
+            return i;
+        }
+    }
+    return PatronBusqueda::NO_ENCONTRADO;
+}
+
+} // namespace
+
+PatronBusqueda::PatronBusqueda(const std::string &patron) : patron_(patron) {
+    std::transform(patron_.begin(), patron_.end(), patron_.begin(),
+                   [](char c) { return static_cast<char>(minuscula(static_cast<unsigned char>(c))); });
+}
+
+std::size_t PatronBusqueda::buscar(const char *texto, std::size_t n, std::size_t desde) const {
+    const std::size_t k = patron_.size();
+    if (k == 0) return desde <= n ? desde : NO_ENCONTRADO;
+    if (desde >= n || n - desde < k) return NO_ENCONTRADO;
+
+    std::size_t i = desde;
+#if defined(__SSE2__)
+    // Para las letras, OR 0x20 lleva mayúscula y minúscula al mismo valor; el
+    // resto de los caracteres se compara tal cual
+    const unsigned char primero = static_cast<unsigned char>(patron_[0]);
+    const unsigned char ultimo = static_cast<unsigned char>(patron_[k - 1]);
+    const __m128i vPrimero = _mm_set1_epi8(static_cast<char>(primero));
+    const __m128i vUltimo = _mm_set1_epi8(static_cast<char>(ultimo));
+    const __m128i mPrimero = _mm_set1_epi8(esLetra(primero) ? 0x20 : 0);
+    const __m128i mUltimo = _mm_set1_epi8(esLetra(ultimo) ? 0x20 : 0);
+
+    for (; i + k - 1 + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(texto + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(texto + i + k - 1));
+        __m128i ea = _mm_cmpeq_epi8(_mm_or_si128(a, mPrimero), vPrimero);
+        __m128i eb = _mm_cmpeq_epi8(_mm_or_si128(b, mUltimo), vUltimo);
+        unsigned mascara = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(ea, eb)));
+        while (mascara) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mascara));
+            // Primero y último ya coinciden (la máscara sólo se aplica a letras); falta el medio
+            if (igualSinMayusculas(texto + i + bit, patron_.data(), k)) return i + bit;
+            mascara &= mascara - 1;
+        }
+    }
+#endif
+    return buscarEscalar(texto, n, i, patron_);
+}
+
+FiltroLineas::FiltroLineas(const std::vector<std::string> &patrones) : guia_(0) {
+    for (const std::string &p : patrones) {
+        if (p.empty()) continue;
+        patrones_.emplace_back(p);
+        if (patrones_.back().tamano() > patrones_[guia_].tamano()) guia_ = patrones_.size() - 1;
+    }
+}
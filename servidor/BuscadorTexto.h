@@ -0,0 +1,78 @@
+#ifndef BUSCADORTEXTO_H
+#define BUSCADORTEXTO_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Búsqueda de una subcadena sin distinguir mayúsculas (ASCII). Con SSE2 se
+// comparan 16 posiciones por vez contra el primer y el último carácter del
+// patrón, y sólo las candidatas se verifican completas; sin SSE2 se recorre
+// byte a byte. No reserva memoria al buscar.
+class PatronBusqueda {
+private:
+    std::string patron_; // en minúsculas
+
+public:
+    static const std::size_t NO_ENCONTRADO = static_cast<std::size_t>(-1);
+
+    explicit PatronBusqueda(const std::string &patron);
+
+    const std::string &patron() const { return patron_; }
+    std::size_t tamano() const { return patron_.size(); }
+
+    // Posición de la primera aparición en texto[desde, n), o NO_ENCONTRADO
+    std::size_t buscar(const char *texto, std::size_t n, std::size_t desde = 0) const;
+
+    bool contenidoEn(const char *texto, std::size_t n) const { return buscar(texto, n) != NO_ENCONTRADO; }
+    bool contenidoEn(const std::string &texto) const { return contenidoEn(texto.data(), texto.size()); }
+};
+
+// Varios patrones que deben aparecer todos en la misma línea. Recorre un bloque
+// de texto buscando sólo el patrón más largo (el que menos candidatos da) y
+// revisa los demás únicamente en las líneas donde apareció.
+class FiltroLineas {
+private:
+    std::vector<PatronBusqueda> patrones_;
+    std::size_t guia_;
+
+public:
+    explicit FiltroLineas(const std::vector<std::string> &patrones);
+
+    bool vacio() const { return patrones_.empty(); }
+
+    // Llama a porLinea(inicio, largo) por cada línea de texto[0, n) que contiene
+    // todos los patrones, sin el '\n'. Sin patrones, pasan todas las líneas.
+    // Si porLinea devuelve false se deja de recorrer y recorrer devuelve false.
+    template <typename F>
+    bool recorrer(const char *texto, std::size_t n, F porLinea) const;
+};
+
+template <typename F>
+bool FiltroLineas::recorrer(const char *texto, std::size_t n, F porLinea) const {
+    std::size_t pos = 0;
+    while (pos < n) {
+        std::size_t inicio, fin;
+        if (patrones_.empty()) {
+            inicio = pos;
+        } else {
+            std::size_t hallado = patrones_[guia_].buscar(texto, n, pos);
+            if (hallado == PatronBusqueda::NO_ENCONTRADO) return true;
+            inicio = hallado;
+            while (inicio > pos && texto[inicio - 1] != '\n') --inicio;
+        }
+        const void *nl = std::memchr(texto + inicio, '\n', n - inicio);
+        fin = nl ? static_cast<std::size_t>(static_cast<const char *>(nl) - texto) : n;
+
+        bool todos = true;
+        for (std::size_t p = 0; todos && p < patrones_.size(); ++p) {
+            if (p != guia_) todos = patrones_[p].contenidoEn(texto + inicio, fin - inicio);
+        }
+        if (todos && !porLinea(texto + inicio, fin - inicio)) return false;
+        pos = fin + 1;
+    }
+    return true;
+}
+
+#endif
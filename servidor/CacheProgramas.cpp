@@ -0,0 +1,63 @@
+#include "CacheProgramas.h"
+#include <iterator>
+
+CacheProgramas::CacheProgramas(std::size_t bytesMaximos) {
+    estadisticas_.bytesMaximos = bytesMaximos;
+}
+
+void CacheProgramas::quitar(std::list<Entrada>::iterator it) {
+    estadisticas_.bytes -= it->bytes;
+    porClave_.erase(it->clave);
+    entradas_.erase(it);
+}
+
+void CacheProgramas::ajustarAlPresupuesto() {
+    while (!entradas_.empty() && estadisticas_.bytes > estadisticas_.bytesMaximos) {
+        quitar(std::prev(entradas_.end()));
+        ++estadisticas_.descartes;
+    }
+}
+
+void CacheProgramas::configurarMemoria(std::size_t bytesMaximos) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    estadisticas_.bytesMaximos = bytesMaximos;
+    ajustarAlPresupuesto();
+}
+
+CacheProgramas::Programa CacheProgramas::buscar(const std::string& clave, const FirmaPrograma& firma) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = porClave_.find(clave);
+    if (it == porClave_.end() || !(it->second->firma == firma)) {
+        ++estadisticas_.fallos;
+        return nullptr;
+    }
+    ++estadisticas_.aciertos;
+    entradas_.splice(entradas_.begin(), entradas_, it->second);
+    return it->second->programa;
+}
+
+void CacheProgramas::guardar(const std::string& clave, const FirmaPrograma& firma, Programa programa, std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = porClave_.find(clave);
+    if (it != porClave_.end()) quitar(it->second); // versión anterior del archivo
+    if (bytes > estadisticas_.bytesMaximos) return;
+
+    entradas_.push_front(Entrada{clave, firma, std::move(programa), bytes});
+    porClave_[clave] = entradas_.begin();
+    estadisticas_.bytes += bytes;
+    ajustarAlPresupuesto();
+}
+
+void CacheProgramas::vaciar() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    entradas_.clear();
+    porClave_.clear();
+    estadisticas_.bytes = 0;
+}
+
+EstadisticasCacheProgramas CacheProgramas::estadisticas() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    EstadisticasCacheProgramas e = estadisticas_;
+    e.programas = entradas_.size();
+    return e;
+}
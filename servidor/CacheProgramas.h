@@ -0,0 +1,75 @@
+#ifndef CACHEPROGRAMAS_H
+#define CACHEPROGRAMAS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct ProgramaG;
+
+// Identifica una versión de un archivo y el contexto con que se preparó: si
+// cambia la fecha, el tamaño o el contexto, la entrada guardada ya no sirve
+struct FirmaPrograma {
+    std::int64_t fecha = 0;       // última modificación (ns)
+    std::uint64_t bytes = 0;
+    std::uint64_t contexto = 0;   // lo que además influye en la preparación
+
+    bool operator==(const FirmaPrograma& o) const {
+        return fecha == o.fecha && bytes == o.bytes && contexto == o.contexto;
+    }
+};
+
+struct EstadisticasCacheProgramas {
+    std::uint64_t aciertos = 0;
+    std::uint64_t fallos = 0;
+    std::uint64_t descartes = 0;  // entradas sacadas para respetar el presupuesto
+    std::size_t programas = 0;
+    std::size_t bytes = 0;
+    std::size_t bytesMaximos = 0;
+};
+
+// Programas G-Code ya leídos, validados y simplificados, por clave de archivo
+// (quien llama decide cuál: dispositivo e inodo comparten la entrada entre
+// nombres enlazados al mismo contenido). Se descarta
+// el usado hace más tiempo (LRU) cuando la suma estimada supera el presupuesto.
+// Los programas se comparten como const: quien los use hace su propia copia.
+class CacheProgramas {
+public:
+    typedef std::shared_ptr<const ProgramaG> Programa;
+
+private:
+    struct Entrada {
+        std::string clave;
+        FirmaPrograma firma;
+        Programa programa;
+        std::size_t bytes;
+    };
+
+    std::list<Entrada> entradas_; // la más reciente al frente
+    std::unordered_map<std::string, std::list<Entrada>::iterator> porClave_;
+    EstadisticasCacheProgramas estadisticas_;
+    mutable std::mutex mtx_;
+
+    void quitar(std::list<Entrada>::iterator it);
+    void ajustarAlPresupuesto();
+
+public:
+    explicit CacheProgramas(std::size_t bytesMaximos = 64u << 20);
+
+    // 0 desactiva la caché (y la vacía)
+    void configurarMemoria(std::size_t bytesMaximos);
+
+    // El programa guardado para 'clave' si la firma coincide; cuenta acierto o fallo
+    Programa buscar(const std::string& clave, const FirmaPrograma& firma);
+    // 'bytes' es la memoria estimada del programa; si no entra en el presupuesto no se guarda
+    void guardar(const std::string& clave, const FirmaPrograma& firma, Programa programa, std::size_t bytes);
+    void vaciar();
+
+    EstadisticasCacheProgramas estadisticas() const;
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include "CatalogoArchivos.h"
+#include "IndiceLineas.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+CatalogoArchivos::CatalogoArchivos(const std::string& directorio, const std::string& extension)
+    : directorio_(directorio), extension_(extension), inotify_(-1), escaneado_(false) {
+#ifdef __linux__
+    // Creación, escritura terminada, cambios de fecha, borrado y renombres
+    inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_ >= 0 &&
+        inotify_add_watch(inotify_, directorio_.c_str(),
+                          IN_CREATE | IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO) < 0) {
+        close(inotify_);
+        inotify_ = -1;
+    }
+    if (inotify_ < 0) {
+        std::cerr << "Aviso: sin inotify para " << directorio_ << " (" << std::strerror(errno)
+                  << "), el catálogo se reescanea en cada consulta" << std::endl;
+    }
+#endif
+}
+
+CatalogoArchivos::~CatalogoArchivos() {
+    if (inotify_ >= 0) close(inotify_);
+}
+
+bool CatalogoArchivos::interesa(const std::string& nombre) const {
+    return nombre.size() > extension_.size() &&
+           nombre.compare(nombre.size() - extension_.size(), extension_.size(), extension_) == 0;
+}
+
+std::string CatalogoArchivos::dueno(const std::string& nombre) const {
+    std::size_t guion = nombre.rfind('_');
+    if (guion == std::string::npos) return "";
+    return nombre.substr(guion + 1, nombre.size() - extension_.size() - guion - 1);
+}
+
+void CatalogoArchivos::escanear() {
+    archivos_.clear();
+    porDueno_.clear();
+    DIR* dir = opendir(directorio_.c_str());
+    if (!dir) {
+        std::cerr << "Error: no se pudo abrir el directorio " << directorio_ << std::endl;
+        return;
+    }
+    while (struct dirent* entrada = readdir(dir)) {
+        std::string nombre = entrada->d_name;
+        if (interesa(nombre)) actualizar(nombre);
+    }
+    closedir(dir);
+    escaneado_ = true;
+}
+
+void CatalogoArchivos::actualizar(const std::string& nombre) {
+    std::string ruta = directorio_ + "/" + nombre;
+    struct stat st;
+    if (stat(ruta.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        quitar(nombre);
+        return;
+    }
+    ArchivoCatalogo& archivo = archivos_[nombre];
+    // Un evento de fecha sin cambio de contenido no necesita el índice
+    if (archivo.nombre == nombre && archivo.bytes == static_cast<std::uint64_t>(st.st_size) &&
+        archivo.modificado == static_cast<std::int64_t>(st.st_mtime)) {
+        return;
+    }
+    archivo.nombre = nombre;
+    archivo.dueno = dueno(nombre);
+    archivo.bytes = static_cast<std::uint64_t>(st.st_size);
+    archivo.modificado = static_cast<std::int64_t>(st.st_mtime);
+    // Las líneas salen del índice en caché: si está al día no se lee el archivo
+    IndiceLineas indice;
+    archivo.lineas = indice.sincronizar(ruta) ? indice.lineas() : 0;
+    porDueno_[archivo.dueno].insert(nombre);
+}
+
+void CatalogoArchivos::quitar(const std::string& nombre) {
+    auto it = archivos_.find(nombre);
+    if (it == archivos_.end()) return;
+    auto d = porDueno_.find(it->second.dueno);
+    if (d != porDueno_.end()) {
+        d->second.erase(nombre);
+        if (d->second.empty()) porDueno_.erase(d);
+    }
+    archivos_.erase(it);
+}
+
+void CatalogoArchivos::procesarEventos() {
+#ifdef __linux__
+    // Primero se juntan los nombres: varios eventos del mismo archivo (crear,
+    // escribir, cerrar) se resuelven con un solo stat
+    std::set<std::string> cambiados;
+    alignas(struct inotify_event) char buf[16384];
+    ssize_t n;
+    while ((n = read(inotify_, buf, sizeof(buf))) > 0) {
+        for (char* p = buf; p < buf + n;) {
+            const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + ev->len;
+            if (ev->mask & IN_Q_OVERFLOW) {
+                escaneado_ = false;
+            } else if (ev->len > 0) {
+                std::string nombre = ev->name;
+                if (interesa(nombre)) cambiados.insert(nombre);
+            }
+        }
+    }
+    if (!escaneado_) return;
+    for (const auto& nombre : cambiados) actualizar(nombre);
+#endif
+}
+
+std::vector<ArchivoCatalogo> CatalogoArchivos::listar(const std::string& usuario) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (inotify_ >= 0) procesarEventos();
+    if (inotify_ < 0 || !escaneado_) escanear();
+
+    std::vector<ArchivoCatalogo> resultado;
+    if (usuario.empty()) {
+        resultado.reserve(archivos_.size());
+        for (const auto& par : archivos_) resultado.push_back(par.second);
+    } else if (usuario.find('_') == std::string::npos) {
+        auto d = porDueno_.find(usuario);
+        if (d != porDueno_.end()) {
+            for (const auto& nombre : d->second) resultado.push_back(archivos_[nombre]);
+        }
+    } else {
+        // Un usuario con '_' no coincide con el dueño deducido: se compara el sufijo
+        std::string sufijo = "_" + usuario + extension_;
+        for (const auto& par : archivos_) {
+            const std::string& nombre = par.first;
+            if (nombre.size() >= sufijo.size() && nombre.compare(nombre.size() - sufijo.size(), sufijo.size(), sufijo) == 0) {
+                resultado.push_back(par.second);
+            }
+        }
+    }
+    return resultado;
+}
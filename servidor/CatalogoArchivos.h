@@ -0,0 +1,58 @@
+#ifndef CATALOGOARCHIVOS_H
+#define CATALOGOARCHIVOS_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Datos de un programa G-Code del catálogo
+struct ArchivoCatalogo {
+    std::string nombre;
+    std::string dueno;            // lo que sigue al último '_' (nombre_usuario.gcode)
+    std::uint64_t bytes = 0;
+    std::size_t lineas = 0;       // según el índice de líneas (IndiceLineas)
+    std::int64_t modificado = 0;  // time_t de la última modificación
+};
+
+// Catálogo en memoria de los archivos de un directorio con una extensión dada.
+// Se escanea una vez y después se mantiene con inotify: los eventos se quedan en
+// la cola del kernel y se aplican al consultar, así que listar sólo hace stat de
+// los archivos que cambiaron. Si el kernel pierde eventos (cola llena) o no hay
+// inotify, se vuelve a escanear el directorio.
+class CatalogoArchivos {
+private:
+    std::string directorio_;
+    std::string extension_;
+    int inotify_;
+    bool escaneado_;
+
+    std::map<std::string, ArchivoCatalogo> archivos_;                     // por nombre
+    std::unordered_map<std::string, std::set<std::string>> porDueno_;    // dueño -> nombres
+    std::mutex mtx_;
+
+    bool interesa(const std::string& nombre) const;
+    std::string dueno(const std::string& nombre) const;
+    void escanear();
+    void actualizar(const std::string& nombre); // lo agrega, refresca o quita según el disco
+    void quitar(const std::string& nombre);
+    void procesarEventos();
+
+public:
+    explicit CatalogoArchivos(const std::string& directorio = ".", const std::string& extension = ".gcode");
+    ~CatalogoArchivos();
+
+    CatalogoArchivos(const CatalogoArchivos&) = delete;
+    CatalogoArchivos& operator=(const CatalogoArchivos&) = delete;
+
+    // Archivos ordenados por nombre; con usuario vacío, todos. Un usuario ve los
+    // archivos terminados en "_<usuario><extension>".
+    std::vector<ArchivoCatalogo> listar(const std::string& usuario = "");
+
+    bool vigilando() const { return inotify_ >= 0; }
+};
+
+#endif
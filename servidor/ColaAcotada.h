@@ -0,0 +1,74 @@
+#ifndef COLAACOTADA_H
+#define COLAACOTADA_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+// Cola productor/consumidor de capacidad fija: poner() espera si está llena y
+// tomar() espera si está vacía. El productor la cierra al terminar (el consumidor
+// vacía lo que quede) y el consumidor la cancela si abandona (el productor deja
+// de esperar lugar). Lo escrito antes de cerrar() es visible tras tomar() == false.
+template <typename T>
+class ColaAcotada {
+private:
+    std::deque<T> elementos_;
+    std::size_t capacidad_;
+    bool cerrada_;
+    bool cancelada_;
+    std::mutex mtx_;
+    std::condition_variable hayElementos_;
+    std::condition_variable hayLugar_;
+
+public:
+    explicit ColaAcotada(std::size_t capacidad)
+        : capacidad_(capacidad ? capacidad : 1), cerrada_(false), cancelada_(false) {}
+
+    ColaAcotada(const ColaAcotada&) = delete;
+    ColaAcotada& operator=(const ColaAcotada&) = delete;
+
+    // false si la cola se canceló (el elemento se descarta)
+    bool poner(T valor) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        hayLugar_.wait(lock, [this] { return cancelada_ || elementos_.size() < capacidad_; });
+        if (cancelada_) return false;
+        elementos_.push_back(std::move(valor));
+        hayElementos_.notify_one();
+        return true;
+    }
+
+    // false cuando está cerrada y vacía, o cancelada
+    bool tomar(T& valor) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        hayElementos_.wait(lock, [this] { return cancelada_ || cerrada_ || !elementos_.empty(); });
+        if (cancelada_ || elementos_.empty()) return false;
+        valor = std::move(elementos_.front());
+        elementos_.pop_front();
+        hayLugar_.notify_one();
+        return true;
+    }
+
+    // Espera a que haya algo para tomar; false si se cerró o canceló vacía
+    bool esperarElementos() {
+        std::unique_lock<std::mutex> lock(mtx_);
+        hayElementos_.wait(lock, [this] { return cancelada_ || cerrada_ || !elementos_.empty(); });
+        return !cancelada_ && !elementos_.empty();
+    }
+
+    void cerrar() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        cerrada_ = true;
+        hayElementos_.notify_all();
+    }
+
+    void cancelar() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        cancelada_ = true;
+        elementos_.clear();
+        hayElementos_.notify_all();
+        hayLugar_.notify_all();
+    }
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "ColaComandos.h"
+#include <iostream>
+
+namespace {
+
+std::future<ResultadoPeticion> resultadoInmediato(ResultadoPeticion resultado) {
+    std::promise<ResultadoPeticion> promesa;
+    promesa.set_value(resultado);
+    return promesa.get_future();
+}
+
+} // namespace
+
+ColaComandos::ColaComandos(const ConfiguracionCola& config)
+    : config_(config), pendientesNoUrgentes_(0), detenida_(false) {
+    trabajador_ = std::thread(&ColaComandos::bucleTrabajador, this);
+}
+
+ColaComandos::~ColaComandos() {
+    detener();
+}
+
+void ColaComandos::detener() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (detenida_) {
+            return;
+        }
+        detenida_ = true;
+        descartarLocked(static_cast<int>(PrioridadComando::EMERGENCIA), ResultadoPeticion::COLA_DETENIDA);
+    }
+    cv_.notify_all();
+    if (trabajador_.joinable()) {
+        trabajador_.join();
+    }
+}
+
+void ColaComandos::liberarOrigen(const std::string& origen) {
+    auto it = pendientesPorOrigen_.find(origen);
+    if (it != pendientesPorOrigen_.end() && --it->second == 0) {
+        pendientesPorOrigen_.erase(it);
+    }
+}
+
+std::size_t ColaComandos::descartarLocked(int desdePrioridad, ResultadoPeticion motivo) {
+    std::size_t descartadas = 0;
+    for (int p = desdePrioridad; p < NUM_PRIORIDADES; ++p) {
+        for (auto& peticion : colas_[p]) {
+            if (p != static_cast<int>(PrioridadComando::EMERGENCIA)) {
+                liberarOrigen(peticion->origen);
+                --pendientesNoUrgentes_;
+            }
+            peticion->resultado.set_value(motivo);
+            ++descartadas;
+        }
+        colas_[p].clear();
+    }
+    estadisticas_.descartadas += descartadas;
+    return descartadas;
+}
+
+std::size_t ColaComandos::descartarPendientes(PrioridadComando desde) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return descartarLocked(static_cast<int>(desde), ResultadoPeticion::DESCARTADA);
+}
+
+std::future<ResultadoPeticion> ColaComandos::encolar(PrioridadComando prioridad, const std::string& origen,
+                                                     Accion accion) {
+    std::unique_ptr<Peticion> peticion(new Peticion());
+    peticion->origen = origen;
+    peticion->accion = std::move(accion);
+    std::future<ResultadoPeticion> futuro = peticion->resultado.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (detenida_) {
+            return resultadoInmediato(ResultadoPeticion::COLA_DETENIDA);
+        }
+
+        if (prioridad == PrioridadComando::EMERGENCIA) {
+            // Lo que estaba esperando ya no tiene sentido después de una parada
+            std::size_t descartadas = descartarLocked(static_cast<int>(PrioridadComando::MANUAL),
+                                                      ResultadoPeticion::DESCARTADA);
+            if (descartadas > 0) {
+                std::cout << "Cola de comandos: " << descartadas << " peticiones descartadas por emergencia" << std::endl;
+            }
+        } else {
+            if (pendientesNoUrgentes_ >= config_.capacidad) {
+                ++estadisticas_.rechazadas;
+                std::cerr << "Error: Cola de comandos llena, petición de " << origen << " rechazada" << std::endl;
+                return resultadoInmediato(ResultadoPeticion::COLA_LLENA);
+            }
+            std::size_t& delOrigen = pendientesPorOrigen_[origen];
+            if (delOrigen >= config_.maximoPorOrigen) {
+                ++estadisticas_.rechazadas;
+                std::cerr << "Error: " << origen << " tiene " << delOrigen
+                          << " peticiones pendientes, petición rechazada" << std::endl;
+                return resultadoInmediato(ResultadoPeticion::LIMITE_ORIGEN);
+            }
+            ++delOrigen;
+            ++pendientesNoUrgentes_;
+        }
+
+        colas_[static_cast<int>(prioridad)].push_back(std::move(peticion));
+    }
+    cv_.notify_one();
+    return futuro;
+}
+
+ResultadoPeticion ColaComandos::ejecutar(PrioridadComando prioridad, const std::string& origen, Accion accion) {
+    return encolar(prioridad, origen, std::move(accion)).get();
+}
+
+void ColaComandos::bucleTrabajador() {
+    while (true) {
+        std::unique_ptr<Peticion> peticion;
+        bool urgente = false;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [this] {
+                return detenida_ || !colas_[0].empty() || !colas_[1].empty() || !colas_[2].empty();
+            });
+            if (detenida_) {
+                return;
+            }
+            for (int p = 0; p < NUM_PRIORIDADES; ++p) {
+                if (!colas_[p].empty()) {
+                    peticion = std::move(colas_[p].front());
+                    colas_[p].pop_front();
+                    urgente = (p == static_cast<int>(PrioridadComando::EMERGENCIA));
+                    break;
+                }
+            }
+            if (!urgente) {
+                liberarOrigen(peticion->origen);
+                --pendientesNoUrgentes_;
+            }
+        }
+
+        // La operación se ejecuta fuera del cerrojo para poder seguir encolando
+        ResultadoPeticion resultado = ResultadoPeticion::FALLO;
+        try {
+            resultado = peticion->accion() ? ResultadoPeticion::EXITO : ResultadoPeticion::FALLO;
+        } catch (const std::exception& e) {
+            std::cerr << "Error ejecutando petición de " << peticion->origen << ": " << e.what() << std::endl;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            ++estadisticas_.ejecutadas;
+        }
+        peticion->resultado.set_value(resultado);
+    }
+}
+
+EstadisticasCola ColaComandos::obtenerEstadisticas() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    EstadisticasCola copia = estadisticas_;
+    for (int p = 0; p < NUM_PRIORIDADES; ++p) {
+        copia.pendientes[p] = colas_[p].size();
+    }
+    return copia;
+}
+
+const char* ColaComandos::nombreResultado(ResultadoPeticion resultado) {
+    switch (resultado) {
+        case ResultadoPeticion::EXITO:         return "exito";
+        case ResultadoPeticion::FALLO:         return "fallo";
+        case ResultadoPeticion::COLA_LLENA:    return "cola llena";
+        case ResultadoPeticion::LIMITE_ORIGEN: return "demasiadas peticiones pendientes del mismo origen";
+        case ResultadoPeticion::DESCARTADA:    return "descartada por parada de emergencia";
+        case ResultadoPeticion::COLA_DETENIDA: return "cola detenida";
+    }
+    return "desconocido";
+}
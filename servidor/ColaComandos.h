@@ -0,0 +1,100 @@
+#ifndef COLACOMANDOS_H
+#define COLACOMANDOS_H
+
+#include <string>
+#include <deque>
+#include <map>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+// Orden de atención: un nivel sólo se atiende cuando los anteriores están vacíos
+enum class PrioridadComando {
+    EMERGENCIA = 0,
+    MANUAL = 1,
+    ARCHIVO = 2
+};
+
+#define NUM_PRIORIDADES 3
+
+enum class ResultadoPeticion {
+    EXITO,
+    FALLO,             // la operación se ejecutó y devolvió false
+    COLA_LLENA,
+    LIMITE_ORIGEN,     // el origen ya tiene demasiadas peticiones pendientes
+    DESCARTADA,        // purgada por una parada de emergencia
+    COLA_DETENIDA
+};
+
+struct ConfiguracionCola {
+    std::size_t capacidad;        // peticiones pendientes en total (sin contar emergencias)
+    std::size_t maximoPorOrigen;  // peticiones pendientes de una misma sesión (usuario/nodo)
+
+    ConfiguracionCola() : capacidad(16), maximoPorOrigen(4) {}
+};
+
+struct EstadisticasCola {
+    std::size_t pendientes[NUM_PRIORIDADES];
+    std::size_t ejecutadas;
+    std::size_t rechazadas;
+    std::size_t descartadas;
+
+    EstadisticasCola() : pendientes{0, 0, 0}, ejecutadas(0), rechazadas(0), descartadas(0) {}
+};
+
+// Cola única de operaciones sobre el robot: un único hilo las ejecuta de a una,
+// por prioridad y en orden de llegada dentro de cada prioridad. Encolan el
+// despachador RPC y la consola; la cola ordena su acceso al puerto. Cada origen
+// (sesión) tiene a lo sumo maximoPorOrigen peticiones pendientes, así una sesión
+// no acapara la capacidad total. El ejecutor de programas y la parada de
+// emergencia de ServidorRpc no pasan por aquí: comparten el puerto a través de
+// GestorCodigoG. Las emergencias encoladas no tienen límite de profundidad y al
+// encolarse descartan todo lo pendiente de menor prioridad.
+class ColaComandos {
+public:
+    typedef std::function<bool()> Accion;
+
+private:
+    struct Peticion {
+        std::string origen;
+        Accion accion;
+        std::promise<ResultadoPeticion> resultado;
+    };
+
+    ConfiguracionCola config_;
+    std::deque<std::unique_ptr<Peticion>> colas_[NUM_PRIORIDADES];
+    std::size_t pendientesNoUrgentes_;
+    std::map<std::string, std::size_t> pendientesPorOrigen_;
+    EstadisticasCola estadisticas_;
+    bool detenida_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::thread trabajador_;
+
+    void bucleTrabajador();
+    void liberarOrigen(const std::string& origen);
+    std::size_t descartarLocked(int desdePrioridad, ResultadoPeticion motivo);
+
+public:
+    explicit ColaComandos(const ConfiguracionCola& config = ConfiguracionCola());
+    ~ColaComandos();
+
+    // Encola sin esperar; si la petición se rechaza el futuro ya tiene el motivo
+    std::future<ResultadoPeticion> encolar(PrioridadComando prioridad, const std::string& origen, Accion accion);
+    // Encola y espera a que la operación termine
+    ResultadoPeticion ejecutar(PrioridadComando prioridad, const std::string& origen, Accion accion);
+
+    // Descarta lo pendiente desde la prioridad indicada (inclusive) hacia abajo
+    std::size_t descartarPendientes(PrioridadComando desde);
+    void detener();
+
+    EstadisticasCola obtenerEstadisticas() const;
+    static const char* nombreResultado(ResultadoPeticion resultado);
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "ComandoG.h"
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+std::uint32_t TextosPrograma::agregar(std::string_view texto) {
+    inicios_.push_back(static_cast<std::uint32_t>(datos_.size()));
+    datos_.append(texto.data(), texto.size());
+    return static_cast<std::uint32_t>(inicios_.size());
+}
+
+std::string_view TextosPrograma::texto(std::uint32_t numero) const {
+    if (numero == 0 || numero > inicios_.size()) {
+        return std::string_view();
+    }
+    std::size_t inicio = inicios_[numero - 1];
+    std::size_t fin = numero < inicios_.size() ? inicios_[numero] : datos_.size();
+    return std::string_view(datos_).substr(inicio, fin - inicio);
+}
+
+void TextosPrograma::compactar() {
+    datos_.shrink_to_fit();
+    inicios_.shrink_to_fit();
+}
+
+void TextosPrograma::clear() {
+    datos_.clear();
+    inicios_.clear();
+}
+
+std::int32_t ComandoG::aFijo(double valor) {
+    double escalado = std::round(valor * ESCALA);
+    const double maximo = std::numeric_limits<std::int32_t>::max();
+    if (!(escalado < maximo)) return std::numeric_limits<std::int32_t>::max();
+    if (!(escalado > -maximo)) return -std::numeric_limits<std::int32_t>::max();
+    return static_cast<std::int32_t>(escalado);
+}
+
+void ComandoG::fijarPosicion(const Posicion& p) {
+    x = aFijo(p.x);
+    y = aFijo(p.y);
+    z = aFijo(p.z);
+    palabras |= EJE_X | EJE_Y | EJE_Z;
+}
+
+Posicion ComandoG::destino(const Posicion& desde, bool relativo) const {
+    Posicion p = desde;
+    if (palabras & EJE_X) p.x = relativo ? desde.x + deFijo(x) : deFijo(x);
+    if (palabras & EJE_Y) p.y = relativo ? desde.y + deFijo(y) : deFijo(y);
+    if (palabras & EJE_Z) p.z = relativo ? desde.z + deFijo(z) : deFijo(z);
+    return p;
+}
+
+static const char* nombreOperacion(OperacionG operacion) {
+    switch (operacion) {
+        case OperacionG::G0:  return "G0";
+        case OperacionG::G1:  return "G1";
+        case OperacionG::G2:  return "G2";
+        case OperacionG::G3:  return "G3";
+        case OperacionG::G28: return "G28";
+        case OperacionG::G90: return "G90";
+        case OperacionG::G91: return "G91";
+        case OperacionG::M3:  return "M3";
+        case OperacionG::M5:  return "M5";
+        case OperacionG::OTRA: break;
+    }
+    return "";
+}
+
+// " X12.5": el valor exacto en punto fijo, sin ceros a la derecha
+static void agregarPalabra(std::string& texto, char letra, std::int32_t valor) {
+    texto += ' ';
+    texto += letra;
+    std::int64_t absoluto = valor;
+    if (absoluto < 0) {
+        texto += '-';
+        absoluto = -absoluto;
+    }
+    texto += std::to_string(absoluto / 1000);
+    int decimales = static_cast<int>(absoluto % 1000);
+    if (decimales != 0) {
+        char buf[5];
+        std::snprintf(buf, sizeof(buf), ".%03d", decimales);
+        std::size_t largo = 4;
+        while (buf[largo - 1] == '0') --largo;
+        texto.append(buf, largo);
+    }
+}
+
+std::string ComandoG::texto(const TextosPrograma* textos) const {
+    if (textoOriginal != 0 && textos) {
+        return std::string(textos->texto(textoOriginal));
+    }
+
+    std::string texto = nombreOperacion(operacion);
+    if (fPlan > 0) {
+        // Como GestorCodigoG::posicionAComandoG: los tres ejes y la velocidad planificada
+        agregarPalabra(texto, 'X', x);
+        agregarPalabra(texto, 'Y', y);
+        agregarPalabra(texto, 'Z', z);
+        agregarPalabra(texto, 'F', fPlan);
+        return texto;
+    }
+    if (palabras & EJE_X) agregarPalabra(texto, 'X', x);
+    if (palabras & EJE_Y) agregarPalabra(texto, 'Y', y);
+    if (palabras & EJE_Z) agregarPalabra(texto, 'Z', z);
+    if (palabras & PALABRA_I) agregarPalabra(texto, 'I', i);
+    if (palabras & PALABRA_J) agregarPalabra(texto, 'J', j);
+    if (palabras & PALABRA_R) agregarPalabra(texto, 'R', r);
+    if (palabras & PALABRA_F) agregarPalabra(texto, 'F', f);
+    return texto;
+}
+
+const char* ComandoG::descripcion() const {
+    switch (operacion) {
+        case OperacionG::G28: return "Home - Ir a origen";
+        case OperacionG::G2:  return "Arco horario";
+        case OperacionG::G3:  return "Arco antihorario";
+        case OperacionG::G0:
+        case OperacionG::G1:  return "Movimiento lineal";
+        case OperacionG::M3:  return "Activar efector";
+        case OperacionG::M5:  return "Desactivar efector";
+        case OperacionG::G90: return "Modo absoluto";
+        case OperacionG::G91:
+        case OperacionG::OTRA: break;
+    }
+    return "Comando G-Code";
+}
@@ -0,0 +1,117 @@
+#ifndef COMANDOG_H
+#define COMANDOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Posicion {
+    double x;
+    double y;
+    double z;
+
+    Posicion(double x = 0, double y = 0, double z = 0) : x(x), y(y), z(z) {}
+};
+
+// Palabras presentes en el comando (bits de ComandoG::palabras)
+#define EJE_X 0x01
+#define EJE_Y 0x02
+#define EJE_Z 0x04
+#define PALABRA_F 0x08
+#define PALABRA_I 0x10
+#define PALABRA_J 0x20
+#define PALABRA_R 0x40
+
+// Códigos que el servidor interpreta; el resto se envía tal como vino
+enum class OperacionG : std::uint8_t {
+    OTRA,
+    G0,   // movimiento rápido
+    G1,   // movimiento lineal
+    G2,   // arco horario
+    G3,   // arco antihorario
+    G28,  // ir a origen
+    G90,  // modo absoluto
+    G91,  // modo relativo
+    M3,   // activar efector
+    M5    // desactivar efector
+};
+
+class TextosPrograma;
+
+// Comando G-Code compacto y sin memoria propia: coordenadas en punto fijo
+// (milésimas de mm o de mm/min), las palabras presentes como bits y el código
+// como enumerado. El texto que se envía al firmware se regenera desde los
+// campos, salvo que el programa lo conserve en sus TextosPrograma.
+struct ComandoG {
+    static constexpr double ESCALA = 1000.0;
+
+    std::int32_t x, y, z;
+    std::int32_t i, j;      // I/J de los arcos: desplazamiento del centro respecto del inicio
+    std::int32_t r;         // R de los arcos (0 si se usa I/J)
+    std::int32_t f;         // F del programa
+    std::int32_t fPlan;     // F ajustada por el planificador (0 si no se planificó)
+    std::uint32_t textoOriginal; // número en los TextosPrograma del programa, 0 si se regenera
+    OperacionG operacion;
+    std::uint8_t palabras;
+    bool valido;
+    bool enlazado; // el planificador permite seguir sin detenerse al terminar
+
+    ComandoG()
+        : x(0), y(0), z(0), i(0), j(0), r(0), f(0), fPlan(0), textoOriginal(0),
+          operacion(OperacionG::OTRA), palabras(0), valido(false), enlazado(false) {}
+
+    static std::int32_t aFijo(double valor);
+    static double deFijo(std::int32_t valor) { return valor / ESCALA; }
+
+    Posicion posicion() const { return Posicion(deFijo(x), deFijo(y), deFijo(z)); }
+    Posicion centro() const { return Posicion(deFijo(i), deFijo(j), 0); }
+    double radio() const { return deFijo(r); }
+    double velocidad() const { return deFijo(f); }
+    void fijarPosicion(const Posicion& p);
+    // Destino de un G0/G1 desde 'desde': los ejes ausentes conservan su valor y en
+    // modo relativo (G91) los presentes se suman
+    Posicion destino(const Posicion& desde, bool relativo = false) const;
+
+    bool esMovimiento() const { return operacion == OperacionG::G0 || operacion == OperacionG::G1; }
+    bool esArco() const { return operacion == OperacionG::G2 || operacion == OperacionG::G3; }
+
+    // Con los textos del programa se devuelve la línea original si se conservó
+    std::string texto(const TextosPrograma* textos = nullptr) const;
+    const char* descripcion() const;
+};
+
+// Líneas originales de los comandos de un programa que no pueden regenerarse
+// desde sus campos (códigos no interpretados, palabras E/S, más de tres
+// decimales), guardadas una tras otra en un único bloque que se libera con el
+// programa
+class TextosPrograma {
+private:
+    std::string datos_;
+    std::vector<std::uint32_t> inicios_; // el texto n va de inicios_[n-1] al inicio siguiente
+
+public:
+    // Número (desde 1) del texto agregado
+    std::uint32_t agregar(std::string_view texto);
+    std::string_view texto(std::uint32_t numero) const;
+    std::size_t bytes() const { return datos_.capacity() + inicios_.capacity() * sizeof(std::uint32_t); }
+    void compactar();
+    void clear();
+};
+
+// Programa G-Code: los comandos y los textos que conservan
+struct ProgramaG {
+    std::vector<ComandoG> comandos;
+    TextosPrograma textos;
+
+    std::size_t size() const { return comandos.size(); }
+    bool empty() const { return comandos.empty(); }
+    ComandoG& operator[](std::size_t i) { return comandos[i]; }
+    const ComandoG& operator[](std::size_t i) const { return comandos[i]; }
+    void push_back(const ComandoG& cmd) { comandos.push_back(cmd); }
+    void clear() { comandos.clear(); textos.clear(); }
+    std::string texto(const ComandoG& cmd) const { return cmd.texto(&textos); }
+};
+
+#endif
@@ -0,0 +1,19 @@
+#include "EspacioTrabajo.h"
+#include <sstream>
+
+EspacioTrabajo::EspacioTrabajo() : r2Min_(sq(R_MIN)), r2Max_(sq(R_MAX)) {
+}
+
+std::string EspacioTrabajo::diagnosticar(double x, double y, double z) const {
+    if (esAlcanzable(x, y, z)) {
+        return "";
+    }
+
+    std::ostringstream msg;
+    if (z < Z_MIN || z > Z_MAX) {
+        msg << "Posición Z fuera de límites [" << Z_MIN << ", " << Z_MAX << "] - actual: " << z;
+        return msg.str();
+    }
+    msg << "Posición radial fuera de límites [" << R_MIN << ", " << R_MAX << "] - actual: " << std::sqrt(sq(x) + sq(y));
+    return msg.str();
+}
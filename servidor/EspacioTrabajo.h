@@ -0,0 +1,42 @@
+#ifndef ESPACIOTRABAJO_H
+#define ESPACIOTRABAJO_H
+
+#include <string>
+#include <cmath>
+
+// Definiciones del espacio de trabajo del robot
+#define LOW_SHANK_LENGTH 120.0
+#define HIGH_SHANK_LENGTH 120.0
+#define Z_MIN -115 // -140.0 //MINIMUM Z HEIGHT OF TOOLHEAD TOUCHING GROUND
+#define Z_MAX (LOW_SHANK_LENGTH+30.0) //SHANK_LENGTH ADDING ARBITUARY NUMBER FOR Z_MAX
+#define SHANKS_MIN_ANGLE_COS 0.791436948
+#define SHANKS_MAX_ANGLE_COS -0.774944489
+#define R_MIN (sqrt((sq(LOW_SHANK_LENGTH) + sq(HIGH_SHANK_LENGTH)) - (2*LOW_SHANK_LENGTH*HIGH_SHANK_LENGTH*SHANKS_MIN_ANGLE_COS) ))
+#define R_MAX (sqrt((sq(LOW_SHANK_LENGTH) + sq(HIGH_SHANK_LENGTH)) - (2*LOW_SHANK_LENGTH*HIGH_SHANK_LENGTH*SHANKS_MAX_ANGLE_COS) ))
+#define sq(x) ((x)*(x))
+
+// Envolvente de trabajo del firmware: anillo radial [R_MIN, R_MAX] y rango
+// [Z_MIN, Z_MAX]. El radio se compara al cuadrado, sin raíz por punto.
+class EspacioTrabajo {
+private:
+    double r2Min_;
+    double r2Max_;
+
+public:
+    EspacioTrabajo();
+
+    // Mismo criterio que el firmware; no escribe nada (apto para bucles)
+    bool esAlcanzable(double x, double y, double z) const {
+        double r2 = x * x + y * y;
+        return r2 >= r2Min_ && r2 <= r2Max_ && z >= Z_MIN && z <= Z_MAX;
+    }
+
+    // Explica qué restricción incumple una posición (cadena vacía si es alcanzable)
+    std::string diagnosticar(double x, double y, double z) const;
+
+    // Límites radiales al cuadrado, para validaciones por lotes
+    double obtenerR2Min() const { return r2Min_; }
+    double obtenerR2Max() const { return r2Max_; }
+};
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef GEOMETRIA_H
+#define GEOMETRIA_H
+
+// Punto en el espacio cartesiano del robot (mm)
+struct Punto3D {
+    double x;
+    double y;
+    double z;
+
+    Punto3D(double x = 0, double y = 0, double z = 0) : x(x), y(y), z(z) {}
+};
+
+#endif
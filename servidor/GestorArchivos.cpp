@@ -7,10 +7,21 @@
 #include <ctime>
 #include <cstdlib>
 #include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include "HilosParalelos.h"
 
 using std::string;
 namespace fs = std::filesystem;
 
+// Nombre único junto a 'ruta' para escribir aparte y después renombrar encima
+static std::string rutaTemporal(const std::string& ruta) {
+    static std::atomic<unsigned long> contador(0);
+    return ruta + ".tmp" + std::to_string(++contador);
+}
+
 static bool starts_with(const std::string& s, const std::string& pref) {
     return s.size() >= pref.size() && std::equal(pref.begin(), pref.end(), s.begin());
 }
@@ -19,6 +30,36 @@ static bool ends_with(const std::string& s, const std::string& suf) {
     return s.size() >= suf.size() && std::equal(suf.rbegin(), suf.rend(), s.rbegin());
 }
 
+// Versiones de trim/split sobre vistas, para los parsers: no copian el texto
+static std::string_view recortar(std::string_view s) {
+    std::size_t i = 0, j = s.size();
+    while (i < j && std::isspace(static_cast<unsigned char>(s[i]))) ++i;
+    while (j > i && std::isspace(static_cast<unsigned char>(s[j-1]))) --j;
+    return s.substr(i, j - i);
+}
+
+// Próximo registro CSV desde 'p': separa en comas fuera de comillas y termina en
+// el primer '\n' fuera de comillas (un campo entre comillas puede tener ambos).
+// Los campos quedan recortados y con sus comillas, como en el archivo.
+static const char* leerRegistroCSV(const char* p, const char* fin, std::vector<std::string_view>& out) {
+    out.clear();
+    bool entreComillas = false;
+    const char* campo = p;
+    for (; p < fin; ++p) {
+        char c = *p;
+        if (c == '"') {
+            entreComillas = !entreComillas;
+        } else if (!entreComillas && (c == ',' || c == '\n')) {
+            out.push_back(recortar(std::string_view(campo, static_cast<std::size_t>(p - campo))));
+            campo = p + 1;
+            if (c == '\n') return p + 1;
+        }
+    }
+    out.push_back(recortar(std::string_view(campo, static_cast<std::size_t>(p - campo))));
+    return fin;
+}
+
+
 // Fecha/hora local
 std::string GestorArchivos::nowAsString() {
     std::time_t t = std::time(nullptr);
@@ -70,29 +111,18 @@ bool GestorArchivos::fileExists(const std::string& path) const {
 }
 
 void GestorArchivos::updateDimension() const {
-    // La dejo const y uso ifstream local para no tocar el stream principal
-    std::ifstream f(name_);
-    if (!f) {
+    // El índice sólo lee lo que se agregó desde la última vez (o nada, si el
+    // de la caché está al día), así que no toca el stream principal
+    if (!indice_.sincronizar(name_)) {
         const_cast<GestorArchivos*>(this)->dimension_ = 0;
         return;
     }
-    std::size_t lines = 0;
-    std::string dummy;
-    while (std::getline(f, dummy)) ++lines;
-    const_cast<GestorArchivos*>(this)->dimension_ = lines;
-}
-
-std::string GestorArchivos::readAll() const {
-    std::ifstream f(name_, std::ios::in | std::ios::binary);
-    if (!f) return "";
-    std::ostringstream oss;
-    oss << f.rdbuf();
-    return oss.str();
+    const_cast<GestorArchivos*>(this)->dimension_ = indice_.lineas();
 }
 
 // --------- Constructores / destructor ---------
 GestorArchivos::GestorArchivos()
-: name_(""), datetime_(nowAsString()), owner_(), dimension_(0), openMode_("r"), nextLineIdx_(0)
+: name_(""), datetime_(nowAsString()), owner_(), dimension_(0), openMode_("r"), nextLineIdx_(0), generacionLector_(0)
 {
 #ifdef _WIN32
     const char* u = std::getenv("USERNAME");
@@ -127,8 +157,23 @@ bool GestorArchivos::open(const std::string& mode) {
         fs_.open(name_, std::ios::in);
         nextLineIdx_ = 0;
     } else if (mode == "w") {
-        fs_.open(name_, std::ios::out | std::ios::trunc);
+        // Se escribe un temporal que close() renombra sobre el archivo: quien lo
+        // tenga mapeado sigue viendo el contenido anterior, y un nombre enlazado
+        // al AlmacenGCode se reemplaza sin tocar el objeto compartido
+        temporal_ = rutaTemporal(name_);
+        fs_.open(temporal_, std::ios::out | std::ios::trunc);
+        if (!fs_.is_open()) {
+            temporal_.clear();
+            return false;
+        }
+        dimension_ = 0;
+        return true;
+    } else if (mode == "m") {
+        bool ok = mapa_.abrir(name_);
+        if (ok) updateDimension();
+        return ok;
     } else { // "a" (append) por defecto
+        separarEnlace();
         fs_.open(name_, std::ios::out | std::ios::app);
     }
     bool ok = fs_.is_open();
@@ -136,8 +181,44 @@ bool GestorArchivos::open(const std::string& mode) {
     return ok;
 }
 
+// Un archivo con varios enlaces duros (p. ej. un programa del AlmacenGCode) es
+// compartido: antes de agregarle al final se lo reemplaza por una copia propia
+void GestorArchivos::separarEnlace() {
+    std::error_code ec;
+    if (fs::hard_link_count(name_, ec) <= 1 || ec) return;
+    const std::string temporal = rutaTemporal(name_);
+    fs::copy_file(name_, temporal, fs::copy_options::overwrite_existing, ec);
+    if (!ec) fs::permissions(temporal, fs::perms::owner_write, fs::perm_options::add, ec);
+    if (!ec) fs::rename(temporal, name_, ec);
+    if (ec) std::cerr << "Error: no se pudo separar " << name_ << " de sus enlaces: " << ec.message() << std::endl;
+}
+
 void GestorArchivos::close() {
-    if (fs_.is_open()) fs_.close();
+    if (fs_.is_open()) {
+        bool escrito = static_cast<bool>(fs_.flush());
+        fs_.close();
+        if (!temporal_.empty()) publicarTemporal(escrito);
+    }
+    if (lector_.is_open()) lector_.close();
+    mapa_.cerrar();
+}
+
+// Fin del modo "w": el temporal reemplaza al archivo de una vez, o se descarta
+// si no se pudo escribir entero
+void GestorArchivos::publicarTemporal(bool escrito) {
+    std::error_code ec;
+    if (escrito) fs::rename(temporal_, name_, ec);
+    if (!escrito || ec) {
+        std::cerr << "Error: no se pudo reemplazar " << name_ << (ec ? ": " + ec.message() : std::string()) << std::endl;
+        fs::remove(temporal_, ec);
+    }
+    temporal_.clear();
+    updateDimension();
+}
+
+std::string_view GestorArchivos::getContenido() {
+    if (!mapa_.abierto()) open("m");
+    return mapa_.contenido();
 }
 
 // --------- Lectura de líneas ---------
@@ -153,16 +234,35 @@ std::string GestorArchivos::getLine() {
     return "";
 }
 
+bool GestorArchivos::getLine(std::string& line) {
+    if (!fs_.is_open() || openMode_ != "r") {
+        open("r");
+    }
+    if (std::getline(fs_, line)) {
+        ++nextLineIdx_;
+        return true;
+    }
+    line.clear();
+    return false;
+}
+
 std::string GestorArchivos::getLine(std::size_t idx) {
-    std::ifstream f(name_);
-    if (!f) return "";
-    std::string line;
-    std::size_t cur = 0;
-    while (std::getline(f, line)) {
-        ++cur;
-        if (cur == idx) return line;
+    updateDimension();
+    std::uint64_t inicio;
+    std::size_t largo;
+    if (idx == 0 || !indice_.ubicar(idx - 1, inicio, largo)) return "";
+    // El lector queda abierto entre llamadas; se reabre si el archivo se reescribió
+    if (!lector_.is_open() || generacionLector_ != indice_.generacion()) {
+        if (lector_.is_open()) lector_.close();
+        lector_.open(name_, std::ios::in | std::ios::binary);
+        generacionLector_ = indice_.generacion();
+        if (!lector_) return "";
     }
-    return "";
+    std::string line(largo, '\0');
+    lector_.clear();
+    lector_.seekg(static_cast<std::streamoff>(inicio));
+    if (!lector_.read(&line[0], static_cast<std::streamsize>(largo))) return "";
+    return line;
 }
 
 // --------- Escritura ---------
@@ -173,7 +273,13 @@ void GestorArchivos::write(const std::string& data) {
     fs_ << data;
     if (!data.empty() && data.back() != '\n') fs_ << '\n';
     fs_.flush();
-    updateDimension();
+    if (temporal_.empty()) {
+        updateDimension();
+    } else {
+        // El archivo todavía no se reemplazó: se cuentan las líneas escritas
+        dimension_ += static_cast<std::size_t>(std::count(data.begin(), data.end(), '\n'));
+        if (!data.empty() && data.back() != '\n') ++dimension_;
+    }
 }
 
 // --------- Info y existencia ---------
@@ -190,207 +296,478 @@ std::string GestorArchivos::getInfo() const {
     return oss.str();
 }
 
-GestorArchivos::Table GestorArchivos::parseCSV(const std::string& text) const {
-    std::istringstream iss(text);
-    std::string line;
-    std::vector<string> headers;
-    std::vector<Row> rows;
-    bool first = true;
-    while (std::getline(iss, line)) {
-        if (line.size() && (line.back()=='\r' || line.back()=='\n')) line.pop_back();
-        if (trim(line).empty()) continue;
-        auto parts = split(line, ',');
-        if (first) {
-            headers = parts;
-            for (auto& h : headers) h = trim(h);
-            first = false;
-        } else {
-            for (auto& p : parts) p = trim(p);
-            rows.push_back(parts);
-        }
+// --------- TablaColumnas ---------
+void TablaColumnas::definirEncabezados(const std::vector<std::string_view>& nombres) {
+    conEncabezados = true;
+    encabezados = nombres;
+    if (columnas.size() < encabezados.size()) columnas.resize(encabezados.size());
+}
+
+void TablaColumnas::nuevaFila() {
+    for (auto& c : columnas) c.emplace_back();
+    anchos.push_back(0);
+    ++filas;
+}
+
+void TablaColumnas::poner(std::size_t columna, std::string_view valor) {
+    if (columna >= columnas.size()) columnas.resize(columna + 1, std::vector<std::string_view>(filas));
+    columnas[columna][filas - 1] = valor;
+    if (anchos.back() < columna + 1) anchos.back() = static_cast<std::uint32_t>(columna + 1);
+}
+
+void TablaColumnas::agregarFilas(const TablaColumnas& otra) {
+    if (otra.filas == 0) return;
+    if (columnas.size() < otra.columnas.size()) columnas.resize(otra.columnas.size(), std::vector<std::string_view>(filas));
+    for (std::size_t c = 0; c < columnas.size(); ++c) {
+        if (c < otra.columnas.size()) columnas[c].insert(columnas[c].end(), otra.columnas[c].begin(), otra.columnas[c].end());
+        else columnas[c].resize(filas + otra.filas);
     }
-    return {headers, rows};
-}
-
-GestorArchivos::Table GestorArchivos::parseJSON(const std::string& text) const {
-    std::string s = text;
-
-    s.erase(std::remove(s.begin(), s.end(), '\n'), s.end());
-    s.erase(std::remove(s.begin(), s.end(), '\r'), s.end());
-
-    std::vector<string> headers;
-    std::vector<Row> rows;
-
-    size_t pos = 0;
-    while ((pos = s.find('{', pos)) != std::string::npos) {
-        size_t end = s.find('}', pos);
-        if (end == std::string::npos) break;
-        std::string obj = s.substr(pos + 1, end - pos - 1);
-        pos = end + 1;
-
-        std::vector<std::pair<string,string>> pairs;
-        std::string token;
-        int braces = 0;
-        bool inStr = false;
-        for (size_t i = 0; i <= obj.size(); ++i) {
-            char c = (i < obj.size() ? obj[i] : ',');
-            if (c == '"' && (i == 0 || obj[i-1] != '\\')) inStr = !inStr;
-            if (!inStr && braces == 0 && c == ',') {
-                if (!trim(token).empty()) {
-                    auto kv = split(token, ':');
-                    if (kv.size() >= 2) {
-                        string k = trim(kv[0]);
-                        string v = trim(token.substr(token.find(':')+1));
-                        if (k.size() >= 2 && k.front()=='"' && k.back()=='"') k = k.substr(1, k.size()-2);
-                        if (v.size() >= 2 && v.front()=='"' && v.back()=='"') v = v.substr(1, v.size()-2);
-                        pairs.push_back({k, v});
-                    }
-                }
-                token.clear();
-            } else {
-                token.push_back(c);
-            }
-        }
+    anchos.insert(anchos.end(), otra.anchos.begin(), otra.anchos.end());
+    filas += otra.filas;
+}
 
-        if (!pairs.empty()) {
-            
-            if (headers.empty()) {
-                for (auto& p : pairs) headers.push_back(p.first);
+void TablaColumnas::limpiarFilas() {
+    for (auto& c : columnas) c.clear();
+    anchos.clear();
+    filas = 0;
+}
+
+// --------- Parsers ---------
+namespace {
+
+inline void saltarEspacios(const char*& p, const char* fin) {
+    while (p < fin && std::isspace(static_cast<unsigned char>(*p))) ++p;
+}
+
+// Un string JSON entre comillas (p apunta a la que abre); devuelve el contenido
+// sin las comillas y con los escapes tal cual
+std::string_view leerCadenaJSON(const char*& p, const char* fin) {
+    const char* inicio = ++p;
+    while (p < fin && *p != '"') p += (*p == '\\') ? 2 : 1;
+    if (p > fin) p = fin;
+    std::string_view v(inicio, static_cast<std::size_t>(p - inicio));
+    if (p < fin) ++p;
+    return v;
+}
+
+// Una clave o un valor JSON. Los valores anidados ({...} o [...]) se devuelven
+// enteros como texto; los demás sin comillas ni espacios alrededor.
+std::string_view leerValorJSON(const char*& p, const char* fin, bool esClave) {
+    if (p < fin && *p == '"') {
+        std::string_view v = leerCadenaJSON(p, fin);
+        // Lo que sobre hasta el separador no forma parte del valor
+        while (p < fin && *p != ',' && *p != '}' && (!esClave || *p != ':')) ++p;
+        return v;
+    }
+    const char* inicio = p;
+    if (!esClave && p < fin && (*p == '{' || *p == '[')) {
+        int nivel = 0;
+        while (p < fin) {
+            if (*p == '"') {
+                leerCadenaJSON(p, fin);
+                continue;
             }
-            
-            Row r(headers.size(), "");
-            for (auto& p : pairs) {
-                auto it = std::find(headers.begin(), headers.end(), p.first);
-                if (it != headers.end()) {
-                    r[std::distance(headers.begin(), it)] = p.second;
-                }
+            if (*p == '{' || *p == '[') ++nivel;
+            if ((*p == '}' || *p == ']') && --nivel == 0) {
+                ++p;
+                break;
             }
-            rows.push_back(r);
+            ++p;
         }
     }
-    return {headers, rows};
+    while (p < fin && *p != ',' && *p != '}' && (!esClave || *p != ':')) ++p;
+    return recortar(std::string_view(inicio, static_cast<std::size_t>(p - inicio)));
 }
 
+// Busca 'literal' justo en p
+inline bool empiezaCon(const char* p, const char* fin, std::string_view literal) {
+    return static_cast<std::size_t>(fin - p) >= literal.size() && std::memcmp(p, literal.data(), literal.size()) == 0;
+}
 
-GestorArchivos::Table GestorArchivos::parseXML(const std::string& text) const {
-    std::vector<string> headers;
-    std::vector<Row> rows;
+// Ubica cada par de un objeto/fila en su columna: primero se prueba la misma
+// posición que en los encabezados (el caso habitual) y si no, el índice por nombre
+class UbicadorColumnas {
+private:
+    std::unordered_map<std::string_view, std::size_t> indice_;
+    const std::vector<std::string_view>* encabezados_ = nullptr;
+    bool porPosicion_ = true;
+
+public:
+    void definir(const std::vector<std::string_view>& encabezados) {
+        encabezados_ = &encabezados;
+        indice_.reserve(encabezados.size());
+        for (std::size_t i = 0; i < encabezados.size(); ++i) {
+            // Con nombres repetidos vale el primero, y la posición ya no alcanza
+            if (!indice_.emplace(encabezados[i], i).second) porPosicion_ = false;
+        }
+    }
+
+    // Columna de 'nombre', que apareció en la posición 'i' de su fila; -1 si no está
+    long buscar(std::size_t i, std::string_view nombre) const {
+        if (porPosicion_ && i < encabezados_->size() && (*encabezados_)[i] == nombre) return static_cast<long>(i);
+        auto it = indice_.find(nombre);
+        return it == indice_.end() ? -1 : static_cast<long>(it->second);
+    }
+};
+
+// Cierra una fila de pares nombre/valor: el primer objeto con pares define los
+// encabezados, y los nombres que no estén en ellos se descartan
+void agregarFila(TablaColumnas& tabla, UbicadorColumnas& ubicador,
+                 const std::vector<std::pair<std::string_view, std::string_view>>& pares,
+                 std::vector<std::string_view>& nombres) {
+    if (pares.empty()) return;
+    if (!tabla.conEncabezados) {
+        nombres.clear();
+        for (const auto& par : pares) nombres.push_back(par.first);
+        tabla.definirEncabezados(nombres);
+        ubicador.definir(tabla.encabezados);
+    }
+    tabla.nuevaFila();
+    for (std::size_t i = 0; i < pares.size(); ++i) {
+        long c = ubicador.buscar(i, pares[i].first);
+        if (c >= 0) tabla.columnas[static_cast<std::size_t>(c)][tabla.filas - 1] = pares[i].second;
+    }
+    tabla.anchos.back() = static_cast<std::uint32_t>(tabla.encabezados.size());
+}
+
+} // namespace
+
+// Un trozo del CSV que empieza y termina en un límite de registro
+static void parsearTrozoCSV(const char* p, const char* fin, TablaColumnas& tabla) {
+    std::vector<std::string_view> campos;
+    while (p < fin) {
+        p = leerRegistroCSV(p, fin, campos);
+        if (campos.size() == 1 && campos[0].empty()) continue; // línea en blanco
+        tabla.nuevaFila();
+        for (std::size_t i = 0; i < campos.size(); ++i) tabla.poner(i, campos[i]);
+    }
+}
 
-    std::string s = text;
-    s.erase(std::remove(s.begin(), s.end(), '\n'), s.end());
-    s.erase(std::remove(s.begin(), s.end(), '\r'), s.end());
+// Primer límite de registro en o después de 'p', sabiendo si 'p' cae entre comillas
+static const char* siguienteLimiteCSV(const char* p, const char* fin, bool entreComillas) {
+    for (; p < fin; ++p) {
+        if (*p == '"') entreComillas = !entreComillas;
+        else if (*p == '\n' && !entreComillas) return p + 1;
+    }
+    return fin;
+}
 
-    size_t pos = 0;
-    while ((pos = s.find("<row>", pos)) != std::string::npos) {
-        size_t endRow = s.find("</row>", pos);
-        if (endRow == std::string::npos) break;
-        std::string rowBlock = s.substr(pos + 5, endRow - (pos + 5)); 
-        pos = endRow + 6;
+static std::atomic<std::size_t> tamTrozoCSV(1 << 20);
 
-        size_t p2 = 0;
-        std::vector<std::pair<string,string>> cols;
-        while ((p2 = rowBlock.find("<col", p2)) != std::string::npos) {
-            size_t namePos = rowBlock.find("name=\"", p2);
-            if (namePos == std::string::npos) break;
-            namePos += 6;
-            size_t nameEnd = rowBlock.find("\"", namePos);
-            if (nameEnd == std::string::npos) break;
-            string header = rowBlock.substr(namePos, nameEnd - namePos);
+void GestorArchivos::configurarTrozoCSV(std::size_t bytes) {
+    tamTrozoCSV = bytes ? bytes : (1 << 20);
+}
 
-            size_t gt = rowBlock.find(">", nameEnd);
-            if (gt == std::string::npos) break;
-            size_t colEnd = rowBlock.find("</col>", gt);
-            if (colEnd == std::string::npos) break;
-            string value = rowBlock.substr(gt + 1, colEnd - gt - 1);
+void GestorArchivos::parseCSV(std::string_view text, TablaColumnas& tabla, std::size_t filasPorLote,
+                              const PorLote& porLote) const {
+    const std::size_t TAM_TROZO = tamTrozoCSV;
+    const char* p = text.data();
+    const char* fin = p + text.size();
+
+    // Encabezados: el primer registro que no esté en blanco
+    std::vector<std::string_view> campos;
+    while (p < fin && !tabla.conEncabezados) {
+        p = leerRegistroCSV(p, fin, campos);
+        if (!(campos.size() == 1 && campos[0].empty())) tabla.definirEncabezados(campos);
+    }
 
-            cols.push_back({header, value});
-            p2 = colEnd + 6;
+    // El resto se corta en trozos de ~TAM_TROZO que se parsean en paralelo, de a
+    // una ventana de dos trozos por núcleo para acotar la memoria, y se agregan a
+    // la tabla en orden. Un corte nunca cae dentro de un campo entre comillas.
+    const std::size_t porVentana = 2 * std::max(1u, std::thread::hardware_concurrency());
+    std::vector<TablaColumnas> trozos(porVentana);
+    std::vector<const char*> cortes;
+    std::vector<std::size_t> comillas;
+    while (p < fin) {
+        std::size_t n = std::min(porVentana, (static_cast<std::size_t>(fin - p) + TAM_TROZO - 1) / TAM_TROZO);
+        comillas.assign(n, 0);
+        paraCadaEnParalelo(n, [&](std::size_t i) {
+            const char* a = p + i * TAM_TROZO;
+            const char* b = std::min(fin, a + TAM_TROZO);
+            comillas[i] = static_cast<std::size_t>(std::count(a, b, '"'));
+        });
+        // Cada corte es el primer límite de registro después del corte nominal
+        // i*TAM_TROZO; la ventana empieza fuera de comillas, así que la paridad
+        // allí es la de todas las comillas contadas hasta ese punto
+        cortes.assign(1, p);
+        bool entreComillas = false;
+        for (std::size_t i = 0; i < n; ++i) {
+            entreComillas ^= (comillas[i] & 1) != 0;
+            const char* nominal = std::min(fin, p + (i + 1) * TAM_TROZO);
+            cortes.push_back(siguienteLimiteCSV(nominal, fin, entreComillas));
         }
+        paraCadaEnParalelo(n, [&](std::size_t i) {
+            trozos[i].limpiarFilas();
+            parsearTrozoCSV(cortes[i], cortes[i + 1], trozos[i]);
+        });
+        for (std::size_t i = 0; i < n; ++i) {
+            tabla.agregarFilas(trozos[i]);
+            if (tabla.filas >= filasPorLote) {
+                porLote(tabla);
+                tabla.limpiarFilas();
+            }
+        }
+        p = cortes.back();
+    }
+    porLote(tabla);
+}
 
-        if (!cols.empty()) {
-            if (headers.empty()) {
-                for (auto& c : cols) headers.push_back(c.first);
+void GestorArchivos::parseJSON(std::string_view s, TablaColumnas& tabla, std::size_t filasPorLote,
+                               const PorLote& porLote) const {
+    // Un solo recorrido: cada objeto {...} del arreglo es una fila. Los saltos
+    // de línea y espacios entre elementos se saltean sin copiar el texto.
+    UbicadorColumnas ubicador;
+    std::vector<std::pair<std::string_view, std::string_view>> pares;
+    std::vector<std::string_view> nombres;
+    const char* p = s.data();
+    const char* fin = p + s.size();
+    while (p < fin) {
+        const void* llave = std::memchr(p, '{', static_cast<std::size_t>(fin - p));
+        if (!llave) break;
+        p = static_cast<const char*>(llave) + 1;
+
+        pares.clear();
+        bool cerrado = false;
+        while (p < fin) {
+            saltarEspacios(p, fin);
+            if (p >= fin) break;
+            if (*p == '}') {
+                ++p;
+                cerrado = true;
+                break;
             }
-            Row r(headers.size(), "");
-            for (auto& c : cols) {
-                auto it = std::find(headers.begin(), headers.end(), c.first);
-                if (it != headers.end()) {
-                    r[std::distance(headers.begin(), it)] = c.second;
-                }
+            if (*p == ',') {
+                ++p;
+                continue;
             }
-            rows.push_back(r);
+            std::string_view clave = leerValorJSON(p, fin, true);
+            if (p >= fin || *p != ':') continue; // sin ':' no es un par
+            ++p;
+            saltarEspacios(p, fin);
+            std::string_view valor = leerValorJSON(p, fin, false);
+            if (!clave.empty() || !valor.empty()) pares.push_back({clave, valor});
+        }
+        if (!cerrado) break; // objeto cortado al final del archivo
+        agregarFila(tabla, ubicador, pares, nombres);
+        if (tabla.filas >= filasPorLote) {
+            porLote(tabla);
+            tabla.limpiarFilas();
         }
     }
-    return {headers, rows};
+    porLote(tabla);
 }
 
-std::string GestorArchivos::tableToCSV(const Table& t) {
-    std::ostringstream oss;
-    // headers
-    for (std::size_t i = 0; i < t.first.size(); ++i) {
-        if (i) oss << ",";
-        oss << t.first[i];
-    }
-    oss << "\n";
-    // filas
-    for (const Row& r : t.second) {
-        for (std::size_t i = 0; i < r.size(); ++i) {
-            if (i) oss << ",";
-            oss << r[i];
+
+void GestorArchivos::parseXML(std::string_view s, TablaColumnas& tabla, std::size_t filasPorLote,
+                              const PorLote& porLote) const {
+    // Un solo recorrido de etiqueta en etiqueta: <row> abre una fila, cada
+    // <col name="..."> agrega un par y </row> la cierra
+    static const std::string_view ROW = "<row>", FIN_ROW = "</row>", COL = "<col", FIN_COL = "</col>";
+    UbicadorColumnas ubicador;
+    std::vector<std::pair<std::string_view, std::string_view>> pares;
+    std::vector<std::string_view> nombres;
+    bool enFila = false;
+    const char* p = s.data();
+    const char* fin = p + s.size();
+    while (p < fin) {
+        const void* menor = std::memchr(p, '<', static_cast<std::size_t>(fin - p));
+        if (!menor) break;
+        p = static_cast<const char*>(menor);
+
+        if (empiezaCon(p, fin, ROW)) {
+            p += ROW.size();
+            enFila = true;
+            pares.clear();
+        } else if (enFila && empiezaCon(p, fin, FIN_ROW)) {
+            p += FIN_ROW.size();
+            enFila = false;
+            agregarFila(tabla, ubicador, pares, nombres);
+            if (tabla.filas >= filasPorLote) {
+                porLote(tabla);
+                tabla.limpiarFilas();
+            }
+        } else if (enFila && empiezaCon(p, fin, COL)) {
+            std::string_view resto(p, static_cast<std::size_t>(fin - p));
+            std::size_t gt = resto.find('>');
+            if (gt == std::string_view::npos) break;
+            std::string_view etiqueta = resto.substr(0, gt);
+            std::size_t namePos = etiqueta.find("name=\"");
+            std::size_t colEnd = resto.find(FIN_COL, gt);
+            if (colEnd == std::string_view::npos) break;
+            if (namePos != std::string_view::npos) {
+                namePos += 6;
+                std::size_t nameEnd = etiqueta.find('"', namePos);
+                if (nameEnd != std::string_view::npos) {
+                    pares.push_back({etiqueta.substr(namePos, nameEnd - namePos), resto.substr(gt + 1, colEnd - gt - 1)});
+                }
+            }
+            p += colEnd + FIN_COL.size();
+        } else {
+            ++p;
         }
-        oss << "\n";
     }
-    return oss.str();
+    porLote(tabla);
 }
 
-std::string GestorArchivos::tableToJSON(const Table& t) {
-    std::ostringstream oss;
-    oss << "[\n";
-    for (std::size_t r = 0; r < t.second.size(); ++r) {
-        oss << "  {";
-        for (std::size_t c = 0; c < t.first.size(); ++c) {
-            if (c) oss << ", ";
-            oss << "\"" << t.first[c] << "\":\"" << (c < t.second[r].size() ? t.second[r][c] : "") << "\"";
+void GestorArchivos::parseTabla(std::string_view text, TablaColumnas& tabla, std::size_t filasPorLote,
+                                const PorLote& porLote) const {
+    std::string ext = detectExtension(name_);
+    if (ext == "csv")  return parseCSV(text, tabla, filasPorLote, porLote);
+    if (ext == "json") return parseJSON(text, tabla, filasPorLote, porLote);
+    if (ext == "xml")  return parseXML(text, tabla, filasPorLote, porLote);
+    
+    std::string_view t = recortar(text);
+    if (!t.empty() && t.front() == '[') return parseJSON(text, tabla, filasPorLote, porLote);
+    if (!t.empty() && t.front() == '<') return parseXML(text, tabla, filasPorLote, porLote);
+    return parseCSV(text, tabla, filasPorLote, porLote); 
+}
+
+// Celda de JSON/XML: un campo CSV entre comillas se escribe sin ellas, con cada
+// "" como la comilla escapada del formato de destino
+static void agregarCelda(std::string& linea, std::string_view celda, char formato) {
+    if (celda.size() < 2 || celda.front() != '"' || celda.back() != '"') {
+        linea += celda;
+        return;
+    }
+    const char* comilla = formato == 'j' ? "\\\"" : "&quot;";
+    for (std::size_t i = 1; i + 1 < celda.size(); ++i) {
+        if (celda[i] != '"') {
+            linea += celda[i];
+            continue;
         }
-        oss << "}";
-        if (r + 1 < t.second.size()) oss << ",";
-        oss << "\n";
+        linea += comilla;
+        if (celda[i + 1] == '"' && i + 2 < celda.size()) ++i;
     }
-    oss << "]";
-    return oss.str();
 }
 
-std::string GestorArchivos::tableToXML(const Table& t) {
-    std::ostringstream oss;
-    oss << "<rows>\n";
-    for (const Row& r : t.second) {
-        oss << "  <row>\n";
-        for (std::size_t c = 0; c < t.first.size(); ++c) {
-            oss << "    <col name=\"" << t.first[c] << "\">"
-                << (c < r.size() ? r[c] : "") << "</col>\n";
+// Cada fila se arma en 'linea' y se escribe de una vez; la tabla sólo guarda
+// un lote de filas por vez
+bool GestorArchivos::exportarDesde(std::string_view text, std::ostream& destino, char formato,
+                                   ArchivoMapeado* mapa) const {
+    static const std::size_t FILAS_POR_LOTE = 4096;
+    const char f = static_cast<char>(std::tolower(static_cast<unsigned char>(formato)));
+    if (f != 'c' && f != 'j' && f != 'x') {
+        std::cerr << "Error: formato de exportación desconocido: " << formato << std::endl;
+        return false;
+    }
+    TablaColumnas tabla;
+    bool encabezadoEscrito = false;
+    std::size_t filas = 0;
+    std::string linea;
+
+    if (f == 'j') destino << "[\n";
+    if (f == 'x') destino << "<rows>\n";
+    parseTabla(text, tabla, FILAS_POR_LOTE, [&](TablaColumnas& lote) {
+        if (f == 'c' && !encabezadoEscrito && lote.conEncabezados) {
+            linea.clear();
+            for (std::size_t i = 0; i < lote.encabezados.size(); ++i) {
+                if (i) linea += ',';
+                linea += lote.encabezados[i];
+            }
+            linea += '\n';
+            destino.write(linea.data(), static_cast<std::streamsize>(linea.size()));
+            encabezadoEscrito = true;
+        }
+        const std::vector<std::string_view>& headers = lote.encabezados;
+        for (std::size_t r = 0; r < lote.filas; ++r) {
+            if (f == 'c') {
+                linea.clear();
+                for (std::size_t i = 0; i < lote.anchos[r]; ++i) {
+                    if (i) linea += ',';
+                    linea += lote.columnas[i][r];
+                }
+                linea += '\n';
+            } else if (f == 'j') {
+                linea.assign(filas ? ",\n  {" : "  {");
+                for (std::size_t c = 0; c < headers.size(); ++c) {
+                    if (c) linea += ", ";
+                    linea += '"';
+                    linea += headers[c];
+                    linea += "\":\"";
+                    agregarCelda(linea, lote.columnas[c][r], f);
+                    linea += '"';
+                }
+                linea += '}';
+            } else {
+                linea.assign("  <row>\n");
+                for (std::size_t c = 0; c < headers.size(); ++c) {
+                    linea += "    <col name=\"";
+                    linea += headers[c];
+                    linea += "\">";
+                    agregarCelda(linea, lote.columnas[c][r], f);
+                    linea += "</col>\n";
+                }
+                linea += "  </row>\n";
+            }
+            destino.write(linea.data(), static_cast<std::streamsize>(linea.size()));
+            ++filas;
+        }
+        // Las páginas del archivo ya convertidas se devuelven al sistema
+        if (mapa && lote.filas > 0) {
+            for (const auto& columna : lote.columnas) {
+                if (!columna.empty() && columna.back().data()) {
+                    mapa->liberarHasta(static_cast<std::size_t>(columna.back().data() - text.data()));
+                    break;
+                }
+            }
         }
-        oss << "  </row>\n";
+    });
+    if (f == 'c' && !encabezadoEscrito) destino << "\n";
+    if (f == 'j') destino << (filas ? "\n]" : "]");
+    if (f == 'x') destino << "</rows>";
+    return static_cast<bool>(destino);
+}
+
+bool GestorArchivos::exportar(std::ostream& destino, char formato) {
+    // Se usa el mapeo del modo "m" si ya está abierto
+    if (mapa_.abierto()) return exportarDesde(mapa_.contenido(), destino, formato);
+    ArchivoMapeado archivo;
+    if (!archivo.abrir(name_)) return exportarDesde(std::string_view(), destino, formato);
+    return exportarDesde(archivo.contenido(), destino, formato, &archivo);
+}
+
+bool GestorArchivos::exportar(const std::string& rutaDestino, char formato) {
+    // Como el modo "w": el destino se reemplaza al terminar, nunca se trunca
+    const std::string temporal = rutaTemporal(rutaDestino);
+    std::ofstream destino(temporal, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!destino) {
+        std::cerr << "Error: no se pudo crear " << temporal << std::endl;
+        return false;
     }
-    oss << "</rows>";
-    return oss.str();
+    bool ok = exportar(destino, formato) && destino.flush();
+    destino.close();
+    std::error_code ec;
+    if (ok) fs::rename(temporal, rutaDestino, ec);
+    if (!ok || ec) {
+        std::cerr << "Error: no se pudo escribir " << rutaDestino << (ec ? ": " + ec.message() : std::string()) << std::endl;
+        fs::remove(temporal, ec);
+        return false;
+    }
+    return true;
 }
 
-GestorArchivos::Table GestorArchivos::readAsTable() const {
-    std::string ext = detectExtension(name_);
-    std::string text = readAll();
-    if (ext == "csv")  return parseCSV(text);
-    if (ext == "json") return parseJSON(text);
-    if (ext == "xml")  return parseXML(text);
-    
-    std::string t = trim(text);
-    if (!t.empty() && t.front() == '[') return parseJSON(text);
-    if (!t.empty() && t.front() == '<') return parseXML(text);
-    return parseCSV(text); 
+bool GestorArchivos::exportarArchivo(const std::string& origen, const std::string& rutaDestino, char formato) {
+    GestorArchivos archivo; // sin el updateDimension del constructor con nombre
+    archivo.name_ = origen;
+    return archivo.exportar(rutaDestino, formato);
+}
+
+bool GestorArchivos::getTabla(TablaColumnas& tabla) {
+    tabla = TablaColumnas();
+    if (!mapa_.abierto() && !open("m")) return false;
+    parseTabla(mapa_.contenido(), tabla, static_cast<std::size_t>(-1), [](TablaColumnas&) {});
+    return true;
+}
+
+std::string GestorArchivos::convertir(char formato) {
+    std::ostringstream oss;
+    exportar(oss, formato);
+    return oss.str();
 }
 
-std::string GestorArchivos::getCsv()  { return tableToCSV (readAsTable()); }
-std::string GestorArchivos::getJson() { return tableToJSON(readAsTable()); }
-std::string GestorArchivos::getXml()  { return tableToXML (readAsTable()); }
+std::string GestorArchivos::getCsv()  { return convertir('c'); }
+std::string GestorArchivos::getJson() { return convertir('j'); }
+std::string GestorArchivos::getXml()  { return convertir('x'); }
 
 std::string GestorArchivos::buildPathCSV(const std::string& baseName) {
     namespace fs = std::filesystem;
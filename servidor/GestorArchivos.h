@@ -8,6 +8,27 @@
 #include <map>
 #include <ostream>
 #include <iostream>
+#include <string_view>
+#include <functional>
+#include <cstdint>
+#include "IndiceLineas.h"
+#include "ArchivoMapeado.h"
+
+// Tabla leída de un CSV/JSON/XML, guardada por columnas: columnas[c][fila]. Las
+// celdas son vistas sobre el texto leído, que debe vivir mientras se use la tabla.
+struct TablaColumnas {
+    bool conEncabezados = false;
+    std::vector<std::string_view> encabezados;
+    std::vector<std::vector<std::string_view>> columnas;
+    std::vector<std::uint32_t> anchos; // celdas presentes en cada fila (un CSV puede tener filas cortas)
+    std::size_t filas = 0;
+
+    void definirEncabezados(const std::vector<std::string_view>& nombres);
+    void nuevaFila();                                  // fila vacía al final
+    void poner(std::size_t columna, std::string_view valor); // en la última fila
+    void agregarFilas(const TablaColumnas& otra);      // las filas de 'otra' al final
+    void limpiarFilas();                               // conserva encabezados y memoria reservada
+};
 
 class GestorArchivos {
 private:
@@ -18,29 +39,42 @@ private:
 
     std::fstream fs_;         
     std::string openMode_;    
+    std::string temporal_;    // modo "w": lo que se escribe hasta que close() lo renombra
     std::size_t nextLineIdx_; 
 
+    // Comienzos de línea (persistidos en la caché de IndiceLineas) y lector para getLine(idx)
+    mutable IndiceLineas indice_;
+    std::ifstream lector_;
+    unsigned long generacionLector_;
+
+    ArchivoMapeado mapa_;     // modo "m": el archivo entero como vista, sin copiarlo
+
     static std::string nowAsString();
     static std::string detectExtension(const std::string& path);
     static std::string trim(const std::string& s);
     static std::vector<std::string> split(const std::string& s, char delim);
 
     bool fileExists(const std::string& path) const;
+    void separarEnlace();
+    void publicarTemporal(bool escrito);
     void updateDimension() const; 
-    std::string readAll() const;  
 
-    using Row   = std::vector<std::string>;
-    using Table = std::pair<std::vector<std::string>, std::vector<Row>>;
+    // Los parsers recorren el texto una sola vez y escriben las celdas en la
+    // tabla. Cada 'filasPorLote' filas (y al final) llaman a porLote y la vacían,
+    // así exportar no necesita tener el archivo entero como tabla. parseCSV
+    // parsea trozos de ~1 MB en paralelo y entrega de a trozos enteros, así que
+    // sus lotes pueden pasar de 'filasPorLote'.
+    using PorLote = std::function<void(TablaColumnas&)>;
 
-    Table parseCSV(const std::string& text) const;
-    Table parseJSON(const std::string& text) const;
-    Table parseXML (const std::string& text) const;
+    void parseCSV(std::string_view text, TablaColumnas& tabla, std::size_t filasPorLote, const PorLote& porLote) const;
+    void parseJSON(std::string_view text, TablaColumnas& tabla, std::size_t filasPorLote, const PorLote& porLote) const;
+    void parseXML (std::string_view text, TablaColumnas& tabla, std::size_t filasPorLote, const PorLote& porLote) const;
+    void parseTabla(std::string_view text, TablaColumnas& tabla, std::size_t filasPorLote,
+                    const PorLote& porLote) const; // según la extensión
 
-    static std::string tableToCSV (const Table& t);
-    static std::string tableToJSON(const Table& t);
-    static std::string tableToXML (const Table& t);
-
-    Table readAsTable() const;
+    bool exportarDesde(std::string_view text, std::ostream& destino, char formato,
+                       ArchivoMapeado* mapa = nullptr) const;
+    std::string convertir(char formato);
 
 public:
     // Constructores pedidos
@@ -49,15 +83,35 @@ public:
     GestorArchivos(const std::string& name, const std::string& datetime); // sólo nombre y fecha
 
     // Operaciones principales
-    bool open(const std::string& mode = "r"); 
-    void close();
+    bool open(const std::string& mode = "r"); // "r", "w", "a" o "m" (lectura mapeada)
+    void close();  // en modo "w" reemplaza el archivo por lo escrito
+
+    // Todo el archivo como vista, mapeado en memoria (abre en modo "m" si hace
+    // falta). Vale hasta close(), write() u otro open().
+    std::string_view getContenido();
 
     std::string getCsv();   // leer el archivo y devolverlo como CSV
     std::string getJson();  // leer el archivo y devolverlo como JSON
     std::string getXml();   // leer el archivo y devolverlo como XML
 
+    // Convierte el archivo a CSV/JSON/XML ('c', 'j', 'x') escribiendo cada fila
+    // en 'destino' apenas se lee: la memoria no depende del tamaño del archivo
+    bool exportar(std::ostream& destino, char formato);
+    bool exportar(const std::string& rutaDestino, char formato);
+    // Lo mismo para un archivo que sólo se convierte: no se indexa (ni deja su
+    // índice en la caché), como haría construir un GestorArchivos con su nombre
+    static bool exportarArchivo(const std::string& origen, const std::string& rutaDestino, char formato);
+    // Tamaño nominal de los trozos que parseCSV reparte entre hilos (0 vuelve al
+    // valor por defecto, 1 MB); con uno mayor que el archivo el parseo es secuencial
+    static void configurarTrozoCSV(std::size_t bytes);
+
+    // El archivo entero como tabla por columnas (lo abre en modo "m"); las
+    // celdas valen hasta close(), write() u otro open()
+    bool getTabla(TablaColumnas& tabla);
+
     std::string getLine();                 // siguiente línea disponible (modo lectura)
-    std::string getLine(std::size_t idx);  // línea N. Devuelve "" si no existe.
+    std::string getLine(std::size_t idx);  // línea N (desde 1), sin leer las anteriores. Devuelve "" si no existe.
+    bool getLine(std::string& line);       // siguiente línea; false al llegar al final (distingue líneas vacías)
 
     void write(const std::string& data);   // escribe al archivo
 
@@ -3,29 +3,52 @@
 #include <sstream>
 #include <fstream>
 #include <algorithm>
-#include <regex>
+#include <cstdlib>
+#include <cctype>
 #include <cmath>
 #include <thread>
 #include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <sys/stat.h>
 
 GestorCodigoG::GestorCodigoG(const std::string& puertoSerial) 
-    : serial_(std::make_unique<Serial>()),
+    : serial_(std::make_unique<Serial>(puertoSerial)),
       modoTrabajo_(ModoTrabajo::MANUAL),
       modoCoordenadas_(ModoCoordenas::ABSOLUTO),
-      posicionActual_(0, 0, 0),
       posicionOrigen_(0, 0, 0),
       velocidadActual_(1000.0),
       efectorActivo_(false),
       robotConectado_(false),
-      aprendiendoTrayectoria_(false) {
+      aprendiendoTrayectoria_(false),
+      planificador_(),
+      planificacionActiva_(true),
+      simplificador_(),
+      simplificacionActiva_(false),
+      interpoladorArcos_(),
+      espacioTrabajo_(),
+      estadoEjecucion_(EstadoEjecucion::INACTIVO),
+      contadorPrograma_(0),
+      pasosPendientes_(0),
+      tramosArcoEnviados_(0),
+      ultimaEjecucionExitosa_(true),
+      cargaIncremental_(false),
+      comandosLeidos_(0),
+      cargaTerminada_(true),
+      umbralCargaIncremental_(1u << 20),
+      monitorPosicion_(),
+      periodoTelemetriaMs_(200) {
     
     // Inicializar comunicación serie
     if (!serial_->abrirPuerto()) {
-        std::cerr << "Warning: No se pudo abrir puerto serie " << puertoSerial << std::endl;
+        std::cerr << "Warning: No se pudo abrir puerto serie "
+                  << (puertoSerial.empty() ? "(ninguno encontrado)" : puertoSerial) << std::endl;
     }
 }
 
 GestorCodigoG::~GestorCodigoG() {
+    detenerEjecucion();
+    esperarFinEjecucion();
     desconectarRobot();
 }
 
@@ -56,6 +79,7 @@ bool GestorCodigoG::conectarRobot() {
         return false;
     }
     std::cout << "Homing completado." << std::endl;
+    actualizarPosicionComandada(posicionOrigen_);
     
     // Configurar modo absoluto
     std::cout << "Configurando modo absoluto..." << std::endl;
@@ -64,23 +88,34 @@ bool GestorCodigoG::conectarRobot() {
         return false;
     }
     
-    // Solicitar posición actual
+    // Conectado antes de pedir la posición: solicitarPosicionActual no envía nada
+    // sin conexión, y así la primera medida se publica antes de arrancar el sondeo
+    robotConectado_ = true;
     std::string respuesta = solicitarPosicionActual();
+    Punto3D medida;
+    if (MonitorPosicion::parsearM114(respuesta, medida)) {
+        monitorPosicion_.publicarMedida(medida);
+    }
     if (!respuesta.empty()) {
         std::cout << "Robot conectado. Posición inicial: " << respuesta << std::endl;
     } else {
         std::cout << "Robot conectado (posición en origen después de homing)" << std::endl;
     }
     
-    robotConectado_ = true;
+    monitorPosicion_.iniciar([this](Punto3D& p) { return muestrearPosicion(p); }, periodoTelemetriaMs_);
     return true;
 }
 
 void GestorCodigoG::desconectarRobot() {
     if (robotConectado_) {
+        // Primero se detiene cualquier ejecución en curso
+        detenerEjecucion();
+        esperarFinEjecucion();
+        
         // Desactivar efector y motores antes de desconectar
         desactivarEfectorFinal();
         enviarComandoASerial("M84"); // Desactivar motores
+        monitorPosicion_.detener();
         serial_->cerrarPuerto();
         robotConectado_ = false;
         std::cout << "Robot desconectado" << std::endl;
@@ -88,6 +123,9 @@ void GestorCodigoG::desconectarRobot() {
 }
 
 bool GestorCodigoG::configurarModoTrabajo(ModoTrabajo modo) {
+    if (rechazarSiEjecutando("Cambio de modo")) {
+        return false;
+    }
     modoTrabajo_ = modo;
     std::cout << "Modo de trabajo cambiado a: " 
               << (modo == ModoTrabajo::MANUAL ? "MANUAL" : "AUTOMÁTICO") << std::endl;
@@ -95,6 +133,10 @@ bool GestorCodigoG::configurarModoTrabajo(ModoTrabajo modo) {
 }
 
 bool GestorCodigoG::configurarModoCoordenadas(ModoCoordenas modo) {
+    // Un programa en curso interpreta sus coordenadas con el modo del firmware
+    if (rechazarSiEjecutando("Cambio de modo de coordenadas")) {
+        return false;
+    }
     if (!robotConectado_) {
         std::cerr << "Error: Robot no conectado" << std::endl;
         return false;
@@ -113,105 +155,157 @@ bool GestorCodigoG::configurarModoCoordenadas(ModoCoordenas modo) {
 }
 
 bool GestorCodigoG::validarPosicion(const Posicion& pos) const {
-    // Calcular módulo cuadrado de la posición (más eficiente que sqrt)
-    double squaredPositionModule = sq(pos.x) + sq(pos.y);
-    
-    // Validar límites usando módulo cuadrado y coordenada Z - similar al firmware
-    bool posicionValida = squaredPositionModule <= sq(R_MAX) 
-                      && squaredPositionModule >= sq(R_MIN) 
-                      && pos.z >= Z_MIN  
-                      && pos.z <= Z_MAX;
-    
-    if (!posicionValida) {
-        double r = std::sqrt(squaredPositionModule);
-        if (squaredPositionModule < sq(R_MIN) || squaredPositionModule > sq(R_MAX)) {
-            std::cerr << "Error: Posición radial fuera de límites [" << R_MIN << ", " << R_MAX << "] - actual: " << r << std::endl;
-        }
-        if (pos.z < Z_MIN || pos.z > Z_MAX) {
-            std::cerr << "Error: Posición Z fuera de límites [" << Z_MIN << ", " << Z_MAX << "] - actual: " << pos.z << std::endl;
-        }
-        return false;
+    // Envolvente del firmware; sin salida, el diagnóstico lo da validarPosicionInformando
+    return espacioTrabajo_.esAlcanzable(pos.x, pos.y, pos.z);
+}
+
+bool GestorCodigoG::validarPosicionInformando(const Posicion& pos) const {
+    if (validarPosicion(pos)) {
+        return true;
     }
-    
-    return true;
+    std::cerr << "Error: " << espacioTrabajo_.diagnosticar(pos.x, pos.y, pos.z) << std::endl;
+    return false;
 }
 
 double GestorCodigoG::calcularDistanciaRadial(double x, double y) const {
     return std::sqrt(x * x + y * y);
 }
 
-bool GestorCodigoG::validarComandoG(const std::string& comando) const {
-    // Extraer solo la parte del comando antes del comentario
-    std::string comandoLimpio = comando;
-    size_t pos = comandoLimpio.find(';');
-    if (pos != std::string::npos) {
-        comandoLimpio = comandoLimpio.substr(0, pos);
+// Código que el servidor interpreta según la letra y el número de la primera palabra
+static OperacionG clasificarOperacion(char letra, int numero) {
+    if (letra == 'M') {
+        return numero == 3 ? OperacionG::M3 : numero == 5 ? OperacionG::M5 : OperacionG::OTRA;
     }
-    
-    // Remover espacios al final
-    comandoLimpio.erase(comandoLimpio.find_last_not_of(" \t\r\n") + 1);
-    
-    if (comandoLimpio.empty()) {
-        return false;
+    switch (numero) {
+        case 0:  return OperacionG::G0;
+        case 1:  return OperacionG::G1;
+        case 2:  return OperacionG::G2;
+        case 3:  return OperacionG::G3;
+        case 28: return OperacionG::G28;
+        case 90: return OperacionG::G90;
+        case 91: return OperacionG::G91;
+        default: return OperacionG::OTRA;
     }
-    
-    // Validación básica de formato G-Code (más flexible)
-    std::regex gcode_pattern(R"(^[GM]\d+(\s+[XYZFES][-+]?\d*\.?\d*)*\s*$)");
-    return std::regex_match(comandoLimpio, gcode_pattern);
 }
 
-ComandoG GestorCodigoG::parsearComandoG(const std::string& comando) const {
-    ComandoG cmd;
-    cmd.comando = comando;
-    cmd.valido = validarComandoG(comando);
-    
-    if (!cmd.valido) {
-        return cmd;
+bool GestorCodigoG::esComandoArco(const ComandoG& cmd) {
+    return cmd.esArco();
+}
+
+bool GestorCodigoG::esComandoMovimiento(const ComandoG& cmd) {
+    return cmd.esMovimiento();
+}
+
+// Analiza una línea G-Code en una sola pasada, sin expresiones regulares. Acepta el
+// formato ^[GM]\d+(\s+[XYZFESIJR][-+]?\d*\.?\d*)*\s*$ sobre la parte anterior a ';'.
+// Una palabra X/Y/Z/F/I/J/R repetida invalida la línea: el firmware se quedaría con
+// otro valor que el validado. Si llega sin dígitos no cuenta como presente y la
+// línea se conserva tal cual. Devuelve el largo de la parte útil (sin comentario ni
+// espacios finales) o 0 si la línea no es válida. 'conservarTexto' indica que los
+// campos de cmd no bastan para regenerar la línea.
+static size_t escanearComandoG(const std::string& linea, ComandoG& cmd, bool& conservarTexto) {
+    size_t fin = linea.find(';');
+    if (fin == std::string::npos) {
+        fin = linea.size();
     }
-    
-    // Extraer solo la parte del comando antes del comentario para el parseo
-    std::string comandoLimpio = comando;
-    size_t pos = comandoLimpio.find(';');
-    if (pos != std::string::npos) {
-        comandoLimpio = comandoLimpio.substr(0, pos);
+    while (fin > 0 && (linea[fin - 1] == ' ' || linea[fin - 1] == '\t' || linea[fin - 1] == '\r' || linea[fin - 1] == '\n')) {
+        --fin;
     }
     
-    // Extraer coordenadas usando regex
-    std::regex x_pattern(R"(X\s*([-+]?\d*\.?\d+))");
-    std::regex y_pattern(R"(Y\s*([-+]?\d*\.?\d+))");
-    std::regex z_pattern(R"(Z\s*([-+]?\d*\.?\d+))");
-    std::regex f_pattern(R"(F\s*([-+]?\d*\.?\d+))");
-    
-    std::smatch match;
-    
-    if (std::regex_search(comandoLimpio, match, x_pattern)) {
-        cmd.posicion.x = std::stod(match[1]);
-    }
-    if (std::regex_search(comandoLimpio, match, y_pattern)) {
-        cmd.posicion.y = std::stod(match[1]);
+    const char* p = linea.c_str();
+    if (fin < 2 || (p[0] != 'G' && p[0] != 'M') || !std::isdigit(static_cast<unsigned char>(p[1]))) {
+        return 0;
     }
-    if (std::regex_search(comandoLimpio, match, z_pattern)) {
-        cmd.posicion.z = std::stod(match[1]);
-    }
-    if (std::regex_search(comandoLimpio, match, f_pattern)) {
-        cmd.velocidad = std::stod(match[1]);
+    
+    size_t i = 1;
+    int numero = 0;
+    while (i < fin && std::isdigit(static_cast<unsigned char>(p[i]))) {
+        if (numero < 10000) {
+            numero = numero * 10 + (p[i] - '0');
+        }
+        ++i;
     }
+    cmd.operacion = clasificarOperacion(p[0], numero);
     
-    // Determinar descripción del comando
-    if (comandoLimpio.find("G28") != std::string::npos) {
-        cmd.descripcion = "Home - Ir a origen";
-    } else if (comandoLimpio.find("G1") != std::string::npos || comandoLimpio.find("G0") != std::string::npos) {
-        cmd.descripcion = "Movimiento lineal";
-    } else if (comandoLimpio.find("M3") != std::string::npos) {
-        cmd.descripcion = "Activar efector";
-    } else if (comandoLimpio.find("M5") != std::string::npos) {
-        cmd.descripcion = "Desactivar efector";
-    } else if (comandoLimpio.find("G90") != std::string::npos) {
-        cmd.descripcion = "Modo absoluto";
-    } else {
-        cmd.descripcion = "Comando G-Code";
+    while (i < fin) {
+        // Cada palabra va precedida de al menos un espacio
+        if (!std::isspace(static_cast<unsigned char>(p[i]))) {
+            return 0;
+        }
+        while (i < fin && std::isspace(static_cast<unsigned char>(p[i]))) {
+            ++i;
+        }
+        if (i >= fin) {
+            break;
+        }
+        
+        char letra = p[i];
+        std::int32_t* destino = nullptr;
+        unsigned bit = 0;
+        switch (letra) {
+            case 'X': destino = &cmd.x; bit = EJE_X;     break;
+            case 'Y': destino = &cmd.y; bit = EJE_Y;     break;
+            case 'Z': destino = &cmd.z; bit = EJE_Z;     break;
+            case 'F': destino = &cmd.f; bit = PALABRA_F; break;
+            case 'I': destino = &cmd.i; bit = PALABRA_I; break;
+            case 'J': destino = &cmd.j; bit = PALABRA_J; break;
+            case 'R': destino = &cmd.r; bit = PALABRA_R; break;
+            case 'E':
+            case 'S': conservarTexto = true; break; // se aceptan y se envían, pero no se usan
+            default: return 0;
+        }
+        
+        size_t inicioValor = ++i;
+        if (i < fin && (p[i] == '+' || p[i] == '-')) {
+            ++i;
+        }
+        size_t digitos = 0;
+        while (i < fin && std::isdigit(static_cast<unsigned char>(p[i]))) {
+            ++i;
+            ++digitos;
+        }
+        if (i < fin && p[i] == '.') {
+            ++i;
+            while (i < fin && std::isdigit(static_cast<unsigned char>(p[i]))) {
+                ++i;
+                ++digitos;
+            }
+        }
+        
+        if (destino && (cmd.palabras & bit)) {
+            return 0;
+        }
+        if (destino && digitos == 0) {
+            conservarTexto = true;
+        } else if (destino) {
+            double valor = std::strtod(p + inicioValor, nullptr);
+            *destino = ComandoG::aFijo(valor);
+            cmd.palabras |= static_cast<std::uint8_t>(bit);
+            if (ComandoG::deFijo(*destino) != valor) {
+                conservarTexto = true; // más de tres decimales o fuera de rango
+            }
+        }
     }
     
+    return fin;
+}
+
+bool GestorCodigoG::validarComandoG(const std::string& comando) const {
+    ComandoG descartado;
+    bool conservarTexto = false;
+    return escanearComandoG(comando, descartado, conservarTexto) > 0;
+}
+
+ComandoG GestorCodigoG::parsearComandoG(const std::string& comando, TextosPrograma* textos) const {
+    ComandoG cmd;
+    bool conservarTexto = false;
+    size_t largo = escanearComandoG(comando, cmd, conservarTexto);
+    cmd.valido = largo > 0;
+    
+    // Sólo se guarda el texto que no puede regenerarse; los comentarios se descartan
+    if (textos && cmd.valido && (conservarTexto || cmd.operacion == OperacionG::OTRA)) {
+        cmd.textoOriginal = textos->agregar(std::string_view(comando).substr(0, largo));
+    }
     return cmd;
 }
 
@@ -229,9 +323,10 @@ Posicion GestorCodigoG::coordenadasXYZAComandoG(double x, double y, double z) co
     
     // Si estamos en modo relativo, ajustar respecto a posición actual
     if (modoCoordenadas_ == ModoCoordenas::RELATIVO) {
-        pos.x += posicionActual_.x;
-        pos.y += posicionActual_.y;
-        pos.z += posicionActual_.z;
+        Posicion actual = posicionComandada();
+        pos.x += actual.x;
+        pos.y += actual.y;
+        pos.z += actual.z;
     }
     
     return pos;
@@ -243,6 +338,7 @@ bool GestorCodigoG::enviarComandoASerial(const std::string& comando) {
         return false;
     }
     
+    std::lock_guard<std::mutex> lock(mtxSerial_);
     if (!serial_->enviarComando(comando)) {
         std::cerr << "Error enviando comando: " << comando << std::endl;
         return false;
@@ -260,6 +356,7 @@ bool GestorCodigoG::enviarComandoASerial(const std::string& comando) {
 }
 
 bool GestorCodigoG::enviarComandoConEspera(const std::string& comando, int tiempoEsperaMs) {
+    std::lock_guard<std::mutex> lock(mtxSerial_);
     if (!serial_->enviarComando(comando)) {
         std::cerr << "Error enviando comando: " << comando << std::endl;
         return false;
@@ -292,6 +389,7 @@ std::string GestorCodigoG::solicitarPosicionActual() {
         return "";
     }
     
+    std::lock_guard<std::mutex> lock(mtxSerial_);
     if (!serial_->enviarComando("M114")) {
         return "";
     }
@@ -299,11 +397,43 @@ std::string GestorCodigoG::solicitarPosicionActual() {
     return serial_->leerPuerto(2000);
 }
 
+bool GestorCodigoG::muestrearPosicion(Punto3D& posicion) {
+    // El sondeo nunca retrasa al ejecutor ni a los comandos manuales: durante una
+    // ejecución no se sondea (la posición comandada ya se publica en cada envío) y
+    // si el puerto está ocupado se omite la muestra de este ciclo. La espera de la
+    // respuesta no se acorta: una respuesta tardía quedaría en el puerto y la
+    // leería el comando siguiente como suya
+    if (estadoEjecucion_ == EstadoEjecucion::EJECUTANDO) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(mtxSerial_, std::try_to_lock);
+    if (!lock.owns_lock() || !robotConectado_) {
+        return false;
+    }
+    if (!serial_->enviarComando("M114")) {
+        return false;
+    }
+    return MonitorPosicion::parsearM114(serial_->leerPuerto(std::max(periodoTelemetriaMs_.load(), 100)), posicion);
+}
+
+void GestorCodigoG::actualizarPosicionComandada(const Posicion& pos) {
+    // La única copia es la del monitor: se publica entera y se lee sin cerrojos
+    monitorPosicion_.publicarComandada(Punto3D(pos.x, pos.y, pos.z));
+}
+
+void GestorCodigoG::configurarTelemetria(int periodoMs) {
+    periodoTelemetriaMs_ = periodoMs;
+    if (robotConectado_) {
+        monitorPosicion_.iniciar([this](Punto3D& p) { return muestrearPosicion(p); }, periodoTelemetriaMs_);
+    }
+}
+
 std::string GestorCodigoG::solicitarEstadoRobot() {
     if (!robotConectado_) {
         return "Robot desconectado";
     }
     
+    std::lock_guard<std::mutex> lock(mtxSerial_);
     if (!serial_->enviarComando("M115")) {
         return "Error consultando estado";
     }
@@ -313,6 +443,9 @@ std::string GestorCodigoG::solicitarEstadoRobot() {
 }
 
 bool GestorCodigoG::irAPosicionOrigen() {
+    if (rechazarSiEjecutando("Ir a origen")) {
+        return false;
+    }
     if (modoTrabajo_ != ModoTrabajo::MANUAL) {
         std::cerr << "Error: Función solo disponible en modo manual" << std::endl;
         return false;
@@ -325,7 +458,7 @@ bool GestorCodigoG::irAPosicionOrigen() {
     
     std::cout << "Enviando robot a posición de origen..." << std::endl;
     if (enviarComandoConEspera("G28", 5000)) { // 5 segundos para homing
-        posicionActual_ = posicionOrigen_;
+        actualizarPosicionComandada(posicionOrigen_);
         return true;
     }
     
@@ -333,6 +466,9 @@ bool GestorCodigoG::irAPosicionOrigen() {
 }
 
 bool GestorCodigoG::moverEfectorConVelocidad(double x, double y, double z, double velocidad) {
+    if (rechazarSiEjecutando("Movimiento manual")) {
+        return false;
+    }
     if (modoTrabajo_ != ModoTrabajo::MANUAL) {
         std::cerr << "Error: Función solo disponible en modo manual" << std::endl;
         return false;
@@ -340,7 +476,7 @@ bool GestorCodigoG::moverEfectorConVelocidad(double x, double y, double z, doubl
     
     Posicion nuevaPos = coordenadasXYZAComandoG(x, y, z);
     
-    if (!validarPosicion(nuevaPos)) {
+    if (!validarPosicionInformando(nuevaPos)) {
         return false;
     }
     
@@ -351,7 +487,7 @@ bool GestorCodigoG::moverEfectorConVelocidad(double x, double y, double z, doubl
     
     std::string comando = posicionAComandoG(nuevaPos, velocidad);
     if (enviarComandoConEspera(comando, 1000)) { // 1 segundo para movimientos
-        posicionActual_ = nuevaPos;
+        actualizarPosicionComandada(nuevaPos);
         velocidadActual_ = velocidad;
         
         // Si estamos aprendiendo, capturar automáticamente el comando
@@ -374,6 +510,9 @@ bool GestorCodigoG::moverEfectorSinVelocidad(double x, double y, double z) {
 }
 
 bool GestorCodigoG::activarEfectorFinal() {
+    if (rechazarSiEjecutando("Activar efector")) {
+        return false;
+    }
     if (!robotConectado_) {
         std::cerr << "Error: Robot no conectado" << std::endl;
         return false;
@@ -399,6 +538,10 @@ bool GestorCodigoG::activarEfectorFinal() {
 }
 
 bool GestorCodigoG::desactivarEfectorFinal() {
+    // Durante una ejecución se usa detenerEjecucion o paradaEmergencia (que envía M5 directamente)
+    if (rechazarSiEjecutando("Desactivar efector")) {
+        return false;
+    }
     if (!robotConectado_) {
         return true; // Ya está desactivado
     }
@@ -423,6 +566,9 @@ bool GestorCodigoG::desactivarEfectorFinal() {
 }
 
 bool GestorCodigoG::iniciarAprendizajeTrayectoria(const std::string& nombreTrayectoria) {
+    if (rechazarSiEjecutando("Aprendizaje")) {
+        return false;
+    }
     if (modoTrabajo_ != ModoTrabajo::MANUAL) {
         std::cerr << "Error: Aprendizaje solo disponible en modo manual" << std::endl;
         return false;
@@ -437,6 +583,10 @@ bool GestorCodigoG::iniciarAprendizajeTrayectoria(const std::string& nombreTraye
 }
 
 bool GestorCodigoG::agregarPasoTrayectoria(double x, double y, double z, double velocidad) {
+    // trayectoriaAprendida_ es el programa que está leyendo el ejecutor
+    if (rechazarSiEjecutando("Agregar paso")) {
+        return false;
+    }
     if (nombreTrayectoriaActual_.empty()) {
         std::cerr << "Error: No se ha iniciado el aprendizaje de trayectoria" << std::endl;
         return false;
@@ -444,31 +594,36 @@ bool GestorCodigoG::agregarPasoTrayectoria(double x, double y, double z, double
     
     Posicion nuevaPos = coordenadasXYZAComandoG(x, y, z);
     
-    if (!validarPosicion(nuevaPos)) {
+    if (!validarPosicionInformando(nuevaPos)) {
         return false;
     }
     
     ComandoG cmd;
-    cmd.comando = posicionAComandoG(nuevaPos, velocidad > 0 ? velocidad : velocidadActual_);
-    cmd.descripcion = "Movimiento aprendido";
-    cmd.posicion = nuevaPos;
-    cmd.velocidad = velocidad > 0 ? velocidad : velocidadActual_;
+    cmd.operacion = OperacionG::G1;
+    cmd.fijarPosicion(nuevaPos);
+    cmd.f = ComandoG::aFijo(velocidad > 0 ? velocidad : velocidadActual_.load());
+    if (cmd.f > 0) {
+        cmd.palabras |= PALABRA_F;
+    }
     cmd.valido = true;
     
     trayectoriaAprendida_.push_back(cmd);
-    std::cout << "Paso agregado a trayectoria: " << cmd.comando << std::endl;
+    std::cout << "Paso agregado a trayectoria: " << cmd.texto() << std::endl;
     
     // Ejecutar el movimiento inmediatamente en modo aprendizaje
-    return moverEfectorConVelocidad(x, y, z, cmd.velocidad);
+    return moverEfectorConVelocidad(x, y, z, cmd.velocidad());
 }
 
 bool GestorCodigoG::agregarComandoGTrayectoria(const std::string& comandoG) {
+    if (rechazarSiEjecutando("Agregar comando")) {
+        return false;
+    }
     if (nombreTrayectoriaActual_.empty()) {
         std::cerr << "Error: No se ha iniciado el aprendizaje de trayectoria" << std::endl;
         return false;
     }
     
-    ComandoG cmd = parsearComandoG(comandoG);
+    ComandoG cmd = parsearComandoG(comandoG, &trayectoriaAprendida_.textos);
     if (!cmd.valido) {
         std::cerr << "Error: Comando G-Code inválido: " << comandoG << std::endl;
         return false;
@@ -482,6 +637,9 @@ bool GestorCodigoG::agregarComandoGTrayectoria(const std::string& comandoG) {
 }
 
 bool GestorCodigoG::finalizarAprendizajeTrayectoria(const std::string& usuario) {
+    if (rechazarSiEjecutando("Finalizar aprendizaje")) {
+        return false;
+    }
     if (nombreTrayectoriaActual_.empty()) {
         std::cerr << "Error: No hay trayectoria en progreso" << std::endl;
         return false;
@@ -498,6 +656,12 @@ bool GestorCodigoG::finalizarAprendizajeTrayectoria(const std::string& usuario)
         nombreCompleto += "_" + usuario;
     }
     
+    if (simplificacionActiva_) {
+        ResultadoSimplificacion r = simplificarTrayectoria();
+        std::cout << "Simplificación: " << r.puntosOriginales << " -> " << r.puntosResultantes
+                  << " puntos (-" << r.reduccionPorcentual() << "%)" << std::endl;
+    }
+    
     if (guardarTrayectoria(nombreCompleto)) {
         std::cout << "Trayectoria '" << nombreCompleto 
                   << "' guardada con " << trayectoriaAprendida_.size() << " pasos" << std::endl;
@@ -510,6 +674,9 @@ bool GestorCodigoG::finalizarAprendizajeTrayectoria(const std::string& usuario)
 }
 
 bool GestorCodigoG::cancelarAprendizajeTrayectoria() {
+    if (rechazarSiEjecutando("Cancelar aprendizaje")) {
+        return false;
+    }
     trayectoriaAprendida_.clear();
     nombreTrayectoriaActual_.clear();
     aprendiendoTrayectoria_ = false;
@@ -520,7 +687,10 @@ bool GestorCodigoG::cancelarAprendizajeTrayectoria() {
 bool GestorCodigoG::guardarTrayectoria(const std::string& nombreArchivo) {
     try {
         GestorArchivos gestor(nombreArchivo + ".gcode");
-        gestor.open("w");
+        if (!gestor.open("w")) {
+            std::cerr << "Error: No se pudo crear " << nombreArchivo << ".gcode" << std::endl;
+            return false;
+        }
         
         // Escribir header
         gestor.write("; Trayectoria generada por GestorCodigoG\n");
@@ -529,8 +699,8 @@ bool GestorCodigoG::guardarTrayectoria(const std::string& nombreArchivo) {
         gestor.write("G28 ; Home\n");
         
         // Escribir comandos de la trayectoria
-        for (const auto& cmd : trayectoriaAprendida_) {
-            gestor.write(cmd.comando + " ; " + cmd.descripcion + "\n");
+        for (const auto& cmd : trayectoriaAprendida_.comandos) {
+            gestor.write(trayectoriaAprendida_.texto(cmd) + " ; " + cmd.descripcion() + "\n");
         }
         
         gestor.write("M5 ; Desactivar efector\n");
@@ -544,7 +714,7 @@ bool GestorCodigoG::guardarTrayectoria(const std::string& nombreArchivo) {
     }
 }
 
-bool GestorCodigoG::cargarArchivoGCode(const std::string& nombreArchivo) {
+bool GestorCodigoG::leerProgramaGCode(const std::string& nombreArchivo, ProgramaG& programa) const {
     try {
         GestorArchivos gestor(nombreArchivo);
         if (!gestor.exist()) {
@@ -553,24 +723,25 @@ bool GestorCodigoG::cargarArchivoGCode(const std::string& nombreArchivo) {
         }
         
         gestor.open("r");
-        trayectoriaAprendida_.clear();
+        programa.clear();
         
+        // Los arcos dependen de dónde empieza el programa: no se validan aquí sino
+        // al usarlo (validarArcosPrograma, validarPrograma), así el resultado sirve
+        // para cualquier posición del robot
         std::string linea;
-        while (!(linea = gestor.getLine()).empty()) {
+        while (gestor.getLine(linea)) {
             // Saltar comentarios y líneas vacías
             if (linea.empty() || linea[0] == ';') {
                 continue;
             }
             
-            ComandoG cmd = parsearComandoG(linea);
+            ComandoG cmd = parsearComandoG(linea, &programa.textos);
             if (cmd.valido) {
-                trayectoriaAprendida_.push_back(cmd);
+                programa.push_back(cmd);
             }
         }
         
         gestor.close();
-        std::cout << "Archivo G-Code cargado: " << nombreArchivo 
-                  << " (" << trayectoriaAprendida_.size() << " comandos)" << std::endl;
         return true;
         
     } catch (const std::exception& e) {
@@ -579,35 +750,147 @@ bool GestorCodigoG::cargarArchivoGCode(const std::string& nombreArchivo) {
     }
 }
 
+bool GestorCodigoG::validarArcosPrograma(const ProgramaG& programa, const Posicion& inicio) const {
+    // Mismo recorrido modal que validarPrograma, pero sólo se generan los puntos de los arcos
+    Posicion posicion = inicio;
+    bool relativo = false; // los programas empiezan en modo absoluto (ver bucleEjecucion)
+    for (size_t i = 0; i < programa.size(); ++i) {
+        const ComandoG& cmd = programa[i];
+        if (!cmd.valido) {
+            continue;
+        }
+        if (esComandoArco(cmd)) {
+            if (!validarArco(cmd, posicion, relativo)) {
+                std::cerr << "Error: Arco inválido o fuera del espacio de trabajo en el comando " << (i + 1)
+                          << ": " << programa.texto(cmd) << std::endl;
+                return false;
+            }
+            Punto3D fin = definirArco(cmd, posicion, relativo).fin;
+            posicion = Posicion(fin.x, fin.y, fin.z);
+        } else if (esComandoMovimiento(cmd)) {
+            posicion = cmd.destino(posicion, relativo);
+        } else if (cmd.operacion == OperacionG::G28) {
+            posicion = posicionOrigen_;
+        } else if (cmd.operacion == OperacionG::G90 || cmd.operacion == OperacionG::G91) {
+            relativo = cmd.operacion == OperacionG::G91;
+        }
+    }
+    return true;
+}
+
+// Memoria aproximada de un programa, para el presupuesto de la caché
+static size_t memoriaPrograma(const ProgramaG& programa) {
+    // Los comandos no reservan memoria propia; sólo suman los textos conservados
+    return sizeof(programa) + programa.comandos.capacity() * sizeof(ComandoG) + programa.textos.bytes();
+}
+
+CacheProgramas::Programa GestorCodigoG::prepararPrograma(const std::string& nombreArchivo, bool* desdeCache,
+                                                         ResultadoSimplificacion* simplificacion) const {
+    if (desdeCache) *desdeCache = false;
+    
+    // La preparación depende sólo del archivo y de si se simplifica (no de dónde esté
+    // el robot, así que repetir un programa acierta); los cambios de tolerancia vacían la caché.
+    // La clave es el inodo: los nombres enlazados al mismo objeto del AlmacenGCode
+    // comparten la entrada y el contenido se prepara una sola vez
+    FirmaPrograma firma;
+    std::string clave;
+    struct stat st;
+    bool conFirma = stat(nombreArchivo.c_str(), &st) == 0;
+    if (conFirma) {
+        clave = std::to_string(st.st_dev) + ":" + std::to_string(st.st_ino);
+        firma.bytes = static_cast<std::uint64_t>(st.st_size);
+        firma.fecha = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        firma.contexto = simplificacionActiva_ ? 1 : 0;
+        
+        CacheProgramas::Programa programa = cacheProgramas_.buscar(clave, firma);
+        if (programa) {
+            if (desdeCache) *desdeCache = true;
+            return programa;
+        }
+    }
+    
+    auto programa = std::make_shared<ProgramaG>();
+    if (!leerProgramaGCode(nombreArchivo, *programa)) {
+        return nullptr;
+    }
+    if (simplificacionActiva_) {
+        ResultadoSimplificacion r = simplificarPrograma(*programa);
+        if (simplificacion) *simplificacion = r;
+    }
+    programa->comandos.shrink_to_fit();
+    programa->textos.compactar();
+    if (conFirma) {
+        cacheProgramas_.guardar(clave, firma, programa, memoriaPrograma(*programa));
+    }
+    return programa;
+}
+
+bool GestorCodigoG::cargarArchivoGCode(const std::string& nombreArchivo) {
+    if (rechazarSiEjecutando("Carga de archivo")) {
+        return false;
+    }
+    trayectoriaAprendida_.clear();
+    cargaIncremental_ = false;
+    bool desdeCache = false;
+    ResultadoSimplificacion simplificacion;
+    CacheProgramas::Programa programa = prepararPrograma(nombreArchivo, &desdeCache, &simplificacion);
+    if (!programa) {
+        return false;
+    }
+    // Lo único que depende de la posición del robot; el resto se valida al ejecutar
+    if (!validarArcosPrograma(*programa, posicionComandada())) {
+        return false;
+    }
+    // Copia propia: el planificador y la ejecución modifican la trayectoria cargada
+    trayectoriaAprendida_ = *programa;
+    
+    std::cout << "Archivo G-Code cargado: " << nombreArchivo 
+              << " (" << trayectoriaAprendida_.size() << " comandos" << (desdeCache ? ", desde caché" : "") << ")" << std::endl;
+    
+    if (simplificacionActiva_ && !desdeCache) {
+        std::cout << "Simplificación: " << simplificacion.puntosOriginales << " -> " << simplificacion.puntosResultantes
+                  << " puntos (-" << simplificacion.reduccionPorcentual() << "%)" << std::endl;
+    }
+    return true;
+}
+
 bool GestorCodigoG::ejecutarComandoGDirecto(const std::string& comandoG) {
     if (!robotConectado_) {
         std::cerr << "Error: Robot no conectado" << std::endl;
         return false;
     }
     
+    if (rechazarSiEjecutando("Comando directo")) {
+        return false;
+    }
+    
     ComandoG cmd = parsearComandoG(comandoG);
     if (!cmd.valido) {
         std::cerr << "Error: Comando G-Code inválido: " << comandoG << std::endl;
         return false;
     }
     
+    // Los arcos se convierten en tramos rectos antes de enviarlos
+    if (esComandoArco(cmd)) {
+        size_t tramos = 0;
+        return ejecutarArco(cmd, 1000, posicionComandada(), tramos);
+    }
+    
     // Validar posición si es comando de movimiento
-    if (comandoG.find("G1") != std::string::npos || comandoG.find("G0") != std::string::npos) {
-        Posicion nuevaPos = cmd.posicion;
-        if (modoCoordenadas_ == ModoCoordenas::RELATIVO) {
-            nuevaPos.x += posicionActual_.x;
-            nuevaPos.y += posicionActual_.y;
-            nuevaPos.z += posicionActual_.z;
-        }
+    if (esComandoMovimiento(cmd)) {
+        Posicion nuevaPos = cmd.destino(posicionComandada(), modoCoordenadas_ == ModoCoordenas::RELATIVO);
         
-        if (!validarPosicion(nuevaPos)) {
+        if (!validarPosicionInformando(nuevaPos)) {
             return false;
         }
         
         if (enviarComandoASerial(comandoG)) {
-            posicionActual_ = nuevaPos;
+            actualizarPosicionComandada(nuevaPos);
             return true;
         }
+    } else if (cmd.operacion == OperacionG::G90 || cmd.operacion == OperacionG::G91) {
+        return configurarModoCoordenadas(cmd.operacion == OperacionG::G91 ? ModoCoordenas::RELATIVO
+                                                                            : ModoCoordenas::ABSOLUTO);
     } else {
         // Otros comandos (M, G28, etc.)
         return enviarComandoASerial(comandoG);
@@ -616,11 +899,10 @@ bool GestorCodigoG::ejecutarComandoGDirecto(const std::string& comandoG) {
     return false;
 }
 
-Posicion GestorCodigoG::obtenerPosicionActual() {
-    std::string respuesta = solicitarPosicionActual();
-    // Aquí se podría parsear la respuesta para actualizar posicionActual_
-    // Por ahora devolvemos la posición almacenada localmente
-    return posicionActual_;
+Posicion GestorCodigoG::obtenerPosicionActual() const {
+    std::shared_ptr<const MuestraPosicion> muestra = monitorPosicion_.obtener();
+    const Punto3D& p = muestra->actual();
+    return Posicion(p.x, p.y, p.z);
 }
 
 std::string GestorCodigoG::obtenerEstadoRobot() const {
@@ -629,7 +911,10 @@ std::string GestorCodigoG::obtenerEstadoRobot() const {
     estado << "- Conectado: " << (robotConectado_ ? "Sí" : "No") << "\n";
     estado << "- Modo trabajo: " << (modoTrabajo_ == ModoTrabajo::MANUAL ? "Manual" : "Automático") << "\n";
     estado << "- Modo coordenadas: " << (modoCoordenadas_ == ModoCoordenas::ABSOLUTO ? "Absoluto" : "Relativo") << "\n";
-    estado << "- Posición actual: X" << posicionActual_.x << " Y" << posicionActual_.y << " Z" << posicionActual_.z << "\n";
+    std::shared_ptr<const MuestraPosicion> muestra = monitorPosicion_.obtener();
+    const Punto3D& pos = muestra->actual();
+    estado << "- Posición actual: X" << pos.x << " Y" << pos.y << " Z" << pos.z
+           << (muestra->actualEsMedida() ? " (reportada por el robot)" : " (comandada)") << "\n";
     estado << "- Velocidad actual: " << velocidadActual_ << "\n";
     estado << "- Efector activo: " << (efectorActivo_ ? "Sí" : "No") << "\n";
     
@@ -651,12 +936,371 @@ std::string GestorCodigoG::obtenerEspacioTrabajoInfo() const {
 }
 
 void GestorCodigoG::limpiarTrayectoriaActual() {
+    if (rechazarSiEjecutando("Limpiar trayectoria")) {
+        return;
+    }
     trayectoriaAprendida_.clear();
     nombreTrayectoriaActual_.clear();
     std::cout << "Trayectoria actual limpiada" << std::endl;
 }
 
-bool GestorCodigoG::ejecutarTrayectoriaCargada() {
+void GestorCodigoG::configurarLatencias(const LatenciasFirmware& latencias) {
+    std::lock_guard<std::mutex> lock(mtxLatencias_);
+    latencias_ = latencias;
+}
+
+LatenciasFirmware GestorCodigoG::obtenerLatencias() const {
+    std::lock_guard<std::mutex> lock(mtxLatencias_);
+    return latencias_;
+}
+
+void GestorCodigoG::configurarPlanificador(const ConfiguracionPlanificador& config, bool activo) {
+    planificador_.configurar(config);
+    planificacionActiva_ = activo;
+}
+
+ResultadoPlanificacion GestorCodigoG::planificarTrayectoria() {
+    return planificarPrograma(trayectoriaAprendida_, posicionComandada());
+}
+
+ResultadoPlanificacion GestorCodigoG::planificarPrograma(ProgramaG& programa, const Posicion& inicioPrograma,
+                                                         std::vector<SegmentoPlan>* detalle) const {
+    ResultadoPlanificacion total;
+    double sumaUnion = 0.0;
+    
+    // Se planifica por bloques de movimientos consecutivos: cualquier otro comando
+    // (M3, M5, G28...) obliga a detenerse antes de enviarlo. Los movimientos en
+    // modo relativo (G91) tampoco se planifican: se envían tal como vinieron.
+    Posicion posicion = inicioPrograma;  // posición modal tras cada comando
+    Posicion inicio = posicion;          // inicio del bloque en curso
+    bool relativo = false; // los programas empiezan en modo absoluto (ver bucleEjecucion)
+    double avance = velocidadActual_;
+    std::vector<SegmentoPlan> bloque;
+    std::vector<size_t> indices;
+    if (detalle) {
+        detalle->assign(programa.size(), SegmentoPlan());
+    }
+    
+    auto cerrarBloque = [&]() {
+        if (bloque.empty()) {
+            return;
+        }
+        ResultadoPlanificacion r = planificador_.planificar(inicio.x, inicio.y, inicio.z, bloque);
+        for (size_t k = 0; k < bloque.size(); ++k) {
+            // Se envía con todos los ejes y la velocidad ajustada (ver ComandoG::texto)
+            ComandoG& cmd = programa[indices[k]];
+            cmd.fijarPosicion(Posicion(bloque[k].x, bloque[k].y, bloque[k].z));
+            cmd.fPlan = ComandoG::aFijo(std::round(bloque[k].velocidadAjustada));
+            cmd.textoOriginal = 0;
+            cmd.enlazado = bloque[k].velocidadSalida >= planificador_.obtenerConfiguracion().velocidadMinima;
+            if (detalle) {
+                (*detalle)[indices[k]] = bloque[k];
+            }
+        }
+        total.segmentos += r.segmentos;
+        total.paradasSinPlanificar += r.paradasSinPlanificar;
+        total.paradasPlanificadas += r.paradasPlanificadas;
+        sumaUnion += r.velocidadMediaUnion * r.segmentos;
+        
+        bloque.clear();
+        indices.clear();
+    };
+    
+    for (size_t i = 0; i < programa.size(); ++i) {
+        ComandoG& cmd = programa[i];
+        cmd.enlazado = false;
+        if (!cmd.valido) {
+            continue;
+        }
+        
+        if (esComandoMovimiento(cmd)) {
+            if (cmd.f > 0) {
+                avance = cmd.velocidad();
+            }
+            Posicion destino = cmd.destino(posicion, relativo);
+            if (relativo) {
+                cerrarBloque();
+            } else {
+                if (bloque.empty()) {
+                    inicio = posicion;
+                }
+                bloque.push_back(SegmentoPlan(destino.x, destino.y, destino.z, avance));
+                indices.push_back(i);
+            }
+            posicion = destino;
+        } else {
+            cerrarBloque();
+            if (esComandoArco(cmd)) {
+                Punto3D fin = definirArco(cmd, posicion, relativo).fin;
+                posicion = Posicion(fin.x, fin.y, fin.z);
+            } else if (cmd.operacion == OperacionG::G28) {
+                posicion = posicionOrigen_;
+            } else if (cmd.operacion == OperacionG::G90 || cmd.operacion == OperacionG::G91) {
+                relativo = cmd.operacion == OperacionG::G91;
+            }
+        }
+    }
+    cerrarBloque();
+    
+    if (total.segmentos > 0) {
+        total.velocidadMediaUnion = sumaUnion / static_cast<double>(total.segmentos);
+    }
+    return total;
+}
+
+void GestorCodigoG::configurarSimplificacion(double toleranciaMm, bool activa) {
+    simplificador_.configurarTolerancia(toleranciaMm);
+    simplificacionActiva_ = activa;
+    cacheProgramas_.vaciar(); // los programas guardados se simplificaron con la tolerancia anterior
+}
+
+ResultadoSimplificacion GestorCodigoG::simplificarTrayectoria() {
+    return simplificarPrograma(trayectoriaAprendida_);
+}
+
+ResultadoSimplificacion GestorCodigoG::simplificarPrograma(ProgramaG& programa) const {
+    ResultadoSimplificacion resultado;
+    std::vector<ComandoG> simplificada;
+    simplificada.reserve(programa.size());
+    
+    // Los destinos se siguen de forma modal desde el inicio del programa. Sólo se
+    // simplifica cuando no dependen de dónde empiece el robot (el programa ya fijó
+    // los tres ejes) y hasta el primer G91: desde ahí se conserva tal cual.
+    const int TODOS_LOS_EJES = EJE_X | EJE_Y | EJE_Z;
+    Posicion posicion;
+    int ejesConocidos = 0;
+    
+    const size_t n = programa.size();
+    size_t i = 0;
+    while (i < n) {
+        const ComandoG& cmd = programa[i];
+        if (cmd.valido && cmd.operacion == OperacionG::G91) {
+            simplificada.insert(simplificada.end(), programa.comandos.begin() + i, programa.comandos.end());
+            break;
+        }
+        if (!cmd.valido || !esComandoMovimiento(cmd) || ejesConocidos != TODOS_LOS_EJES || cmd.textoOriginal != 0) {
+            if (esComandoMovimiento(cmd) && cmd.valido) {
+                posicion = cmd.destino(posicion);
+                ejesConocidos |= cmd.palabras & TODOS_LOS_EJES;
+            } else if (esComandoArco(cmd) && cmd.valido) {
+                Punto3D fin = definirArco(cmd, posicion).fin;
+                posicion = Posicion(fin.x, fin.y, fin.z);
+                ejesConocidos |= cmd.palabras & TODOS_LOS_EJES;
+            } else if (cmd.operacion == OperacionG::G28 && cmd.valido) {
+                posicion = posicionOrigen_;
+                ejesConocidos = TODOS_LOS_EJES;
+            }
+            simplificada.push_back(cmd);
+            ++i;
+            continue;
+        }
+        
+        // Tramo de movimientos consecutivos del mismo tipo y con la misma velocidad
+        // (los que conservan su texto original no se tocan)
+        size_t fin = i + 1;
+        while (fin < n) {
+            const ComandoG& sig = programa[fin];
+            if (!sig.valido || !esComandoMovimiento(sig) || sig.f != cmd.f || sig.operacion != cmd.operacion ||
+                sig.textoOriginal != 0) {
+                break;
+            }
+            ++fin;
+        }
+        
+        std::vector<Punto3D> puntos;
+        puntos.reserve(fin - i);
+        for (size_t k = i; k < fin; ++k) {
+            posicion = programa[k].destino(posicion);
+            puntos.emplace_back(posicion.x, posicion.y, posicion.z);
+        }
+        
+        std::vector<size_t> conservados = simplificador_.simplificar(puntos);
+        for (size_t idx : conservados) {
+            ComandoG conservado = programa[i + idx];
+            // Los ejes ausentes tomaban el valor de un comando que pudo descartarse
+            if ((conservado.palabras & TODOS_LOS_EJES) != TODOS_LOS_EJES) {
+                conservado.fijarPosicion(Posicion(puntos[idx].x, puntos[idx].y, puntos[idx].z));
+            }
+            simplificada.push_back(conservado);
+        }
+        
+        resultado.puntosOriginales += fin - i;
+        resultado.puntosResultantes += conservados.size();
+        i = fin;
+    }
+    
+    // Los comandos conservados siguen apuntando a los mismos textos
+    programa.comandos.swap(simplificada);
+    return resultado;
+}
+
+void GestorCodigoG::configurarInterpolacionArcos(double toleranciaCuerdaMm) {
+    interpoladorArcos_.configurarToleranciaCuerda(toleranciaCuerdaMm);
+}
+
+DefinicionArco GestorCodigoG::definirArco(const ComandoG& cmd, const Posicion& inicio, bool relativo) const {
+    DefinicionArco arco;
+    arco.inicio = Punto3D(inicio.x, inicio.y, inicio.z);
+    // El fin se resuelve como el de un G1 (ejes ausentes y modo relativo); I/J
+    // siempre son desplazamientos desde el inicio
+    Posicion fin = cmd.destino(inicio, relativo);
+    arco.fin = Punto3D(fin.x, fin.y, fin.z);
+    arco.i = ComandoG::deFijo(cmd.i);
+    arco.j = ComandoG::deFijo(cmd.j);
+    arco.radio = cmd.radio();
+    arco.horario = cmd.operacion == OperacionG::G2;
+    return arco;
+}
+
+bool GestorCodigoG::validarArco(const ComandoG& cmd, const Posicion& inicio, bool relativo) const {
+    // Sin salida por punto: quien llama informa del comando que falla
+    return interpoladorArcos_.interpolar(definirArco(cmd, inicio, relativo), [this](const Punto3D& p) {
+        return validarPosicion(Posicion(p.x, p.y, p.z));
+    });
+}
+
+bool GestorCodigoG::ejecutarArco(const ComandoG& cmd, int tiempoEsperaMs, const Posicion& inicio,
+                                 size_t& tramosEnviados, bool* interrumpido) {
+    // Al retomar un arco interrumpido se regeneran los mismos tramos desde su inicio
+    // original y se omiten los que ya se enviaron. En modo relativo cada tramo se
+    // envía como desplazamiento desde el punto anterior.
+    const bool relativo = modoCoordenadas_ == ModoCoordenas::RELATIVO;
+    size_t tramo = 0;
+    Posicion anterior = inicio;
+    bool exito = interpoladorArcos_.interpolar(definirArco(cmd, inicio, relativo), [&](const Punto3D& p) {
+        Posicion destino(p.x, p.y, p.z);
+        Posicion desde = anterior;
+        anterior = destino;
+        if (tramo++ < tramosEnviados) {
+            return true;
+        }
+        if (interrumpido && debeInterrumpir()) {
+            *interrumpido = true;
+            return false;
+        }
+        if (!validarPosicionInformando(destino)) {
+            return false;
+        }
+        Posicion enviado = relativo ? Posicion(destino.x - desde.x, destino.y - desde.y, destino.z - desde.z)
+                                    : destino;
+        if (!enviarComandoConEspera(posicionAComandoG(enviado, cmd.velocidad()), tiempoEsperaMs)) {
+            return false;
+        }
+        actualizarPosicionComandada(destino);
+        ++tramosEnviados;
+        return true;
+    });
+    
+    if (!exito && !(interrumpido && *interrumpido)) {
+        std::cerr << "Error ejecutando arco tras " << tramosEnviados << " tramos: " << cmd.texto() << std::endl;
+    }
+    return exito;
+}
+
+ResultadoValidacionLote GestorCodigoG::validarTrayectoriaCompleta() const {
+    return validarPrograma(trayectoriaAprendida_, posicionComandada());
+}
+
+ResultadoValidacionLote GestorCodigoG::validarPrograma(const ProgramaG& programa, const Posicion& inicio) const {
+    ValidadorLote lote(espacioTrabajo_);
+    lote.reservar(programa.size());
+    
+    // Se recorre el programa igual que el ejecutor para conocer el inicio de cada arco
+    Posicion posicion = inicio;
+    bool relativo = false; // los programas empiezan en modo absoluto (ver bucleEjecucion)
+    for (size_t i = 0; i < programa.size(); ++i) {
+        const ComandoG& cmd = programa[i];
+        if (!cmd.valido) {
+            continue;
+        }
+        if (esComandoArco(cmd)) {
+            DefinicionArco arco = definirArco(cmd, posicion, relativo);
+            bool geometriaValida = interpoladorArcos_.interpolar(arco, [&](const Punto3D& p) {
+                lote.agregar(p.x, p.y, p.z, i);
+                return true;
+            });
+            if (!geometriaValida) {
+                // Un punto fuera antes del arco sigue siendo el primer error del programa
+                ResultadoValidacionLote resultado = lote.validar();
+                if (resultado.valido) {
+                    resultado.valido = false;
+                    resultado.arcoInvalido = true;
+                    resultado.origenInvalido = i;
+                    resultado.posicionInvalida = arco.fin;
+                }
+                return resultado;
+            }
+            posicion = Posicion(arco.fin.x, arco.fin.y, arco.fin.z);
+        } else if (esComandoMovimiento(cmd)) {
+            posicion = cmd.destino(posicion, relativo);
+            lote.agregar(posicion.x, posicion.y, posicion.z, i);
+        } else if (cmd.operacion == OperacionG::G28) {
+            posicion = posicionOrigen_;
+        } else if (cmd.operacion == OperacionG::G90 || cmd.operacion == OperacionG::G91) {
+            relativo = cmd.operacion == OperacionG::G91;
+        }
+    }
+    
+    return lote.validar();
+}
+
+Posicion GestorCodigoG::posicionComandada() const {
+    std::shared_ptr<const MuestraPosicion> muestra = monitorPosicion_.obtener();
+    const Punto3D& p = muestra->comandada;
+    return Posicion(p.x, p.y, p.z);
+}
+
+std::string GestorCodigoG::diagnosticarValidacion(const ResultadoValidacionLote& validacion) const {
+    if (validacion.arcoInvalido) {
+        return "Arco inválido (el fin no está sobre el círculo del centro o radio indicado)";
+    }
+    const Punto3D& p = validacion.posicionInvalida;
+    return espacioTrabajo_.diagnosticar(p.x, p.y, p.z);
+}
+
+const char* GestorCodigoG::nombreEstadoEjecucion(EstadoEjecucion estado) {
+    switch (estado) {
+        case EstadoEjecucion::INACTIVO:   return "inactivo";
+        case EstadoEjecucion::EJECUTANDO: return "ejecutando";
+        case EstadoEjecucion::PAUSANDO:   return "pausando";
+        case EstadoEjecucion::PAUSADO:    return "pausado";
+        case EstadoEjecucion::DETENIENDO: return "deteniendo";
+    }
+    return "desconocido";
+}
+
+bool GestorCodigoG::rechazarSiEjecutando(const char* operacion) const {
+    EstadoEjecucion estado = estadoEjecucion_.load();
+    if (estado == EstadoEjecucion::INACTIVO) {
+        return false;
+    }
+    std::cerr << "Error: " << operacion << " no disponible durante una ejecución ("
+              << nombreEstadoEjecucion(estado) << ")" << std::endl;
+    return true;
+}
+
+void GestorCodigoG::notificarEjecucion() {
+    if (observadorEjecucion_) {
+        observadorEjecucion_(estadoEjecucion_.load(), contadorPrograma_.load(), obtenerTotalComandos());
+    }
+}
+
+bool GestorCodigoG::debeInterrumpir() const {
+    EstadoEjecucion estado = estadoEjecucion_.load();
+    return estado == EstadoEjecucion::PAUSANDO || estado == EstadoEjecucion::DETENIENDO;
+}
+
+size_t GestorCodigoG::obtenerTotalComandos() const {
+    // En carga incremental sólo se conocen los comandos leídos hasta ahora
+    return cargaIncremental_ ? comandosLeidos_.load() : trayectoriaAprendida_.size();
+}
+
+std::string GestorCodigoG::obtenerMensajeEjecucion() const {
+    std::lock_guard<std::mutex> lock(mtxEjecucion_);
+    return mensajeEjecucion_;
+}
+
+bool GestorCodigoG::verificarEjecucionPosible() const {
     if (modoTrabajo_ != ModoTrabajo::AUTOMATICO) {
         std::cerr << "Error: Debe estar en modo automático para ejecutar trayectorias" << std::endl;
         return false;
@@ -666,55 +1310,696 @@ bool GestorCodigoG::ejecutarTrayectoriaCargada() {
         std::cerr << "Error: Robot no conectado" << std::endl;
         return false;
     }
+    return true;
+}
+
+bool GestorCodigoG::prepararEjecucion() {
+    if (!verificarEjecucionPosible()) {
+        return false;
+    }
     
     if (trayectoriaAprendida_.empty()) {
         std::cerr << "Error: No hay trayectoria cargada para ejecutar" << std::endl;
         return false;
     }
     
-    std::cout << "Iniciando ejecución de trayectoria (" << trayectoriaAprendida_.size() << " comandos)..." << std::endl;
+    if (planificacionActiva_) {
+        ResultadoPlanificacion plan = planificarTrayectoria();
+        std::cout << "Planificador: " << plan.segmentos << " tramos, paradas completas "
+                  << plan.paradasSinPlanificar << " -> " << plan.paradasPlanificadas
+                  << ", velocidad media en vértices " << plan.velocidadMediaUnion << " mm/min" << std::endl;
+    }
+    
+    // Todas las posiciones se validan antes de mover el robot
+    ResultadoValidacionLote validacion = validarTrayectoriaCompleta();
+    if (!validacion.valido) {
+        const ComandoG& cmd = trayectoriaAprendida_[validacion.origenInvalido];
+        std::cerr << "Error: Programa rechazado en el comando " << (validacion.origenInvalido + 1)
+                  << " (" << trayectoriaAprendida_.texto(cmd) << "): " << diagnosticarValidacion(validacion) << std::endl;
+        return false;
+    }
+    std::cout << "Validación: " << validacion.puntosEvaluados << " puntos dentro del espacio de trabajo ("
+              << validacion.implementacion << ")" << std::endl;
+    return true;
+}
+
+bool GestorCodigoG::iniciarEjecucion(size_t desdeComando, bool enPausa) {
+    if (rechazarSiEjecutando("Nueva ejecución")) {
+        return false;
+    }
+    if (hiloEjecucion_.joinable()) {
+        hiloEjecucion_.join(); // hilo de una ejecución anterior ya terminada
+    }
+    
+    cargaIncremental_ = false;
+    if (!prepararEjecucion()) {
+        return false;
+    }
+    if (desdeComando >= trayectoriaAprendida_.size()) {
+        std::cerr << "Error: Comando inicial fuera de rango: " << (desdeComando + 1) << std::endl;
+        return false;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mtxEjecucion_);
+        contadorPrograma_ = desdeComando;
+        pasosPendientes_ = 0;
+        tramosArcoEnviados_ = 0;
+        mensajeEjecucion_ = "En ejecución";
+        estadoEjecucion_ = enPausa ? EstadoEjecucion::PAUSADO : EstadoEjecucion::EJECUTANDO;
+    }
+    notificarEjecucion();
+    
+    std::cout << "Iniciando ejecución de trayectoria (" << trayectoriaAprendida_.size() << " comandos";
+    if (desdeComando > 0) {
+        std::cout << ", desde el comando " << (desdeComando + 1);
+    }
+    std::cout << ")..." << std::endl;
+    
+    hiloEjecucion_ = std::thread(&GestorCodigoG::bucleEjecucion, this);
+    return true;
+}
+
+bool GestorCodigoG::convieneCargaIncremental(const std::string& nombreArchivo) const {
+    std::error_code ec;
+    auto tamano = std::filesystem::file_size(nombreArchivo, ec);
+    return !ec && tamano > umbralCargaIncremental_;
+}
+
+bool GestorCodigoG::iniciarEjecucionIncremental(const std::string& nombreArchivo, size_t desdeComando) {
+    if (rechazarSiEjecutando("Nueva ejecución")) {
+        return false;
+    }
+    if (hiloEjecucion_.joinable()) {
+        hiloEjecucion_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtxEjecucion_);
+        mensajeEjecucion_.clear(); // aquí queda el motivo si no se inicia
+    }
+    if (!verificarEjecucionPosible()) {
+        return false;
+    }
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(nombreArchivo, ec)) {
+        std::cerr << "Error: Archivo no encontrado: " << nombreArchivo << std::endl;
+        return false;
+    }
+    
+    // El hilo de carga valida cada bloque antes de entregarlo, y la cola lo deja
+    // a lo sumo unos bloques por delante del envío. Antes del primer movimiento
+    // sólo se espera el primer bloque, así que el arranque no depende del tamaño
+    // del archivo; un error más adelante detiene la ejecución antes de llegar a él.
+    trayectoriaAprendida_ = ProgramaG(); // libera también la memoria reservada
+    cargaIncremental_ = true;
+    comandosLeidos_ = 0;
+    cargaTerminada_ = false;
+    errorCarga_.clear();
+    colaCarga_ = std::make_unique<ColaAcotada<ProgramaG>>(4);
+    hiloCarga_ = std::thread(&GestorCodigoG::bucleCarga, this, nombreArchivo, desdeComando, posicionComandada());
+    if (!colaCarga_->esperarElementos()) {
+        terminarCarga();
+        cargaIncremental_ = false;
+        std::cerr << "Error: " << errorCarga_ << std::endl;
+        std::lock_guard<std::mutex> lock(mtxEjecucion_);
+        mensajeEjecucion_ = errorCarga_;
+        return false;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mtxEjecucion_);
+        contadorPrograma_ = desdeComando;
+        pasosPendientes_ = 0;
+        tramosArcoEnviados_ = 0;
+        mensajeEjecucion_ = "En ejecución";
+        estadoEjecucion_ = EstadoEjecucion::EJECUTANDO;
+    }
+    notificarEjecucion();
+    
+    std::cout << "Iniciando ejecución incremental de " << nombreArchivo;
+    if (desdeComando > 0) {
+        std::cout << " desde el comando " << (desdeComando + 1);
+    }
+    std::cout << "..." << std::endl;
+    
+    hiloEjecucion_ = std::thread(&GestorCodigoG::bucleEjecucion, this);
+    return true;
+}
+
+std::string GestorCodigoG::avanzarValidando(const ComandoG& cmd, Posicion& posicion, bool& relativo) const {
+    if (esComandoArco(cmd)) {
+        if (!validarArco(cmd, posicion, relativo)) {
+            return "arco inválido o fuera del espacio de trabajo";
+        }
+        Punto3D fin = definirArco(cmd, posicion, relativo).fin;
+        posicion = Posicion(fin.x, fin.y, fin.z);
+    } else if (esComandoMovimiento(cmd)) {
+        Posicion p = cmd.destino(posicion, relativo);
+        if (!validarPosicion(p)) {
+            return espacioTrabajo_.diagnosticar(p.x, p.y, p.z);
+        }
+        posicion = p;
+    } else if (cmd.operacion == OperacionG::G28) {
+        posicion = posicionOrigen_;
+    } else if (cmd.operacion == OperacionG::G90 || cmd.operacion == OperacionG::G91) {
+        relativo = cmd.operacion == OperacionG::G91;
+    }
+    return std::string();
+}
+
+// Hilo de carga: misma lectura y validación que leerProgramaGCode, pero los
+// comandos se entregan al ejecutor en bloques pequeños, cada uno con sus textos,
+// que se liberan en cuanto se ejecutan
+void GestorCodigoG::bucleCarga(std::string nombreArchivo, size_t desdeComando, Posicion inicio) {
+    const size_t COMANDOS_POR_BLOQUE = 256;
+    std::string error;
+    try {
+        // Lectura secuencial sin GestorArchivos, que indexaría el archivo entero antes
+        std::ifstream archivo(nombreArchivo);
+        if (!archivo) {
+            throw std::runtime_error("no se pudo abrir " + nombreArchivo);
+        }
+        Posicion posicionCarga = inicio;
+        bool relativo = false; // como en leerProgramaGCode
+        size_t leidos = 0;
+        bool cancelada = false;
+        ProgramaG bloque;
+        std::string linea;
+        while (std::getline(archivo, linea)) {
+            if (linea.empty() || linea[0] == ';') {
+                continue;
+            }
+            
+            // Los textos sólo se conservan para los comandos que se van a ejecutar
+            ComandoG cmd = parsearComandoG(linea, leidos >= desdeComando ? &bloque.textos : nullptr);
+            if (!cmd.valido) {
+                continue;
+            }
+            std::string motivo = avanzarValidando(cmd, posicionCarga, relativo);
+            if (!motivo.empty()) {
+                // El bloque en curso no se entrega: el envío se detiene antes de este comando
+                error = "Programa rechazado en el comando " + std::to_string(leidos + 1) + " (" + linea + "): " + motivo;
+                break;
+            }
+            
+            comandosLeidos_ = ++leidos;
+            if (leidos <= desdeComando) {
+                continue;
+            }
+            bloque.push_back(cmd);
+            if (bloque.size() == COMANDOS_POR_BLOQUE) {
+                if (!colaCarga_->poner(std::move(bloque))) {
+                    cancelada = true; // el ejecutor terminó o se detuvo
+                    break;
+                }
+                bloque = ProgramaG();
+            }
+        }
+        if (!cancelada && error.empty() && !bloque.empty()) {
+            colaCarga_->poner(std::move(bloque));
+        }
+        if (error.empty() && leidos <= desdeComando) {
+            error = leidos == 0 ? "El archivo no tiene comandos para ejecutar"
+                                : "Comando inicial fuera de rango: " + std::to_string(desdeComando + 1);
+        }
+    } catch (const std::exception& e) {
+        error = std::string("Error cargando archivo: ") + e.what();
+    }
+    
+    errorCarga_ = error;
+    cargaTerminada_ = true;
+    colaCarga_->cerrar();
+}
+
+void GestorCodigoG::terminarCarga() {
+    if (!colaCarga_) {
+        return;
+    }
+    colaCarga_->cancelar(); // libera al hilo de carga si espera lugar
+    if (hiloCarga_.joinable()) {
+        hiloCarga_.join();
+    }
+    colaCarga_.reset();
+}
+
+bool GestorCodigoG::esperarFinEjecucion() {
+    {
+        std::unique_lock<std::mutex> lock(mtxEjecucion_);
+        cvEjecucion_.wait(lock, [this] { return estadoEjecucion_ == EstadoEjecucion::INACTIVO; });
+    }
+    if (hiloEjecucion_.joinable()) {
+        hiloEjecucion_.join();
+    }
+    std::lock_guard<std::mutex> lock(mtxEjecucion_);
+    return ultimaEjecucionExitosa_;
+}
+
+bool GestorCodigoG::ejecutarTrayectoriaCargada() {
+    return iniciarEjecucion() && esperarFinEjecucion();
+}
+
+bool GestorCodigoG::puntoDeControl() {
+    std::unique_lock<std::mutex> lock(mtxEjecucion_);
+    if (estadoEjecucion_ == EstadoEjecucion::PAUSANDO) {
+        estadoEjecucion_ = EstadoEjecucion::PAUSADO;
+        std::cout << "Ejecución pausada antes del comando " << (contadorPrograma_ + 1) << std::endl;
+        cvEjecucion_.notify_all();
+        notificarEjecucion();
+    }
+    
+    cvEjecucion_.wait(lock, [this] {
+        return estadoEjecucion_ != EstadoEjecucion::PAUSADO || pasosPendientes_ > 0;
+    });
+    
+    if (estadoEjecucion_ == EstadoEjecucion::DETENIENDO) {
+        return false;
+    }
+    if (estadoEjecucion_ == EstadoEjecucion::PAUSADO) {
+        --pasosPendientes_; // modo paso a paso: un comando y se vuelve a esperar
+    }
+    return true;
+}
+
+void GestorCodigoG::bucleEjecucion() {
+    bool exito = true;
+    std::string mensaje = "Trayectoria ejecutada exitosamente";
+    
+    // Comando i del programa: de la trayectoria cargada o, en carga incremental,
+    // del bloque tomado de la cola (se conserva hasta terminarlo, así un arco
+    // interrumpido se retoma sobre el mismo comando)
+    ProgramaG bloque;
+    size_t inicioBloque = contadorPrograma_;
+    const ProgramaG* programa = &trayectoriaAprendida_;
+    auto comandoEn = [&](size_t i) -> const ComandoG* {
+        if (!cargaIncremental_) {
+            return i < trayectoriaAprendida_.size() ? &trayectoriaAprendida_[i] : nullptr;
+        }
+        while (i >= inicioBloque + bloque.size()) {
+            inicioBloque += bloque.size();
+            if (!colaCarga_->tomar(bloque)) {
+                bloque.clear();
+                return nullptr;
+            }
+        }
+        programa = &bloque;
+        return &bloque[i - inicioBloque];
+    };
+    
+    // Los programas se interpretan desde modo absoluto, igual que al planificarlos y validarlos
+    if (modoCoordenadas_ == ModoCoordenas::RELATIVO) {
+        if (enviarComandoConEspera("G90", 1000)) {
+            modoCoordenadas_ = ModoCoordenas::ABSOLUTO;
+        } else {
+            exito = false;
+            mensaje = "Error: No se pudo pasar a modo absoluto antes de ejecutar";
+        }
+    }
     
-    for (size_t i = 0; i < trayectoriaAprendida_.size(); ++i) {
-        const ComandoG& cmd = trayectoriaAprendida_[i];
+    while (exito) {
+        if (!puntoDeControl()) {
+            exito = false;
+            mensaje = "Ejecución detenida antes del comando " + std::to_string(contadorPrograma_ + 1);
+            break;
+        }
         
-        std::cout << "Ejecutando comando " << (i + 1) << "/" << trayectoriaAprendida_.size() 
-                  << ": " << cmd.comando << std::endl;
+        size_t i = contadorPrograma_;
+        const ComandoG* siguiente = comandoEn(i);
+        if (!siguiente) {
+            if (cargaIncremental_ && !errorCarga_.empty()) {
+                exito = false;
+                mensaje = errorCarga_;
+            }
+            break;
+        }
+        const ComandoG& cmd = *siguiente;
+        const std::string texto = programa->texto(cmd);
+        
+        std::cout << "Ejecutando comando " << (i + 1) << "/" << obtenerTotalComandos()
+                  << (cargaIncremental_ && !cargaTerminada_ ? "+" : "") << ": " << texto << std::endl;
         
         // Validar comando antes de enviarlo
         if (!cmd.valido) {
-            std::cerr << "Advertencia: Comando inválido omitido: " << cmd.comando << std::endl;
+            std::cerr << "Advertencia: Comando inválido omitido: " << texto << std::endl;
+            contadorPrograma_ = i + 1;
+            notificarEjecucion();
             continue;
         }
         
-        // Validar posición si es un comando de movimiento
-        if (cmd.comando.find("G1") != std::string::npos || cmd.comando.find("G0") != std::string::npos) {
-            if (!validarPosicion(cmd.posicion)) {
-                std::cerr << "Error: Posición inválida en comando: " << cmd.comando << std::endl;
-                return false;
+        // Enviar comando y esperar confirmación (2 s por defecto, 5 s para homing);
+        // los arcos se envían tramo a tramo y pueden interrumpirse entre tramos
+        bool enviado = true;
+        switch (cmd.operacion) {
+            case OperacionG::G2:
+            case OperacionG::G3: {
+                if (tramosArcoEnviados_ == 0) {
+                    inicioArcoEnCurso_ = posicionComandada();
+                }
+                bool interrumpido = false;
+                enviado = ejecutarArco(cmd, 2000, inicioArcoEnCurso_, tramosArcoEnviados_, &interrumpido);
+                if (!enviado && interrumpido) {
+                    continue; // se retoma desde el mismo tramo
+                }
+                if (enviado) {
+                    tramosArcoEnviados_ = 0;
+                }
+                break;
             }
+            case OperacionG::G0:
+            case OperacionG::G1: {
+                // Además de la validación previa del programa, cada destino se comprueba
+                // antes de enviarlo (como los tramos de los arcos en ejecutarArco)
+                Posicion destino = cmd.destino(posicionComandada(), modoCoordenadas_ == ModoCoordenas::RELATIVO);
+                enviado = validarPosicionInformando(destino) && enviarComandoConEspera(texto, 2000);
+                if (enviado) {
+                    actualizarPosicionComandada(destino);
+                }
+                break;
+            }
+            case OperacionG::G90:
+            case OperacionG::G91:
+                // El modo queda activo en el firmware al terminar el programa
+                enviado = enviarComandoConEspera(texto, 2000);
+                if (enviado) {
+                    modoCoordenadas_ = cmd.operacion == OperacionG::G91 ? ModoCoordenas::RELATIVO : ModoCoordenas::ABSOLUTO;
+                }
+                break;
+            case OperacionG::G28:
+                enviado = enviarComandoConEspera(texto, 5000);
+                if (enviado) {
+                    actualizarPosicionComandada(posicionOrigen_);
+                }
+                break;
+            default:
+                enviado = enviarComandoConEspera(texto, 2000);
+                break;
         }
-        
-        // Determinar tiempo de espera según el tipo de comando
-        int tiempoEspera = 2000; // 2 segundos por defecto
-        if (cmd.comando.find("G28") != std::string::npos) {
-            tiempoEspera = 5000; // 5 segundos para homing
+        if (!enviado) {
+            if (!cmd.esArco()) {
+                std::cerr << "Error ejecutando comando: " << texto << std::endl;
+            }
+            exito = false;
+            mensaje = "Error ejecutando el comando " + std::to_string(i + 1) + ": " + texto;
+            break;
         }
+        contadorPrograma_ = i + 1;
+        notificarEjecucion();
         
-        // Enviar comando y esperar confirmación
-        if (!enviarComandoConEspera(cmd.comando, tiempoEspera)) {
-            std::cerr << "Error ejecutando comando: " << cmd.comando << std::endl;
+        // Pequeña pausa entre comandos para estabilidad, salvo en vértices que
+        // el planificador permite recorrer sin detenerse
+        if (!cmd.enlazado) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+    
+    terminarCarga();
+    
+    if (exito) {
+        std::cout << "✓ " << mensaje << std::endl;
+    } else {
+        std::cerr << mensaje << std::endl;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mtxEjecucion_);
+        ultimaEjecucionExitosa_ = exito;
+        mensajeEjecucion_ = mensaje;
+        estadoEjecucion_ = EstadoEjecucion::INACTIVO;
+    }
+    cvEjecucion_.notify_all();
+    notificarEjecucion();
+}
+
+bool GestorCodigoG::pausarEjecucion() {
+    std::lock_guard<std::mutex> lock(mtxEjecucion_);
+    switch (estadoEjecucion_.load()) {
+        case EstadoEjecucion::EJECUTANDO:
+            estadoEjecucion_ = EstadoEjecucion::PAUSANDO;
+            std::cout << "Pausa solicitada" << std::endl;
+            notificarEjecucion();
+            return true;
+        case EstadoEjecucion::PAUSANDO:
+        case EstadoEjecucion::PAUSADO:
+            return true;
+        default:
+            std::cerr << "Error: No hay ejecución en curso para pausar" << std::endl;
+            return false;
+    }
+}
+
+bool GestorCodigoG::reanudarEjecucion() {
+    {
+        std::lock_guard<std::mutex> lock(mtxEjecucion_);
+        EstadoEjecucion estado = estadoEjecucion_.load();
+        if (estado != EstadoEjecucion::PAUSADO && estado != EstadoEjecucion::PAUSANDO) {
+            std::cerr << "Error: La ejecución no está pausada" << std::endl;
             return false;
         }
+        pasosPendientes_ = 0;
+        estadoEjecucion_ = EstadoEjecucion::EJECUTANDO;
+    }
+    cvEjecucion_.notify_all();
+    notificarEjecucion();
+    std::cout << "Ejecución reanudada en el comando " << (contadorPrograma_ + 1) << std::endl;
+    return true;
+}
+
+bool GestorCodigoG::detenerEjecucion() {
+    {
+        std::lock_guard<std::mutex> lock(mtxEjecucion_);
+        EstadoEjecucion estado = estadoEjecucion_.load();
+        if (estado == EstadoEjecucion::INACTIVO) {
+            return false;
+        }
+        estadoEjecucion_ = EstadoEjecucion::DETENIENDO;
+    }
+    cvEjecucion_.notify_all();
+    notificarEjecucion();
+    std::cout << "Detención solicitada" << std::endl;
+    return true;
+}
+
+bool GestorCodigoG::paradaEmergencia() {
+    std::cerr << "PARADA DE EMERGENCIA" << std::endl;
+    bool ejecutando = detenerEjecucion();
+    if (!robotConectado_) {
+        if (ejecutando) esperarFinEjecucion();
+        return true;
+    }
+    
+    // Directo al puerto y en una sola toma del cerrojo: se envían en cuanto el
+    // ejecutor (que ya no manda nada más) o el comando en curso lo sueltan, sin que
+    // otro comando se intercale. Se intentan ambos aunque falle el primero
+    bool efector, motores;
+    {
+        std::lock_guard<std::mutex> lock(mtxSerial_);
+        efector = serial_->enviarComando("M5");
+        serial_->leerPuerto(2000);
+        motores = serial_->enviarComando("M84");
+        serial_->leerPuerto(2000);
+    }
+    efectorActivo_ = false;
+    if (ejecutando) esperarFinEjecucion();
+    std::cerr << "Efector y motores desactivados: se requiere G28 antes de volver a mover" << std::endl;
+    return efector && motores;
+}
+
+bool GestorCodigoG::ejecutarPasoAPaso() {
+    if (estadoEjecucion_ == EstadoEjecucion::INACTIVO) {
+        // Arranca en pausa desde el principio y ejecuta el primer comando
+        if (!iniciarEjecucion(0, true)) {
+            return false;
+        }
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mtxEjecucion_);
+        if (estadoEjecucion_ != EstadoEjecucion::PAUSADO) {
+            std::cerr << "Error: El paso a paso requiere la ejecución pausada" << std::endl;
+            return false;
+        }
+        ++pasosPendientes_;
+    }
+    cvEjecucion_.notify_all();
+    return true;
+}
+
+AnalisisGCode GestorCodigoG::analizarGCode(const std::string& contenido, const std::string& hash, bool* enCache) const {
+    if (enCache) *enCache = false;
+    if (!hash.empty()) {
+        std::lock_guard<std::mutex> lock(mtxAnalisis_);
+        auto it = analisisPorHash_.find(hash);
+        if (it != analisisPorHash_.end()) {
+            ordenAnalisis_.splice(ordenAnalisis_.begin(), ordenAnalisis_, it->second.orden);
+            if (enCache) *enCache = true;
+            return it->second.analisis;
+        }
+    }
+    
+    // Los arcos dependen de dónde empiezan (la posición del robot al cargar), así
+    // que aquí sólo se controlan los destinos de los movimientos lineales, y sólo
+    // desde que el programa fijó los tres ejes; la carga sigue validando todo
+    const int TODOS_LOS_EJES = EJE_X | EJE_Y | EJE_Z;
+    Posicion posicion;
+    int ejesConocidos = 0;
+    bool relativo = false;
+    AnalisisGCode analisis;
+    ValidadorLote lote(espacioTrabajo_);
+    std::vector<std::string> textos; // comando de cada punto, para el mensaje
+    std::istringstream iss(contenido);
+    std::string linea;
+    while (std::getline(iss, linea)) {
+        ++analisis.lineas;
+        if (linea.empty() || linea[0] == ';' || linea.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        ComandoG cmd = parsearComandoG(linea);
+        if (!cmd.valido) {
+            if (analisis.lineasIgnoradas++ == 0) analisis.primeraIgnorada = analisis.lineas;
+            continue;
+        }
+        ++analisis.comandos;
+        if (esComandoMovimiento(cmd) || esComandoArco(cmd)) {
+            posicion = cmd.destino(posicion, relativo);
+            if (!relativo) {
+                ejesConocidos |= cmd.palabras & TODOS_LOS_EJES;
+            }
+            if (esComandoMovimiento(cmd) && ejesConocidos == TODOS_LOS_EJES) {
+                lote.agregar(posicion.x, posicion.y, posicion.z, textos.size());
+                textos.push_back(linea);
+            }
+        } else if (cmd.operacion == OperacionG::G28) {
+            posicion = posicionOrigen_;
+            ejesConocidos = TODOS_LOS_EJES;
+        } else if (cmd.operacion == OperacionG::G90 || cmd.operacion == OperacionG::G91) {
+            relativo = cmd.operacion == OperacionG::G91;
+        }
+    }
+    
+    ResultadoValidacionLote validacion = lote.validar();
+    if (!validacion.valido) {
+        const Punto3D& p = validacion.posicionInvalida;
+        analisis.valido = false;
+        analisis.mensaje = textos[validacion.origenInvalido] + ": " + espacioTrabajo_.diagnosticar(p.x, p.y, p.z);
+    }
+    
+    if (!hash.empty()) {
+        std::lock_guard<std::mutex> lock(mtxAnalisis_);
+        if (analisisPorHash_.find(hash) == analisisPorHash_.end()) { // otro hilo pudo guardarlo
+            ordenAnalisis_.push_front(hash);
+            analisisPorHash_[hash] = EntradaAnalisis{analisis, ordenAnalisis_.begin()};
+            if (analisisPorHash_.size() > MAX_ANALISIS) {
+                analisisPorHash_.erase(ordenAnalisis_.back());
+                ordenAnalisis_.pop_back();
+            }
+        }
+    }
+    return analisis;
+}
+
+ResultadoSimulacion GestorCodigoG::simularArchivoGCode(const std::string& nombreArchivo) const {
+    // Se simula desde la última posición comandada, tomada una sola vez: una
+    // ejecución en curso puede estar moviendo el robot desde otro hilo
+    const Posicion inicio = posicionComandada();
+    
+    // Mismo preprocesado que la carga real (y la misma caché)
+    CacheProgramas::Programa preparado = prepararPrograma(nombreArchivo);
+    if (!preparado) {
+        ResultadoSimulacion resultado;
+        resultado.mensaje = "No se pudo leer el archivo: " + nombreArchivo;
+        return resultado;
+    }
+    ProgramaG programa = *preparado;
+    return simularPrograma(programa, inicio);
+}
+
+ResultadoSimulacion GestorCodigoG::simularPrograma(ProgramaG& programa, const Posicion& inicio) const {
+    ResultadoSimulacion resultado;
+    resultado.comandos = programa.size();
+    
+    // Configuración leída una vez: la consola puede cambiarla mientras se simula
+    const bool planificar = planificacionActiva_;
+    const LatenciasFirmware latencias = obtenerLatencias();
+    
+    ResultadoValidacionLote validacion = validarPrograma(programa, inicio);
+    if (!validacion.valido) {
+        resultado.mensaje = "Comando " + std::to_string(validacion.origenInvalido + 1) + " (" +
+                            programa.texto(programa[validacion.origenInvalido]) + "): " +
+                            diagnosticarValidacion(validacion);
+        return resultado;
+    }
+    
+    // Velocidades de entrada/salida que usará el ejecutor en cada tramo
+    std::vector<SegmentoPlan> plan;
+    if (planificar) {
+        planificarPrograma(programa, inicio, &plan);
+    }
+    
+    double movimiento = 0.0;  // s
+    double latencia = 0.0;    // ms
+    double avance = velocidadActual_;
+    double velocidadPrevia = 0.0; // mm/min al terminar el tramo anterior
+    Posicion posicion = inicio;
+    bool relativo = false; // los programas empiezan en modo absoluto (ver bucleEjecucion)
+    
+    auto recorrer = [&](const Posicion& destino, double v0, double v1, double crucero) {
+        double dx = destino.x - posicion.x, dy = destino.y - posicion.y, dz = destino.z - posicion.z;
+        double longitud = std::sqrt(dx * dx + dy * dy + dz * dz);
+        movimiento += planificador_.duracionTramo(longitud, v0, v1, crucero);
+        resultado.longitudRecorridoMm += longitud;
+        resultado.alcanceMaximoMm = std::max(resultado.alcanceMaximoMm, calcularDistanciaRadial(destino.x, destino.y));
+        latencia += latencias.respuestaMs;
+        ++resultado.tramos;
+        posicion = destino;
+    };
+    
+    for (size_t i = 0; i < programa.size(); ++i) {
+        const ComandoG& cmd = programa[i];
+        if (!cmd.valido) {
+            continue;
+        }
+        if (cmd.velocidad() > 0) {
+            avance = cmd.velocidad();
+        }
         
-        // Actualizar posición actual si es comando de movimiento
-        if (cmd.comando.find("G1") != std::string::npos || cmd.comando.find("G0") != std::string::npos) {
-            posicionActual_ = cmd.posicion;
+        if (esComandoArco(cmd)) {
+            // Cada tramo del arco se envía esperando su confirmación: arranca y termina detenido
+            interpoladorArcos_.interpolar(definirArco(cmd, posicion, relativo), [&](const Punto3D& p) {
+                recorrer(Posicion(p.x, p.y, p.z), 0.0, 0.0, avance);
+                return true;
+            });
+            velocidadPrevia = 0.0;
+        } else if (esComandoMovimiento(cmd)) {
+            Posicion destino = cmd.destino(posicion, relativo);
+            if (cmd.fPlan > 0) {
+                const SegmentoPlan& tramo = plan[i];
+                double salida = cmd.enlazado ? tramo.velocidadSalida : 0.0;
+                recorrer(destino, velocidadPrevia, salida, tramo.velocidadAjustada);
+                velocidadPrevia = salida;
+            } else {
+                // Sin planificar (planificador inactivo o modo relativo)
+                recorrer(destino, 0.0, 0.0, avance);
+                velocidadPrevia = 0.0;
+            }
+        } else {
+            latencia += latencias.respuestaMs;
+            ++resultado.tramos;
+            if (cmd.operacion == OperacionG::G28) {
+                latencia += latencias.homingMs;
+                posicion = posicionOrigen_;
+            } else if (cmd.operacion == OperacionG::G90 || cmd.operacion == OperacionG::G91) {
+                relativo = cmd.operacion == OperacionG::G91;
+            }
+            velocidadPrevia = 0.0;
         }
         
-        // Pequeña pausa entre comandos para estabilidad
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (!cmd.enlazado) {
+            latencia += latencias.pausaEntreComandosMs;
+        }
     }
     
-    std::cout << "✓ Trayectoria ejecutada exitosamente" << std::endl;
-    return true;
+    resultado.valido = true;
+    resultado.tiempoMovimientoSegundos = movimiento;
+    resultado.tiempoLatenciaSegundos = latencia / 1000.0;
+    resultado.duracionSegundos = resultado.tiempoMovimientoSegundos + resultado.tiempoLatenciaSegundos;
+    return resultado;
 }
@@ -5,72 +5,213 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <unordered_map>
 #include "Serial.h"
+#include "ComandoG.h"
 #include "GestorArchivos.h"
-
-// Definiciones del espacio de trabajo del robot
-#define LOW_SHANK_LENGTH 120.0
-#define HIGH_SHANK_LENGTH 120.0
-#define Z_MIN -115 // -140.0 //MINIMUM Z HEIGHT OF TOOLHEAD TOUCHING GROUND
-#define Z_MAX (LOW_SHANK_LENGTH+30.0) //SHANK_LENGTH ADDING ARBITUARY NUMBER FOR Z_MAX
-#define SHANKS_MIN_ANGLE_COS 0.791436948 
-#define SHANKS_MAX_ANGLE_COS -0.774944489 
-#define R_MIN (sqrt((sq(LOW_SHANK_LENGTH) + sq(HIGH_SHANK_LENGTH)) - (2*LOW_SHANK_LENGTH*HIGH_SHANK_LENGTH*SHANKS_MIN_ANGLE_COS) ))
-#define R_MAX (sqrt((sq(LOW_SHANK_LENGTH) + sq(HIGH_SHANK_LENGTH)) - (2*LOW_SHANK_LENGTH*HIGH_SHANK_LENGTH*SHANKS_MAX_ANGLE_COS) ))
-#define sq(x) ((x)*(x))
+#include "PlanificadorMovimiento.h"
+#include "SimplificadorTrayectoria.h"
+#include "InterpoladorArcos.h"
+#include "EspacioTrabajo.h"
+#include "ValidadorLote.h"
+#include "MonitorPosicion.h"
+#include "CacheProgramas.h"
+#include "ColaAcotada.h"
 
 enum class ModoTrabajo {
     MANUAL,
     AUTOMATICO
 };
 
+// Estados del ejecutor de trayectorias. Las transiciones PAUSANDO -> PAUSADO y
+// DETENIENDO -> INACTIVO las hace el hilo ejecutor al terminar el tramo en curso.
+enum class EstadoEjecucion {
+    INACTIVO,
+    EJECUTANDO,
+    PAUSANDO,
+    PAUSADO,
+    DETENIENDO
+};
+
 enum class ModoCoordenas {
     ABSOLUTO,
     RELATIVO
 };
 
-struct Posicion {
-    double x;
-    double y;
-    double z;
+// Tiempos del firmware y del ejecutor que no dependen del movimiento. respuestaMs y
+// homingMs son estimaciones sin calibrar (no se midieron contra un firmware real);
+// pausaEntreComandosMs es la pausa fija de bucleEjecucion. Se ajustan con
+// configurarLatencias (comando 'latencias' de la consola).
+struct LatenciasFirmware {
+    double respuestaMs;          // envío de la línea hasta recibir "ok"
+    double pausaEntreComandosMs; // pausa del ejecutor tras cada comando no enlazado
+    double homingMs;             // duración de G28
     
-    Posicion(double x = 0, double y = 0, double z = 0) : x(x), y(y), z(z) {}
+    LatenciasFirmware() : respuestaMs(15.0), pausaEntreComandosMs(100.0), homingMs(5000.0) {}
 };
 
-struct ComandoG {
-    std::string comando;
-    std::string descripcion;
-    Posicion posicion;
-    double velocidad;
+// Estimación de una ejecución sin enviar nada al robot
+struct ResultadoSimulacion {
     bool valido;
+    std::string mensaje;            // motivo del rechazo si !valido
+    size_t comandos;
+    size_t tramos;                  // líneas que recibiría el firmware (incluye los tramos de arcos)
+    double duracionSegundos;
+    double tiempoMovimientoSegundos;
+    double tiempoLatenciaSegundos;
+    double longitudRecorridoMm;
+    double alcanceMaximoMm;         // radio horizontal máximo respecto de la base
+    
+    ResultadoSimulacion()
+        : valido(false), comandos(0), tramos(0), duracionSegundos(0), tiempoMovimientoSegundos(0),
+          tiempoLatenciaSegundos(0), longitudRecorridoMm(0), alcanceMaximoMm(0) {}
+};
+
+// Lo que se sabe de un programa sólo por su texto, sin depender del estado del
+// robot: por eso puede guardarse por hash del contenido
+struct AnalisisGCode {
+    bool valido;                 // todos los destinos lineales dentro del espacio de trabajo
+    std::string mensaje;         // primer destino inaccesible si !valido
+    size_t lineas;
+    size_t comandos;             // líneas que se ejecutarían
+    size_t lineasIgnoradas;      // ni comentario ni comando reconocido (la carga las salta)
+    size_t primeraIgnorada;      // número de línea (desde 1), 0 si no hay
     
-    ComandoG() : velocidad(0), valido(false) {}
+    AnalisisGCode() : valido(true), lineas(0), comandos(0), lineasIgnoradas(0), primeraIgnorada(0) {}
 };
 
 class GestorCodigoG {
 private:
     std::unique_ptr<Serial> serial_;
     
-    ModoTrabajo modoTrabajo_;
-    ModoCoordenas modoCoordenadas_;
+    // Se leen desde los hilos RPC, el ejecutor (que cambia el de coordenadas con
+    // G90/G91) y la telemetría
+    std::atomic<ModoTrabajo> modoTrabajo_;
+    std::atomic<ModoCoordenas> modoCoordenadas_;
     
-    Posicion posicionActual_;
     Posicion posicionOrigen_;
-    double velocidadActual_;
+    std::atomic<double> velocidadActual_;
     bool efectorActivo_;
-    bool robotConectado_;
+    std::atomic<bool> robotConectado_; // lo consultan el ejecutor, el sondeo y los hilos RPC
     
-    std::vector<ComandoG> trayectoriaAprendida_;
+    ProgramaG trayectoriaAprendida_;
     std::string nombreTrayectoriaActual_;
     bool aprendiendoTrayectoria_;
     
+    PlanificadorMovimiento planificador_;
+    std::atomic<bool> planificacionActiva_;
+    
+    SimplificadorTrayectoria simplificador_;
+    std::atomic<bool> simplificacionActiva_; // al cargar archivos y al finalizar el aprendizaje
+    
+    InterpoladorArcos interpoladorArcos_;
+    
+    EspacioTrabajo espacioTrabajo_; // envolvente del firmware
+    
+    LatenciasFirmware latencias_; // modelo de tiempos usado por el simulador
+    mutable std::mutex mtxLatencias_;
+    
+    // Ejecutor en hilo propio con puntos de control entre tramos
+    std::thread hiloEjecucion_;
+    std::atomic<EstadoEjecucion> estadoEjecucion_;
+    std::atomic<size_t> contadorPrograma_; // próximo comando a enviar
+    mutable std::mutex mtxEjecucion_;
+    std::condition_variable cvEjecucion_;
+    size_t pasosPendientes_;               // pasos pedidos en modo paso a paso
+    size_t tramosArcoEnviados_;            // progreso dentro de un arco interrumpido
+    Posicion inicioArcoEnCurso_;
+    bool ultimaEjecucionExitosa_;
+    std::string mensajeEjecucion_;
+    
+    std::mutex mtxSerial_; // el ejecutor y los comandos manuales comparten el puerto
+    
+    // Carga incremental: un hilo lee y valida el archivo mientras el ejecutor
+    // envía lo ya leído; la cola acota la memoria y trayectoriaAprendida_ queda vacía
+    std::atomic<bool> cargaIncremental_;
+    std::thread hiloCarga_;
+    std::unique_ptr<ColaAcotada<ProgramaG>> colaCarga_; // bloques de comandos
+    std::atomic<size_t> comandosLeidos_;
+    std::atomic<bool> cargaTerminada_;
+    std::string errorCarga_;          // lo escribe el hilo de carga antes de cerrar la cola
+    size_t umbralCargaIncremental_;   // bytes de archivo a partir de los que conviene
+    
+    // Programas ya preparados (leídos, validados y simplificados) por inodo
+    mutable CacheProgramas cacheProgramas_;
+    
+    // Análisis de programas por hash de su contenido (ver AlmacenGCode), como
+    // mucho MAX_ANALISIS; se descarta el usado hace más tiempo
+    static const size_t MAX_ANALISIS = 256;
+    struct EntradaAnalisis {
+        AnalisisGCode analisis;
+        std::list<std::string>::iterator orden;
+    };
+    mutable std::unordered_map<std::string, EntradaAnalisis> analisisPorHash_;
+    mutable std::list<std::string> ordenAnalisis_; // hashes, el más reciente al frente
+    mutable std::mutex mtxAnalisis_;
+    
+    // Aviso de cambios de estado del ejecutor (para las suscripciones)
+    std::function<void(EstadoEjecucion, size_t, size_t)> observadorEjecucion_;
+    
+    // Telemetría: sondeo M114 en segundo plano y última posición publicada
+    MonitorPosicion monitorPosicion_;
+    std::atomic<int> periodoTelemetriaMs_;
+    
     // Métodos de validación
-    bool validarPosicion(const Posicion& pos) const;
+    bool validarPosicion(const Posicion& pos) const; // sin salida por consola, apta para bucles
+    bool validarPosicionInformando(const Posicion& pos) const;
     bool validarComandoG(const std::string& comando) const;
     double calcularDistanciaRadial(double x, double y) const;
+    static bool esComandoMovimiento(const ComandoG& cmd);
+    static bool esComandoArco(const ComandoG& cmd);
+    
+    // Arcos G2/G3
+    // 'relativo': el fin del arco se interpreta en modo G91
+    DefinicionArco definirArco(const ComandoG& cmd, const Posicion& inicio, bool relativo = false) const;
+    bool validarArco(const ComandoG& cmd, const Posicion& inicio, bool relativo = false) const;
+    bool ejecutarArco(const ComandoG& cmd, int tiempoEsperaMs, const Posicion& inicio,
+                      size_t& tramosEnviados, bool* interrumpido = nullptr);
+    
+    // Ejecutor
+    bool prepararEjecucion();
+    void bucleEjecucion();
+    bool puntoDeControl();
+    bool debeInterrumpir() const;
+    bool rechazarSiEjecutando(const char* operacion) const;
+    void notificarEjecucion();
+    bool verificarEjecucionPosible() const;
+    void bucleCarga(std::string nombreArchivo, size_t desdeComando, Posicion inicio);
+    void terminarCarga();
+    // Valida un comando leído en streaming y avanza la posición y el modo; devuelve
+    // el motivo del rechazo o una cadena vacía
+    std::string avanzarValidando(const ComandoG& cmd, Posicion& posicion, bool& relativo) const;
+    
+    // Lectura, planificación, simplificación y validación sobre un programa cualquiera
+    // La lectura y la preparación no dependen de la posición del robot; 'inicio' es
+    // la posición desde la que se recorrería el programa
+    bool leerProgramaGCode(const std::string& nombreArchivo, ProgramaG& programa) const;
+    // leerProgramaGCode + simplificación, pasando por cacheProgramas_ (clave: inodo,
+    // fecha y tamaño); nullptr si falla
+    CacheProgramas::Programa prepararPrograma(const std::string& nombreArchivo, bool* desdeCache = nullptr,
+                                              ResultadoSimplificacion* simplificacion = nullptr) const;
+    bool validarArcosPrograma(const ProgramaG& programa, const Posicion& inicio) const;
+    ResultadoPlanificacion planificarPrograma(ProgramaG& programa, const Posicion& inicio,
+                                              std::vector<SegmentoPlan>* detalle = nullptr) const;
+    ResultadoSimplificacion simplificarPrograma(ProgramaG& programa) const;
+    ResultadoValidacionLote validarPrograma(const ProgramaG& programa, const Posicion& inicio) const;
+    std::string diagnosticarValidacion(const ResultadoValidacionLote& validacion) const;
+    ResultadoSimulacion simularPrograma(ProgramaG& programa, const Posicion& inicio) const;
+    // Última posición comandada (la publicada en monitorPosicion_), legible desde cualquier hilo
+    Posicion posicionComandada() const;
     
     // Métodos de conversión
-    ComandoG parsearComandoG(const std::string& comando) const;
+    // Con 'textos' se conserva ahí la línea si no puede regenerarse desde sus campos
+    ComandoG parsearComandoG(const std::string& comando, TextosPrograma* textos = nullptr) const;
     std::string posicionAComandoG(const Posicion& pos, double velocidad = 0) const;
     Posicion coordenadasXYZAComandoG(double x, double y, double z) const;
     
@@ -78,10 +219,12 @@ private:
     bool enviarComandoASerial(const std::string& comando);
     bool enviarComandoConEspera(const std::string& comando, int tiempoEsperaMs);
     std::string solicitarPosicionActual();
+    bool muestrearPosicion(Punto3D& posicion); // no espera si el puerto está ocupado
+    void actualizarPosicionComandada(const Posicion& pos);
     std::string solicitarEstadoRobot();
 
 public:
-    explicit GestorCodigoG(const std::string& puertoSerial = "/dev/ttyUSB0");
+    explicit GestorCodigoG(const std::string& puertoSerial = ""); // "" = buscar el puerto
     ~GestorCodigoG();
     
     // Conexión y configuración inicial
@@ -115,14 +258,76 @@ public:
     // Modo Automático - Ejecución de secuencias
     bool cargarSecuenciaTrabajo(const std::string& nombreArchivo, const std::string& usuario = "");
     bool ejecutarSecuenciaCompleta();
-    bool ejecutarTrayectoriaCargada(); // Nuevo método para ejecutar línea por línea
+    bool ejecutarTrayectoriaCargada(); // Ejecuta la trayectoria y espera a que termine
     bool ejecutarPasoAPaso();
     bool pausarEjecucion();
     bool reanudarEjecucion();
     bool detenerEjecucion();
+    bool paradaEmergencia(); // detiene la ejecución y desactiva efector y motores
+    
+    // Ejecución en segundo plano (no bloquea al llamador)
+    bool iniciarEjecucion(size_t desdeComando = 0, bool enPausa = false);
+    bool esperarFinEjecucion();
+    // Ejecuta un archivo mientras se lee (sin planificación ni simplificación). Cada
+    // bloque se valida antes de enviarlo y se arranca con el primero listo: si ahí
+    // hay un error no se inicia nada; uno posterior detiene la ejecución antes de él.
+    bool iniciarEjecucionIncremental(const std::string& nombreArchivo, size_t desdeComando = 0);
+    bool convieneCargaIncremental(const std::string& nombreArchivo) const;
+    void configurarCargaIncremental(size_t umbralBytes) { umbralCargaIncremental_ = umbralBytes; }
+    bool enCargaIncremental() const { return cargaIncremental_; }
+    EstadoEjecucion obtenerEstadoEjecucion() const { return estadoEjecucion_.load(); }
+    size_t obtenerContadorPrograma() const { return contadorPrograma_.load(); }
+    size_t obtenerTotalComandos() const;
+    std::string obtenerMensajeEjecucion() const;
+    static const char* nombreEstadoEjecucion(EstadoEjecucion estado);
+    
+    // Planificación de movimiento (lookahead sobre la trayectoria cargada). Activa
+    // por defecto para todo programa cargado, también los de EjecutarArchivo; la
+    // consola ('planificar') la desactiva y se envían las velocidades del archivo.
+    // La ejecución incremental nunca planifica.
+    void configurarPlanificador(const ConfiguracionPlanificador& config, bool activo = true);
+    void activarPlanificacion(bool activa) { planificacionActiva_ = activa; }
+    bool planificacionActiva() const { return planificacionActiva_; }
+    ResultadoPlanificacion planificarTrayectoria();
+    
+    // Simplificación de trayectoria (fusión de colineales + Douglas-Peucker)
+    void configurarSimplificacion(double toleranciaMm, bool activa = true);
+    ResultadoSimplificacion simplificarTrayectoria();
+    
+    // Interpolación de arcos G2/G3 (error de cuerda máximo en mm)
+    void configurarInterpolacionArcos(double toleranciaCuerdaMm);
+    
+    // Simulación de la ejecución de un archivo (no usa el puerto serie ni modifica la trayectoria cargada)
+    ResultadoSimulacion simularArchivoGCode(const std::string& nombreArchivo) const;
+    // Los valores por defecto son estimaciones sin calibrar contra un firmware real
+    void configurarLatencias(const LatenciasFirmware& latencias);
+    LatenciasFirmware obtenerLatencias() const;
+    
+    // Sintaxis y alcance de los destinos lineales de un programa. Con hash, el
+    // resultado se recuerda y un contenido ya analizado no se vuelve a parsear;
+    // 'enCache' indica si fue así.
+    AnalisisGCode analizarGCode(const std::string& contenido, const std::string& hash = "",
+                                bool* enCache = nullptr) const;
+    
+    // Caché de programas preparados (0 la desactiva)
+    void configurarCacheProgramas(size_t bytesMaximos) { cacheProgramas_.configurarMemoria(bytesMaximos); }
+    EstadisticasCacheProgramas obtenerEstadisticasCache() const { return cacheProgramas_.estadisticas(); }
+    
+    // Validación completa del programa cargado (incluye los tramos de los arcos)
+    ResultadoValidacionLote validarTrayectoriaCompleta() const;
+    
+    // Telemetría de posición (0 desactiva el sondeo; se aplica al conectar)
+    void configurarTelemetria(int periodoMs);
+    std::shared_ptr<const MuestraPosicion> obtenerTelemetria() const { return monitorPosicion_.obtener(); }
+    
+    // Observadores de cambios (configurar antes de conectar el robot)
+    void observarPosicion(const MonitorPosicion::Observador& observador) { monitorPosicion_.establecerObservador(observador); }
+    void observarEjecucion(const std::function<void(EstadoEjecucion estado, size_t comando, size_t total)>& observador) {
+        observadorEjecucion_ = observador;
+    }
     
     // Consultas de estado
-    Posicion obtenerPosicionActual();
+    Posicion obtenerPosicionActual() const; // última posición publicada, sin consultar al robot
     std::string obtenerEstadoRobot() const;
     ModoTrabajo obtenerModoTrabajo() const { return modoTrabajo_; }
     ModoCoordenas obtenerModoCoordenadas() const { return modoCoordenadas_; }
@@ -135,7 +340,7 @@ public:
     
     // Utilidades
     std::string obtenerEspacioTrabajoInfo() const;
-    std::vector<ComandoG> obtenerTrayectoriaActual() const { return trayectoriaAprendida_; }
+    ProgramaG obtenerTrayectoriaActual() const { return trayectoriaAprendida_; }
     void limpiarTrayectoriaActual();
 };
 
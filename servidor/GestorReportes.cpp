@@ -5,17 +5,167 @@
 #include <iomanip>
 #include <algorithm>
 #include <iostream>
+#include <cstdio>
+#include <cctype>
+#include <iterator>
+#include <limits>
+#include "HilosParalelos.h"
+#include "BuscadorTexto.h"
+#include "GestorArchivos.h"
 
-GestorReportes::GestorReportes(const std::string &logPath) : logPath(logPath) {
+namespace {
+
+// "YYYY-MM-DD HH:MM:SS" (hora local) a time_t; 0 si no tiene ese formato
+std::time_t parsearTimestamp(const std::string &ts) {
+    std::tm tm = {};
+    std::istringstream ss(ts);
+    ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+    if (ss.fail()) return 0;
+    tm.tm_isdst = -1;
+    return std::mktime(&tm);
+}
+
+// Completa una fecha parcial con el resto de 'relleno'
+std::string completarTimestamp(const std::string &ts, const std::string &relleno) {
+    if (ts.size() >= relleno.size()) return ts;
+    return ts + relleno.substr(ts.size());
+}
+
+// Patrones que debe contener una línea CSV para poder cumplir la consulta; sólo
+// esas líneas se separan en campos
+std::vector<std::string> patronesDe(const ConsultaLog &consulta) {
+    std::vector<std::string> patrones = consulta.subcadenas;
+    if (!consulta.usuario.empty()) patrones.push_back(consulta.usuario);
+    if (!consulta.codigo.empty()) patrones.push_back(consulta.codigo);
+    return patrones;
+}
+
+// Un segmento se salta si su rango de timestamps no toca el de la consulta
+bool segmentoInteresa(const ConsultaLog &consulta, const std::string &desde, const std::string &hasta) {
+    if (desde.empty() || hasta.empty()) return true;
+    return !(RegistroLog::instanteDesdeTexto(hasta) < consulta.desde ||
+             RegistroLog::instanteDesdeTexto(desde) > consulta.hasta);
+}
+
+// Cursor de paginaLog: "<segmento>.<c|t><offset>.<fila>". 'c' es un bloque del
+// log columnar y la fila dentro de él; 't' un byte del CSV (descomprimido). El
+// número de segmento no cambia al rotar: el activo pasa al manifiesto con ese índice.
+struct CursorLog {
+    std::size_t segmento = 0;
+    char tipo = 0; // 0: todavía no se leyó nada del segmento
+    std::uint64_t offset = 0;
+    std::uint32_t fila = 0;
+};
+
+std::string cursorATexto(const CursorLog &c) {
+    std::ostringstream ss;
+    ss << c.segmento << '.';
+    if (c.tipo) ss << c.tipo;
+    ss << c.offset << '.' << c.fila;
+    return ss.str();
+}
+
+bool cursorDesdeTexto(const std::string &texto, CursorLog &c) {
+    std::istringstream ss(texto);
+    char punto1 = 0, punto2 = 0;
+    c = CursorLog();
+    if (!(ss >> c.segmento >> punto1) || punto1 != '.') return false;
+    if (ss.peek() == 'c' || ss.peek() == 't') c.tipo = static_cast<char>(ss.get());
+    if (!(ss >> c.offset >> punto2 >> c.fila) || punto2 != '.') return false;
+    return ss.peek() == std::char_traits<char>::eof();
+}
+
+} // namespace
+
+GestorReportes::GestorReportes(const std::string &logPath, std::size_t capacidadHistorial)
+    : logPath(logPath), capacidadHistorial(capacidadHistorial) {
     tiempoInicio = nowTimestamp();
+    manifiesto = ManifiestoLog(this->logPath + ".manifiesto");
+    manifiesto.cargar();
+    recuperarSinComprimir();
+    if (!columnar.abrir(this->logPath + ".col")) {
+        std::cerr << "Warning: los reportes usarán sólo el log CSV" << std::endl;
+    }
+    cargarSegmentoActivo();
     fileStream.open(this->logPath, std::ios::app);
     if (!fileStream.is_open()) {
         std::cerr << "Warning: could not open log file: " << this->logPath << std::endl;
     }
+    hiloCompresion = std::thread(&GestorReportes::bucleCompresion, this);
 }
 
 GestorReportes::~GestorReportes() {
+    // Lo rotado se termina de comprimir antes de cerrar
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        detenerCompresion = true;
+    }
+    cvCompresion.notify_all();
+    if (hiloCompresion.joinable()) hiloCompresion.join();
     if (fileStream.is_open()) fileStream.close();
+    columnar.cerrar();
+}
+
+// Número NNNNNN del segmento: <log>.NNNNNN
+static std::string baseSegmento(const std::string &logPath, std::size_t n) {
+    char sufijo[16];
+    std::snprintf(sufijo, sizeof(sufijo), ".%06zu", n);
+    return logPath + sufijo;
+}
+
+void GestorReportes::recuperarSinComprimir() {
+    // Segmentos rotados que el servidor no llegó a comprimir antes de cerrarse:
+    // siguen al último del manifiesto como <log>.NNNNNN.csv
+    for (std::size_t n = manifiesto.segmentos().size() + 1; ; ++n) {
+        std::string base = baseSegmento(logPath, n);
+        SegmentoLog seg;
+        seg.archivo = base + ".csv";
+        if (!std::ifstream(seg.archivo).is_open()) break;
+        leerLineasLog(seg.archivo, false, [&seg](const std::string &linea) {
+            std::string ts = timestampDeLinea(linea);
+            if (seg.lineas == 0) seg.desde = ts;
+            if (!ts.empty()) seg.hasta = ts;
+            ++seg.lineas;
+        });
+        if (std::ifstream(base + ".col").is_open()) seg.columnar = base + ".col";
+        manifiesto.agregarPendiente(seg);
+        porComprimir.push_back(manifiesto.segmentos().size() - 1);
+    }
+}
+
+void GestorReportes::bucleCompresion() {
+    std::unique_lock<std::mutex> lk(mtx);
+    while (true) {
+        cvCompresion.wait(lk, [this] { return detenerCompresion || !porComprimir.empty(); });
+        if (porComprimir.empty()) return; // detenido y sin nada pendiente
+        std::size_t indice = porComprimir.front();
+        porComprimir.pop_front();
+        comprimiendo = true;
+        std::string origen = manifiesto.segmentos()[indice].archivo;
+        std::string destino = origen.substr(0, origen.size() - 4) + ".gz";
+        int nivel = rotacion.nivelCompresion;
+
+        // Sin el cerrojo: el log, las suscripciones y los reportes siguen mientras tanto
+        lk.unlock();
+        bool ok = comprimirSegmento(origen, destino, nivel);
+        lk.lock();
+
+        if (ok) {
+            // Quien ya tomó la ruta del .csv pasa al .gz si no llega a abrirlo
+            manifiesto.confirmar(indice, destino);
+            std::remove(origen.c_str());
+        } else {
+            std::cerr << "Error: el segmento " << origen << " queda sin comprimir" << std::endl;
+            manifiesto.confirmar(indice, origen);
+        }
+        comprimiendo = false;
+        cvCompresion.notify_all();
+    }
+}
+
+void GestorReportes::esperarCompresion() {
+    std::unique_lock<std::mutex> lk(mtx);
+    cvCompresion.wait(lk, [this] { return porComprimir.empty() && !comprimiendo; });
 }
 
 std::string GestorReportes::nowTimestamp() {
@@ -26,8 +176,14 @@ std::string GestorReportes::nowTimestamp() {
     return ss.str();
 }
 
-void GestorReportes::appendLogLine(const std::string &line) {
+void GestorReportes::appendLogLine(const RegistroLog &registro) {
+    std::string line = registro.aCsv();
     std::lock_guard<std::mutex> lk(mtx);
+    std::time_t ahora = std::time(nullptr);
+    // Un segmento demasiado viejo se cierra antes de escribir la línea nueva
+    if (lineasSegmento > 0 && rotacion.maxSegundos > 0 && ahora - inicioSegmento >= rotacion.maxSegundos) {
+        rotarLocked();
+    }
     if (fileStream.is_open()) {
         fileStream << line << "\n";
         fileStream.flush();
@@ -36,66 +192,322 @@ void GestorReportes::appendLogLine(const std::string &line) {
         std::ofstream ofs(logPath, std::ios::app);
         if (ofs.is_open()) ofs << line << "\n";
     }
+    if (columnar.estaAbierto()) columnar.agregar(registro);
+
+    std::string ts = timestampDeLinea(line);
+    if (lineasSegmento == 0) {
+        desdeSegmento = ts;
+        inicioSegmento = ahora;
+    }
+    if (!ts.empty()) hastaSegmento = ts;
+    ++lineasSegmento;
+    bytesSegmento += line.size() + 1;
+    if (rotacion.maxBytes > 0 && bytesSegmento >= rotacion.maxBytes) {
+        rotarLocked();
+    }
+}
+
+void GestorReportes::cargarSegmentoActivo() {
+    // Un log que ya existía al arrancar sigue siendo el segmento activo
+    leerLineasLog(logPath, false, [this](const std::string &linea) {
+        std::string ts = timestampDeLinea(linea);
+        if (lineasSegmento == 0) desdeSegmento = ts;
+        if (!ts.empty()) hastaSegmento = ts;
+        ++lineasSegmento;
+        bytesSegmento += linea.size() + 1;
+    });
+    inicioSegmento = parsearTimestamp(desdeSegmento);
+    if (inicioSegmento == 0) inicioSegmento = std::time(nullptr);
+    if (!columnar.estaAbierto()) return;
+
+    // El log columnar puede haber quedado atrás del CSV (filas sin volcar en una
+    // caída, o un log anterior a él); si tiene más filas, no es de este CSV
+    std::size_t indexadas = columnar.filas();
+    if (indexadas > lineasSegmento) {
+        std::cerr << "Warning: " << columnar.ruta() << " no corresponde al log, se regenera" << std::endl;
+        std::string ruta = columnar.ruta();
+        columnar.cerrar();
+        std::remove(ruta.c_str());
+        columnar.abrir(ruta);
+        indexadas = 0;
+    }
+    if (indexadas < lineasSegmento) {
+        std::size_t i = 0;
+        leerLineasLog(logPath, false, [&](const std::string &linea) {
+            if (i++ < indexadas) return;
+            RegistroLog r;
+            if (!RegistroLog::desdeCsv(linea, r)) {
+                r = RegistroLog(); // se conserva para no desalinear la cuenta de filas
+                r.detalle = linea;
+            }
+            columnar.agregar(r);
+        });
+        columnar.volcar();
+    }
+}
+
+void GestorReportes::configurarRotacion(const ConfiguracionRotacion &config) {
+    std::lock_guard<std::mutex> lk(mtx);
+    rotacion = config;
+}
+
+bool GestorReportes::rotarLog() {
+    std::lock_guard<std::mutex> lk(mtx);
+    return rotarLocked();
+}
+
+std::vector<SegmentoLog> GestorReportes::segmentosLog() {
+    std::lock_guard<std::mutex> lk(mtx);
+    return manifiesto.segmentos();
+}
+
+bool GestorReportes::rotarLocked() {
+    if (lineasSegmento == 0) return false;
+
+    std::string base;
+    for (std::size_t n = manifiesto.segmentos().size() + 1; ; ++n) {
+        base = baseSegmento(logPath, n);
+        if (!std::ifstream(base + ".gz").good() && !std::ifstream(base + ".csv").good()) break;
+    }
+
+    // Con el cerrojo sólo se renombra (quien esté leyendo el activo conserva su
+    // copia); bucleCompresion comprime después sin frenar a quien escribe el log
+    if (fileStream.is_open()) fileStream.close();
+    std::string cerrado = base + ".csv";
+    bool ok = std::rename(logPath.c_str(), cerrado.c_str()) == 0;
+    if (ok) {
+        // El log columnar acompaña al segmento con el mismo número
+        std::string columnarCerrado;
+        if (columnar.estaAbierto()) {
+            std::string activo = columnar.ruta();
+            columnar.cerrar();
+            columnarCerrado = base + ".col";
+            if (std::rename(activo.c_str(), columnarCerrado.c_str()) != 0) {
+                std::cerr << "Error: no se pudo cerrar " << activo << ", el segmento se consultará por CSV" << std::endl;
+                std::remove(activo.c_str());
+                columnarCerrado.clear();
+            }
+            columnar.abrir(activo);
+        }
+        manifiesto.agregarPendiente(SegmentoLog{cerrado, desdeSegmento, hastaSegmento, lineasSegmento, columnarCerrado});
+        porComprimir.push_back(manifiesto.segmentos().size() - 1);
+        cvCompresion.notify_all();
+        bytesSegmento = 0;
+        lineasSegmento = 0;
+        desdeSegmento.clear();
+        hastaSegmento.clear();
+    } else {
+        std::cerr << "Error: no se pudo rotar el log " << logPath << std::endl;
+    }
+    fileStream.open(logPath, std::ios::app);
+    return ok;
+}
+
+std::vector<std::string> GestorReportes::escanearLog(const ConsultaLog &consulta) {
+    auto interesa = [&consulta](const std::string &desde, const std::string &hasta) {
+        return segmentoInteresa(consulta, desde, hasta);
+    };
+
+    std::vector<SegmentoLog> aLeer;
+    bool leerActivo = false;
+    LogColumnar::Instantanea activoColumnar;
+    std::ifstream activoCsv;
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        for (const auto &seg : manifiesto.segmentos()) {
+            if (interesa(seg.desde, seg.hasta)) aLeer.push_back(seg);
+        }
+        // Se toma con el cerrojo para que una rotación posterior no lo cambie
+        leerActivo = lineasSegmento > 0 && interesa(desdeSegmento, hastaSegmento);
+        if (leerActivo && columnar.estaAbierto()) {
+            activoColumnar = columnar.instantanea();
+        } else if (leerActivo) {
+            activoCsv.open(logPath);
+        }
+    }
+
+    // Segmentos sin log columnar: el texto se recorre por bloques buscando los
+    // patrones de la consulta, y sólo las líneas candidatas se separan en campos
+    FiltroLineas candidatas(patronesDe(consulta));
+    auto filtrarBloque = [&](std::vector<std::string> &salida, const char *texto, std::size_t n) {
+        candidatas.recorrer(texto, n, [&](const char *linea, std::size_t largo) {
+            std::string copia(linea, largo);
+            RegistroLog r;
+            if (RegistroLog::desdeCsv(copia, r) && consulta.coincide(r)) salida.push_back(std::move(copia));
+            return true;
+        });
+    };
+
+    // Un resultado parcial por segmento; el activo va último
+    std::vector<std::vector<std::string>> parciales(aLeer.size() + 1);
+    paraCadaEnParalelo(parciales.size(), [&](std::size_t i) {
+        std::vector<std::string> &salida = parciales[i];
+        auto porBloque = [&](const char *texto, std::size_t n) { filtrarBloque(salida, texto, n); };
+        if (i < aLeer.size()) {
+            const SegmentoLog &seg = aLeer[i];
+            if (seg.columnar.empty() || !LogColumnar::consultar(seg.columnar, consulta, salida)) {
+                salida.clear();
+                leerBloquesSegmentoDesde(seg, 0, [&](const char *texto, std::size_t n, std::uint64_t) {
+                    porBloque(texto, n);
+                    return true;
+                });
+            }
+        } else if (leerActivo && activoColumnar.archivo) {
+            LogColumnar::consultar(activoColumnar, consulta, salida);
+        } else if (activoCsv.is_open()) {
+            std::string texto((std::istreambuf_iterator<char>(activoCsv)), std::istreambuf_iterator<char>());
+            porBloque(texto.data(), texto.size());
+        }
+    });
+
+    // Los segmentos están en orden cronológico, así que basta concatenar; sólo
+    // se reordena si el reloj retrocedió en algún momento
+    std::vector<std::string> lineas;
+    std::size_t total = 0;
+    for (const auto &p : parciales) total += p.size();
+    lineas.reserve(total);
+    for (auto &p : parciales) {
+        std::move(p.begin(), p.end(), std::back_inserter(lineas));
+    }
+    auto porTimestamp = [](const std::string &a, const std::string &b) {
+        return timestampDeLinea(a) < timestampDeLinea(b);
+    };
+    if (!std::is_sorted(lineas.begin(), lineas.end(), porTimestamp)) {
+        std::stable_sort(lineas.begin(), lineas.end(), porTimestamp);
+    }
+    return lineas;
+}
+
+void GestorReportes::actualizarCampo(CampoEstado &campo, const std::string &valor) {
+    // Sólo los cambios reales despiertan a los suscriptores
+    if (campo.valor == valor) return;
+    campo.valor = valor;
+    campo.version = ++version;
+    cvEstado.notify_all();
 }
 
 void GestorReportes::actualizarEstadoConexion(const std::string &estado) {
     std::lock_guard<std::mutex> lk(mtx);
-    estadoConexion = estado;
+    actualizarCampo(estadoConexion, estado);
     tiempoInicio = nowTimestamp();
 }
 
 void GestorReportes::actualizarPosicion(const std::string &pos) {
     std::lock_guard<std::mutex> lk(mtx);
-    posicion = pos;
+    actualizarCampo(posicion, pos);
 }
 
 void GestorReportes::actualizarEstadoActividad(const std::string &act) {
     std::lock_guard<std::mutex> lk(mtx);
-    estadoActividad = act;
+    actualizarCampo(estadoActividad, act);
+}
+
+void GestorReportes::actualizarEstadoEjecucion(const std::string &estado) {
+    std::lock_guard<std::mutex> lk(mtx);
+    actualizarCampo(estadoEjecucion, estado);
+}
+
+unsigned long GestorReportes::versionEstado() {
+    std::lock_guard<std::mutex> lk(mtx);
+    return version;
+}
+
+CambiosEstado GestorReportes::esperarCambios(unsigned long ultimaVersion, int timeoutMs) {
+    std::unique_lock<std::mutex> lk(mtx);
+    // Una versión mayor que la actual viene de un servidor anterior: se reenvía todo
+    if (ultimaVersion > version) ultimaVersion = 0;
+    if (ultimaVersion > 0 && timeoutMs > 0) {
+        cvEstado.wait_for(lk, std::chrono::milliseconds(timeoutMs),
+                          [&] { return version > ultimaVersion || cerrando; });
+    }
+
+    CambiosEstado cambios;
+    cambios.version = version;
+    const std::pair<const char*, const CampoEstado*> campos[] = {
+        {"estadoConexion", &estadoConexion},
+        {"posicion", &posicion},
+        {"estadoActividad", &estadoActividad},
+        {"estadoEjecucion", &estadoEjecucion},
+    };
+    for (const auto &c : campos) {
+        if (ultimaVersion == 0 || c.second->version > ultimaVersion) {
+            cambios.campos[c.first] = c.second->valor;
+        }
+    }
+    return cambios;
+}
+
+void GestorReportes::despertarSuscriptores() {
+    std::lock_guard<std::mutex> lk(mtx);
+    cerrando = true;
+    cvEstado.notify_all();
 }
 
 void GestorReportes::registrarPeticion(const std::string &detalle, const std::string &usuario,
                                        const std::string &nodo, const std::string &codigo) {
-    std::ostringstream line;
-    line << "\"" << nowTimestamp() << "\",\"REQUEST\",\"" << detalle << "\",\"" << usuario << "\",\"" << nodo << "\",\"" << codigo << "\",\"RPC\"";
-    appendLogLine(line.str());
+    RegistroLog r;
+    r.instante = RegistroLog::instanteDesdeTexto(nowTimestamp());
+    r.tipo = "REQUEST";
+    r.detalle = detalle;
+    r.usuario = usuario;
+    r.nodo = nodo;
+    r.codigo = codigo;
+    r.modulo = "RPC";
+    appendLogLine(r);
 
     std::lock_guard<std::mutex> lk(mtx);
-    Orden o{detalle, codigo};
-    ordenesPorUsuario[usuario].push_back(o);
+    HistorialUsuario &h = historialDe(usuario);
+    ++h.total;
+    if (codigo != "200" && codigo != "OK") ++h.errores;
+    h.recientes.agregar(Orden{detalle, codigo});
+}
+
+GestorReportes::HistorialUsuario &GestorReportes::historialDe(const std::string &usuario) {
+    auto it = ordenesPorUsuario.find(usuario);
+    if (it == ordenesPorUsuario.end()) {
+        it = ordenesPorUsuario.emplace(usuario, HistorialUsuario(capacidadHistorial)).first;
+    }
+    return it->second;
 }
 
 std::string GestorReportes::reporteGeneral(const std::string &usuario) {
     std::lock_guard<std::mutex> lk(mtx);
     std::ostringstream out;
     out << "usuario," << usuario << "\n";
-    out << "estadoConexion," << estadoConexion << "\n";
-    out << "posicion," << posicion << "\n";
-    out << "estadoActividad," << estadoActividad << "\n";
+    out << "estadoConexion," << estadoConexion.valor << "\n";
+    out << "posicion," << posicion.valor << "\n";
+    out << "estadoActividad," << estadoActividad.valor << "\n";
     std::string inicio = tiempoInicio;
     auto itInicio = tiempoInicioPorUsuario.find(usuario);
     if (itInicio != tiempoInicioPorUsuario.end()) inicio = itInicio->second;
     out << "inicioActividad," << inicio << "\n";
 
-    int total = 0, errores = 0;
+    unsigned long total = 0, errores = 0, mostradas = 0;
     out << "orden_detalle,resultado\n";
     auto it = ordenesPorUsuario.find(usuario);
     if (it != ordenesPorUsuario.end()) {
-        for (const auto &o : it->second) {
+        const HistorialUsuario &h = it->second;
+        h.recientes.paraCada([&out](const Orden &o) {
             out << '"' << o.detalle << "\"," << o.resultado << "\n";
-            ++total;
-            if (o.resultado != "200" && o.resultado != "OK") ++errores;
-        }
+        });
+        total = h.total;
+        errores = h.errores;
+        mostradas = h.recientes.tamano();
     }
     out << "total_ordenes," << total << "\n";
     out << "ordenes_erroneas," << errores << "\n";
+    // Las más antiguas ya no están en memoria, pero siguen en el log
+    if (total > mostradas) out << "ordenes_omitidas," << (total - mostradas) << "\n";
     return out.str();
 }
 
 void GestorReportes::registrarConexionUsuario(const std::string &usuario) {
     std::lock_guard<std::mutex> lk(mtx);
     tiempoInicioPorUsuario[usuario] = nowTimestamp();
-    ordenesPorUsuario[usuario].clear();
+    HistorialUsuario &h = historialDe(usuario);
+    h.recientes.limpiar();
+    h.total = 0;
+    h.errores = 0;
 }
 
 std::string GestorReportes::reporteAdmin() {
@@ -109,24 +521,219 @@ std::string GestorReportes::reporteAdmin() {
 
 std::string GestorReportes::reporteLog(const std::string &desde, const std::string &hasta,
                                        const std::string &usuarioFilter, const std::string &codigoFilter) {
-    std::ifstream ifs(logPath);
-    if (!ifs.is_open()) return "error,missing_log\n";
+    if (segmentosLog().empty() && !std::ifstream(logPath).is_open()) return "error,missing_log\n";
+    std::vector<std::string> lineas = escanearLog(crearConsulta(desde, hasta, usuarioFilter, codigoFilter));
     std::ostringstream out;
-    std::string line;
-    while (std::getline(ifs, line)) {
-        size_t p1 = line.find('"');
-        if (p1 == std::string::npos) continue;
-        size_t p2 = line.find('"', p1+1);
-        if (p2 == std::string::npos) continue;
-        std::string ts = line.substr(p1+1, p2-p1-1);
-        if (ts < desde || ts > hasta) continue;
-        if (!usuarioFilter.empty() && line.find(std::string("\"") + usuarioFilter + "\"") == std::string::npos) continue;
-        if (!codigoFilter.empty() && line.find(std::string("\"") + codigoFilter + "\"") == std::string::npos) continue;
-        out << line << "\n";
-    }
+    for (const auto &line : lineas) out << line << "\n";
     return out.str();
 }
 
+ConsultaLog GestorReportes::crearConsulta(const std::string &desde, const std::string &hasta,
+                                          const std::string &usuario, const std::string &codigo,
+                                          const std::vector<std::string> &textos) {
+    // Las fechas incompletas ("2024-10-28") abarcan el día entero
+    ConsultaLog consulta;
+    if (!desde.empty()) {
+        std::int64_t d = RegistroLog::instanteDesdeTexto(completarTimestamp(desde, "0000-01-01 00:00:00"));
+        if (d >= 0) consulta.desde = d;
+    }
+    if (!hasta.empty()) {
+        std::int64_t h = RegistroLog::instanteDesdeTexto(completarTimestamp(hasta, "9999-12-31 23:59:59"));
+        if (h >= 0) consulta.hasta = h;
+    }
+    consulta.usuario = usuario;
+    consulta.codigo = codigo;
+    for (std::string t : textos) {
+        if (t.empty()) continue;
+        std::transform(t.begin(), t.end(), t.begin(), ::tolower);
+        consulta.subcadenas.push_back(t);
+    }
+    return consulta;
+}
+
+bool GestorReportes::paginaLog(const ConsultaLog &consulta, std::string cursor, std::size_t limite,
+                               PaginaLog &pagina) {
+    pagina = PaginaLog();
+    CursorLog c;
+    if (!cursor.empty() && !cursorDesdeTexto(cursor, c)) {
+        std::cerr << "Error: cursor de log inválido: " << cursor << std::endl;
+        return false;
+    }
+    if (limite == 0) limite = 1;
+
+    // Como en escanearLog, el estado del activo se toma con el cerrojo (y su CSV
+    // se abre ahí, así una rotación posterior no lo cambia); del CSV activo sólo
+    // se leen los bytes que ya tenía en ese momento
+    std::vector<SegmentoLog> segmentos;
+    LogColumnar::Instantanea activoColumnar;
+    std::ifstream activoCsv;
+    std::uint64_t bytesActivo;
+    std::string desdeActivo, hastaActivo;
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        segmentos = manifiesto.segmentos();
+        if (columnar.estaAbierto()) activoColumnar = columnar.instantanea();
+        else activoCsv.open(logPath, std::ios::binary);
+        bytesActivo = bytesSegmento;
+        desdeActivo = desdeSegmento;
+        hastaActivo = hastaSegmento;
+    }
+    if (c.segmento > segmentos.size()) {
+        std::cerr << "Error: el cursor apunta a un segmento inexistente: " << cursor << std::endl;
+        return false;
+    }
+
+    FiltroLineas candidatas(patronesDe(consulta));
+    while (true) {
+        const bool esActivo = c.segmento == segmentos.size();
+        const SegmentoLog *seg = esActivo ? nullptr : &segmentos[c.segmento];
+        const bool conColumnas = esActivo ? activoColumnar.archivo && activoColumnar.archivo->is_open()
+                                          : !seg->columnar.empty();
+        if (c.tipo == 0) {
+            c.tipo = conColumnas ? 'c' : 't';
+        } else if ((c.tipo == 'c') != conColumnas) {
+            std::cerr << "Error: el segmento " << c.segmento << " cambió desde que se emitió el cursor" << std::endl;
+            return false;
+        }
+
+        bool terminado = true;
+        if (segmentoInteresa(consulta, esActivo ? desdeActivo : seg->desde, esActivo ? hastaActivo : seg->hasta)) {
+            const std::size_t resto = limite - pagina.lineas.size();
+            if (c.tipo == 'c') {
+                LogColumnar::Posicion posicion{c.offset, c.fila};
+                bool ok = esActivo
+                    ? LogColumnar::consultarPagina(activoColumnar, consulta, posicion, resto, pagina.lineas, terminado)
+                    : LogColumnar::consultarPagina(seg->columnar, consulta, posicion, resto, pagina.lineas, terminado);
+                if (!ok) return false;
+                c.offset = posicion.bloque;
+                c.fila = posicion.fila;
+            } else {
+                const std::uint64_t tope = esActivo ? bytesActivo : std::numeric_limits<std::uint64_t>::max();
+                std::uint64_t siguiente = c.offset;
+                auto porBloque = [&](const char *texto, std::size_t n, std::uint64_t offsetBloque) {
+                    if (offsetBloque >= tope) return false;
+                    n = static_cast<std::size_t>(std::min<std::uint64_t>(n, tope - offsetBloque));
+                    bool seguir = candidatas.recorrer(texto, n, [&](const char *linea, std::size_t largo) {
+                        if (pagina.lineas.size() >= limite) {
+                            siguiente = offsetBloque + static_cast<std::uint64_t>(linea - texto);
+                            return false;
+                        }
+                        std::string copia(linea, largo);
+                        RegistroLog r;
+                        if (RegistroLog::desdeCsv(copia, r) && consulta.coincide(r)) pagina.lineas.push_back(std::move(copia));
+                        return true;
+                    });
+                    if (!seguir) {
+                        terminado = false;
+                        return false;
+                    }
+                    siguiente = offsetBloque + n;
+                    return true;
+                };
+                bool ok = esActivo ? leerBloquesLogDesde(activoCsv, c.offset, porBloque)
+                                   : leerBloquesSegmentoDesde(*seg, c.offset, porBloque, &lectoresGzip);
+                if (!ok && !esActivo) return false;
+                c.offset = siguiente;
+            }
+        }
+        // El activo es el último: desde su posición final se retoma lo que se agregue
+        if (!terminado || esActivo) {
+            pagina.cursor = cursorATexto(c);
+            pagina.hayMas = !terminado;
+            return true;
+        }
+        std::size_t siguienteSegmento = c.segmento + 1;
+        c = CursorLog();
+        c.segmento = siguienteSegmento;
+    }
+}
+
+void GestorReportes::ultimasLineasLog(const ConsultaLog &consulta, std::size_t cuantas, PaginaLog &pagina) {
+    pagina = PaginaLog();
+    std::vector<SegmentoLog> segmentos;
+    std::uint64_t bytesActivo;
+    std::ifstream activoCsv;
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        segmentos = manifiesto.segmentos();
+        bytesActivo = bytesSegmento;
+        activoCsv.open(logPath, std::ios::binary); // como en paginaLog
+    }
+
+    std::vector<std::string> recientes; // de la más nueva a la más vieja
+    auto hastaCompletar = [&](const char *linea, std::size_t largo) {
+        std::string copia(linea, largo);
+        RegistroLog r;
+        if (RegistroLog::desdeCsv(copia, r) && consulta.coincide(r)) recientes.push_back(std::move(copia));
+        return recientes.size() < cuantas;
+    };
+    leerLineasHaciaAtras(activoCsv, bytesActivo, hastaCompletar);
+
+    FiltroLineas candidatas(patronesDe(consulta));
+    for (std::size_t i = segmentos.size(); i-- > 0 && recientes.size() < cuantas;) {
+        const SegmentoLog &seg = segmentos[i];
+        if (!segmentoInteresa(consulta, seg.desde, seg.hasta)) continue;
+        if (!segmentoComprimido(seg) && leerLineasHaciaAtras(seg.archivo, std::numeric_limits<std::uint64_t>::max(), hastaCompletar)) continue;
+        // Un gzip sólo se lee hacia adelante: se conservan las últimas que faltan
+        const std::size_t faltan = cuantas - recientes.size();
+        std::deque<std::string> ultimas;
+        leerBloquesSegmentoDesde(seg, 0, [&](const char *texto, std::size_t n, std::uint64_t) {
+            candidatas.recorrer(texto, n, [&](const char *linea, std::size_t largo) {
+                std::string copia(linea, largo);
+                RegistroLog r;
+                if (RegistroLog::desdeCsv(copia, r) && consulta.coincide(r)) {
+                    ultimas.push_back(std::move(copia));
+                    if (ultimas.size() > faltan) ultimas.pop_front();
+                }
+                return true;
+            });
+            return true;
+        });
+        std::move(ultimas.rbegin(), ultimas.rend(), std::back_inserter(recientes));
+    }
+    pagina.lineas.assign(std::make_move_iterator(recientes.rbegin()), std::make_move_iterator(recientes.rend()));
+}
+
+bool GestorReportes::exportarLog(const ConsultaLog &consulta, const std::string &rutaDestino, char formato,
+                                 std::size_t &filas) {
+    static const std::size_t FILAS_POR_PAGINA = 4096;
+    filas = 0;
+    // La extensión .csv elige el parser al convertir
+    const std::string temporal = rutaDestino + ".tmp.csv";
+    {
+        std::ofstream csv(temporal, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!csv) {
+            std::cerr << "Error: no se pudo crear " << temporal << std::endl;
+            return false;
+        }
+        csv << "instante,tipo,detalle,usuario,nodo,codigo,modulo\n";
+        PaginaLog pagina;
+        std::string cursor;
+        do {
+            if (!paginaLog(consulta, cursor, FILAS_POR_PAGINA, pagina)) break;
+            for (const auto &linea : pagina.lineas) csv << linea << '\n';
+            filas += pagina.lineas.size();
+            cursor = pagina.cursor;
+        } while (pagina.hayMas);
+        if (!csv.flush()) {
+            std::cerr << "Error: no se pudo escribir " << temporal << std::endl;
+            csv.close();
+            std::remove(temporal.c_str());
+            return false;
+        }
+    }
+    // En CSV el temporal ya es el resultado, con los campos entre comillas
+    if (std::tolower(static_cast<unsigned char>(formato)) == 'c') {
+        if (std::rename(temporal.c_str(), rutaDestino.c_str()) == 0) return true;
+        std::cerr << "Error: no se pudo escribir " << rutaDestino << std::endl;
+        std::remove(temporal.c_str());
+        return false;
+    }
+    bool ok = GestorArchivos::exportarArchivo(temporal, rutaDestino, formato);
+    std::remove(temporal.c_str());
+    return ok;
+}
+
 std::string GestorReportes::reporteAdminPorUsuario(const std::string &usuario) {
     return reporteLog("0000-00-00 00:00:00", "9999-12-31 23:59:59", usuario, "");
 }
@@ -136,32 +743,17 @@ std::string GestorReportes::reporteAdminPorCodigo(const std::string &codigo) {
 }
 
 void GestorReportes::registrarEvento(const std::string &mensaje, const std::string &usuario, const std::string &nodo, const std::string &modulo) {
-    std::ostringstream line;
-    line << "\"" << nowTimestamp() << "\",\"EVENTO\",\"" << mensaje << "\",\"" 
-         << (usuario.empty() ? "SISTEMA" : usuario) << "\",\"" 
-         << (nodo.empty() ? "localhost" : nodo) << "\",\"\"";
-    if (!modulo.empty()) {
-        line << ",\"" << modulo << "\"";
-    } else {
-        line << ",\"SERVIDOR\"";
-    }
-    appendLogLine(line.str());
+    RegistroLog r;
+    r.instante = RegistroLog::instanteDesdeTexto(nowTimestamp());
+    r.tipo = "EVENTO";
+    r.detalle = mensaje;
+    r.usuario = usuario.empty() ? "SISTEMA" : usuario;
+    r.nodo = nodo.empty() ? "localhost" : nodo;
+    r.modulo = modulo.empty() ? "SERVIDOR" : modulo;
+    appendLogLine(r);
 }
 
 std::vector<std::string> GestorReportes::filtrarLog(const std::string &filtro1, const std::string &filtro2) {
-    std::vector<std::string> resultados;
-    std::ifstream ifs(logPath);
-    if (!ifs.is_open()) return resultados;
-    std::string linea;
-    std::string f1 = filtro1; std::string f2 = filtro2;
-    std::transform(f1.begin(), f1.end(), f1.begin(), ::tolower);
-    std::transform(f2.begin(), f2.end(), f2.begin(), ::tolower);
-    while (std::getline(ifs, linea)) {
-        std::string low = linea;
-        std::transform(low.begin(), low.end(), low.begin(), ::tolower);
-        bool m1 = f1.empty() || (low.find(f1) != std::string::npos);
-        bool m2 = f2.empty() || (low.find(f2) != std::string::npos);
-        if (m1 && m2) resultados.push_back(linea);
-    }
-    return resultados;
+    // Cada filtro debe aparecer, sin distinguir mayúsculas, en algún campo
+    return escanearLog(crearConsulta("", "", "", "", {filtro1, filtro2}));
 }
\ No newline at end of file
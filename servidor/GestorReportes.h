@@ -5,23 +5,63 @@
 #include <vector>
 #include <unordered_map>
 #include <mutex>
+#include <condition_variable>
+#include <map>
 #include <fstream>
+#include <ctime>
+#include <deque>
+#include <thread>
+#include "BufferCircular.h"
+#include "SegmentosLog.h"
+#include "LogColumnar.h"
 
 struct Orden {
     std::string detalle;
     std::string resultado; // código o texto
 };
 
+// Cuándo se cierra el segmento activo del log y se comprime
+struct ConfiguracionRotacion {
+    std::size_t maxBytes = 8 * 1024 * 1024;
+    long maxSegundos = 24 * 60 * 60;   // 0 = sólo por tamaño
+    int nivelCompresion = 1;           // gzip 1..9; se comprime en segundo plano
+};
+
+// Una página de un reporte del log. El cursor es opaco para el cliente: se
+// devuelve tal cual para pedir la página siguiente, y sigue sirviendo después
+// de terminar para leer lo que se agregue más tarde.
+struct PaginaLog {
+    std::vector<std::string> lineas;
+    std::string cursor;
+    bool hayMas = false;
+};
+
+// Respuesta de una suscripción: versión alcanzada y campos modificados desde la pedida
+struct CambiosEstado {
+    unsigned long version;
+    std::map<std::string, std::string> campos;
+};
+
 class GestorReportes {
 public:
-    // Constructor: acepta ruta de log por defecto
-    explicit GestorReportes(const std::string &logPath = "servidor_log.csv");
+    // Constructor: acepta ruta de log por defecto y cuántas órdenes recientes
+    // se conservan por usuario para el reporte general
+    explicit GestorReportes(const std::string &logPath = "servidor_log.csv",
+                            std::size_t capacidadHistorial = 100);
     ~GestorReportes();
 
     // Estado en memoria (para reportes por usuario)
     void actualizarEstadoConexion(const std::string &estado);
     void actualizarPosicion(const std::string &pos);
     void actualizarEstadoActividad(const std::string &act);
+    void actualizarEstadoEjecucion(const std::string &estado);
+
+    // Suscripción al estado: cada cambio real de un campo incrementa la versión.
+    // esperarCambios bloquea hasta que haya una versión posterior a 'ultimaVersion'
+    // o venza el plazo, y devuelve sólo los campos modificados después de ella.
+    unsigned long versionEstado();
+    CambiosEstado esperarCambios(unsigned long ultimaVersion, int timeoutMs);
+    void despertarSuscriptores(); // al detener el servidor
 
     // Registrar peticiones (persisten en CSV y también almacenan en memoria)
     void registrarPeticion(const std::string &detalle, const std::string &usuario,
@@ -30,12 +70,40 @@ public:
     // Registrar inicio de conexión para un usuario (resetea órdenes recientes)
     void registrarConexionUsuario(const std::string &usuario);
 
+    // Rotación del log: al superar el tamaño o la antigüedad configurados, el
+    // segmento activo se renombra a <log>.NNNNNN.csv (ya se consulta como rotado);
+    // un hilo lo comprime a <log>.NNNNNN.gz y al terminar lo anota en <log>.manifiesto
+    void configurarRotacion(const ConfiguracionRotacion &config);
+    bool rotarLog();
+    std::vector<SegmentoLog> segmentosLog();
+    void esperarCompresion(); // hasta que no quede ningún segmento por comprimir
+
     // Reportes solicitados por test y por RPC
     std::string reporteGeneral(const std::string &usuario);
-    std::string reporteAdmin();
+    std::string reporteAdmin(); // sólo el segmento activo; lo rotado, con reporteLog
+    // Recorre en paralelo los segmentos que solapan [desde, hasta] y devuelve
+    // las líneas en orden de timestamp. Usuario y código deben coincidir exactos.
     std::string reporteLog(const std::string &desde, const std::string &hasta,
                            const std::string &usuarioFilter = "", const std::string &codigoFilter = "");
 
+    // Consulta para reporteLog/paginaLog: fechas parciales abarcan el período
+    // entero y vacías no limitan; los textos se buscan sin distinguir mayúsculas
+    static ConsultaLog crearConsulta(const std::string &desde, const std::string &hasta,
+                                     const std::string &usuario = "", const std::string &codigo = "",
+                                     const std::vector<std::string> &textos = {});
+    // Hasta 'limite' líneas a partir de 'cursor' ("" = principio), recorriendo
+    // los segmentos en orden sin cargar el resto. false si el cursor no es válido.
+    // El cursor va por copia: puede ser el de la misma 'pagina' que se rellena.
+    bool paginaLog(const ConsultaLog &consulta, std::string cursor, std::size_t limite, PaginaLog &pagina);
+    // Las últimas 'cuantas' líneas que cumplen la consulta, en orden: el activo se
+    // lee hacia atrás desde el final y los rotados sólo si faltan (sin cursor)
+    void ultimasLineasLog(const ConsultaLog &consulta, std::size_t cuantas, PaginaLog &pagina);
+    std::size_t lecturasGzipReanudadas() { return lectoresGzip.reanudados(); }
+    // Escribe en 'rutaDestino' las líneas que cumplen la consulta como CSV, JSON o
+    // XML ('c', 'j', 'x'). Se vuelcan por páginas a un CSV con encabezados que
+    // GestorArchivos::exportarArchivo convierte fila a fila: la memoria no depende del log.
+    bool exportarLog(const ConsultaLog &consulta, const std::string &rutaDestino, char formato, std::size_t &filas);
+
     // Métodos de ayuda para administrador (filtros por usuario o código)
     std::string reporteAdminPorUsuario(const std::string &usuario);
     std::string reporteAdminPorCodigo(const std::string &codigo);
@@ -51,20 +119,67 @@ private:
     std::string logPath;
     std::ofstream fileStream;
 
-    // in-memory state
+    // rotación: segmento activo (sin comprimir) y segmentos ya cerrados
+    ConfiguracionRotacion rotacion;
+    ManifiestoLog manifiesto;
+    std::size_t bytesSegmento = 0;
+    std::size_t lineasSegmento = 0;
+    std::string desdeSegmento, hastaSegmento;
+    std::time_t inicioSegmento = 0;
+
+    // Compresión en segundo plano: índices en el manifiesto de los segmentos
+    // rotados que faltan comprimir, en orden
+    std::deque<std::size_t> porComprimir;
+    bool comprimiendo = false;          // uno en curso, fuera del cerrojo
+    bool detenerCompresion = false;
+    std::condition_variable cvCompresion;
+    std::thread hiloCompresion;
+
+    // Copia por columnas del segmento activo (<log>.col), la que usan los filtros;
+    // al rotar se cierra junto al .gz como <log>.NNNNNN.col
+    LogColumnar columnar;
+
+    // Cursores 't' de los segmentos comprimidos: la página siguiente retoma el
+    // descompresor de la anterior
+    LectoresGzip lectoresGzip;
+
+    // in-memory state (cada campo guarda la versión en que cambió por última vez)
+    struct CampoEstado {
+        std::string valor;
+        unsigned long version = 0;
+    };
     std::mutex mtx;
-    std::string estadoConexion;
-    std::string posicion;
-    std::string estadoActividad;
+    CampoEstado estadoConexion;
+    CampoEstado posicion;
+    CampoEstado estadoActividad;
+    CampoEstado estadoEjecucion;
     std::string tiempoInicio; // fallback global
 
-    // track per-user data
-    std::unordered_map<std::string, std::vector<Orden>> ordenesPorUsuario;
+    unsigned long version = 1; // 0 lo usan los clientes que aún no recibieron nada
+    bool cerrando = false;
+    std::condition_variable cvEstado;
+
+    // track per-user data: sólo las últimas órdenes; los totales cuentan todas
+    struct HistorialUsuario {
+        BufferCircular<Orden> recientes;
+        unsigned long total = 0;
+        unsigned long errores = 0;
+        explicit HistorialUsuario(std::size_t capacidad) : recientes(capacidad) {}
+    };
+    std::size_t capacidadHistorial;
+    std::unordered_map<std::string, HistorialUsuario> ordenesPorUsuario;
     std::unordered_map<std::string, std::string> tiempoInicioPorUsuario;
 
     // helpers
     std::string nowTimestamp();
-    void appendLogLine(const std::string &line);
+    void appendLogLine(const RegistroLog &registro);
+    void cargarSegmentoActivo();
+    bool rotarLocked();                                                   // requiere mtx
+    void recuperarSinComprimir();
+    void bucleCompresion();
+    std::vector<std::string> escanearLog(const ConsultaLog &consulta);
+    void actualizarCampo(CampoEstado &campo, const std::string &valor); // requiere mtx
+    HistorialUsuario &historialDe(const std::string &usuario);            // requiere mtx
 };
 
 #endif // GESTORREPORTES_H
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef HILOSPARALELOS_H
+#define HILOSPARALELOS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Ejecuta tarea(i) para i en [0, n) repartiendo los índices entre tantos hilos
+// como núcleos haya (o maxHilos si se indica). Vuelve cuando terminaron todas.
+// Los índices se toman de a uno, así una tarea larga no frena a las demás.
+// No es un pool: los hilos se crean en cada llamada, así que conviene para
+// tareas que duran bastante más que crear un hilo (trozos de ~1 MB, segmentos).
+template <typename F>
+void paraCadaEnParalelo(std::size_t n, F tarea, unsigned maxHilos = 0) {
+    if (n == 0) return;
+    unsigned hilos = maxHilos ? maxHilos : std::max(1u, std::thread::hardware_concurrency());
+    hilos = static_cast<unsigned>(std::min<std::size_t>(hilos, n));
+    if (hilos <= 1) {
+        for (std::size_t i = 0; i < n; ++i) tarea(i);
+        return;
+    }
+
+    std::atomic<std::size_t> siguiente(0);
+    auto trabajar = [&]() {
+        for (std::size_t i = siguiente++; i < n; i = siguiente++) {
+            tarea(i);
+        }
+    };
+    std::vector<std::thread> trabajadores;
+    trabajadores.reserve(hilos - 1);
+    for (unsigned h = 1; h < hilos; ++h) {
+        trabajadores.emplace_back(trabajar);
+    }
+    trabajar(); // el hilo que llama también trabaja
+    for (auto& t : trabajadores) t.join();
+}
+
+#endif
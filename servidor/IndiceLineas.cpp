@@ -0,0 +1,343 @@
+#include "IndiceLineas.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char MAGICO[4] = {'I', 'L', 'N', '1'};
+// mágico, bytes, fecha, completas, inicioCola, último byte
+const std::size_t CABECERA = sizeof(MAGICO) + 4 * sizeof(std::uint64_t) + 1;
+const std::size_t TAM_LECTURA = 1 << 16;
+
+std::mutex mtxCache;
+std::string directorioCache;
+std::uint64_t maxBytesCache = 0;
+std::uint64_t bytesCache = 0; // aproximado: lo que había al podar más lo escrito desde entonces
+
+void ponerVarint(std::string &s, std::uint64_t v) {
+    while (v >= 0x80) {
+        s += static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    s += static_cast<char>(v);
+}
+
+// Lee un varint de s en 'pos' y avanza; false si está cortado
+bool tomarVarint(const std::string &s, std::size_t &pos, std::uint64_t &v) {
+    v = 0;
+    for (int desplazamiento = 0; pos < s.size() && desplazamiento < 64; desplazamiento += 7) {
+        unsigned char b = static_cast<unsigned char>(s[pos++]);
+        v |= static_cast<std::uint64_t>(b & 0x7F) << desplazamiento;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+template <typename T>
+void poner(std::string &s, T v) {
+    s.append(reinterpret_cast<const char *>(&v), sizeof(T));
+}
+
+template <typename T>
+T tomar(const char *&p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return v;
+}
+
+// Inversa del nombre que arma rutaCache: la ruta del archivo indexado
+std::string rutaIndexada(const std::string &nombreIdx) {
+    std::string ruta;
+    const std::size_t fin = nombreIdx.size() - 4; // sin ".idx"
+    for (std::size_t i = 0; i < fin; ++i) {
+        if (nombreIdx.compare(i, 3, "%2F") == 0) {
+            ruta += '/';
+            i += 2;
+        } else if (nombreIdx.compare(i, 3, "%25") == 0) {
+            ruta += '%';
+            i += 2;
+        } else {
+            ruta += nombreIdx[i];
+        }
+    }
+    return ruta;
+}
+
+std::int64_t fechaDe(const std::string &ruta) {
+    std::error_code ec;
+    auto fecha = fs::last_write_time(ruta, ec);
+    return ec ? 0 : static_cast<std::int64_t>(fecha.time_since_epoch().count());
+}
+
+} // namespace
+
+IndiceLineas::IndiceLineas() : generacion_(0) {
+    limpiar();
+}
+
+void IndiceLineas::configurarCache(const std::string &directorio, std::uint64_t maxBytes) {
+    std::error_code ec;
+    if (!directorio.empty() && !fs::create_directories(directorio, ec) && ec) {
+        std::cerr << "Warning: no se pudo crear " << directorio << ", los índices de líneas quedan en memoria" << std::endl;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mtxCache);
+        directorioCache = directorio;
+        maxBytesCache = maxBytes;
+    }
+    podarCache();
+}
+
+void IndiceLineas::podarCache() {
+    std::lock_guard<std::mutex> lk(mtxCache);
+    bytesCache = 0;
+    if (directorioCache.empty()) return;
+
+    struct Entrada {
+        fs::path ruta;
+        fs::file_time_type fecha;
+        std::uint64_t bytes;
+    };
+    std::vector<Entrada> entradas;
+    std::error_code ec;
+    for (const auto &e : fs::directory_iterator(directorioCache, ec)) {
+        const std::string nombre = e.path().filename().string();
+        if (nombre.size() <= 4 || nombre.compare(nombre.size() - 4, 4, ".idx") != 0) continue;
+        std::error_code ecArchivo;
+        if (!fs::exists(rutaIndexada(nombre), ecArchivo)) {
+            fs::remove(e.path(), ecArchivo);
+            continue;
+        }
+        Entrada entrada{e.path(), e.last_write_time(ecArchivo), e.file_size(ecArchivo)};
+        if (ecArchivo) continue;
+        bytesCache += entrada.bytes;
+        entradas.push_back(std::move(entrada));
+    }
+    if (bytesCache <= maxBytesCache) return;
+    std::sort(entradas.begin(), entradas.end(),
+              [](const Entrada &a, const Entrada &b) { return a.fecha < b.fecha; });
+    for (const Entrada &e : entradas) {
+        if (bytesCache <= maxBytesCache) break;
+        if (fs::remove(e.ruta, ec)) bytesCache -= e.bytes;
+    }
+}
+
+void IndiceLineas::contarEnCache(std::uint64_t bytes) {
+    bool podar;
+    {
+        std::lock_guard<std::mutex> lk(mtxCache);
+        bytesCache += bytes;
+        podar = bytesCache > maxBytesCache;
+    }
+    if (podar) podarCache();
+}
+
+// <caché>/<ruta absoluta con '%' y '/' escapados>.idx, o "" sin caché
+std::string IndiceLineas::rutaCache(const std::string &ruta) {
+    std::string directorio;
+    {
+        std::lock_guard<std::mutex> lk(mtxCache);
+        directorio = directorioCache;
+    }
+    if (directorio.empty()) return "";
+    std::error_code ec;
+    std::string absoluta = fs::absolute(ruta, ec).lexically_normal().string();
+    if (ec) return "";
+    std::string nombre;
+    for (char c : absoluta) {
+        if (c == '%') nombre += "%25";
+        else if (c == '/') nombre += "%2F";
+        else nombre += c;
+    }
+    return directorio + "/" + nombre + ".idx";
+}
+
+void IndiceLineas::limpiar() {
+    largos_.clear();
+    anclas_.clear();
+    posAnclas_.clear();
+    completas_ = 0;
+    inicioCola_ = 0;
+    bytes_ = 0;
+    fecha_ = 0;
+    ultimoByte_ = '\n';
+    largosGuardados_ = 0;
+}
+
+void IndiceLineas::agregar(const char *datos, std::size_t n) {
+    const char *p = datos;
+    const char *fin = datos + n;
+    while (const void *nl = std::memchr(p, '\n', static_cast<std::size_t>(fin - p))) {
+        const char *finLinea = static_cast<const char *>(nl) + 1;
+        std::uint64_t siguiente = bytes_ + static_cast<std::uint64_t>(finLinea - datos);
+        if (completas_ % PASO == 0) {
+            anclas_.push_back(inicioCola_);
+            posAnclas_.push_back(largos_.size());
+        }
+        ponerVarint(largos_, siguiente - inicioCola_);
+        ++completas_;
+        inicioCola_ = siguiente;
+        p = finLinea;
+    }
+    if (n > 0) ultimoByte_ = datos[n - 1];
+    bytes_ += n;
+}
+
+bool IndiceLineas::indexarDesde(std::uint64_t desde) {
+    std::ifstream f(ruta_, std::ios::binary);
+    if (!f) return false;
+    // Lo indexado sólo vale si el archivo creció por el final: se compara el
+    // último byte que se había visto
+    if (desde > 0) {
+        char c;
+        f.seekg(static_cast<std::streamoff>(desde - 1));
+        if (!f.get(c) || c != ultimoByte_) return false;
+    }
+    std::vector<char> buf(TAM_LECTURA);
+    while (f.read(buf.data(), static_cast<std::streamsize>(buf.size())) || f.gcount() > 0) {
+        agregar(buf.data(), static_cast<std::size_t>(f.gcount()));
+    }
+    return true;
+}
+
+bool IndiceLineas::cargar() {
+    const std::string rutaIdx = rutaCache(ruta_);
+    if (rutaIdx.empty()) return false;
+    std::ifstream f(rutaIdx, std::ios::binary | std::ios::ate);
+    if (!f) return false;
+    std::string contenido(static_cast<std::size_t>(f.tellg()), '\0');
+    f.seekg(0);
+    if (!f.read(&contenido[0], static_cast<std::streamsize>(contenido.size()))) return false;
+    if (contenido.size() < CABECERA || std::memcmp(contenido.data(), MAGICO, sizeof(MAGICO)) != 0) return false;
+
+    const char *p = contenido.data() + sizeof(MAGICO);
+    std::uint64_t bytes = tomar<std::uint64_t>(p);
+    std::int64_t fecha = tomar<std::int64_t>(p);
+    std::uint64_t completas = tomar<std::uint64_t>(p);
+    std::uint64_t inicioCola = tomar<std::uint64_t>(p);
+    char ultimo = *p;
+
+    // Las anclas no se guardan: salen de recorrer los largos, sin tocar el archivo
+    limpiar();
+    largos_.assign(contenido, CABECERA, std::string::npos);
+    std::size_t pos = 0;
+    std::uint64_t offset = 0;
+    while (pos < largos_.size()) {
+        if (completas_ % PASO == 0) {
+            anclas_.push_back(offset);
+            posAnclas_.push_back(pos);
+        }
+        std::uint64_t largo;
+        if (!tomarVarint(largos_, pos, largo)) break;
+        offset += largo;
+        ++completas_;
+    }
+    // Un .idx cortado (caída a mitad de guardar) o incoherente se descarta
+    if (pos != largos_.size() || completas_ != completas || offset != inicioCola || inicioCola > bytes) {
+        limpiar();
+        return false;
+    }
+    inicioCola_ = inicioCola;
+    bytes_ = bytes;
+    fecha_ = fecha;
+    ultimoByte_ = ultimo;
+    largosGuardados_ = largos_.size();
+    return true;
+}
+
+bool IndiceLineas::guardar() {
+    std::string cabecera(MAGICO, sizeof(MAGICO));
+    poner<std::uint64_t>(cabecera, bytes_);
+    poner<std::int64_t>(cabecera, fecha_);
+    poner<std::uint64_t>(cabecera, completas_);
+    poner<std::uint64_t>(cabecera, inicioCola_);
+    cabecera += ultimoByte_;
+
+    const std::string rutaIdx = rutaCache(ruta_);
+    if (rutaIdx.empty()) return false;
+    if (largosGuardados_ > 0) {
+        // Sólo se agregan los largos nuevos y después se reescribe la cabecera
+        std::fstream f(rutaIdx, std::ios::in | std::ios::out | std::ios::binary);
+        if (f) {
+            f.seekp(static_cast<std::streamoff>(CABECERA + largosGuardados_));
+            f.write(largos_.data() + largosGuardados_, static_cast<std::streamsize>(largos_.size() - largosGuardados_));
+            f.seekp(0);
+            f.write(cabecera.data(), static_cast<std::streamsize>(cabecera.size()));
+            if (f.flush()) {
+                contarEnCache(largos_.size() - largosGuardados_);
+                largosGuardados_ = largos_.size();
+                return true;
+            }
+        }
+    }
+    std::ofstream f(rutaIdx, std::ios::binary | std::ios::trunc);
+    f.write(cabecera.data(), static_cast<std::streamsize>(cabecera.size()));
+    f.write(largos_.data(), static_cast<std::streamsize>(largos_.size()));
+    if (!f.flush()) return false; // sin .idx el índice igual sirve en memoria
+    f.close();
+    largosGuardados_ = largos_.size();
+    contarEnCache(cabecera.size() + largos_.size());
+    return true;
+}
+
+bool IndiceLineas::sincronizar(const std::string &ruta) {
+    std::error_code ec;
+    std::uint64_t tamano = fs::file_size(ruta, ec);
+    if (ec) {
+        // El archivo ya no existe: su índice tampoco sirve
+        const std::string rutaIdx = rutaCache(ruta);
+        if (!rutaIdx.empty()) fs::remove(rutaIdx, ec);
+        ruta_ = ruta;
+        limpiar();
+        return false;
+    }
+    if (ruta != ruta_) {
+        ruta_ = ruta;
+        ++generacion_;
+        if (!cargar()) limpiar();
+    }
+
+    std::int64_t fecha = fechaDe(ruta);
+    if (fecha == fecha_ && tamano == bytes_) return true;
+
+    // Mismo tamaño con otra fecha, o más chico: no es un agregado al final
+    bool soloAgregado = tamano > bytes_;
+    if (!soloAgregado || !indexarDesde(bytes_)) {
+        limpiar();
+        ++generacion_;
+        if (!indexarDesde(0)) return false;
+    }
+    fecha_ = fechaDe(ruta);
+    guardar();
+    return true;
+}
+
+bool IndiceLineas::ubicar(std::size_t idx, std::uint64_t &inicio, std::size_t &largo) const {
+    if (idx < completas_) {
+        std::size_t a = idx / PASO;
+        std::uint64_t offset = anclas_[a];
+        std::size_t pos = posAnclas_[a];
+        std::uint64_t l = 0;
+        for (std::size_t k = a * PASO; k <= idx; ++k) {
+            tomarVarint(largos_, pos, l);
+            if (k < idx) offset += l;
+        }
+        inicio = offset;
+        largo = static_cast<std::size_t>(l - 1);
+        return true;
+    }
+    if (idx == completas_ && bytes_ > inicioCola_) {
+        inicio = inicioCola_;
+        largo = static_cast<std::size_t>(bytes_ - inicioCola_);
+        return true;
+    }
+    return false;
+}
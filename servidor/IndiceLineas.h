@@ -0,0 +1,65 @@
+#ifndef INDICELINEAS_H
+#define INDICELINEAS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Índice de los comienzos de línea de un archivo de texto, para leer la línea N
+// o saber cuántas hay sin recorrerlo. Guarda el largo de cada línea como varint
+// (una línea de G-code ocupa uno o dos bytes del índice) y, cada PASO líneas, el
+// offset absoluto, así ubicar una línea decodifica a lo sumo PASO largos.
+// Si se configuró un directorio de caché se persiste ahí (nunca junto al archivo)
+// y sólo se indexa lo que se agregó desde entonces; si no, vive en memoria.
+class IndiceLineas {
+public:
+    static const std::size_t PASO = 64;
+
+private:
+    std::string ruta_;
+    std::string largos_;                 // varint del largo (con '\n') de cada línea completa
+    std::vector<std::uint64_t> anclas_;  // offset de la línea k*PASO
+    std::vector<std::size_t> posAnclas_; // y dónde empieza su largo en largos_
+    std::size_t completas_;              // líneas terminadas en '\n'
+    std::uint64_t inicioCola_;           // offset de la línea sin '\n' final (o de la próxima)
+    std::uint64_t bytes_;                // bytes del archivo ya indexados
+    std::int64_t fecha_;                 // fecha de modificación del archivo al indexarlo
+    char ultimoByte_;
+    std::size_t largosGuardados_;        // bytes de largos_ que ya están en el .idx de la caché
+    unsigned long generacion_;           // cambia cada vez que se reconstruye
+
+    static std::string rutaCache(const std::string &ruta);
+    static void podarCache();
+    static void contarEnCache(std::uint64_t bytes); // poda al pasar el máximo
+
+    void limpiar();
+    void agregar(const char *datos, std::size_t n);
+    bool indexarDesde(std::uint64_t desde);
+    bool cargar();
+    bool guardar();
+
+public:
+    IndiceLineas();
+
+    // Directorio donde se guardan los índices ("" = sólo en memoria, el valor
+    // inicial). Se fija al arrancar, antes de abrir archivos. Al configurarlo y
+    // cada vez que pasa de 'maxBytes' se borran los índices de archivos que ya
+    // no existen y, si no alcanza, los escritos hace más tiempo.
+    static void configurarCache(const std::string &directorio, std::uint64_t maxBytes = 64ull << 20);
+
+    // Pone el índice al día con el archivo: lo carga de la caché si hace falta e
+    // indexa sólo lo agregado al final. Si el archivo cambió de otra forma (se
+    // achicó o se reescribió) lo reconstruye. false si el archivo no existe.
+    bool sincronizar(const std::string &ruta);
+
+    // Cantidad de líneas tal como las cuenta std::getline
+    std::size_t lineas() const { return completas_ + (bytes_ > inicioCola_ ? 1 : 0); }
+
+    // Offset y largo (sin '\n') de la línea idx, contando desde 0
+    bool ubicar(std::size_t idx, std::uint64_t &inicio, std::size_t &largo) const;
+
+    unsigned long generacion() const { return generacion_; }
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "InterpoladorArcos.h"
+#include <cmath>
+#include <algorithm>
+
+// Diferencia de radio admitida entre inicio y fin en formato I/J
+static const double TOLERANCIA_RADIO = 0.05;
+
+InterpoladorArcos::InterpoladorArcos(double toleranciaCuerda, double longitudMinima)
+    : toleranciaCuerda_(toleranciaCuerda), longitudMinima_(longitudMinima) {
+}
+
+bool InterpoladorArcos::interpolar(const DefinicionArco& arco, const Consumidor& consumidor) const {
+    const Punto3D& a = arco.inicio;
+    const Punto3D& b = arco.fin;
+    double i = arco.i;
+    double j = arco.j;
+
+    if (arco.radio != 0.0) {
+        // Formato R: calcular el centro a partir de la cuerda
+        double dx = b.x - a.x;
+        double dy = b.y - a.y;
+        double r = arco.radio;
+        double h2 = 4.0 * r * r - dx * dx - dy * dy;
+        double cuerda = std::hypot(dx, dy);
+        if (h2 < 0.0 || cuerda == 0.0) {
+            return false;
+        }
+        double h = -std::sqrt(h2) / cuerda;
+        if (!arco.horario) h = -h;
+        if (r < 0.0) h = -h;
+        i = 0.5 * (dx - dy * h);
+        j = 0.5 * (dy + dx * h);
+    }
+
+    double cx = a.x + i;
+    double cy = a.y + j;
+    double radio = std::hypot(i, j);
+    if (radio <= 0.0) {
+        return false;
+    }
+
+    double r0x = -i, r0y = -j;            // inicio respecto del centro
+    double r1x = b.x - cx, r1y = b.y - cy; // fin respecto del centro
+    if (std::fabs(std::hypot(r1x, r1y) - radio) > TOLERANCIA_RADIO) {
+        return false;
+    }
+
+    double recorrido = std::atan2(r0x * r1y - r0y * r1x, r0x * r1x + r0y * r1y);
+    if (arco.horario) {
+        if (recorrido >= -1e-9) recorrido -= 2.0 * M_PI;
+    } else {
+        if (recorrido <= 1e-9) recorrido += 2.0 * M_PI;
+    }
+
+    // Ángulo máximo por tramo para respetar el error de cuerda: r(1 - cos(θ/2)) <= tol
+    double anguloMax = (toleranciaCuerda_ < radio) ? 2.0 * std::acos(1.0 - toleranciaCuerda_ / radio) : M_PI / 2.0;
+    std::size_t tramos = static_cast<std::size_t>(std::ceil(std::fabs(recorrido) / anguloMax));
+
+    double longitud = std::hypot(std::fabs(recorrido) * radio, b.z - a.z);
+    if (longitudMinima_ > 0.0) {
+        std::size_t maxTramos = static_cast<std::size_t>(longitud / longitudMinima_);
+        tramos = std::min(tramos, maxTramos);
+    }
+    tramos = std::max<std::size_t>(tramos, 1);
+
+    double anguloInicio = std::atan2(r0y, r0x);
+    for (std::size_t k = 1; k < tramos; ++k) {
+        double t = static_cast<double>(k) / static_cast<double>(tramos);
+        double ang = anguloInicio + recorrido * t;
+        Punto3D p(cx + radio * std::cos(ang), cy + radio * std::sin(ang), a.z + (b.z - a.z) * t);
+        if (!consumidor(p)) {
+            return false;
+        }
+    }
+    return consumidor(b);
+}
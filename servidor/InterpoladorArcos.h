@@ -0,0 +1,41 @@
+#ifndef INTERPOLADORARCOS_H
+#define INTERPOLADORARCOS_H
+
+#include <functional>
+#include <cstddef>
+#include "Geometria.h"
+
+// Arco G2/G3 en el plano XY (G17), con Z lineal para hélices
+struct DefinicionArco {
+    Punto3D inicio;
+    Punto3D fin;
+    double i;       // desplazamiento X del centro respecto del inicio
+    double j;       // desplazamiento Y del centro respecto del inicio
+    double radio;   // formato R (si es distinto de 0 se ignoran I/J; negativo = arco mayor a 180°)
+    bool horario;   // true = G2, false = G3
+
+    DefinicionArco() : i(0), j(0), radio(0), horario(true) {}
+};
+
+// Convierte arcos en tramos rectos aptos para el firmware. La cantidad de tramos
+// se adapta al radio para que el error de cuerda no supere la tolerancia.
+// Los puntos se entregan uno a uno al consumidor, sin almacenarlos.
+class InterpoladorArcos {
+private:
+    double toleranciaCuerda_; // mm
+    double longitudMinima_;   // mm, evita tramos demasiado cortos para el firmware
+
+public:
+    using Consumidor = std::function<bool(const Punto3D&)>;
+
+    explicit InterpoladorArcos(double toleranciaCuerda = 0.02, double longitudMinima = 0.5);
+
+    // Entrega los puntos intermedios y el final del arco (no el inicio).
+    // Devuelve false si el arco no es geométricamente válido o si el consumidor devuelve false.
+    bool interpolar(const DefinicionArco& arco, const Consumidor& consumidor) const;
+
+    double obtenerToleranciaCuerda() const { return toleranciaCuerda_; }
+    void configurarToleranciaCuerda(double tolerancia) { toleranciaCuerda_ = tolerancia; }
+};
+
+#endif
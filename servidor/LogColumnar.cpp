@@ -0,0 +1,561 @@
+#include "LogColumnar.h"
+#include "BuscadorTexto.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+namespace {
+
+const char MAGICO[4] = {'R', 'L', 'C', '1'};
+const char BLOQUE_DICCIONARIO = 'D';
+const char BLOQUE_FILAS = 'F';
+const std::size_t CABECERA_BLOQUE = 1 + sizeof(std::uint32_t);
+// n, instante mínimo y máximo: lo que hace falta para decidir si saltar el bloque
+const std::size_t PREFIJO_FILAS = sizeof(std::uint32_t) + 2 * sizeof(std::int64_t);
+
+template <typename T>
+void poner(std::string &buf, T valor) {
+    buf.append(reinterpret_cast<const char *>(&valor), sizeof(T));
+}
+
+template <typename T>
+void ponerArreglo(std::string &buf, const std::vector<T> &v) {
+    if (!v.empty()) buf.append(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+}
+
+template <typename T>
+T tomar(const char *&p) {
+    T valor;
+    std::memcpy(&valor, p, sizeof(T));
+    p += sizeof(T);
+    return valor;
+}
+
+template <typename T>
+void tomarArreglo(const char *&p, std::vector<T> &v, std::size_t n) {
+    v.resize(n);
+    if (n) std::memcpy(v.data(), p, n * sizeof(T));
+    p += n * sizeof(T);
+}
+
+// Marca las filas del bloque cuyo detalle contiene el patrón. Se busca en el
+// montón entero de una vez y cada aparición se ubica en su fila; las que cruzan
+// el límite entre dos detalles no cuentan.
+void marcarDetalles(const LogColumnar::Bloque &b, const PatronBusqueda &patron, std::vector<char> &filas) {
+    filas.assign(b.filas(), 0);
+    std::size_t fila = 0, pos = 0;
+    while (fila < b.filas()) {
+        std::size_t hallado = patron.buscar(b.detalles.data(), b.detalles.size(), pos);
+        if (hallado == PatronBusqueda::NO_ENCONTRADO) break;
+        while (fila < b.filas() && b.finDetalle[fila] <= hallado) ++fila;
+        if (fila == b.filas()) break;
+        if (hallado + patron.tamano() <= b.finDetalle[fila]) {
+            filas[fila] = 1;
+            pos = b.finDetalle[fila];
+        } else {
+            pos = hallado + 1;
+        }
+    }
+}
+
+bool leerExacto(std::istream &in, char *destino, std::size_t n) {
+    in.read(destino, static_cast<std::streamsize>(n));
+    return static_cast<std::size_t>(in.gcount()) == n;
+}
+
+void aplicarDiccionario(const std::string &payload, LogColumnar::Diccionario diccionarios[]) {
+    const char *p = payload.data();
+    const char *fin = p + payload.size();
+    while (p + 1 + sizeof(std::uint32_t) <= fin) {
+        std::uint8_t columna = tomar<std::uint8_t>(p);
+        std::uint32_t largo = tomar<std::uint32_t>(p);
+        if (columna >= LogColumnar::NUM_COLUMNAS || p + largo > fin) break;
+        diccionarios[columna].idDe(std::string(p, largo));
+        p += largo;
+    }
+}
+
+void decodificarFilas(const std::string &payload, LogColumnar::Bloque &bloque) {
+    const char *p = payload.data();
+    std::uint32_t n = tomar<std::uint32_t>(p);
+    p += 2 * sizeof(std::int64_t);
+    tomarArreglo(p, bloque.instantes, n);
+    for (int c = 0; c < LogColumnar::NUM_COLUMNAS; ++c) tomarArreglo(p, bloque.columnas[c], n);
+    tomarArreglo(p, bloque.finDetalle, n);
+    bloque.detalles.assign(p, payload.data() + payload.size() - p);
+}
+
+// Evalúa una consulta bloque a bloque. Las subcadenas se comparan una sola vez
+// contra cada entrada de diccionario y una vez contra el montón de detalles del
+// bloque; por fila sólo quedan comparaciones de enteros.
+class Evaluador {
+private:
+    const ConsultaLog &consulta_;
+    std::vector<PatronBusqueda> patrones_;
+    std::vector<std::vector<char>> enDetalle_; // [subcadena][fila] del bloque actual
+    // [columna][subcadena][id]: 0 sin evaluar, 1 no contiene, 2 contiene
+    std::vector<std::vector<std::uint8_t>> cache_[LogColumnar::NUM_COLUMNAS];
+    // Sólo vale la pena formatear el instante si la subcadena puede estar en él
+    std::vector<bool> buscarEnInstante_;
+
+    bool contieneEnDiccionario(int columna, std::size_t s, std::uint32_t id,
+                               const LogColumnar::Diccionario &dic) {
+        std::vector<std::uint8_t> &estados = cache_[columna][s];
+        if (id >= estados.size()) estados.resize(dic.valores.size(), 0);
+        if (estados[id] == 0) {
+            estados[id] = patrones_[s].contenidoEn(dic.valores[id]) ? 2 : 1;
+        }
+        return estados[id] == 2;
+    }
+
+public:
+    explicit Evaluador(const ConsultaLog &consulta) : consulta_(consulta) {
+        for (auto &porColumna : cache_) porColumna.resize(consulta.subcadenas.size());
+        for (const std::string &s : consulta.subcadenas) {
+            patrones_.emplace_back(s);
+            buscarEnInstante_.push_back(s.find_first_not_of("0123456789-: ") == std::string::npos);
+        }
+    }
+
+    // Descarta el bloque entero si su rango no toca el de la consulta
+    bool interesa(std::int64_t minimo, std::int64_t maximo) const {
+        return !(maximo < consulta_.desde || minimo > consulta_.hasta);
+    }
+
+    // Evalúa las filas desde 'desdeFila' hasta juntar 'maxLineas'; devuelve la
+    // fila donde seguir (b.filas() si terminó el bloque)
+    std::size_t evaluar(const LogColumnar::Bloque &b, const LogColumnar::Diccionario dic[],
+                        std::vector<std::string> &salida, std::size_t desdeFila = 0,
+                        std::size_t maxLineas = std::numeric_limits<std::size_t>::max()) {
+        if (maxLineas == 0) return desdeFila;
+        std::uint32_t idUsuario = 0, idCodigo = 0;
+        if (!consulta_.usuario.empty()) {
+            const std::uint32_t *id = dic[LogColumnar::USUARIO].buscar(consulta_.usuario);
+            if (!id) return b.filas(); // nadie con ese nombre escribió en este archivo
+            idUsuario = *id;
+        }
+        if (!consulta_.codigo.empty()) {
+            const std::uint32_t *id = dic[LogColumnar::CODIGO].buscar(consulta_.codigo);
+            if (!id) return b.filas();
+            idCodigo = *id;
+        }
+
+        bool detallesMarcados = false;
+        std::size_t producidas = 0;
+        for (std::size_t i = desdeFila; i < b.filas(); ++i) {
+            std::int64_t instante = b.instantes[i];
+            if (instante < consulta_.desde || instante > consulta_.hasta) continue;
+            if (!consulta_.usuario.empty() && b.columnas[LogColumnar::USUARIO][i] != idUsuario) continue;
+            if (!consulta_.codigo.empty() && b.columnas[LogColumnar::CODIGO][i] != idCodigo) continue;
+
+            std::uint32_t inicioDetalle = i ? b.finDetalle[i - 1] : 0;
+            bool coincide = true;
+            for (std::size_t s = 0; coincide && s < consulta_.subcadenas.size(); ++s) {
+                bool enAlguna = false;
+                for (int c = 0; !enAlguna && c < LogColumnar::NUM_COLUMNAS; ++c) {
+                    enAlguna = contieneEnDiccionario(c, s, b.columnas[c][i], dic[c]);
+                }
+                if (!enAlguna) {
+                    if (!detallesMarcados) {
+                        enDetalle_.resize(patrones_.size());
+                        for (std::size_t k = 0; k < patrones_.size(); ++k) marcarDetalles(b, patrones_[k], enDetalle_[k]);
+                        detallesMarcados = true;
+                    }
+                    enAlguna = enDetalle_[s][i] != 0;
+                }
+                if (!enAlguna && buscarEnInstante_[s]) {
+                    enAlguna = patrones_[s].contenidoEn(RegistroLog::instanteATexto(instante));
+                }
+                coincide = enAlguna;
+            }
+            if (!coincide) continue;
+
+            // Recién aquí se vuelve a texto
+            RegistroLog r;
+            r.instante = instante;
+            r.tipo = dic[LogColumnar::TIPO].valores[b.columnas[LogColumnar::TIPO][i]];
+            r.detalle.assign(b.detalles, inicioDetalle, b.finDetalle[i] - inicioDetalle);
+            r.usuario = dic[LogColumnar::USUARIO].valores[b.columnas[LogColumnar::USUARIO][i]];
+            r.nodo = dic[LogColumnar::NODO].valores[b.columnas[LogColumnar::NODO][i]];
+            r.codigo = dic[LogColumnar::CODIGO].valores[b.columnas[LogColumnar::CODIGO][i]];
+            r.modulo = dic[LogColumnar::MODULO].valores[b.columnas[LogColumnar::MODULO][i]];
+            salida.push_back(r.aCsv());
+            if (++producidas == maxLineas) return i + 1;
+        }
+        return b.filas();
+    }
+};
+
+// Recorre los bloques de 'in' hasta 'limite' bytes empezando en 'posicion'.
+// Si junta 'maxLineas' deja en 'posicion' dónde seguir y 'completo' en false;
+// si llega al final, 'posicion' queda en el final del archivo con las filas que
+// todavía faltaba saltar (las del bloque pendiente del escritor).
+bool recorrerArchivo(std::istream &in, std::uint64_t limite, LogColumnar::Diccionario diccionarios[],
+                     Evaluador &evaluador, LogColumnar::Posicion &posicion, std::size_t maxLineas,
+                     std::vector<std::string> &salida, bool &completo) {
+    completo = false;
+    char magico[sizeof(MAGICO)];
+    if (limite < sizeof(MAGICO) || !leerExacto(in, magico, sizeof(MAGICO)) ||
+        std::memcmp(magico, MAGICO, sizeof(MAGICO)) != 0) {
+        return false;
+    }
+    const std::uint64_t inicio = std::max<std::uint64_t>(posicion.bloque, sizeof(MAGICO));
+    const std::size_t base = salida.size();
+    std::size_t saltar = posicion.fila;
+    std::uint64_t pos = sizeof(MAGICO);
+    std::string payload;
+    LogColumnar::Bloque bloque;
+    while (pos + CABECERA_BLOQUE <= limite) {
+        if (salida.size() - base >= maxLineas) {
+            posicion = LogColumnar::Posicion{pos, 0};
+            return true;
+        }
+        char cabecera[CABECERA_BLOQUE];
+        if (!leerExacto(in, cabecera, CABECERA_BLOQUE)) break;
+        const char *p = cabecera + 1;
+        std::uint32_t largo = tomar<std::uint32_t>(p);
+        if (pos + CABECERA_BLOQUE + largo > limite) break;
+        const std::uint64_t inicioBloque = pos;
+        pos += CABECERA_BLOQUE + largo;
+
+        if (cabecera[0] == BLOQUE_FILAS && largo >= PREFIJO_FILAS) {
+            // Antes del punto de partida sólo interesan los diccionarios
+            if (inicioBloque < inicio) {
+                in.seekg(largo, std::ios::cur);
+                continue;
+            }
+            payload.resize(PREFIJO_FILAS);
+            if (!leerExacto(in, &payload[0], PREFIJO_FILAS)) return false;
+            const char *q = payload.data() + sizeof(std::uint32_t);
+            std::int64_t minimo = tomar<std::int64_t>(q);
+            std::int64_t maximo = tomar<std::int64_t>(q);
+            if (!evaluador.interesa(minimo, maximo)) {
+                in.seekg(largo - PREFIJO_FILAS, std::ios::cur);
+                saltar = 0;
+                continue;
+            }
+            payload.resize(largo);
+            if (!leerExacto(in, &payload[PREFIJO_FILAS], largo - PREFIJO_FILAS)) return false;
+            decodificarFilas(payload, bloque);
+            std::size_t siguiente = evaluador.evaluar(bloque, diccionarios, salida, saltar,
+                                                      maxLineas - (salida.size() - base));
+            saltar = 0;
+            if (siguiente < bloque.filas()) {
+                posicion = LogColumnar::Posicion{inicioBloque, static_cast<std::uint32_t>(siguiente)};
+                return true;
+            }
+        } else {
+            payload.resize(largo);
+            if (!leerExacto(in, &payload[0], largo)) return false;
+            if (cabecera[0] == BLOQUE_DICCIONARIO) aplicarDiccionario(payload, diccionarios);
+        }
+    }
+    posicion = LogColumnar::Posicion{pos, static_cast<std::uint32_t>(saltar)};
+    completo = true;
+    return true;
+}
+
+} // namespace
+
+// --- RegistroLog ---
+
+std::string RegistroLog::aCsv() const {
+    std::string linea;
+    linea.reserve(40 + tipo.size() + detalle.size() + usuario.size() + nodo.size() + codigo.size() + modulo.size());
+    linea += '"';
+    linea += instanteATexto(instante);
+    for (const std::string *campo : {&tipo, &detalle, &usuario, &nodo, &codigo, &modulo}) {
+        linea += "\",\"";
+        linea += *campo;
+    }
+    linea += '"';
+    return linea;
+}
+
+bool RegistroLog::desdeCsv(const std::string &linea, RegistroLog &registro) {
+    // Campos entre comillas separados por ","; el detalle no lleva comillas propias
+    if (linea.size() < 2 || linea.front() != '"' || linea.back() != '"') return false;
+    std::vector<std::string> campos;
+    std::size_t inicio = 1;
+    while (true) {
+        std::size_t fin = linea.find("\",\"", inicio);
+        if (fin == std::string::npos) {
+            campos.push_back(linea.substr(inicio, linea.size() - 1 - inicio));
+            break;
+        }
+        campos.push_back(linea.substr(inicio, fin - inicio));
+        inicio = fin + 3;
+    }
+    if (campos.size() < 6) return false;
+    registro.instante = instanteDesdeTexto(campos[0]);
+    if (registro.instante < 0) return false;
+    registro.tipo = campos[1];
+    registro.detalle = campos[2];
+    registro.usuario = campos[3];
+    registro.nodo = campos[4];
+    registro.codigo = campos[5];
+    registro.modulo = campos.size() > 6 ? campos[6] : "";
+    return true;
+}
+
+std::int64_t RegistroLog::instanteDesdeTexto(const std::string &ts) {
+    int a, mes, d, h, mi, s;
+    char resto;
+    if (ts.size() != 19 ||
+        std::sscanf(ts.c_str(), "%4d-%2d-%2d %2d:%2d:%2d%c", &a, &mes, &d, &h, &mi, &s, &resto) != 6) {
+        return -1;
+    }
+    return ((((static_cast<std::int64_t>(a) * 100 + mes) * 100 + d) * 100 + h) * 100 + mi) * 100 + s;
+}
+
+std::string RegistroLog::instanteATexto(std::int64_t instante) {
+    char texto[32];
+    std::snprintf(texto, sizeof(texto), "%04d-%02d-%02d %02d:%02d:%02d",
+                  static_cast<int>(instante / 10000000000LL), static_cast<int>(instante / 100000000 % 100),
+                  static_cast<int>(instante / 1000000 % 100), static_cast<int>(instante / 10000 % 100),
+                  static_cast<int>(instante / 100 % 100), static_cast<int>(instante % 100));
+    return texto;
+}
+
+bool ConsultaLog::coincide(const RegistroLog &r) const {
+    if (r.instante < desde || r.instante > hasta) return false;
+    if (!usuario.empty() && r.usuario != usuario) return false;
+    if (!codigo.empty() && r.codigo != codigo) return false;
+    for (const std::string &s : subcadenas) {
+        PatronBusqueda patron(s);
+        bool enAlguna = false;
+        for (const std::string *campo : {&r.tipo, &r.detalle, &r.usuario, &r.nodo, &r.codigo, &r.modulo}) {
+            if (patron.contenidoEn(*campo)) {
+                enAlguna = true;
+                break;
+            }
+        }
+        if (!enAlguna && !patron.contenidoEn(RegistroLog::instanteATexto(r.instante))) return false;
+    }
+    return true;
+}
+
+// --- LogColumnar ---
+
+std::uint32_t LogColumnar::Diccionario::idDe(const std::string &valor) {
+    auto it = ids.find(valor);
+    if (it != ids.end()) return it->second;
+    std::uint32_t id = static_cast<std::uint32_t>(valores.size());
+    valores.push_back(valor);
+    ids.emplace(valor, id);
+    return id;
+}
+
+const std::uint32_t *LogColumnar::Diccionario::buscar(const std::string &valor) const {
+    auto it = ids.find(valor);
+    return it == ids.end() ? nullptr : &it->second;
+}
+
+void LogColumnar::Bloque::limpiar() {
+    instantes.clear();
+    for (auto &c : columnas) c.clear();
+    finDetalle.clear();
+    detalles.clear();
+}
+
+LogColumnar::LogColumnar(std::size_t filasPorBloque)
+    : filasPorBloque_(filasPorBloque ? filasPorBloque : 1), bytes_(0), filasEscritas_(0), entradasEscritas_() {
+}
+
+LogColumnar::~LogColumnar() {
+    cerrar();
+}
+
+bool LogColumnar::abrir(const std::string &ruta) {
+    cerrar();
+    ruta_ = ruta;
+    bytes_ = 0;
+    filasEscritas_ = 0;
+    pendiente_.limpiar();
+    for (int c = 0; c < NUM_COLUMNAS; ++c) {
+        diccionarios_[c] = Diccionario();
+        entradasEscritas_[c] = 0;
+    }
+
+    std::uint64_t valido = 0;
+    std::uint64_t tamano = 0;
+    {
+        std::ifstream in(ruta, std::ios::binary | std::ios::ate);
+        if (in.is_open()) {
+            tamano = static_cast<std::uint64_t>(in.tellg());
+            in.seekg(0);
+        }
+        char magico[sizeof(MAGICO)];
+        if (tamano >= sizeof(MAGICO) && leerExacto(in, magico, sizeof(MAGICO))) {
+            if (std::memcmp(magico, MAGICO, sizeof(MAGICO)) != 0) {
+                std::cerr << "Error: " << ruta << " no es un log columnar" << std::endl;
+                return false;
+            }
+            valido = sizeof(MAGICO);
+            std::string payload;
+            char cabecera[CABECERA_BLOQUE];
+            while (leerExacto(in, cabecera, CABECERA_BLOQUE)) {
+                const char *p = cabecera + 1;
+                std::uint32_t largo = tomar<std::uint32_t>(p);
+                payload.resize(largo);
+                if ((cabecera[0] != BLOQUE_DICCIONARIO && cabecera[0] != BLOQUE_FILAS) ||
+                    !leerExacto(in, &payload[0], largo)) {
+                    break;
+                }
+                if (cabecera[0] == BLOQUE_DICCIONARIO) {
+                    aplicarDiccionario(payload, diccionarios_);
+                } else {
+                    const char *q = payload.data();
+                    filasEscritas_ += tomar<std::uint32_t>(q);
+                }
+                valido += CABECERA_BLOQUE + largo;
+            }
+        }
+    }
+    if (tamano > valido) {
+        std::cerr << "Aviso: se descartan " << (tamano - valido) << " bytes incompletos al final de " << ruta << std::endl;
+        if (::truncate(ruta.c_str(), static_cast<off_t>(valido)) != 0) {
+            std::cerr << "Error: no se pudo recortar " << ruta << std::endl;
+            return false;
+        }
+    }
+
+    salida_.open(ruta, std::ios::binary | std::ios::app);
+    if (!salida_.is_open()) {
+        std::cerr << "Error: no se pudo abrir el log columnar " << ruta << std::endl;
+        return false;
+    }
+    if (valido == 0) {
+        salida_.write(MAGICO, sizeof(MAGICO));
+        salida_.flush();
+        valido = sizeof(MAGICO);
+    }
+    bytes_ = valido;
+    for (int c = 0; c < NUM_COLUMNAS; ++c) entradasEscritas_[c] = diccionarios_[c].valores.size();
+    return true;
+}
+
+void LogColumnar::cerrar() {
+    if (!salida_.is_open()) return;
+    volcar();
+    salida_.close();
+}
+
+bool LogColumnar::agregar(const RegistroLog &r) {
+    if (!salida_.is_open()) return false;
+    pendiente_.instantes.push_back(r.instante);
+    pendiente_.columnas[TIPO].push_back(diccionarios_[TIPO].idDe(r.tipo));
+    pendiente_.columnas[USUARIO].push_back(diccionarios_[USUARIO].idDe(r.usuario));
+    pendiente_.columnas[NODO].push_back(diccionarios_[NODO].idDe(r.nodo));
+    pendiente_.columnas[CODIGO].push_back(diccionarios_[CODIGO].idDe(r.codigo));
+    pendiente_.columnas[MODULO].push_back(diccionarios_[MODULO].idDe(r.modulo));
+    pendiente_.detalles += r.detalle;
+    pendiente_.finDetalle.push_back(static_cast<std::uint32_t>(pendiente_.detalles.size()));
+    if (pendiente_.filas() >= filasPorBloque_) return volcar();
+    return true;
+}
+
+bool LogColumnar::volcar() {
+    if (!salida_.is_open() || pendiente_.filas() == 0) return true;
+
+    std::string buf;
+    // Primero las entradas de diccionario que usa el bloque y el archivo aún no tiene
+    std::string dic;
+    for (int c = 0; c < NUM_COLUMNAS; ++c) {
+        const std::vector<std::string> &valores = diccionarios_[c].valores;
+        for (std::size_t id = entradasEscritas_[c]; id < valores.size(); ++id) {
+            poner<std::uint8_t>(dic, static_cast<std::uint8_t>(c));
+            poner<std::uint32_t>(dic, static_cast<std::uint32_t>(valores[id].size()));
+            dic += valores[id];
+        }
+    }
+    if (!dic.empty()) {
+        buf += BLOQUE_DICCIONARIO;
+        poner<std::uint32_t>(buf, static_cast<std::uint32_t>(dic.size()));
+        buf += dic;
+    }
+
+    const Bloque &b = pendiente_;
+    std::string filas;
+    poner<std::uint32_t>(filas, static_cast<std::uint32_t>(b.filas()));
+    poner<std::int64_t>(filas, *std::min_element(b.instantes.begin(), b.instantes.end()));
+    poner<std::int64_t>(filas, *std::max_element(b.instantes.begin(), b.instantes.end()));
+    ponerArreglo(filas, b.instantes);
+    for (int c = 0; c < NUM_COLUMNAS; ++c) ponerArreglo(filas, b.columnas[c]);
+    ponerArreglo(filas, b.finDetalle);
+    filas += b.detalles;
+    buf += BLOQUE_FILAS;
+    poner<std::uint32_t>(buf, static_cast<std::uint32_t>(filas.size()));
+    buf += filas;
+
+    salida_.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    salida_.flush();
+    if (!salida_) {
+        std::cerr << "Error escribiendo el log columnar " << ruta_ << std::endl;
+        return false;
+    }
+    bytes_ += buf.size();
+    filasEscritas_ += b.filas();
+    for (int c = 0; c < NUM_COLUMNAS; ++c) entradasEscritas_[c] = diccionarios_[c].valores.size();
+    pendiente_.limpiar();
+    return true;
+}
+
+LogColumnar::Instantanea LogColumnar::instantanea() const {
+    Instantanea inst;
+    inst.archivo.reset(new std::ifstream(ruta_, std::ios::binary));
+    inst.bytes = bytes_;
+    inst.pendiente = pendiente_;
+    for (int c = 0; c < NUM_COLUMNAS; ++c) inst.diccionarios[c] = diccionarios_[c];
+    return inst;
+}
+
+bool LogColumnar::consultar(const std::string &ruta, const ConsultaLog &consulta, std::vector<std::string> &salida) {
+    Posicion posicion;
+    bool terminado;
+    return consultarPagina(ruta, consulta, posicion, std::numeric_limits<std::size_t>::max(), salida, terminado);
+}
+
+bool LogColumnar::consultar(Instantanea &activo, const ConsultaLog &consulta, std::vector<std::string> &salida) {
+    Posicion posicion;
+    bool terminado;
+    return consultarPagina(activo, consulta, posicion, std::numeric_limits<std::size_t>::max(), salida, terminado);
+}
+
+bool LogColumnar::consultarPagina(const std::string &ruta, const ConsultaLog &consulta, Posicion &posicion,
+                                  std::size_t maxLineas, std::vector<std::string> &salida, bool &terminado) {
+    std::ifstream in(ruta, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Error: no se pudo abrir el log columnar " << ruta << std::endl;
+        return false;
+    }
+    Diccionario diccionarios[NUM_COLUMNAS];
+    Evaluador evaluador(consulta);
+    return recorrerArchivo(in, std::numeric_limits<std::uint64_t>::max(), diccionarios, evaluador, posicion,
+                           maxLineas, salida, terminado);
+}
+
+bool LogColumnar::consultarPagina(Instantanea &activo, const ConsultaLog &consulta, Posicion &posicion,
+                                  std::size_t maxLineas, std::vector<std::string> &salida, bool &terminado) {
+    const std::size_t base = salida.size();
+    bool ok = true;
+    if (activo.archivo && activo.archivo->is_open()) {
+        Diccionario diccionarios[NUM_COLUMNAS];
+        Evaluador evaluador(consulta);
+        ok = recorrerArchivo(*activo.archivo, activo.bytes, diccionarios, evaluador, posicion, maxLineas, salida,
+                             terminado);
+        if (!ok || !terminado) return ok;
+    }
+    // Las filas pendientes usan los diccionarios del escritor, que incluyen
+    // entradas que todavía no llegaron al archivo. Cuando se vuelquen, formarán
+    // el bloque que empieza en activo.bytes, así que la posición sigue valiendo.
+    Evaluador evaluador(consulta);
+    std::size_t siguiente = evaluador.evaluar(activo.pendiente, activo.diccionarios, salida, posicion.fila,
+                                              maxLineas - (salida.size() - base));
+    // Aun terminada, la posición sirve para retomar cuando lleguen filas nuevas
+    terminado = siguiente >= activo.pendiente.filas();
+    posicion = Posicion{activo.bytes, static_cast<std::uint32_t>(siguiente)};
+    return ok;
+}
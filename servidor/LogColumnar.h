@@ -0,0 +1,125 @@
+#ifndef LOGCOLUMNAR_H
+#define LOGCOLUMNAR_H
+
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Una línea del log separada en campos. El instante se guarda como entero
+// AAAAMMDDhhmmss: ordena igual que el texto y se reconstruye sin ambigüedad
+// de zona horaria.
+struct RegistroLog {
+    std::int64_t instante = 0;
+    std::string tipo, detalle, usuario, nodo, codigo, modulo;
+
+    // "instante","tipo","detalle","usuario","nodo","codigo","modulo"
+    std::string aCsv() const;
+    static bool desdeCsv(const std::string &linea, RegistroLog &registro);
+
+    static std::int64_t instanteDesdeTexto(const std::string &ts); // -1 si no es "AAAA-MM-DD hh:mm:ss"
+    static std::string instanteATexto(std::int64_t instante);
+};
+
+// Filtro sobre el log: rango de instantes, igualdad exacta de usuario/código y
+// subcadenas (en minúsculas) que deben aparecer cada una en algún campo
+struct ConsultaLog {
+    std::int64_t desde = 0;
+    std::int64_t hasta = std::numeric_limits<std::int64_t>::max();
+    std::string usuario;
+    std::string codigo;
+    std::vector<std::string> subcadenas;
+
+    bool coincide(const RegistroLog &registro) const; // para segmentos sin columnas
+};
+
+// Log binario por columnas, sólo de agregado. Las filas se acumulan en memoria
+// y se escriben en bloques: instantes como int64, tipo/usuario/nodo/código/módulo
+// como índices de diccionario y los detalles en un montón de texto. Cada bloque
+// lleva su rango de instantes, así una consulta salta los que no le interesan
+// sin leerlos. El diccionario se escribe en el mismo archivo, antes del primer
+// bloque que usa cada entrada, de modo que cada archivo se lee por sí solo.
+class LogColumnar {
+public:
+    enum Columna { TIPO, USUARIO, NODO, CODIGO, MODULO, NUM_COLUMNAS };
+
+    struct Diccionario {
+        std::vector<std::string> valores;
+        std::unordered_map<std::string, std::uint32_t> ids;
+
+        std::uint32_t idDe(const std::string &valor); // lo agrega si no existe
+        const std::uint32_t *buscar(const std::string &valor) const;
+    };
+
+    struct Bloque {
+        std::vector<std::int64_t> instantes;
+        std::vector<std::uint32_t> columnas[NUM_COLUMNAS];
+        std::vector<std::uint32_t> finDetalle; // fin de cada detalle dentro de 'detalles'
+        std::string detalles;
+
+        std::size_t filas() const { return instantes.size(); }
+        void limpiar();
+    };
+
+    // Dónde retomar una consulta paginada: bloque (offset en el archivo) y filas
+    // de ese bloque ya recorridas. {0, 0} es el principio.
+    struct Posicion {
+        std::uint64_t bloque = 0;
+        std::uint32_t fila = 0;
+    };
+
+    // Estado del log activo tomado con el cerrojo del escritor: el archivo queda
+    // abierto (una rotación posterior no lo cambia) y el bloque pendiente copiado
+    struct Instantanea {
+        std::unique_ptr<std::ifstream> archivo;
+        std::uint64_t bytes = 0;
+        Bloque pendiente;
+        Diccionario diccionarios[NUM_COLUMNAS];
+    };
+
+private:
+    std::string ruta_;
+    std::ofstream salida_;
+    std::size_t filasPorBloque_;
+    std::uint64_t bytes_;
+    std::size_t filasEscritas_;
+    Diccionario diccionarios_[NUM_COLUMNAS];
+    std::size_t entradasEscritas_[NUM_COLUMNAS]; // ya presentes en el archivo
+    Bloque pendiente_;
+
+public:
+    explicit LogColumnar(std::size_t filasPorBloque = 1024);
+    ~LogColumnar();
+
+    // Abre (o crea) el archivo y recupera sus diccionarios. Un bloque final
+    // incompleto, de una caída a mitad de escritura, se descarta.
+    bool abrir(const std::string &ruta);
+    void cerrar();
+    bool estaAbierto() const { return salida_.is_open(); }
+    const std::string &ruta() const { return ruta_; }
+    std::size_t filas() const { return filasEscritas_ + pendiente_.filas(); }
+
+    bool agregar(const RegistroLog &registro);
+    bool volcar(); // escribe el bloque pendiente
+
+    Instantanea instantanea() const;
+
+    // Agrega a 'salida' las líneas CSV que cumplen la consulta, en orden
+    static bool consultar(const std::string &ruta, const ConsultaLog &consulta,
+                          std::vector<std::string> &salida);
+    static bool consultar(Instantanea &activo, const ConsultaLog &consulta,
+                          std::vector<std::string> &salida);
+
+    // Igual que consultar, pero desde 'posicion' y hasta 'maxLineas' líneas. Si
+    // quedan más, 'terminado' es false y 'posicion' indica dónde seguir.
+    static bool consultarPagina(const std::string &ruta, const ConsultaLog &consulta, Posicion &posicion,
+                                std::size_t maxLineas, std::vector<std::string> &salida, bool &terminado);
+    static bool consultarPagina(Instantanea &activo, const ConsultaLog &consulta, Posicion &posicion,
+                                std::size_t maxLineas, std::vector<std::string> &salida, bool &terminado);
+};
+
+#endif
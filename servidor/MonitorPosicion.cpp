@@ -0,0 +1,106 @@
+#include "MonitorPosicion.h"
+#include <cstdlib>
+#include <cstring>
+
+MonitorPosicion::MonitorPosicion()
+    : muestra_(std::make_shared<MuestraPosicion>()), periodoMs_(0), activo_(false) {
+}
+
+MonitorPosicion::~MonitorPosicion() {
+    detener();
+}
+
+void MonitorPosicion::iniciar(const FuncionMuestreo& muestreo, int periodoMs) {
+    detener();
+    if (periodoMs <= 0) {
+        return;
+    }
+    muestreo_ = muestreo;
+    periodoMs_ = periodoMs;
+    activo_ = true;
+    hilo_ = std::thread(&MonitorPosicion::bucleSondeo, this);
+}
+
+void MonitorPosicion::detener() {
+    {
+        std::lock_guard<std::mutex> lock(mtxHilo_);
+        activo_ = false;
+    }
+    cvHilo_.notify_all();
+    if (hilo_.joinable()) {
+        hilo_.join();
+    }
+}
+
+void MonitorPosicion::bucleSondeo() {
+    std::unique_lock<std::mutex> lock(mtxHilo_);
+    while (activo_) {
+        lock.unlock();
+        Punto3D posicion;
+        if (muestreo_(posicion)) {
+            publicarMedida(posicion);
+        }
+        lock.lock();
+        cvHilo_.wait_for(lock, std::chrono::milliseconds(periodoMs_), [this] { return !activo_; });
+    }
+}
+
+void MonitorPosicion::publicar(const std::function<void(MuestraPosicion&)>& modificar) {
+    // Copia, modificación y reemplazo: los lectores siguen con la instantánea anterior
+    std::lock_guard<std::mutex> lock(mtxPublicacion_);
+    std::shared_ptr<MuestraPosicion> nueva = std::make_shared<MuestraPosicion>(*std::atomic_load(&muestra_));
+    modificar(*nueva);
+    ++nueva->secuencia;
+    std::shared_ptr<const MuestraPosicion> publicada(std::move(nueva));
+    std::atomic_store(&muestra_, publicada);
+    if (observador_) {
+        observador_(*publicada);
+    }
+}
+
+void MonitorPosicion::publicarMedida(const Punto3D& posicion) {
+    publicar([&posicion](MuestraPosicion& m) {
+        m.medida = posicion;
+        m.medidaValida = true;
+        m.instanteMedida = std::chrono::steady_clock::now();
+    });
+}
+
+void MonitorPosicion::publicarComandada(const Punto3D& posicion) {
+    publicar([&posicion](MuestraPosicion& m) {
+        m.comandada = posicion;
+        m.instanteComandada = std::chrono::steady_clock::now();
+    });
+}
+
+std::shared_ptr<const MuestraPosicion> MonitorPosicion::obtener() const {
+    return std::atomic_load(&muestra_);
+}
+
+bool MonitorPosicion::parsearM114(const std::string& respuesta, Punto3D& posicion) {
+    const char* p = respuesta.c_str();
+    const char* fin = p + respuesta.size();
+    bool hayX = false, hayY = false, hayZ = false;
+
+    for (; p < fin; ++p) {
+        if (std::strncmp(p, "Count", 5) == 0) {
+            break; // lo que sigue son pasos de motor, no milímetros
+        }
+        char eje = *p;
+        if ((eje != 'X' && eje != 'Y' && eje != 'Z') || p + 1 >= fin || p[1] != ':') {
+            continue;
+        }
+        char* finNumero = nullptr;
+        double valor = std::strtod(p + 2, &finNumero);
+        if (finNumero == p + 2) {
+            continue;
+        }
+        switch (eje) {
+            case 'X': posicion.x = valor; hayX = true; break;
+            case 'Y': posicion.y = valor; hayY = true; break;
+            default:  posicion.z = valor; hayZ = true; break;
+        }
+        p = finNumero - 1;
+    }
+    return hayX && hayY && hayZ;
+}
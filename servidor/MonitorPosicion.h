@@ -0,0 +1,80 @@
+#ifndef MONITORPOSICION_H
+#define MONITORPOSICION_H
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "Geometria.h"
+
+// Instantánea inmutable de la posición del robot. Se reemplaza entera en cada
+// publicación, de modo que los lectores nunca ven una mezcla de dos muestras.
+struct MuestraPosicion {
+    Punto3D medida;       // último reporte M114 del robot
+    Punto3D comandada;    // último destino enviado por el servidor
+    bool medidaValida;
+    std::chrono::steady_clock::time_point instanteMedida;
+    std::chrono::steady_clock::time_point instanteComandada;
+    std::uint64_t secuencia;  // crece con cada publicación
+
+    MuestraPosicion() : medidaValida(false), secuencia(0) {}
+
+    // La información más reciente de las dos fuentes
+    const Punto3D& actual() const {
+        return (medidaValida && instanteMedida >= instanteComandada) ? medida : comandada;
+    }
+    bool actualEsMedida() const { return medidaValida && instanteMedida >= instanteComandada; }
+};
+
+// Sondea periódicamente la posición del robot en un hilo propio y publica el
+// resultado con un intercambio atómico de shared_ptr. Leer la posición no
+// toca el puerto serie ni toma cerrojos.
+class MonitorPosicion {
+public:
+    // Devuelve false si no hubo muestra en este ciclo (puerto ocupado, sin respuesta)
+    typedef std::function<bool(Punto3D&)> FuncionMuestreo;
+    // Se llama tras cada publicación, desde el hilo que publica
+    typedef std::function<void(const MuestraPosicion&)> Observador;
+
+private:
+    std::shared_ptr<const MuestraPosicion> muestra_;  // acceso con std::atomic_load/store
+    std::mutex mtxPublicacion_;                       // sólo entre escritores
+
+    FuncionMuestreo muestreo_;
+    Observador observador_;
+    int periodoMs_;
+    std::atomic<bool> activo_;
+    std::thread hilo_;
+    std::mutex mtxHilo_;
+    std::condition_variable cvHilo_;
+
+    void bucleSondeo();
+    void publicar(const std::function<void(MuestraPosicion&)>& modificar);
+
+public:
+    MonitorPosicion();
+    ~MonitorPosicion();
+
+    // periodoMs <= 0 deja el monitor sin sondeo (sólo posiciones comandadas)
+    void iniciar(const FuncionMuestreo& muestreo, int periodoMs);
+    void detener();
+    bool estaActivo() const { return activo_; }
+
+    // Debe configurarse antes de iniciar el sondeo
+    void establecerObservador(const Observador& observador) { observador_ = observador; }
+
+    void publicarMedida(const Punto3D& posicion);
+    void publicarComandada(const Punto3D& posicion);
+    std::shared_ptr<const MuestraPosicion> obtener() const;
+
+    // Extrae X/Y/Z de un reporte M114 ("X:10.00 Y:20.00 Z:30.00 E:0.00 Count X:...").
+    // Los contadores de pasos que siguen a "Count" se ignoran.
+    static bool parsearM114(const std::string& respuesta, Punto3D& posicion);
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "PlanificadorMovimiento.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+PlanificadorMovimiento::PlanificadorMovimiento(const ConfiguracionPlanificador& config)
+    : config_(config) {
+}
+
+double PlanificadorMovimiento::velocidadMaximaUnion(const double dirAnterior[3], const double dirActual[3]) const {
+    // Coseno del ángulo entre la dirección saliente y la entrante (método de desviación de unión)
+    double cosTheta = -(dirAnterior[0] * dirActual[0] + dirAnterior[1] * dirActual[1] + dirAnterior[2] * dirActual[2]);
+
+    if (cosTheta > 0.999999) {
+        // Inversión de sentido: hay que detenerse
+        return 0.0;
+    }
+    if (cosTheta < -0.999999) {
+        // Tramos colineales: no limita
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double senoMedio = std::sqrt(0.5 * (1.0 - cosTheta));
+    double v2 = config_.aceleracion * config_.desviacionUnion * senoMedio / (1.0 - senoMedio);
+    return std::sqrt(v2) * 60.0; // mm/s -> mm/min
+}
+
+ResultadoPlanificacion PlanificadorMovimiento::planificar(double x0, double y0, double z0,
+                                                          std::vector<SegmentoPlan>& segmentos) const {
+    ResultadoPlanificacion resultado;
+    const std::size_t n = segmentos.size();
+    resultado.segmentos = n;
+    resultado.paradasSinPlanificar = n; // sin planificar cada vértice es una parada completa
+    if (n == 0) {
+        return resultado;
+    }
+
+    // Aceleración en mm/min^2 para trabajar directamente con F
+    const double a = config_.aceleracion * 3600.0;
+
+    std::vector<double> longitud(n, 0.0);
+    std::vector<double> entradaMax(n, 0.0);
+    std::vector<double> nominal(n, 0.0);
+
+    double px = x0, py = y0, pz = z0;
+    double dirPrevia[3] = {0, 0, 0};
+    bool hayDirPrevia = false;
+
+    for (std::size_t i = 0; i < n; ++i) {
+        SegmentoPlan& s = segmentos[i];
+        double dx = s.x - px, dy = s.y - py, dz = s.z - pz;
+        longitud[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+        nominal[i] = std::min(std::max(s.velocidadNominal, config_.velocidadMinima), config_.velocidadMaxima);
+
+        if (longitud[i] > 1e-9) {
+            double dir[3] = {dx / longitud[i], dy / longitud[i], dz / longitud[i]};
+            if (hayDirPrevia) {
+                double vUnion = velocidadMaximaUnion(dirPrevia, dir);
+                entradaMax[i] = std::min({vUnion, nominal[i], nominal[i - 1]});
+            }
+            std::copy(dir, dir + 3, dirPrevia);
+            hayDirPrevia = true;
+        } else if (i > 0) {
+            // Tramo nulo: no cambia la dirección, hereda el límite del vértice
+            entradaMax[i] = std::min(nominal[i], nominal[i - 1]);
+        }
+
+        px = s.x; py = s.y; pz = s.z;
+    }
+
+    std::vector<double> entrada(entradaMax);
+    std::vector<double> salida(n, 0.0);
+
+    // Pasada hacia atrás: cada tramo debe poder frenar hasta la entrada del siguiente
+    for (std::size_t k = n; k-- > 0;) {
+        double vSalida = (k + 1 < n) ? entrada[k + 1] : 0.0;
+        salida[k] = vSalida;
+        entrada[k] = std::min(entrada[k], std::sqrt(vSalida * vSalida + 2.0 * a * longitud[k]));
+    }
+
+    // Pasada hacia adelante: cada tramo debe poder acelerar desde su entrada
+    entrada[0] = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        double alcanzable = std::sqrt(entrada[i] * entrada[i] + 2.0 * a * longitud[i]);
+        salida[i] = std::min(salida[i], alcanzable);
+        if (i + 1 < n) {
+            entrada[i + 1] = std::min(entrada[i + 1], salida[i]);
+            salida[i] = entrada[i + 1];
+        }
+    }
+
+    double sumaUnion = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        SegmentoPlan& s = segmentos[i];
+        s.velocidadEntrada = entrada[i];
+        s.velocidadSalida = salida[i];
+
+        // Pico alcanzable en el tramo con perfil trapezoidal entre entrada y salida
+        double pico = std::sqrt((2.0 * a * longitud[i] + entrada[i] * entrada[i] + salida[i] * salida[i]) / 2.0);
+        double ajustada = std::min(nominal[i], pico);
+        s.velocidadAjustada = std::min(std::max(ajustada, config_.velocidadMinima), config_.velocidadMaxima);
+
+        if (salida[i] < config_.velocidadMinima) {
+            ++resultado.paradasPlanificadas;
+        }
+        sumaUnion += salida[i];
+    }
+    resultado.velocidadMediaUnion = sumaUnion / static_cast<double>(n);
+
+    return resultado;
+}
+
+double PlanificadorMovimiento::duracionTramo(double longitud, double v0, double v1, double vCrucero) const {
+    if (longitud <= 0.0 || vCrucero <= 0.0) {
+        return 0.0;
+    }
+
+    // Se trabaja en mm/s y mm/s^2
+    double vc = vCrucero / 60.0;
+    double a = config_.aceleracion;
+    if (a <= 0.0) {
+        return longitud / vc;
+    }
+    double vi = std::min(v0 / 60.0, vc);
+    double vf = std::min(v1 / 60.0, vc);
+
+    double dAcel = (vc * vc - vi * vi) / (2.0 * a);
+    double dFren = (vc * vc - vf * vf) / (2.0 * a);
+    if (dAcel + dFren <= longitud) {
+        return (vc - vi) / a + (vc - vf) / a + (longitud - dAcel - dFren) / vc;
+    }
+
+    // Perfil triangular: no llega a la velocidad de crucero
+    double pico = std::sqrt((2.0 * a * longitud + vi * vi + vf * vf) / 2.0);
+    if (pico < std::max(vi, vf)) {
+        // El tramo es demasiado corto para cambiar de velocidad: se recorre a la media
+        return 2.0 * longitud / (vi + vf);
+    }
+    return (pico - vi) / a + (pico - vf) / a;
+}
@@ -0,0 +1,66 @@
+#ifndef PLANIFICADORMOVIMIENTO_H
+#define PLANIFICADORMOVIMIENTO_H
+
+#include <vector>
+#include <cstddef>
+
+// Límites dinámicos del brazo usados por el planificador
+struct ConfiguracionPlanificador {
+    double aceleracion;      // mm/s^2
+    double desviacionUnion;  // mm, tolerancia de desvío en las esquinas (junction deviation)
+    double velocidadMinima;  // mm/min
+    double velocidadMaxima;  // mm/min
+
+    ConfiguracionPlanificador()
+        : aceleracion(400.0), desviacionUnion(0.05), velocidadMinima(60.0), velocidadMaxima(6000.0) {}
+};
+
+// Un tramo lineal de la trayectoria (entrada y salida del planificador)
+struct SegmentoPlan {
+    double x, y, z;            // punto final del tramo
+    double velocidadNominal;   // mm/min pedida por el usuario
+
+    // Resultados (mm/min)
+    double velocidadEntrada;
+    double velocidadSalida;
+    double velocidadAjustada;  // F a emitir para el tramo
+
+    SegmentoPlan(double x = 0, double y = 0, double z = 0, double velocidad = 0)
+        : x(x), y(y), z(z), velocidadNominal(velocidad),
+          velocidadEntrada(0), velocidadSalida(0), velocidadAjustada(velocidad) {}
+};
+
+struct ResultadoPlanificacion {
+    std::size_t segmentos;
+    std::size_t paradasSinPlanificar;  // vértices con parada completa antes de planificar
+    std::size_t paradasPlanificadas;   // vértices que siguen requiriendo parada completa
+    double velocidadMediaUnion;        // mm/min, media de las velocidades en los vértices
+
+    ResultadoPlanificacion() : segmentos(0), paradasSinPlanificar(0), paradasPlanificadas(0), velocidadMediaUnion(0) {}
+};
+
+// Planificador con lookahead: calcula la velocidad máxima en cada vértice a partir
+// del ángulo entre tramos y de la aceleración, y la propaga hacia atrás y hacia
+// adelante para que cada tramo pueda frenar/acelerar dentro de su longitud.
+class PlanificadorMovimiento {
+private:
+    ConfiguracionPlanificador config_;
+
+    double velocidadMaximaUnion(const double dirAnterior[3], const double dirActual[3]) const;
+
+public:
+    explicit PlanificadorMovimiento(const ConfiguracionPlanificador& config = ConfiguracionPlanificador());
+
+    // Planifica los tramos partiendo del reposo en (x0, y0, z0) y terminando detenido.
+    // Modifica las velocidades de los tramos in situ.
+    ResultadoPlanificacion planificar(double x0, double y0, double z0, std::vector<SegmentoPlan>& segmentos) const;
+
+    // Duración (s) de un tramo con perfil trapezoidal que entra a v0 y sale a v1 sin
+    // superar vCrucero (todas en mm/min), con la aceleración configurada.
+    double duracionTramo(double longitud, double v0, double v1, double vCrucero) const;
+    
+    const ConfiguracionPlanificador& obtenerConfiguracion() const { return config_; }
+    void configurar(const ConfiguracionPlanificador& config) { config_ = config; }
+};
+
+#endif
@@ -0,0 +1,332 @@
+#include "SegmentosLog.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// Campos entre comillas de una línea del manifiesto; el último va sin comillas
+std::vector<std::string> camposManifiesto(const std::string &linea) {
+    std::vector<std::string> campos;
+    std::size_t pos = 0;
+    while (pos < linea.size()) {
+        if (linea[pos] == '"') {
+            std::size_t fin = linea.find('"', pos + 1);
+            if (fin == std::string::npos) break;
+            campos.push_back(linea.substr(pos + 1, fin - pos - 1));
+            pos = fin + 1;
+        } else {
+            std::size_t fin = linea.find(',', pos);
+            campos.push_back(linea.substr(pos, fin == std::string::npos ? std::string::npos : fin - pos));
+            if (fin == std::string::npos) break;
+            pos = fin;
+        }
+        if (pos < linea.size() && linea[pos] == ',') ++pos;
+    }
+    return campos;
+}
+
+const std::size_t TAM_BLOQUE = 256 * 1024;
+
+} // namespace
+
+bool ManifiestoLog::cargar() {
+    segmentos_.clear();
+    std::ifstream ifs(ruta_);
+    if (!ifs.is_open()) return false; // todavía no se rotó nada
+    std::string linea;
+    while (std::getline(ifs, linea)) {
+        std::vector<std::string> campos = camposManifiesto(linea);
+        if (campos.size() < 4) continue;
+        SegmentoLog s;
+        s.archivo = campos[0];
+        s.desde = campos[1];
+        s.hasta = campos[2];
+        s.lineas = std::strtoul(campos[3].c_str(), nullptr, 10);
+        if (campos.size() > 4) s.columnar = campos[4];
+        segmentos_.push_back(s);
+    }
+    return true;
+}
+
+bool ManifiestoLog::agregar(const SegmentoLog &segmento) {
+    segmentos_.push_back(segmento);
+    return confirmar(segmentos_.size() - 1, segmento.archivo);
+}
+
+void ManifiestoLog::agregarPendiente(const SegmentoLog &segmento) {
+    segmentos_.push_back(segmento);
+}
+
+bool ManifiestoLog::confirmar(std::size_t indice, const std::string &archivo) {
+    SegmentoLog &segmento = segmentos_[indice];
+    segmento.archivo = archivo;
+    std::ofstream ofs(ruta_, std::ios::app);
+    if (!ofs.is_open()) {
+        std::cerr << "Error: no se pudo escribir el manifiesto de log " << ruta_ << std::endl;
+        return false;
+    }
+    ofs << '"' << segmento.archivo << "\",\"" << segmento.desde << "\",\"" << segmento.hasta << "\","
+        << segmento.lineas << ",\"" << segmento.columnar << "\"\n";
+    return true;
+}
+
+bool segmentoComprimido(const SegmentoLog &segmento) {
+    const std::string &a = segmento.archivo;
+    return a.size() >= 3 && a.compare(a.size() - 3, 3, ".gz") == 0;
+}
+
+bool comprimirSegmento(const std::string &origen, const std::string &destino, int nivel) {
+    std::ifstream ifs(origen, std::ios::binary);
+    if (!ifs.is_open()) {
+        std::cerr << "Error: no se pudo abrir " << origen << " para comprimir" << std::endl;
+        return false;
+    }
+    std::string temporal = destino + ".tmp";
+    std::string modo = "wb" + std::to_string(nivel);
+    gzFile gz = gzopen(temporal.c_str(), modo.c_str());
+    if (!gz) {
+        std::cerr << "Error: no se pudo crear " << temporal << std::endl;
+        return false;
+    }
+
+    std::vector<char> bloque(TAM_BLOQUE);
+    bool ok = true;
+    while (ok && ifs) {
+        ifs.read(bloque.data(), bloque.size());
+        std::streamsize leidos = ifs.gcount();
+        if (leidos > 0 && gzwrite(gz, bloque.data(), static_cast<unsigned>(leidos)) != leidos) {
+            ok = false;
+        }
+    }
+    if (gzclose(gz) != Z_OK) ok = false;
+    if (ok && std::rename(temporal.c_str(), destino.c_str()) != 0) ok = false;
+    if (!ok) {
+        std::cerr << "Error comprimiendo segmento de log " << destino << std::endl;
+        std::remove(temporal.c_str());
+    }
+    return ok;
+}
+
+bool leerBloquesLog(const std::string &ruta, bool comprimido,
+                    const std::function<void(const char *, std::size_t)> &porBloque) {
+    return leerBloquesLogDesde(ruta, comprimido, 0, [&](const char *texto, std::size_t n, std::uint64_t) {
+        porBloque(texto, n);
+        return true;
+    });
+}
+
+LectoresGzip::~LectoresGzip() {
+    for (auto &l : lectores_) gzclose(l.gz);
+}
+
+bool LectoresGzip::tomar(const std::string &ruta, std::uint64_t desde, Lector &lector) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    for (auto it = lectores_.begin(); it != lectores_.end(); ++it) {
+        if (it->ruta == ruta && desde >= it->offset && desde - it->offset <= it->datos.size()) {
+            lector = std::move(*it);
+            lectores_.erase(it);
+            ++reanudados_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void LectoresGzip::guardar(Lector lector) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    lectores_.push_front(std::move(lector));
+    while (lectores_.size() > maximo_) {
+        gzclose(lectores_.back().gz);
+        lectores_.pop_back();
+    }
+}
+
+std::size_t LectoresGzip::reanudados() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return reanudados_;
+}
+
+// Con 'abierto' no se abre 'ruta': se lee ese CSV ya abierto
+static bool leerBloques(const std::string &ruta, bool comprimido, std::uint64_t desde,
+                        const std::function<bool(const char *, std::size_t, std::uint64_t)> &porBloque,
+                        LectoresGzip *lectores, std::ifstream *abierto) {
+    gzFile gz = nullptr;
+    std::ifstream propio;
+    std::ifstream &ifs = abierto ? *abierto : propio;
+    std::vector<char> bloque;
+    std::size_t arrastre = 0;
+    LectoresGzip::Lector guardado;
+    if (comprimido && lectores && lectores->tomar(ruta, desde, guardado)) {
+        // Se sigue desde lo que quedó descomprimido de la página anterior
+        gz = guardado.gz;
+        bloque = std::move(guardado.datos);
+        std::size_t salto = static_cast<std::size_t>(desde - guardado.offset);
+        arrastre = bloque.size() - salto;
+        std::memmove(bloque.data(), bloque.data() + salto, arrastre);
+        bloque.resize(std::max(bloque.size(), TAM_BLOQUE));
+    } else if (comprimido) {
+        gz = gzopen(ruta.c_str(), "rb");
+        if (!gz) {
+            std::cerr << "Error: no se pudo abrir el segmento " << ruta << std::endl;
+            return false;
+        }
+        gzbuffer(gz, TAM_BLOQUE);
+        // En un gzip el salto se hace descomprimiendo hasta 'desde'
+        if (desde > 0 && gzseek(gz, static_cast<z_off_t>(desde), SEEK_SET) < 0) {
+            std::cerr << "Error: posición inválida en el segmento " << ruta << std::endl;
+            gzclose(gz);
+            return false;
+        }
+    } else {
+        if (!abierto) ifs.open(ruta, std::ios::binary);
+        if (!ifs.is_open()) return false;
+        ifs.clear();
+        ifs.seekg(static_cast<std::streamoff>(desde));
+    }
+    if (bloque.empty()) bloque.resize(TAM_BLOQUE);
+
+    // Entrega los n primeros bytes; si el lector corta, un gzip se guarda con todo
+    // lo descomprimido (la página siguiente empieza dentro de ese bloque)
+    std::uint64_t offset = desde; // posición en el archivo del principio de 'bloque'
+    auto entregar = [&](std::size_t n, std::size_t total) {
+        if (porBloque(bloque.data(), n, offset)) return true;
+        if (gz && lectores) {
+            LectoresGzip::Lector lector;
+            lector.ruta = ruta;
+            lector.offset = offset;
+            lector.datos.assign(bloque.begin(), bloque.begin() + total);
+            lector.gz = gz;
+            lectores->guardar(std::move(lector));
+            gz = nullptr;
+        }
+        return false;
+    };
+
+    // Lo que sigue al último '\n' de un bloque pasa al principio del siguiente
+    bool ok = true;
+    bool seguir = true;
+    while (seguir) {
+        if (arrastre == bloque.size()) bloque.resize(bloque.size() * 2); // línea más larga que el bloque
+        std::size_t libre = bloque.size() - arrastre;
+        long leidos;
+        if (comprimido) {
+            leidos = gzread(gz, bloque.data() + arrastre, static_cast<unsigned>(libre));
+        } else {
+            ifs.read(bloque.data() + arrastre, static_cast<std::streamsize>(libre));
+            leidos = static_cast<long>(ifs.gcount());
+        }
+        if (leidos < 0) {
+            std::cerr << "Error leyendo el segmento " << ruta << std::endl;
+            ok = false;
+            break;
+        }
+        if (leidos == 0) break;
+
+        std::size_t total = arrastre + static_cast<std::size_t>(leidos);
+        std::size_t completas = total;
+        while (completas > 0 && bloque[completas - 1] != '\n') --completas;
+        if (completas > 0) {
+            seguir = entregar(completas, total);
+            if (!seguir) break;
+            std::memmove(bloque.data(), bloque.data() + completas, total - completas);
+            offset += completas;
+        }
+        arrastre = total - completas;
+    }
+    if (ok && seguir && arrastre > 0) entregar(arrastre, arrastre); // última línea sin '\n'
+    if (gz) gzclose(gz);
+    return ok;
+}
+
+bool leerBloquesLogDesde(const std::string &ruta, bool comprimido, std::uint64_t desde,
+                         const std::function<bool(const char *, std::size_t, std::uint64_t)> &porBloque,
+                         LectoresGzip *lectores) {
+    return leerBloques(ruta, comprimido, desde, porBloque, lectores, nullptr);
+}
+
+bool leerBloquesLogDesde(std::ifstream &csv, std::uint64_t desde,
+                         const std::function<bool(const char *, std::size_t, std::uint64_t)> &porBloque) {
+    return leerBloques("", false, desde, porBloque, nullptr, &csv);
+}
+
+bool leerBloquesSegmentoDesde(const SegmentoLog &segmento, std::uint64_t desde,
+                              const std::function<bool(const char *, std::size_t, std::uint64_t)> &porBloque,
+                              LectoresGzip *lectores) {
+    if (segmentoComprimido(segmento)) {
+        return leerBloquesLogDesde(segmento.archivo, true, desde, porBloque, lectores);
+    }
+    // Si el CSV no se pudo abrir no se entregó nada todavía y se pasa al .gz
+    bool entregado = false;
+    bool ok = leerBloquesLogDesde(segmento.archivo, false, desde,
+                                  [&](const char *texto, std::size_t n, std::uint64_t offset) {
+        entregado = true;
+        return porBloque(texto, n, offset);
+    });
+    if (ok || entregado || segmento.archivo.size() < 4) return ok;
+    std::string comprimido = segmento.archivo.substr(0, segmento.archivo.size() - 4) + ".gz";
+    return leerBloquesLogDesde(comprimido, true, desde, porBloque, lectores);
+}
+
+bool leerLineasHaciaAtras(const std::string &ruta, std::uint64_t hasta,
+                          const std::function<bool(const char *, std::size_t)> &porLinea) {
+    std::ifstream ifs(ruta, std::ios::binary);
+    return leerLineasHaciaAtras(ifs, hasta, porLinea);
+}
+
+bool leerLineasHaciaAtras(std::ifstream &ifs, std::uint64_t hasta,
+                          const std::function<bool(const char *, std::size_t)> &porLinea) {
+    if (!ifs.is_open()) return false;
+    ifs.clear();
+    ifs.seekg(0, std::ios::end);
+    std::uint64_t pos = std::min<std::uint64_t>(hasta, static_cast<std::uint64_t>(ifs.tellg()));
+
+    // 'resto' es el principio de una línea cuyo comienzo está en un bloque anterior
+    std::string texto, resto;
+    while (true) {
+        std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(TAM_BLOQUE, pos));
+        pos -= n;
+        texto.resize(n);
+        ifs.seekg(static_cast<std::streamoff>(pos));
+        if (n > 0 && !ifs.read(&texto[0], static_cast<std::streamsize>(n))) return false;
+        texto += resto;
+
+        std::size_t fin = texto.size();
+        for (std::size_t nl; fin > 0 && (nl = texto.rfind('\n', fin - 1)) != std::string::npos; fin = nl) {
+            if (fin > nl + 1 && !porLinea(texto.data() + nl + 1, fin - nl - 1)) return true;
+        }
+        if (pos == 0) {
+            if (fin > 0) porLinea(texto.data(), fin);
+            return true;
+        }
+        resto.assign(texto, 0, fin);
+    }
+}
+
+bool leerLineasLog(const std::string &ruta, bool comprimido,
+                   const std::function<void(const std::string &)> &porLinea) {
+    std::string linea;
+    return leerBloquesLog(ruta, comprimido, [&](const char *texto, std::size_t n) {
+        std::size_t pos = 0;
+        while (pos < n) {
+            const char *nl = static_cast<const char *>(std::memchr(texto + pos, '\n', n - pos));
+            std::size_t fin = nl ? static_cast<std::size_t>(nl - texto) : n;
+            linea.assign(texto + pos, fin - pos);
+            porLinea(linea);
+            pos = fin + 1;
+        }
+    });
+}
+
+std::string timestampDeLinea(const std::string &linea) {
+    std::size_t p1 = linea.find('"');
+    if (p1 == std::string::npos) return "";
+    std::size_t p2 = linea.find('"', p1 + 1);
+    if (p2 == std::string::npos) return "";
+    return linea.substr(p1 + 1, p2 - p1 - 1);
+}
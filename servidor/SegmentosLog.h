@@ -0,0 +1,119 @@
+#ifndef SEGMENTOSLOG_H
+#define SEGMENTOSLOG_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <functional>
+#include <fstream>
+#include <cstddef>
+#include <cstdint>
+
+struct gzFile_s;
+
+// Segmento de log ya rotado: archivo, su log columnar (si lo tiene) y rango de
+// timestamps. Al rotar queda como <log>.NNNNNN.csv hasta que se comprime en
+// segundo plano a <log>.NNNNNN.gz; si no pudo comprimirse sigue como .csv.
+struct SegmentoLog {
+    std::string archivo;
+    std::string desde;   // timestamp de la primera línea
+    std::string hasta;   // timestamp de la última línea
+    std::size_t lineas = 0;
+    std::string columnar;
+};
+
+// Índice de segmentos rotados, persistido como CSV junto al log
+// ("archivo","desde","hasta",lineas,"columnar"). Los segmentos quedan en orden de rotación,
+// que es también el orden cronológico.
+class ManifiestoLog {
+private:
+    std::string ruta_;
+    std::vector<SegmentoLog> segmentos_;
+
+public:
+    explicit ManifiestoLog(const std::string &ruta = "") : ruta_(ruta) {}
+
+    bool cargar();
+    bool agregar(const SegmentoLog &segmento);
+    // Un segmento que todavía se comprime ya está en segmentos(), pero se escribe
+    // en el archivo con confirmar() al terminar (en el mismo orden en que se agregó)
+    void agregarPendiente(const SegmentoLog &segmento);
+    bool confirmar(std::size_t indice, const std::string &archivo);
+    const std::vector<SegmentoLog> &segmentos() const { return segmentos_; }
+};
+
+bool segmentoComprimido(const SegmentoLog &segmento); // el archivo termina en .gz
+
+// Descompresores de segmentos detenidos donde terminó una página, para que la
+// siguiente siga desde ahí en lugar de descomprimir otra vez desde el principio.
+// Se guardan pocos; al pasar el máximo se cierra el usado hace más tiempo.
+class LectoresGzip {
+public:
+    struct Lector {
+        std::string ruta;
+        std::uint64_t offset = 0;  // posición (descomprimida) del principio de 'datos'
+        std::vector<char> datos;   // lo último que se descomprimió
+        gzFile_s *gz = nullptr;    // parado justo después de 'datos'
+    };
+
+private:
+    std::list<Lector> lectores_; // el más reciente al frente
+    std::size_t maximo_;
+    std::size_t reanudados_ = 0;
+    std::mutex mtx_;
+
+public:
+    explicit LectoresGzip(std::size_t maximo = 4) : maximo_(maximo) {}
+    ~LectoresGzip();
+
+    LectoresGzip(const LectoresGzip &) = delete;
+    LectoresGzip &operator=(const LectoresGzip &) = delete;
+
+    // Saca el lector de 'ruta' cuyos datos contienen la posición 'desde'
+    bool tomar(const std::string &ruta, std::uint64_t desde, Lector &lector);
+    void guardar(Lector lector);
+    std::size_t reanudados(); // lecturas que siguieron un lector guardado
+};
+
+// Comprime 'origen' en 'destino' (gzip). Escribe primero en un temporal y lo
+// renombra al final, de modo que nunca queda un segmento a medio escribir.
+bool comprimirSegmento(const std::string &origen, const std::string &destino, int nivel);
+
+// Entrega el archivo (comprimido o no) en bloques grandes que terminan siempre
+// en fin de línea; el último puede no tenerlo
+bool leerBloquesLog(const std::string &ruta, bool comprimido,
+                    const std::function<void(const char *, std::size_t)> &porBloque);
+
+// Igual, empezando en el byte 'desde' (del contenido ya descomprimido). porBloque
+// recibe además la posición del bloque en el archivo y devuelve false para cortar.
+// Con 'lectores', un gzip cortado así se guarda para retomarlo desde ese bloque.
+bool leerBloquesLogDesde(const std::string &ruta, bool comprimido, std::uint64_t desde,
+                         const std::function<bool(const char *, std::size_t, std::uint64_t)> &porBloque,
+                         LectoresGzip *lectores = nullptr);
+// Igual sobre un CSV ya abierto (p. ej. el activo, abierto bajo el cerrojo del
+// log para que una rotación no cambie el archivo que se lee)
+bool leerBloquesLogDesde(std::ifstream &csv, std::uint64_t desde,
+                         const std::function<bool(const char *, std::size_t, std::uint64_t)> &porBloque);
+
+// leerBloquesLogDesde sobre un segmento rotado. Si su .csv ya no está porque
+// terminó de comprimirse mientras tanto, se lee el .gz con el mismo número.
+bool leerBloquesSegmentoDesde(const SegmentoLog &segmento, std::uint64_t desde,
+                              const std::function<bool(const char *, std::size_t, std::uint64_t)> &porBloque,
+                              LectoresGzip *lectores = nullptr);
+
+// Recorre de la última a la primera las líneas no vacías de los primeros 'hasta'
+// bytes de un archivo sin comprimir; porLinea devuelve false para cortar
+bool leerLineasHaciaAtras(const std::string &ruta, std::uint64_t hasta,
+                          const std::function<bool(const char *, std::size_t)> &porLinea);
+bool leerLineasHaciaAtras(std::ifstream &csv, std::uint64_t hasta,
+                          const std::function<bool(const char *, std::size_t)> &porLinea);
+
+// Recorre las líneas de un archivo de log, comprimido o no
+bool leerLineasLog(const std::string &ruta, bool comprimido,
+                   const std::function<void(const std::string &)> &porLinea);
+
+// Timestamp entre las dos primeras comillas; vacío si la línea no tiene formato
+std::string timestampDeLinea(const std::string &linea);
+
+#endif
@@ -7,7 +7,7 @@
 #include <sys/select.h>
 #include <errno.h> // Para depurar errores
 
-Serial::Serial() : fd(-1) {
+Serial::Serial(const std::string& puerto) : puerto(puerto), fd(-1), respuestaPendiente(false) {
 }
 
 Serial::~Serial() {
@@ -15,7 +15,18 @@ Serial::~Serial() {
 }
 
 bool Serial::abrirPuerto() {
-    fd = open("/dev/ttyACM0", O_RDWR | O_NOCTTY);
+    if (fd >= 0) {
+        return true;
+    }
+    if (!puerto.empty()) {
+        fd = open(puerto.c_str(), O_RDWR | O_NOCTTY);
+        if (fd < 0) {
+            std::cerr << "Error abriendo puerto serie " << puerto << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+    } else {
+        fd = open("/dev/ttyACM0", O_RDWR | O_NOCTTY);
+    }
     if (fd < 0) {
         // Intentar con /dev/ttyUSB0 si /dev/ttyACM0 falla
         fd = open("/dev/ttyUSB0", O_RDWR | O_NOCTTY);
@@ -45,6 +56,7 @@ void Serial::cerrarPuerto() {
     if (fd >= 0) {
         close(fd);
         fd = -1;
+        respuestaPendiente = false;
         std::cout << "Puerto serie cerrado" << std::endl;
     }
 }
@@ -99,7 +111,12 @@ bool Serial::enviarComando(const std::string& comando) {
     }
     
     // Limpiar buffer de ENTRADA (lo que recibimos) ANTES de enviar
-    // Esto es correcto para asegurar que leemos la respuesta al comando actual
+    // Esto es correcto para asegurar que leemos la respuesta al comando actual.
+    // El flush sólo descarta lo ya recibido: si la lectura anterior se agotó, su
+    // respuesta puede estar en camino y se espera antes de enviar
+    if (respuestaPendiente) {
+        descartarRespuestaAtrasada(500);
+    }
     tcflush(fd, TCIFLUSH);
     
     std::string cmd = comando + "\r\n";
@@ -124,12 +141,6 @@ std::string Serial::leerPuerto(int timeoutMs) {
     const int step_ms = 80; // Intervalo de sondeo
     int elapsed = 0;
     
-    // Para G-code, detectar fin de respuesta cuando vemos "ok" o "error"
-    auto completo = [&](const std::string& s) -> bool {
-        return s.find("ok") != std::string::npos ||
-               s.find("error") != std::string::npos;
-    };
-    
     // Este bucle se ejecutará hasta que se agote el timeout *total*
     // O hasta que la función 'completo' devuelva true.
     while (elapsed < timeoutMs) {
@@ -154,7 +165,7 @@ std::string Serial::leerPuerto(int timeoutMs) {
             if (n > 0) {
                 out.append(buf, n);
                 // Si ya tenemos la respuesta completa, salimos
-                if (completo(out)) {
+                if (respuestaCompleta(out)) {
                     break;
                 }
             } else if (n < 0) {
@@ -170,6 +181,8 @@ std::string Serial::leerPuerto(int timeoutMs) {
         }
     }
     
+    respuestaPendiente = !respuestaCompleta(out);
+    
     // Limpiar caracteres de control al final
     while (!out.empty() && (out.back() == '\n' || out.back() == '\r')) {
         out.pop_back();
@@ -178,3 +191,51 @@ std::string Serial::leerPuerto(int timeoutMs) {
     return out;
 }
 
+// Para G-code, la respuesta termina con una línea que empieza por "ok" o "error"
+// (no basta con que aparezca en el texto: "echo:Unknown command: \"look\"")
+bool Serial::respuestaCompleta(const std::string& respuesta) {
+    std::size_t inicio = 0;
+    while (inicio < respuesta.size()) {
+        std::size_t fin = respuesta.find('\n', inicio);
+        if (fin == std::string::npos) {
+            fin = respuesta.size(); // la última línea puede llegar sin salto
+        }
+        std::size_t i = respuesta.find_first_not_of(" \r", inicio);
+        if (i < fin && (respuesta.compare(i, 2, "ok") == 0 || respuesta.compare(i, 5, "error") == 0 ||
+                        respuesta.compare(i, 5, "Error") == 0)) {
+            return true;
+        }
+        inicio = fin + 1;
+    }
+    return false;
+}
+
+void Serial::descartarRespuestaAtrasada(int timeoutMs) {
+    std::string descartada;
+    const int step_ms = 20;
+    int elapsed = 0;
+    while (elapsed < timeoutMs && !respuestaCompleta(descartada)) {
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        FD_SET(fd, &rfds);
+        struct timeval tv{0, step_ms * 1000};
+        int r = select(fd + 1, &rfds, nullptr, nullptr, &tv);
+        if (r < 0) {
+            break;
+        }
+        if (r > 0 && FD_ISSET(fd, &rfds)) {
+            char buf[256];
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            descartada.append(buf, n);
+        } else {
+            elapsed += step_ms;
+        }
+    }
+    if (!descartada.empty()) {
+        std::cout << "Respuesta atrasada descartada: " << descartada << std::endl;
+    }
+    respuestaPendiente = false;
+}
@@ -5,7 +5,8 @@
 
 class Serial {
 public:
-    Serial();
+    // Puerto vacío: se prueban /dev/ttyACM0 y /dev/ttyUSB0
+    explicit Serial(const std::string& puerto = "");
     ~Serial();
     
     bool abrirPuerto();
@@ -14,8 +15,14 @@ public:
     std::string leerPuerto(int timeoutMs = 2000);
 
 private:
+    std::string puerto;
     int fd;
+    // La última lectura terminó sin "ok"/"error": la respuesta puede llegar tarde y
+    // confundirse con la del comando siguiente, así que se descarta antes de enviarlo
+    bool respuestaPendiente;
     bool configurar();
+    void descartarRespuestaAtrasada(int timeoutMs);
+    static bool respuestaCompleta(const std::string& respuesta);
 };
 
 #endif 
\ No newline at end of file
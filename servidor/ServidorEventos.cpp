@@ -0,0 +1,105 @@
+#include "ServidorEventos.h"
+#include "../lib/XmlRpcServerConnection.h"
+#include "../lib/XmlRpcSocket.h"
+#include <iostream>
+
+using namespace Rpc;
+using namespace XmlRpc;
+
+namespace {
+
+// Conexión que avisa cuando el despachador la cierra y la destruye
+class ConexionEventos : public XmlRpcServerConnection {
+private:
+    bool& cerrada;
+public:
+    ConexionEventos(int socket, XmlRpcServer* servidor, bool& cerrada)
+        : XmlRpcServerConnection(socket, servidor, true), cerrada(cerrada) {}
+    ~ConexionEventos() { cerrada = true; }
+};
+
+// Intervalo en que cada hilo revisa si el servidor se está deteniendo (s)
+const double INTERVALO_REVISION = 0.5;
+
+} // namespace
+
+ServidorEventos::ServidorEventos(int maxConexiones)
+    : maxConexiones(maxConexiones), activo(false), conexionesActivas(0) {
+}
+
+ServidorEventos::~ServidorEventos() {
+    detener();
+}
+
+bool ServidorEventos::iniciar(int puerto) {
+    if (!bindAndListen(puerto)) {
+        return false;
+    }
+    activo = true;
+    hiloAceptacion = std::thread([this] {
+        while (activo) {
+            work(INTERVALO_REVISION);
+        }
+        shutdown();
+    });
+    return true;
+}
+
+void ServidorEventos::detener() {
+    if (!activo.exchange(false)) {
+        return;
+    }
+    if (hiloAceptacion.joinable()) {
+        hiloAceptacion.join();
+    }
+    // Cada hilo de conexión termina en su próxima revisión
+    std::unique_lock<std::mutex> lock(mtxConexiones);
+    cvConexiones.wait(lock, [this] { return conexionesActivas == 0; });
+}
+
+int ServidorEventos::obtenerConexionesActivas() {
+    std::lock_guard<std::mutex> lock(mtxConexiones);
+    return conexionesActivas;
+}
+
+void ServidorEventos::acceptConnection() {
+    int s = XmlRpcSocket::accept(this->getfd());
+    if (s < 0) {
+        std::cerr << "Error aceptando conexión de eventos: " << XmlRpcSocket::getErrorMsg() << std::endl;
+        return;
+    }
+    if (!XmlRpcSocket::setNonBlocking(s)) {
+        XmlRpcSocket::close(s);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtxConexiones);
+        if (conexionesActivas >= maxConexiones) {
+            std::cerr << "Conexión de eventos rechazada: límite de " << maxConexiones << " alcanzado" << std::endl;
+            XmlRpcSocket::close(s);
+            return;
+        }
+        ++conexionesActivas;
+    }
+    std::thread(&ServidorEventos::atenderConexion, this, s).detach();
+}
+
+void ServidorEventos::atenderConexion(int socket) {
+    // Despachador propio: la conexión vive sólo en este hilo
+    bool cerrada = false;
+    XmlRpcDispatch despachador;
+    despachador.addSource(new ConexionEventos(socket, this, cerrada), XmlRpcDispatch::ReadableEvent);
+    while (!cerrada && activo) {
+        despachador.work(INTERVALO_REVISION);
+    }
+    if (!cerrada) {
+        despachador.clear(); // cierra y destruye la conexión
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtxConexiones);
+        --conexionesActivas;
+    }
+    cvConexiones.notify_all();
+}
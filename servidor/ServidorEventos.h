@@ -0,0 +1,46 @@
+#ifndef SERVIDOR_EVENTOS_H
+#define SERVIDOR_EVENTOS_H
+
+#include "../lib/XmlRpc.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace Rpc {
+
+    // Servidor XML-RPC para métodos de larga espera. El servidor principal atiende
+    // todo en un único hilo, de modo que una llamada que bloquea lo frenaría para
+    // todos los clientes; aquí cada conexión se atiende en su propio hilo.
+    class ServidorEventos : public XmlRpc::XmlRpcServer {
+    private:
+        int maxConexiones;
+        std::atomic<bool> activo;
+        std::thread hiloAceptacion;
+
+        // Conexiones vivas, para esperar a que terminen al detener
+        std::mutex mtxConexiones;
+        std::condition_variable cvConexiones;
+        int conexionesActivas;
+
+        void atenderConexion(int socket);
+
+    protected:
+        void acceptConnection() override;
+
+    public:
+        explicit ServidorEventos(int maxConexiones = 32);
+        ~ServidorEventos();
+
+        // Las conexiones no se registran en el despachador del servidor
+        void removeConnection(XmlRpc::XmlRpcServerConnection*) override {}
+
+        bool iniciar(int puerto);
+        // Quien use métodos de espera debe despertarlos antes de llamar a detener()
+        void detener();
+        int obtenerConexionesActivas();
+    };
+
+} // namespace Rpc
+
+#endif
@@ -1,10 +1,14 @@
 #include "ServidorRpc.h"
 #include "../inc/Excepciones.h"
+#include "IndiceLineas.h"
 #include <iostream>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
-#include <dirent.h>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
 
 using namespace Rpc;
 using namespace XmlRpc;
@@ -18,6 +22,28 @@ ServidorRpc::ServidorRpc() : servidor(nullptr), puerto(0), accesoRemotoHabilitad
     // Crear gestor de reportes apuntando al CSV dentro de la carpeta servidor
     gestorReportes.reset(new GestorReportes("servidor_log.csv"));
     gestorRobot.reset(new GestorCodigoG());
+    colaRobot.reset(new ColaComandos());
+    servidorEventos.reset(new ServidorEventos());
+    // Los índices de líneas de los archivos se guardan aparte, no junto a cada uno
+    IndiceLineas::configurarCache("indices_lineas");
+    catalogoArchivos.reset(new CatalogoArchivos(".", ".gcode"));
+    almacenGCode.reset(new AlmacenGCode("gcode_almacen"));
+    
+    // La telemetría y el ejecutor alimentan el estado al que se suscriben los clientes
+    GestorReportes* reportes = gestorReportes.get();
+    gestorRobot->observarPosicion([reportes](const MuestraPosicion& muestra) {
+        const Punto3D& p = muestra.actual();
+        char texto[96];
+        std::snprintf(texto, sizeof(texto), "X:%.2f Y:%.2f Z:%.2f", p.x, p.y, p.z);
+        reportes->actualizarPosicion(texto);
+    });
+    gestorRobot->observarEjecucion([reportes](EstadoEjecucion estado, size_t comando, size_t total) {
+        std::string texto = GestorCodigoG::nombreEstadoEjecucion(estado);
+        if (estado != EstadoEjecucion::INACTIVO) {
+            texto += " " + std::to_string(std::min(comando + 1, total)) + "/" + std::to_string(total);
+        }
+        reportes->actualizarEstadoEjecucion(texto);
+    });
     
     // Inicializar base de datos
     gestorBBDD->inicializar();
@@ -28,6 +54,10 @@ ServidorRpc::ServidorRpc() : servidor(nullptr), puerto(0), accesoRemotoHabilitad
 }
 
 ServidorRpc::~ServidorRpc() {
+    if (gestorReportes) {
+        gestorReportes->despertarSuscriptores();
+    }
+    servidorEventos.reset();
     if (servidor) {
         delete servidor;
     }
@@ -62,8 +92,13 @@ void ServidorRpc::iniciarServidor() {
         new MetodoAprenderTrayectoria(servidor, this);
         new MetodoSubirGCode(servidor, this);
         new MetodoEjecutarArchivo(servidor, this);
+        new MetodoSimularArchivo(servidor, this);
+        new MetodoControlEjecucion(servidor, this);
+        new MetodoParadaEmergencia(servidor, this);
+        new MetodoSuscribirEstado(servidor, this, false);
         new MetodoReporteLogCsv(servidor, this);
         new MetodoListarArchivos(servidor, this);
+        new MetodoExportarLog(servidor, this);
         
         XmlRpc::setVerbosity(1);
         
@@ -71,8 +106,15 @@ void ServidorRpc::iniciarServidor() {
         servidor->bindAndListen(puerto);
         servidor->enableIntrospection(true);
         
+        // Servidor de eventos: un hilo por conexión, para la larga espera y para que
+        // la parada de emergencia llegue aunque el servidor principal esté ocupado
+        new MetodoSuscribirEstado(servidorEventos.get(), this, true);
+        new MetodoParadaEmergencia(servidorEventos.get(), this);
+        bool eventosActivos = servidorEventos->iniciar(puerto + 1);
+        
         std::cout << "=== SERVIDOR RPC ROBOT ===" << std::endl;
         std::cout << "Puerto: " << puerto << std::endl;
+        std::cout << "Suscripciones: " << (eventosActivos ? "puerto " + std::to_string(puerto + 1) : std::string("no disponibles")) << std::endl;
         std::cout << "Acceso remoto: " << (accesoRemotoHabilitado ? "Habilitado" : "Deshabilitado") << std::endl;
         std::cout << "Base de datos: Inicializada" << std::endl;
         std::cout << "Servidor esperando conexiones..." << std::endl;
@@ -91,6 +133,8 @@ void ServidorRpc::iniciarServidor() {
 void ServidorRpc::detenerServidor() {
     if (servidor) {
         registrarEvento("Servidor RPC detenido", "SISTEMA", "localhost");
+        gestorReportes->despertarSuscriptores();
+        servidorEventos->detener();
         servidor->shutdown();
     }
 }
@@ -135,13 +179,13 @@ bool ServidorRpc::validarUsuario(const std::string& usuario, const std::string&
 }
 
 bool ServidorRpc::esAdministrador(const std::string& sessionId) {
-    auto it = sesionesActivas.find(sessionId);
-    if (it == sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!obtenerSesion(sessionId, sesion)) {
         return false;
     }
     
     // Verificar contra la base de datos para mayor seguridad
-    auto usuarioObj = gestorBBDD->obtenerUsuarioPorNombre(it->second.usuario);
+    auto usuarioObj = gestorBBDD->obtenerUsuarioPorNombre(sesion.usuario);
     if (!usuarioObj) {
         return false;
     }
@@ -171,6 +215,100 @@ std::string ServidorRpc::generarSessionId(const std::string& usuario, const std:
     return usuario + "_" + std::to_string(now);
 }
 
+bool ServidorRpc::ejecutarEnRobot(PrioridadComando prioridad, const std::string& origen,
+                                  const std::function<bool()>& accion, std::string* motivoRechazo) {
+    ResultadoPeticion resultado = colaRobot->ejecutar(prioridad, origen, accion);
+    if (resultado == ResultadoPeticion::EXITO) {
+        return true;
+    }
+    if (resultado != ResultadoPeticion::FALLO && motivoRechazo) {
+        *motivoRechazo = ColaComandos::nombreResultado(resultado);
+    }
+    return false;
+}
+
+bool ServidorRpc::paradaEmergencia(const std::string& origen) {
+    // No pasa por la cola: lo pendiente ya no tiene sentido y se descarta, y la
+    // parada va directo al puerto (detiene la ejecución y envía M5/M84 apenas lo
+    // suelta el comando en curso, p. ej. un G28 manual)
+    std::size_t descartadas = colaRobot->descartarPendientes(PrioridadComando::MANUAL);
+    if (descartadas > 0) {
+        std::cout << "Cola de comandos: " << descartadas << " peticiones descartadas por emergencia" << std::endl;
+    }
+    registrarEvento("PARADA DE EMERGENCIA", origen, "");
+    return gestorRobot->paradaEmergencia();
+}
+
+bool ServidorRpc::obtenerSesion(const std::string& sessionId, SesionUsuario& sesion) {
+    std::lock_guard<std::mutex> lock(mtxSesiones);
+    auto it = sesionesActivas.find(sessionId);
+    if (it == sesionesActivas.end()) {
+        return false;
+    }
+    sesion = it->second;
+    return true;
+}
+
+void ServidorRpc::contarComando(const std::string& sessionId, bool exito) {
+    std::lock_guard<std::mutex> lock(mtxSesiones);
+    auto it = sesionesActivas.find(sessionId);
+    if (it == sesionesActivas.end()) {
+        return;
+    }
+    if (exito) {
+        it->second.comandosEjecutados++;
+    } else {
+        it->second.comandosErroneos++;
+    }
+}
+
+std::map<std::string, SesionUsuario> ServidorRpc::copiaSesiones() {
+    std::lock_guard<std::mutex> lock(mtxSesiones);
+    return sesionesActivas;
+}
+
+void ServidorRpc::asignarPropietarioEjecucion(const std::string& sessionId) {
+    std::lock_guard<std::mutex> lock(mtxSesiones);
+    propietarioEjecucion = sessionId;
+}
+
+bool ServidorRpc::puedeControlarEjecucion(const std::string& sessionId, const SesionUsuario& sesion) {
+    if (sesion.esAdmin) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mtxSesiones);
+    return !propietarioEjecucion.empty() && propietarioEjecucion == sessionId;
+}
+
+// Origen de las peticiones de una sesión para los límites de la cola
+static std::string origenSesion(const SesionUsuario& sesion) {
+    return sesion.usuario + "@" + sesion.nodoOrigen;
+}
+
+// Tamaño de página de los reportes del log: acotado para que ninguna respuesta
+// cargue el log entero en memoria
+static const int LIMITE_PAGINA_DEFECTO = 500;
+static const int LIMITE_PAGINA_MAXIMO = 5000;
+
+static std::size_t limitePagina(XmlRpcValue& params, int indice) {
+    int limite = LIMITE_PAGINA_DEFECTO;
+    if (params.size() > indice && params[indice].getType() == XmlRpcValue::TypeInt) limite = params[indice];
+    return static_cast<std::size_t>(std::max(1, std::min(limite, LIMITE_PAGINA_MAXIMO)));
+}
+
+// Las líneas de la página como texto CSV en 'campo', más el cursor para pedir la siguiente
+static void agregarPagina(XmlRpcValue& result, const std::string& campo, const PaginaLog& pagina) {
+    std::string texto;
+    for (const auto& linea : pagina.lineas) {
+        texto += linea;
+        texto += '\n';
+    }
+    result[campo] = texto;
+    result["lineas"] = static_cast<int>(pagina.lineas.size());
+    result["cursor"] = pagina.cursor;
+    result["hayMas"] = pagina.hayMas;
+}
+
 // Implementación de MetodoLogin
 void MetodoLogin::execute(XmlRpcValue& params, XmlRpcValue& result) {
     if (params.size() < 3) {
@@ -198,7 +336,10 @@ void MetodoLogin::execute(XmlRpcValue& params, XmlRpcValue& result) {
         sesion.comandosEjecutados = 0;
         sesion.comandosErroneos = 0;
         
-        servidor->sesionesActivas[sessionId] = sesion;
+        {
+            std::lock_guard<std::mutex> lock(servidor->mtxSesiones);
+            servidor->sesionesActivas[sessionId] = sesion;
+        }
         
         result["exito"] = true;
         result["sessionId"] = sessionId;
@@ -240,17 +381,26 @@ void MetodoConectarRobot::execute(XmlRpcValue& params, XmlRpcValue& result) {
         return;
     }
     
+    SesionUsuario sesion;
+    servidor->obtenerSesion(sessionId, sesion);
+    GestorCodigoG* robot = servidor->gestorRobot.get();
+    std::string origen = origenSesion(sesion);
+    std::string motivo;
     bool exito = false;
     if (accion == "conectar") {
-        exito = servidor->gestorRobot->conectarRobot();
+        exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origen,
+                                          [robot] { return robot->conectarRobot(); }, &motivo);
         result["mensaje"] = exito ? "Robot conectado" : "Error conectando robot";
     } else if (accion == "desconectar") {
-        servidor->gestorRobot->desconectarRobot();
-        exito = true;
-        result["mensaje"] = "Robot desconectado";
+        exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origen,
+                                          [robot] { robot->desconectarRobot(); return true; }, &motivo);
+        result["mensaje"] = exito ? "Robot desconectado" : "Error desconectando robot";
     } else {
         result["mensaje"] = "Acción inválida: usar 'conectar' o 'desconectar'";
     }
+    if (!motivo.empty()) {
+        result["mensaje"] = "Petición rechazada: " + motivo;
+    }
     
     result["exito"] = exito;
     
@@ -269,10 +419,10 @@ void MetodoConectarRobot::execute(XmlRpcValue& params, XmlRpcValue& result) {
         std::cerr << "Error actualizando estado conexión: " << e.what() << std::endl;
     }
     
-    servidor->registrarEvento("Robot " + accion, servidor->sesionesActivas[sessionId].usuario, servidor->sesionesActivas[sessionId].nodoOrigen);
+    servidor->registrarEvento("Robot " + accion, sesion.usuario, sesion.nodoOrigen);
     // Registrar petición en gestor de reportes
     try {
-        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion("Robot " + accion, servidor->sesionesActivas[sessionId].usuario, servidor->sesionesActivas[sessionId].nodoOrigen, exito ? "200" : "ERROR");
+        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion("Robot " + accion, sesion.usuario, sesion.nodoOrigen, exito ? "200" : "ERROR");
     } catch (const std::exception &e) {
         std::cerr << "Error registrarPeticion ConectarRobot: " << e.what() << std::endl;
     }
@@ -291,8 +441,8 @@ void MetodoMoverRobot::execute(XmlRpcValue& params, XmlRpcValue& result) {
     }
     
     std::string sessionId = params[0];
-    auto it = servidor->sesionesActivas.find(sessionId);
-    if (it == servidor->sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
         result["exito"] = false;
         result["mensaje"] = "Sesión inválida";
         return;
@@ -303,18 +453,19 @@ void MetodoMoverRobot::execute(XmlRpcValue& params, XmlRpcValue& result) {
     double z = params[3];
     double velocidad = (params.size() > 4) ? double(params[4]) : 0;
     
-    bool exito;
-    if (velocidad > 0) {
-        exito = servidor->gestorRobot->moverEfectorConVelocidad(x, y, z, velocidad);
-    } else {
-        exito = servidor->gestorRobot->moverEfectorSinVelocidad(x, y, z);
-    }
+    GestorCodigoG* robot = servidor->gestorRobot.get();
+    std::string motivo;
+    bool exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origenSesion(sesion), [&] {
+        return velocidad > 0 ? robot->moverEfectorConVelocidad(x, y, z, velocidad)
+                             : robot->moverEfectorSinVelocidad(x, y, z);
+    }, &motivo);
     
     result["exito"] = exito;
-    result["mensaje"] = exito ? "Movimiento ejecutado" : "Error en movimiento";
+    result["mensaje"] = exito ? "Movimiento ejecutado"
+                              : (motivo.empty() ? "Error en movimiento" : "Petición rechazada: " + motivo);
     
     if (exito) {
-        it->second.comandosEjecutados++;
+        servidor->contarComando(sessionId, true);
         // Actualizar posición en el gestor de reportes
         try {
             if (servidor->gestorReportes) {
@@ -325,14 +476,14 @@ void MetodoMoverRobot::execute(XmlRpcValue& params, XmlRpcValue& result) {
             std::cerr << "Error actualizando posición: " << e.what() << std::endl;
         }
     } else {
-        it->second.comandosErroneos++;
+        servidor->contarComando(sessionId, false);
     }
     
     servidor->registrarEvento("Movimiento robot X:" + std::to_string(x) + " Y:" + std::to_string(y) + " Z:" + std::to_string(z), 
-                             it->second.usuario, it->second.nodoOrigen);
+                             sesion.usuario, sesion.nodoOrigen);
     // Registrar petición en gestor de reportes
     try {
-        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion("G1 Move X:" + std::to_string(x) + " Y:" + std::to_string(y) + " Z:" + std::to_string(z), it->second.usuario, it->second.nodoOrigen, exito ? "200" : "ERROR");
+        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion("G1 Move X:" + std::to_string(x) + " Y:" + std::to_string(y) + " Z:" + std::to_string(z), sesion.usuario, sesion.nodoOrigen, exito ? "200" : "ERROR");
     } catch (const std::exception &e) {
         std::cerr << "Error registrarPeticion MoverRobot: " << e.what() << std::endl;
     }
@@ -353,28 +504,32 @@ void MetodoEjecutarGCode::execute(XmlRpcValue& params, XmlRpcValue& result) {
     std::string sessionId = params[0];
     std::string comandoG = params[1];
     
-    auto it = servidor->sesionesActivas.find(sessionId);
-    if (it == servidor->sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
         result["exito"] = false;
         result["mensaje"] = "Sesión inválida";
         return;
     }
     
-    bool exito = servidor->gestorRobot->ejecutarComandoGDirecto(comandoG);
+    GestorCodigoG* robot = servidor->gestorRobot.get();
+    std::string motivo;
+    bool exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origenSesion(sesion),
+                                           [&] { return robot->ejecutarComandoGDirecto(comandoG); }, &motivo);
     
     result["exito"] = exito;
-    result["mensaje"] = exito ? "Comando G-Code ejecutado" : "Error ejecutando comando";
+    result["mensaje"] = exito ? "Comando G-Code ejecutado"
+                              : (motivo.empty() ? "Error ejecutando comando" : "Petición rechazada: " + motivo);
     
     if (exito) {
-        it->second.comandosEjecutados++;
+        servidor->contarComando(sessionId, true);
     } else {
-        it->second.comandosErroneos++;
+        servidor->contarComando(sessionId, false);
     }
     
-    servidor->registrarEvento("Comando G-Code: " + comandoG, it->second.usuario, it->second.nodoOrigen);
+    servidor->registrarEvento("Comando G-Code: " + comandoG, sesion.usuario, sesion.nodoOrigen);
     // Registrar petición en gestor de reportes
     try {
-        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion(comandoG, it->second.usuario, it->second.nodoOrigen, exito ? "200" : "ERROR");
+        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion(comandoG, sesion.usuario, sesion.nodoOrigen, exito ? "200" : "ERROR");
     } catch (const std::exception &e) {
         std::cerr << "Error registrarPeticion EjecutarGCode: " << e.what() << std::endl;
     }
@@ -401,15 +556,16 @@ void MetodoConfigurarAccesoRemoto::execute(XmlRpcValue& params, XmlRpcValue& res
         return;
     }
     
+    SesionUsuario sesion;
+    servidor->obtenerSesion(sessionId, sesion);
     servidor->accesoRemotoHabilitado = habilitar;
     result["exito"] = true;
     result["mensaje"] = habilitar ? "Acceso remoto habilitado" : "Acceso remoto deshabilitado";
     
     servidor->registrarEvento("Acceso remoto " + std::string(habilitar ? "habilitado" : "deshabilitado"), 
-                             servidor->sesionesActivas[sessionId].usuario, 
-                             servidor->sesionesActivas[sessionId].nodoOrigen);
+                             sesion.usuario, sesion.nodoOrigen);
     try {
-        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion(std::string("Acceso remoto ") + (habilitar ? "habilitado" : "deshabilitado"), servidor->sesionesActivas[sessionId].usuario, servidor->sesionesActivas[sessionId].nodoOrigen, "200");
+        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion(std::string("Acceso remoto ") + (habilitar ? "habilitado" : "deshabilitado"), sesion.usuario, sesion.nodoOrigen, "200");
     } catch (const std::exception &e) {
         std::cerr << "Error registrarPeticion ConfigurarAccesoRemoto: " << e.what() << std::endl;
     }
@@ -430,28 +586,35 @@ void MetodoControlMotores::execute(XmlRpcValue& params, XmlRpcValue& result) {
     std::string sessionId = params[0];
     std::string accion = params[1]; // "activar" o "desactivar"
     
-    auto it = servidor->sesionesActivas.find(sessionId);
-    if (it == servidor->sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
         result["exito"] = false;
         result["mensaje"] = "Sesión inválida";
         return;
     }
     
+    GestorCodigoG* robot = servidor->gestorRobot.get();
+    std::string motivo;
     bool exito = false;
     if (accion == "activar") {
-        exito = servidor->gestorRobot->activarEfectorFinal();
+        exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origenSesion(sesion),
+                                          [robot] { return robot->activarEfectorFinal(); }, &motivo);
         result["mensaje"] = exito ? "Motores activados" : "Error activando motores";
     } else if (accion == "desactivar") {
-        exito = servidor->gestorRobot->desactivarEfectorFinal();
+        exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origenSesion(sesion),
+                                          [robot] { return robot->desactivarEfectorFinal(); }, &motivo);
         result["mensaje"] = exito ? "Motores desactivados" : "Error desactivando motores";
     } else {
         result["mensaje"] = "Acción inválida: usar 'activar' o 'desactivar'";
     }
+    if (!motivo.empty()) {
+        result["mensaje"] = "Petición rechazada: " + motivo;
+    }
     
     result["exito"] = exito;
-    servidor->registrarEvento("Motores " + accion, it->second.usuario, it->second.nodoOrigen);
+    servidor->registrarEvento("Motores " + accion, sesion.usuario, sesion.nodoOrigen);
     try {
-        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion(std::string("Motores ") + accion, it->second.usuario, it->second.nodoOrigen, exito ? "200" : "ERROR");
+        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion(std::string("Motores ") + accion, sesion.usuario, sesion.nodoOrigen, exito ? "200" : "ERROR");
     } catch (const std::exception &e) {
         std::cerr << "Error registrarPeticion ControlMotores: " << e.what() << std::endl;
     }
@@ -470,8 +633,8 @@ void MetodoListarComandos::execute(XmlRpcValue& params, XmlRpcValue& result) {
     }
     
     std::string sessionId = params[0];
-    auto it = servidor->sesionesActivas.find(sessionId);
-    if (it == servidor->sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
         result["exito"] = false;
         result["mensaje"] = "Sesión inválida";
         return;
@@ -490,15 +653,20 @@ void MetodoListarComandos::execute(XmlRpcValue& params, XmlRpcValue& result) {
     comandos["ReporteUsuario"] = "Reporte personal: [sessionId]";
     comandos["AprenderTrayectoria"] = "Aprender trayectoria: [sessionId, accion, nombre]";
     comandos["SubirGCode"] = "Subir archivo: [sessionId, nombre, contenido]";
-    comandos["EjecutarArchivo"] = "Ejecutar archivo: [sessionId, archivo]";
+    comandos["EjecutarArchivo"] = "Ejecutar archivo: [sessionId, archivo, desdeComando]";
+    comandos["ControlEjecucion"] = "Controlar ejecución: [sessionId, pausar|reanudar|detener|paso|estado]";
+    comandos["ParadaEmergencia"] = "Parada de emergencia: [sessionId]";
+    comandos["SuscribirEstado"] = "Cambios de estado (larga espera en puerto + 1): [sessionId, ultimaVersion, timeoutMs]";
+    comandos["SimularArchivo"] = "Estimar duración de un archivo: [sessionId, archivo]";
     
     if (esAdmin) {
         comandos["ConectarRobot"] = "Conectar robot: [sessionId, accion]";
         comandos["ConfigurarAccesoRemoto"] = "Acceso remoto: [sessionId, habilitar]";
         comandos["ControlMotores"] = "Control motores: [sessionId, accion]";
-        comandos["ReporteAdmin"] = "Reporte admin: [sessionId, filtro1, filtro2]";
-        comandos["ReporteLogCsv"] = "Log CSV filtrado: [sessionId, desde, hasta, filtroUsuario, filtroCodigo]";
+        comandos["ReporteAdmin"] = "Reporte admin paginado: [sessionId, filtroUsuario, filtroCodigo, cursor, limite, ultimas]";
+        comandos["ReporteLogCsv"] = "Log CSV filtrado y paginado: [sessionId, desde, hasta, filtroUsuario, filtroCodigo, texto1, texto2, cursor, limite]";
         comandos["ListarArchivos"] = "Listar archivos G-Code: [sessionId]";
+        comandos["ExportarLog"] = "Exportar log filtrado en el servidor: [sessionId, formato(csv/json/xml), desde, hasta, filtroUsuario, filtroCodigo]";
     }
     
     result["exito"] = true;
@@ -519,14 +687,13 @@ void MetodoReporteUsuario::execute(XmlRpcValue& params, XmlRpcValue& result) {
     }
     
     std::string sessionId = params[0];
-    auto it = servidor->sesionesActivas.find(sessionId);
-    if (it == servidor->sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
         result["exito"] = false;
         result["mensaje"] = "Sesión inválida";
         return;
     }
     
-    const SesionUsuario& sesion = it->second;
     auto tiempoConexion = std::chrono::system_clock::to_time_t(sesion.tiempoConexion);
     
     result["exito"] = true;
@@ -536,8 +703,16 @@ void MetodoReporteUsuario::execute(XmlRpcValue& params, XmlRpcValue& result) {
     result["tiempoConexion"] = std::ctime(&tiempoConexion);
     result["estadoRobot"] = servidor->gestorRobot->obtenerEstadoRobot();
     
-    auto pos = servidor->gestorRobot->obtenerPosicionActual();
+    // Posición publicada por la telemetría: no hay consulta al robot en este método
+    std::shared_ptr<const MuestraPosicion> muestra = servidor->gestorRobot->obtenerTelemetria();
+    const Punto3D& pos = muestra->actual();
     result["posicionActual"] = "X:" + std::to_string(pos.x) + " Y:" + std::to_string(pos.y) + " Z:" + std::to_string(pos.z);
+    result["fuentePosicion"] = muestra->actualEsMedida() ? "robot" : "comandada";
+    if (muestra->medidaValida) {
+        auto edad = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - muestra->instanteMedida).count();
+        result["edadMedidaMs"] = static_cast<int>(edad);
+    }
     // Incluir reporte general generado por GestorReportes
     try {
         if (servidor->gestorReportes) result["reporteGeneral"] = servidor->gestorReportes->reporteGeneral(sesion.usuario);
@@ -554,7 +729,7 @@ std::string MetodoReporteUsuario::help() {
 void MetodoReporteAdmin::execute(XmlRpcValue& params, XmlRpcValue& result) {
     if (params.size() < 1) {
         result["exito"] = false;
-        result["mensaje"] = "Parámetros insuficientes: [sessionId, filtro1, filtro2]";
+        result["mensaje"] = "Parámetros insuficientes: [sessionId, filtro1, filtro2, cursor, limite, ultimas]";
         return;
     }
     
@@ -567,16 +742,22 @@ void MetodoReporteAdmin::execute(XmlRpcValue& params, XmlRpcValue& result) {
     
     std::string filtro1 = (params.size() > 1) ? std::string(params[1]) : "";
     std::string filtro2 = (params.size() > 2) ? std::string(params[2]) : "";
+    std::string cursor = (params.size() > 3) ? std::string(params[3]) : "";
+    std::size_t limite = limitePagina(params, 4);
+    // ultimas > 0: sólo las últimas líneas del log, leídas desde el final
+    bool ultimas = params.size() > 5 && params[5].getType() == XmlRpcValue::TypeInt && int(params[5]) > 0;
+    if (ultimas) limite = limitePagina(params, 5);
     
+    std::map<std::string, SesionUsuario> activas = servidor->copiaSesiones();
     result["exito"] = true;
-    result["totalSesiones"] = static_cast<int>(servidor->sesionesActivas.size());
+    result["totalSesiones"] = static_cast<int>(activas.size());
     result["filtro1"] = filtro1;
     result["filtro2"] = filtro2;
     
     // Reporte detallado de todas las sesiones
     XmlRpcValue sesiones;
     int indice = 0;
-    for (const auto& par : servidor->sesionesActivas) {
+    for (const auto& par : activas) {
         XmlRpcValue sesion;
         sesion["sessionId"] = par.first;
         sesion["usuario"] = par.second.usuario;
@@ -586,12 +767,43 @@ void MetodoReporteAdmin::execute(XmlRpcValue& params, XmlRpcValue& result) {
         sesiones[indice++] = sesion;
     }
     result["sesiones"] = sesiones;
-    // Incluir reportes del GestorReportes: log completo y filtros simples
+    
+    // Caché de programas preparados del robot
+    EstadisticasCacheProgramas cache = servidor->gestorRobot->obtenerEstadisticasCache();
+    XmlRpcValue cacheProgramas;
+    cacheProgramas["aciertos"] = static_cast<int>(cache.aciertos);
+    cacheProgramas["fallos"] = static_cast<int>(cache.fallos);
+    cacheProgramas["descartes"] = static_cast<int>(cache.descartes);
+    cacheProgramas["programas"] = static_cast<int>(cache.programas);
+    cacheProgramas["bytes"] = static_cast<int>(cache.bytes);
+    cacheProgramas["bytesMaximos"] = static_cast<int>(cache.bytesMaximos);
+    result["cacheProgramas"] = cacheProgramas;
+    // Incluir reportes del GestorReportes: una página del log (filtro1 = usuario,
+    // filtro2 = código) y los segmentos rotados
     try {
         if (servidor->gestorReportes) {
-            result["reporteAdmin"] = servidor->gestorReportes->reporteAdmin();
-            if (!filtro1.empty()) result["reportePorUsuario"] = servidor->gestorReportes->reporteAdminPorUsuario(filtro1);
-            if (!filtro2.empty()) result["reportePorCodigo"] = servidor->gestorReportes->reporteAdminPorCodigo(filtro2);
+            PaginaLog pagina;
+            ConsultaLog consulta = GestorReportes::crearConsulta("", "", filtro1, filtro2);
+            if (ultimas) {
+                servidor->gestorReportes->ultimasLineasLog(consulta, limite, pagina);
+            } else if (!servidor->gestorReportes->paginaLog(consulta, cursor, limite, pagina)) {
+                result["exito"] = false;
+                result["mensaje"] = "Cursor inválido: " + cursor;
+                return;
+            }
+            agregarPagina(result, "reporteAdmin", pagina);
+            XmlRpcValue segmentos;
+            segmentos.setSize(0);
+            int i = 0;
+            for (const auto &seg : servidor->gestorReportes->segmentosLog()) {
+                segmentos[i]["archivo"] = seg.archivo;
+                segmentos[i]["desde"] = seg.desde;
+                segmentos[i]["hasta"] = seg.hasta;
+                segmentos[i]["lineas"] = static_cast<int>(seg.lineas);
+                segmentos[i]["comprimido"] = segmentoComprimido(seg); // false mientras se comprime
+                ++i;
+            }
+            result["segmentosLog"] = segmentos;
         }
     } catch (const std::exception &e) {
         result["reporteAdmin"] = std::string("error: ") + e.what();
@@ -599,7 +811,8 @@ void MetodoReporteAdmin::execute(XmlRpcValue& params, XmlRpcValue& result) {
 }
 
 std::string MetodoReporteAdmin::help() {
-    return "Reporte administrativo completo (solo admin). Parámetros: [sessionId, filtro1, filtro2]";
+    return "Reporte administrativo paginado (solo admin). Parámetros: [sessionId, filtroUsuario, filtroCodigo, cursor, limite, ultimas]; "
+           "con ultimas > 0 devuelve sólo esas últimas líneas, sin cursor";
 }
 
 // Implementación de MetodoConfigurarModo
@@ -614,36 +827,42 @@ void MetodoConfigurarModo::execute(XmlRpcValue& params, XmlRpcValue& result) {
     std::string modoTrabajo = params[1]; // "manual" o "automatico"
     std::string modoCoordenadas = params[2]; // "absoluto" o "relativo"
     
-    auto it = servidor->sesionesActivas.find(sessionId);
-    if (it == servidor->sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
         result["exito"] = false;
         result["mensaje"] = "Sesión inválida";
         return;
     }
     
-    bool exito = true;
-    
-    if (modoTrabajo == "manual") {
-        exito &= servidor->gestorRobot->configurarModoTrabajo(ModoTrabajo::MANUAL);
-    } else if (modoTrabajo == "automatico") {
-        exito &= servidor->gestorRobot->configurarModoTrabajo(ModoTrabajo::AUTOMATICO);
-    } else {
-        exito = false;
-    }
-    
-    if (modoCoordenadas == "absoluto") {
-        exito &= servidor->gestorRobot->configurarModoCoordenadas(ModoCoordenas::ABSOLUTO);
-    } else if (modoCoordenadas == "relativo") {
-        exito &= servidor->gestorRobot->configurarModoCoordenadas(ModoCoordenas::RELATIVO);
-    } else {
-        exito = false;
-    }
+    GestorCodigoG* robot = servidor->gestorRobot.get();
+    std::string motivo;
+    bool exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origenSesion(sesion), [&] {
+        bool ok = true;
+        
+        if (modoTrabajo == "manual") {
+            ok &= robot->configurarModoTrabajo(ModoTrabajo::MANUAL);
+        } else if (modoTrabajo == "automatico") {
+            ok &= robot->configurarModoTrabajo(ModoTrabajo::AUTOMATICO);
+        } else {
+            ok = false;
+        }
+        
+        if (modoCoordenadas == "absoluto") {
+            ok &= robot->configurarModoCoordenadas(ModoCoordenas::ABSOLUTO);
+        } else if (modoCoordenadas == "relativo") {
+            ok &= robot->configurarModoCoordenadas(ModoCoordenas::RELATIVO);
+        } else {
+            ok = false;
+        }
+        return ok;
+    }, &motivo);
     
     result["exito"] = exito;
-    result["mensaje"] = exito ? "Modo configurado correctamente" : "Error configurando modo";
+    result["mensaje"] = exito ? "Modo configurado correctamente"
+                              : (motivo.empty() ? "Error configurando modo" : "Petición rechazada: " + motivo);
     
     servidor->registrarEvento("Configuración modo: " + modoTrabajo + "/" + modoCoordenadas, 
-                             it->second.usuario, it->second.nodoOrigen);
+                             sesion.usuario, sesion.nodoOrigen);
 }
 
 std::string MetodoConfigurarModo::help() {
@@ -659,20 +878,24 @@ void MetodoIrAOrigen::execute(XmlRpcValue& params, XmlRpcValue& result) {
     }
     
     std::string sessionId = params[0];
-    auto it = servidor->sesionesActivas.find(sessionId);
-    if (it == servidor->sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
         result["exito"] = false;
         result["mensaje"] = "Sesión inválida";
         return;
     }
     
-    bool exito = servidor->gestorRobot->irAPosicionOrigen();
+    GestorCodigoG* robot = servidor->gestorRobot.get();
+    std::string motivo;
+    bool exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origenSesion(sesion),
+                                           [robot] { return robot->irAPosicionOrigen(); }, &motivo);
     
     result["exito"] = exito;
-    result["mensaje"] = exito ? "Robot en posición origen" : "Error moviendo a origen";
+    result["mensaje"] = exito ? "Robot en posición origen"
+                              : (motivo.empty() ? "Error moviendo a origen" : "Petición rechazada: " + motivo);
     
     if (exito) {
-        it->second.comandosEjecutados++;
+        servidor->contarComando(sessionId, true);
         // Actualizar posición en el gestor de reportes
         try {
             if (servidor->gestorReportes) {
@@ -683,12 +906,12 @@ void MetodoIrAOrigen::execute(XmlRpcValue& params, XmlRpcValue& result) {
             std::cerr << "Error actualizando posición origen: " << e.what() << std::endl;
         }
     } else {
-        it->second.comandosErroneos++;
+        servidor->contarComando(sessionId, false);
     }
     
-    servidor->registrarEvento("Ir a origen", it->second.usuario, it->second.nodoOrigen);
+    servidor->registrarEvento("Ir a origen", sesion.usuario, sesion.nodoOrigen);
     try {
-        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion("G0 Ir a origen", it->second.usuario, it->second.nodoOrigen, exito ? "200" : "ERROR");
+        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion("G0 Ir a origen", sesion.usuario, sesion.nodoOrigen, exito ? "200" : "ERROR");
     } catch (const std::exception &e) {
         std::cerr << "Error registrarPeticion IrAOrigen: " << e.what() << std::endl;
     }
@@ -709,33 +932,40 @@ void MetodoControlEfector::execute(XmlRpcValue& params, XmlRpcValue& result) {
     std::string sessionId = params[0];
     std::string accion = params[1]; // "activar" o "desactivar"
     
-    auto it = servidor->sesionesActivas.find(sessionId);
-    if (it == servidor->sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
         result["exito"] = false;
         result["mensaje"] = "Sesión inválida";
         return;
     }
     
+    GestorCodigoG* robot = servidor->gestorRobot.get();
+    std::string motivo;
     bool exito = false;
     if (accion == "activar") {
-        exito = servidor->gestorRobot->activarEfectorFinal();
+        exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origenSesion(sesion),
+                                          [robot] { return robot->activarEfectorFinal(); }, &motivo);
         result["mensaje"] = exito ? "Efector activado" : "Error activando efector";
     } else if (accion == "desactivar") {
-        exito = servidor->gestorRobot->desactivarEfectorFinal();
+        exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origenSesion(sesion),
+                                          [robot] { return robot->desactivarEfectorFinal(); }, &motivo);
         result["mensaje"] = exito ? "Efector desactivado" : "Error desactivando efector";
     } else {
         result["mensaje"] = "Acción inválida: usar 'activar' o 'desactivar'";
     }
+    if (!motivo.empty()) {
+        result["mensaje"] = "Petición rechazada: " + motivo;
+    }
     
     result["exito"] = exito;
     
     if (exito) {
-        it->second.comandosEjecutados++;
+        servidor->contarComando(sessionId, true);
     } else {
-        it->second.comandosErroneos++;
+        servidor->contarComando(sessionId, false);
     }
     
-    servidor->registrarEvento("Efector " + accion, it->second.usuario, it->second.nodoOrigen);
+    servidor->registrarEvento("Efector " + accion, sesion.usuario, sesion.nodoOrigen);
 }
 
 std::string MetodoControlEfector::help() {
@@ -753,13 +983,16 @@ void MetodoAprenderTrayectoria::execute(XmlRpcValue& params, XmlRpcValue& result
     std::string sessionId = params[0];
     std::string accion = params[1]; // "iniciar", "agregar", "finalizar"
     
-    auto it = servidor->sesionesActivas.find(sessionId);
-    if (it == servidor->sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
         result["exito"] = false;
         result["mensaje"] = "Sesión inválida";
         return;
     }
     
+    GestorCodigoG* robot = servidor->gestorRobot.get();
+    std::string origen = origenSesion(sesion);
+    std::string motivo;
     bool exito = false;
     
     if (accion == "iniciar") {
@@ -768,7 +1001,8 @@ void MetodoAprenderTrayectoria::execute(XmlRpcValue& params, XmlRpcValue& result
             return;
         }
         std::string nombre = params[2];
-        exito = servidor->gestorRobot->iniciarAprendizajeTrayectoria(nombre);
+        exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origen,
+                                          [&] { return robot->iniciarAprendizajeTrayectoria(nombre); }, &motivo);
         result["mensaje"] = exito ? "Aprendizaje iniciado" : "Error iniciando aprendizaje";
     } else if (accion == "agregar") {
         if (params.size() < 6) {
@@ -779,17 +1013,23 @@ void MetodoAprenderTrayectoria::execute(XmlRpcValue& params, XmlRpcValue& result
         double y = params[3];
         double z = params[4];
         double vel = params[5];
-        exito = servidor->gestorRobot->agregarPasoTrayectoria(x, y, z, vel);
+        exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origen,
+                                          [&] { return robot->agregarPasoTrayectoria(x, y, z, vel); }, &motivo);
         result["mensaje"] = exito ? "Paso agregado" : "Error agregando paso";
     } else if (accion == "finalizar") {
-        exito = servidor->gestorRobot->finalizarAprendizajeTrayectoria(it->second.usuario);
+        const std::string& usuario = sesion.usuario;
+        exito = servidor->ejecutarEnRobot(PrioridadComando::MANUAL, origen,
+                                          [&] { return robot->finalizarAprendizajeTrayectoria(usuario); }, &motivo);
         result["mensaje"] = exito ? "Trayectoria guardada" : "Error guardando trayectoria";
     } else {
         result["mensaje"] = "Acción inválida: usar 'iniciar', 'agregar' o 'finalizar'";
     }
+    if (!motivo.empty()) {
+        result["mensaje"] = "Petición rechazada: " + motivo;
+    }
     
     result["exito"] = exito;
-    servidor->registrarEvento("Aprendizaje " + accion, it->second.usuario, it->second.nodoOrigen);
+    servidor->registrarEvento("Aprendizaje " + accion, sesion.usuario, sesion.nodoOrigen);
 }
 
 std::string MetodoAprenderTrayectoria::help() {
@@ -808,28 +1048,48 @@ void MetodoSubirGCode::execute(XmlRpcValue& params, XmlRpcValue& result) {
     std::string nombreArchivo = params[1];
     std::string contenido = params[2];
     
-    auto it = servidor->sesionesActivas.find(sessionId);
-    if (it == servidor->sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
         result["exito"] = false;
         result["mensaje"] = "Sesión inválida";
         return;
     }
     
     // Crear archivo con el contenido
-    std::string rutaCompleta = nombreArchivo + "_" + it->second.usuario + ".gcode";
+    std::string rutaCompleta = nombreArchivo + "_" + sesion.usuario + ".gcode";
     
     try {
-        std::ofstream archivo(rutaCompleta);
-        archivo << contenido;
-        archivo.close();
+        // El contenido se guarda una sola vez por hash y el nombre del usuario
+        // queda enlazado a él; el análisis de un contenido ya visto no se repite
+        bool nuevo = false;
+        std::string hash = servidor->almacenGCode->guardar(contenido, rutaCompleta, nuevo);
+        if (hash.empty()) {
+            result["exito"] = false;
+            result["mensaje"] = "Error guardando archivo: " + rutaCompleta;
+            return;
+        }
+        bool analisisEnCache = false;
+        AnalisisGCode analisis = servidor->gestorRobot->analizarGCode(contenido, hash, &analisisEnCache);
         
         result["exito"] = true;
         result["mensaje"] = "Archivo subido correctamente";
         result["archivo"] = rutaCompleta;
+        result["hash"] = hash;
+        result["duplicado"] = !nuevo;
+        result["valido"] = analisis.valido;
+        result["comandos"] = static_cast<int>(analisis.comandos);
+        result["lineasIgnoradas"] = static_cast<int>(analisis.lineasIgnoradas);
+        if (analisis.lineasIgnoradas > 0) {
+            result["primeraLineaIgnorada"] = static_cast<int>(analisis.primeraIgnorada);
+        }
+        if (!analisis.valido) {
+            result["mensajeValidacion"] = analisis.mensaje;
+        }
+        result["analisisEnCache"] = analisisEnCache;
         
-        servidor->registrarEvento("Archivo subido: " + rutaCompleta, it->second.usuario, it->second.nodoOrigen);
+        servidor->registrarEvento("Archivo subido: " + rutaCompleta, sesion.usuario, sesion.nodoOrigen);
         try {
-            if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion(std::string("Archivo subido: ") + rutaCompleta, it->second.usuario, it->second.nodoOrigen, "200");
+            if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion(std::string("Archivo subido: ") + rutaCompleta, sesion.usuario, sesion.nodoOrigen, "200");
         } catch (const std::exception &e) {
             std::cerr << "Error registrarPeticion SubirGCode: " << e.what() << std::endl;
         }
@@ -840,22 +1100,24 @@ void MetodoSubirGCode::execute(XmlRpcValue& params, XmlRpcValue& result) {
 }
 
 std::string MetodoSubirGCode::help() {
-    return "Subir archivo G-Code. Parámetros: [sessionId, nombreArchivo, contenido]";
+    return "Subir archivo G-Code (se guarda una vez por contenido y se informa su análisis). Parámetros: [sessionId, nombreArchivo, contenido]";
 }
 
 // Implementación de MetodoEjecutarArchivo
 void MetodoEjecutarArchivo::execute(XmlRpcValue& params, XmlRpcValue& result) {
     if (params.size() < 2) {
         result["exito"] = false;
-        result["mensaje"] = "Parámetros insuficientes: [sessionId, nombreArchivo]";
+        result["mensaje"] = "Parámetros insuficientes: [sessionId, nombreArchivo, desdeComando]";
         return;
     }
     
     std::string sessionId = params[0];
     std::string nombreArchivo = params[1];
+    // Opcional: número de comando (desde 1) para retomar una ejecución abortada
+    int desdeComando = (params.size() > 2) ? int(params[2]) : 1;
     
-    auto it = servidor->sesionesActivas.find(sessionId);
-    if (it == servidor->sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
         result["exito"] = false;
         result["mensaje"] = "Sesión inválida";
         return;
@@ -863,7 +1125,7 @@ void MetodoEjecutarArchivo::execute(XmlRpcValue& params, XmlRpcValue& result) {
     
     // Verificar permisos: usuarios normales solo pueden ejecutar sus propios archivos
     if (!servidor->esAdministrador(sessionId)) {
-        if (nombreArchivo.find("_" + it->second.usuario + ".gcode") == std::string::npos) {
+        if (nombreArchivo.find("_" + sesion.usuario + ".gcode") == std::string::npos) {
             result["exito"] = false;
             result["mensaje"] = "Acceso denegado: Solo puede ejecutar sus propios archivos";
             return;
@@ -877,48 +1139,287 @@ void MetodoEjecutarArchivo::execute(XmlRpcValue& params, XmlRpcValue& result) {
         return;
     }
     
-    // Cargar y ejecutar archivo
-    bool cargaExitosa = servidor->gestorRobot->cargarArchivoGCode(nombreArchivo);
-    bool ejecucionExitosa = false;
-    
-    if (cargaExitosa) {
-        ejecucionExitosa = servidor->gestorRobot->ejecutarTrayectoriaCargada();
+    if (servidor->gestorRobot->obtenerEstadoEjecucion() != EstadoEjecucion::INACTIVO) {
+        result["exito"] = false;
+        result["mensaje"] = "Error: Ya hay una ejecución en curso";
+        return;
     }
     
-    bool exito = cargaExitosa && ejecucionExitosa;
+    // Cargar el archivo e iniciar la ejecución en segundo plano; el avance se consulta
+    // y controla con ControlEjecucion. La carga y el arranque pasan por la cola
+    // con la prioridad más baja de la cola. Los archivos grandes se ejecutan
+    // mientras se leen, sin esperar a tenerlos enteros en memoria
+    GestorCodigoG* robot = servidor->gestorRobot.get();
+    bool cargaExitosa = false;
+    bool ejecucionIniciada = false;
+    bool incremental = false;
+    std::string motivo;
+    servidor->ejecutarEnRobot(PrioridadComando::ARCHIVO, origenSesion(sesion), [&] {
+        incremental = robot->convieneCargaIncremental(nombreArchivo);
+        if (incremental && desdeComando >= 1) {
+            cargaExitosa = true;
+            ejecucionIniciada = robot->iniciarEjecucionIncremental(nombreArchivo, static_cast<size_t>(desdeComando - 1));
+            return ejecucionIniciada;
+        }
+        cargaExitosa = robot->cargarArchivoGCode(nombreArchivo);
+        if (cargaExitosa && desdeComando >= 1) {
+            ejecucionIniciada = robot->iniciarEjecucion(static_cast<size_t>(desdeComando - 1));
+        }
+        return cargaExitosa && ejecucionIniciada;
+    }, &motivo);
     
-    result["exito"] = exito;
+    bool exito = cargaExitosa && ejecucionIniciada;
     if (exito) {
-        result["mensaje"] = "Archivo cargado y ejecutado correctamente";
+        servidor->asignarPropietarioEjecucion(sessionId);
+    }
+    
+    result["exito"] = exito;
+    if (!motivo.empty()) {
+        result["mensaje"] = "Petición rechazada: " + motivo;
+    } else if (exito) {
+        result["mensaje"] = "Ejecución iniciada: " + nombreArchivo;
+        result["totalComandos"] = static_cast<int>(servidor->gestorRobot->obtenerTotalComandos());
+        result["cargaIncremental"] = incremental; // totalComandos crece mientras se lee
     } else if (!cargaExitosa) {
         result["mensaje"] = "Error cargando archivo: " + nombreArchivo;
+    } else if (incremental && !servidor->gestorRobot->obtenerMensajeEjecucion().empty()) {
+        // Si el primer bloque de la carga incremental no pasa la validación, queda el motivo
+        result["mensaje"] = "Error iniciando la ejecución de " + nombreArchivo + ": " +
+                            servidor->gestorRobot->obtenerMensajeEjecucion();
     } else {
-        result["mensaje"] = "Error ejecutando archivo: " + nombreArchivo;
+        result["mensaje"] = "Error iniciando la ejecución de: " + nombreArchivo;
     }
     
     if (exito) {
-        it->second.comandosEjecutados++;
+        servidor->contarComando(sessionId, true);
     } else {
-        it->second.comandosErroneos++;
+        servidor->contarComando(sessionId, false);
     }
     
-    servidor->registrarEvento("Ejecutar archivo: " + nombreArchivo, it->second.usuario, it->second.nodoOrigen);
+    servidor->registrarEvento("Ejecutar archivo: " + nombreArchivo, sesion.usuario, sesion.nodoOrigen);
     try {
-        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion(std::string("Ejecutar archivo: ") + nombreArchivo, it->second.usuario, it->second.nodoOrigen, exito ? "200" : "ERROR");
+        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion(std::string("Ejecutar archivo: ") + nombreArchivo, sesion.usuario, sesion.nodoOrigen, exito ? "200" : "ERROR");
     } catch (const std::exception &e) {
         std::cerr << "Error registrarPeticion EjecutarArchivo: " << e.what() << std::endl;
     }
 }
 
 std::string MetodoEjecutarArchivo::help() {
-    return "Ejecutar archivo G-Code en modo automático. Parámetros: [sessionId, nombreArchivo]";
+    return "Ejecutar archivo G-Code en modo automático (en segundo plano). Parámetros: [sessionId, nombreArchivo, desdeComando]";
+}
+
+// Implementación de MetodoControlEjecucion
+void MetodoControlEjecucion::execute(XmlRpcValue& params, XmlRpcValue& result) {
+    if (params.size() < 2) {
+        result["exito"] = false;
+        result["mensaje"] = "Parámetros insuficientes: [sessionId, accion]";
+        return;
+    }
+    
+    std::string sessionId = params[0];
+    std::string accion = params[1];
+    
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
+        result["exito"] = false;
+        result["mensaje"] = "Sesión inválida";
+        return;
+    }
+    
+    GestorCodigoG* robot = servidor->gestorRobot.get();
+    bool exito = false;
+    
+    // El estado es público; el resto sólo para quien inició la ejecución o un administrador.
+    // Un paso sin ejecución en curso inicia una nueva, que pasa a ser de esta sesión
+    bool iniciaEjecucion = accion == "paso" && robot->obtenerEstadoEjecucion() == EstadoEjecucion::INACTIVO;
+    if (accion != "estado" && !iniciaEjecucion && !servidor->puedeControlarEjecucion(sessionId, sesion)) {
+        result["exito"] = false;
+        result["mensaje"] = "Acceso denegado: Solo quien inició la ejecución o un administrador puede controlarla";
+        return;
+    }
+    
+    if (accion == "pausar") {
+        exito = robot->pausarEjecucion();
+        result["mensaje"] = exito ? "Pausa solicitada" : "No hay ejecución en curso";
+    } else if (accion == "reanudar") {
+        exito = robot->reanudarEjecucion();
+        result["mensaje"] = exito ? "Ejecución reanudada" : "La ejecución no está pausada";
+    } else if (accion == "detener") {
+        exito = robot->detenerEjecucion();
+        result["mensaje"] = exito ? "Detención solicitada" : "No hay ejecución en curso";
+    } else if (accion == "paso") {
+        exito = robot->ejecutarPasoAPaso();
+        if (exito && iniciaEjecucion) {
+            servidor->asignarPropietarioEjecucion(sessionId);
+        }
+        result["mensaje"] = exito ? "Paso solicitado" : "No se pudo ejecutar el paso";
+    } else if (accion == "estado") {
+        exito = true;
+        result["mensaje"] = robot->obtenerMensajeEjecucion();
+    } else {
+        result["exito"] = false;
+        result["mensaje"] = "Acción inválida. Use: pausar, reanudar, detener, paso, estado";
+        return;
+    }
+    
+    // El estado se devuelve siempre para que el cliente sepa dónde quedó la ejecución
+    result["exito"] = exito;
+    result["estado"] = GestorCodigoG::nombreEstadoEjecucion(robot->obtenerEstadoEjecucion());
+    result["comandoActual"] = static_cast<int>(robot->obtenerContadorPrograma() + 1);
+    result["totalComandos"] = static_cast<int>(robot->obtenerTotalComandos());
+    EstadisticasCola cola = servidor->colaRobot->obtenerEstadisticas();
+    result["colaPendientes"] = static_cast<int>(cola.pendientes[0] + cola.pendientes[1] + cola.pendientes[2]);
+    
+    if (accion != "estado") {
+        servidor->registrarEvento("Control ejecución: " + accion, sesion.usuario, sesion.nodoOrigen);
+        try {
+            if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion(std::string("Control ejecución: ") + accion, sesion.usuario, sesion.nodoOrigen, exito ? "200" : "ERROR");
+        } catch (const std::exception &e) {
+            std::cerr << "Error registrarPeticion ControlEjecucion: " << e.what() << std::endl;
+        }
+    }
+}
+
+std::string MetodoControlEjecucion::help() {
+    return "Controlar la ejecución en curso. Parámetros: [sessionId, accion(pausar|reanudar|detener|paso|estado)]";
+}
+
+// Implementación de MetodoParadaEmergencia
+void MetodoParadaEmergencia::execute(XmlRpcValue& params, XmlRpcValue& result) {
+    if (params.size() < 1) {
+        result["exito"] = false;
+        result["mensaje"] = "Parámetros insuficientes: [sessionId]";
+        return;
+    }
+    
+    // También se atiende en el servidor de eventos (un hilo por conexión), así que
+    // sólo se usan la copia de la sesión y métodos seguros entre hilos
+    std::string sessionId = params[0];
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
+        result["exito"] = false;
+        result["mensaje"] = "Sesión inválida";
+        return;
+    }
+    
+    bool exito = servidor->paradaEmergencia(origenSesion(sesion));
+    
+    result["exito"] = exito;
+    result["mensaje"] = exito ? "Parada de emergencia ejecutada: efector y motores desactivados"
+                              : "Parada de emergencia con errores de comunicación";
+    
+    try {
+        if (servidor->gestorReportes) {
+            servidor->gestorReportes->actualizarEstadoActividad("parada_emergencia");
+            servidor->gestorReportes->registrarPeticion("Parada de emergencia", sesion.usuario, sesion.nodoOrigen, exito ? "200" : "ERROR");
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error registrarPeticion ParadaEmergencia: " << e.what() << std::endl;
+    }
+}
+
+std::string MetodoParadaEmergencia::help() {
+    return "Detiene la ejecución y desactiva efector y motores. Parámetros: [sessionId]";
+}
+
+// Implementación de MetodoSuscribirEstado
+void MetodoSuscribirEstado::execute(XmlRpcValue& params, XmlRpcValue& result) {
+    if (params.size() < 1) {
+        result["exito"] = false;
+        result["mensaje"] = "Parámetros insuficientes: [sessionId, ultimaVersion, timeoutMs]";
+        return;
+    }
+    
+    // Se ejecuta en hilos del servidor de eventos: sólo se usan la copia de la sesión
+    // y GestorReportes, que es seguro entre hilos
+    std::string sessionId = params[0];
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
+        result["exito"] = false;
+        result["mensaje"] = "Sesión inválida";
+        return;
+    }
+    
+    int ultimaVersion = (params.size() > 1) ? int(params[1]) : 0;
+    int timeoutMs = (params.size() > 2) ? int(params[2]) : 30000;
+    timeoutMs = permitirEspera ? std::max(0, std::min(timeoutMs, 60000)) : 0;
+    
+    CambiosEstado cambios = servidor->gestorReportes->esperarCambios(
+        static_cast<unsigned long>(std::max(0, ultimaVersion)), timeoutMs);
+    
+    result["exito"] = true;
+    result["version"] = static_cast<int>(cambios.version);
+    result["hayCambios"] = !cambios.campos.empty();
+    // Sin cambios (plazo vencido) el campo "cambios" se omite
+    for (const auto& par : cambios.campos) {
+        result["cambios"][par.first] = par.second;
+    }
+}
+
+std::string MetodoSuscribirEstado::help() {
+    return "Espera cambios de estado del robot y devuelve sólo los campos modificados. Parámetros: [sessionId, ultimaVersion, timeoutMs]";
+}
+
+// Implementación de MetodoSimularArchivo
+void MetodoSimularArchivo::execute(XmlRpcValue& params, XmlRpcValue& result) {
+    if (params.size() < 2) {
+        result["exito"] = false;
+        result["mensaje"] = "Parámetros insuficientes: [sessionId, nombreArchivo]";
+        return;
+    }
+    
+    std::string sessionId = params[0];
+    std::string nombreArchivo = params[1];
+    
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
+        result["exito"] = false;
+        result["mensaje"] = "Sesión inválida";
+        return;
+    }
+    
+    // Mismos permisos que para ejecutar
+    if (!servidor->esAdministrador(sessionId)) {
+        if (nombreArchivo.find("_" + sesion.usuario + ".gcode") == std::string::npos) {
+            result["exito"] = false;
+            result["mensaje"] = "Acceso denegado: Solo puede simular sus propios archivos";
+            return;
+        }
+    }
+    
+    ResultadoSimulacion sim = servidor->gestorRobot->simularArchivoGCode(nombreArchivo);
+    
+    result["exito"] = sim.valido;
+    if (sim.valido) {
+        result["mensaje"] = "Simulación completada: " + nombreArchivo;
+        result["duracionSegundos"] = sim.duracionSegundos;
+        result["tiempoMovimientoSegundos"] = sim.tiempoMovimientoSegundos;
+        result["tiempoLatenciaSegundos"] = sim.tiempoLatenciaSegundos;
+        result["longitudRecorridoMm"] = sim.longitudRecorridoMm;
+        result["alcanceMaximoMm"] = sim.alcanceMaximoMm;
+        result["comandos"] = static_cast<int>(sim.comandos);
+        result["tramos"] = static_cast<int>(sim.tramos);
+    } else {
+        result["mensaje"] = "Error simulando archivo: " + sim.mensaje;
+    }
+    
+    servidor->registrarEvento("Simular archivo: " + nombreArchivo, sesion.usuario, sesion.nodoOrigen);
+    try {
+        if (servidor->gestorReportes) servidor->gestorReportes->registrarPeticion(std::string("Simular archivo: ") + nombreArchivo, sesion.usuario, sesion.nodoOrigen, sim.valido ? "200" : "ERROR");
+    } catch (const std::exception &e) {
+        std::cerr << "Error registrarPeticion SimularArchivo: " << e.what() << std::endl;
+    }
+}
+
+std::string MetodoSimularArchivo::help() {
+    return "Estimar duración, recorrido y alcance de un archivo G-Code sin mover el robot. Parámetros: [sessionId, nombreArchivo]";
 }
 
 // Implementación de MetodoReporteLogCsv
 void MetodoReporteLogCsv::execute(XmlRpcValue& params, XmlRpcValue& result) {
     if (params.size() < 1) {
         result["exito"] = false;
-        result["mensaje"] = "Parámetros insuficientes: [sessionId, desde, hasta, filtroUsuario, filtroCodigo]";
+        result["mensaje"] = "Parámetros insuficientes: [sessionId, desde, hasta, filtroUsuario, filtroCodigo, texto1, texto2, cursor, limite]";
         return;
     }
     
@@ -934,17 +1435,29 @@ void MetodoReporteLogCsv::execute(XmlRpcValue& params, XmlRpcValue& result) {
     std::string hasta = (params.size() > 2) ? std::string(params[2]) : "2099-12-31 23:59:59";
     std::string filtroUsuario = (params.size() > 3) ? std::string(params[3]) : "";
     std::string filtroCodigo = (params.size() > 4) ? std::string(params[4]) : "";
+    std::string texto1 = (params.size() > 5) ? std::string(params[5]) : "";
+    std::string texto2 = (params.size() > 6) ? std::string(params[6]) : "";
+    std::string cursor = (params.size() > 7) ? std::string(params[7]) : "";
+    std::size_t limite = limitePagina(params, 8);
     
     try {
         if (servidor->gestorReportes) {
-            std::string logFiltrado = servidor->gestorReportes->reporteLog(desde, hasta, filtroUsuario, filtroCodigo);
+            PaginaLog pagina;
+            ConsultaLog consulta = GestorReportes::crearConsulta(desde, hasta, filtroUsuario, filtroCodigo, {texto1, texto2});
+            if (!servidor->gestorReportes->paginaLog(consulta, cursor, limite, pagina)) {
+                result["exito"] = false;
+                result["mensaje"] = "Cursor inválido: " + cursor;
+                return;
+            }
             
             result["exito"] = true;
-            result["logCsv"] = logFiltrado;
+            agregarPagina(result, "logCsv", pagina);
             result["filtros"]["desde"] = desde;
             result["filtros"]["hasta"] = hasta;
             result["filtros"]["usuario"] = filtroUsuario;
             result["filtros"]["codigo"] = filtroCodigo;
+            result["filtros"]["texto1"] = texto1;
+            result["filtros"]["texto2"] = texto2;
         } else {
             result["exito"] = false;
             result["mensaje"] = "Gestor de reportes no disponible";
@@ -956,7 +1469,69 @@ void MetodoReporteLogCsv::execute(XmlRpcValue& params, XmlRpcValue& result) {
 }
 
 std::string MetodoReporteLogCsv::help() {
-    return "Obtener log CSV filtrado (solo admin). Parámetros: [sessionId, desde, hasta, filtroUsuario, filtroCodigo]";
+    return "Obtener log CSV filtrado y paginado (solo admin). Parámetros: [sessionId, desde, hasta, filtroUsuario, filtroCodigo, texto1, texto2, cursor, limite]";
+}
+
+// Implementación de MetodoExportarLog
+void MetodoExportarLog::execute(XmlRpcValue& params, XmlRpcValue& result) {
+    if (params.size() < 2) {
+        result["exito"] = false;
+        result["mensaje"] = "Parámetros insuficientes: [sessionId, formato, desde, hasta, filtroUsuario, filtroCodigo]";
+        return;
+    }
+    
+    std::string sessionId = params[0];
+    if (!servidor->esAdministrador(sessionId)) {
+        result["exito"] = false;
+        result["mensaje"] = "Acceso denegado: Solo administradores";
+        return;
+    }
+    
+    std::string formato = params[1];
+    std::transform(formato.begin(), formato.end(), formato.begin(), ::tolower);
+    if (formato != "csv" && formato != "json" && formato != "xml") {
+        result["exito"] = false;
+        result["mensaje"] = "Formato inválido: " + formato + " (csv, json o xml)";
+        return;
+    }
+    std::string desde = (params.size() > 2) ? std::string(params[2]) : "";
+    std::string hasta = (params.size() > 3) ? std::string(params[3]) : "";
+    std::string filtroUsuario = (params.size() > 4) ? std::string(params[4]) : "";
+    std::string filtroCodigo = (params.size() > 5) ? std::string(params[5]) : "";
+    
+    if (!servidor->gestorReportes) {
+        result["exito"] = false;
+        result["mensaje"] = "Gestor de reportes no disponible";
+        return;
+    }
+    
+    // El archivo queda en el servidor: un log de varios GB no pasa por la respuesta
+    std::error_code ec;
+    std::filesystem::create_directories("exportaciones", ec);
+    char fecha[32];
+    std::time_t ahora = std::time(nullptr);
+    std::strftime(fecha, sizeof(fecha), "%Y%m%d_%H%M%S", std::localtime(&ahora));
+    SesionUsuario sesion;
+    servidor->obtenerSesion(sessionId, sesion);
+    std::string archivo = "exportaciones/log_" + sesion.usuario + "_" + fecha + "." + formato;
+    
+    ConsultaLog consulta = GestorReportes::crearConsulta(desde, hasta, filtroUsuario, filtroCodigo);
+    std::size_t filas = 0;
+    if (!servidor->gestorReportes->exportarLog(consulta, archivo, formato[0], filas)) {
+        result["exito"] = false;
+        result["mensaje"] = "Error exportando el log a " + archivo;
+        return;
+    }
+    
+    result["exito"] = true;
+    result["mensaje"] = "Log exportado";
+    result["archivo"] = archivo;
+    result["filas"] = static_cast<int>(filas);
+    servidor->registrarEvento("Log exportado: " + archivo, sesion.usuario, sesion.nodoOrigen);
+}
+
+std::string MetodoExportarLog::help() {
+    return "Exportar el log filtrado a un archivo CSV, JSON o XML en el servidor (solo admin). Parámetros: [sessionId, formato, desde, hasta, filtroUsuario, filtroCodigo]";
 }
 
 // Implementación de MetodoListarArchivos
@@ -968,52 +1543,42 @@ void MetodoListarArchivos::execute(XmlRpcValue& params, XmlRpcValue& result) {
     }
     
     std::string sessionId = params[0];
-    auto it = servidor->sesionesActivas.find(sessionId);
-    if (it == servidor->sesionesActivas.end()) {
+    SesionUsuario sesion;
+    if (!servidor->obtenerSesion(sessionId, sesion)) {
         result["exito"] = false;
         result["mensaje"] = "Sesión inválida";
         return;
     }
     
-    const SesionUsuario& sesion = it->second;
     bool esAdmin = servidor->esAdministrador(sessionId);
     
     try {
-        std::vector<std::string> archivos;
+        // Admin ve todos los archivos; un usuario normal sólo los suyos (*_usuario.gcode)
+        std::vector<ArchivoCatalogo> archivos = servidor->catalogoArchivos->listar(esAdmin ? "" : sesion.usuario);
         
-        // Buscar archivos .gcode en el directorio actual
-        DIR* dir = opendir(".");
-        if (dir) {
-            struct dirent* entry;
-            while ((entry = readdir(dir)) != nullptr) {
-                std::string nombre = entry->d_name;
-                
-                // Solo archivos .gcode
-                if (nombre.length() > 6 && nombre.substr(nombre.length() - 6) == ".gcode") {
-                    // Si es admin, puede ver todos los archivos
-                    if (esAdmin) {
-                        archivos.push_back(nombre);
-                    } else {
-                        // Usuario normal solo ve sus propios archivos
-                        std::string sufijo = "_" + sesion.usuario + ".gcode";
-                        if (nombre.length() >= sufijo.length() && 
-                            nombre.substr(nombre.length() - sufijo.length()) == sufijo) {
-                            archivos.push_back(nombre);
-                        }
-                    }
-                }
-            }
-            closedir(dir);
-        }
-        
-        // Convertir a XmlRpcValue
+        // Convertir a XmlRpcValue: los nombres como antes y los datos de cada uno aparte
         XmlRpcValue listaArchivos;
+        XmlRpcValue detalles;
         for (size_t i = 0; i < archivos.size(); ++i) {
-            listaArchivos[static_cast<int>(i)] = archivos[i];
+            const ArchivoCatalogo& a = archivos[i];
+            listaArchivos[static_cast<int>(i)] = a.nombre;
+            
+            std::time_t t = static_cast<std::time_t>(a.modificado);
+            std::ostringstream fecha;
+            fecha << std::put_time(std::localtime(&t), "%Y-%m-%d %H:%M:%S");
+            
+            XmlRpcValue d;
+            d["nombre"] = a.nombre;
+            d["dueno"] = a.dueno;
+            d["bytes"] = static_cast<int>(a.bytes);
+            d["lineas"] = static_cast<int>(a.lineas);
+            d["modificado"] = fecha.str();
+            detalles[static_cast<int>(i)] = d;
         }
         
         result["exito"] = true;
         result["archivos"] = listaArchivos;
+        result["detalles"] = detalles;
         result["totalArchivos"] = static_cast<int>(archivos.size());
         result["esAdmin"] = esAdmin;
         
@@ -1024,5 +1589,5 @@ void MetodoListarArchivos::execute(XmlRpcValue& params, XmlRpcValue& result) {
 }
 
 std::string MetodoListarArchivos::help() {
-    return "Listar archivos G-Code disponibles. Parámetros: [sessionId]";
+    return "Listar archivos G-Code disponibles con dueño, tamaño, líneas y fecha. Parámetros: [sessionId]";
 }
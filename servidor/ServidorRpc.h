@@ -6,6 +6,10 @@
 #include "GestorBBDD.h"
 #include "GestorReportes.h"
 #include "GestorCodigoG.h"
+#include "ColaComandos.h"
+#include "ServidorEventos.h"
+#include "CatalogoArchivos.h"
+#include "AlmacenGCode.h"
 #include "Usuario.h"
 #include "Usuario.h"
 #include <string>
@@ -13,6 +17,8 @@
 #include <map>
 #include <vector>
 #include <chrono>
+#include <functional>
+#include <mutex>
 
 namespace Rpc {
 
@@ -31,14 +37,27 @@ namespace Rpc {
     public:  // Hacer todo público por simplicidad
         XmlRpc::XmlRpcServer* servidor;
         int puerto;
+        // Segundo servidor (puerto + 1) para las suscripciones de larga espera
+        std::unique_ptr<ServidorEventos> servidorEventos;
         
         // Gestores integrados
         std::unique_ptr<GestorBBDD> gestorBBDD;
         std::unique_ptr<GestorReportes> gestorReportes;
         std::unique_ptr<GestorCodigoG> gestorRobot;
+        // Toda operación que mueve o reconfigura el robot pasa por esta cola
+        // (se declara después de gestorRobot para destruirse antes)
+        std::unique_ptr<ColaComandos> colaRobot;
+        // Programas .gcode del directorio de trabajo, al día vía inotify
+        std::unique_ptr<CatalogoArchivos> catalogoArchivos;
+        // Contenido de los programas subidos, una vez por hash (los nombres son enlaces)
+        std::unique_ptr<AlmacenGCode> almacenGCode;
         
         // Control de acceso y sesiones
         std::map<std::string, SesionUsuario> sesionesActivas;
+        std::mutex mtxSesiones; // todo acceso a sesionesActivas va bajo este mutex: XML-RPC y eventos usan hilos distintos
+        // Sesión que inició la ejecución en curso ("" si la inició la consola); sólo
+        // ella y los administradores pueden controlarla. Protegida por mtxSesiones
+        std::string propietarioEjecucion;
         bool accesoRemotoHabilitado;
         
         // Estado del servidor
@@ -58,6 +77,24 @@ namespace Rpc {
         bool esAdministrador(const std::string& sessionId);
         void registrarEvento(const std::string& evento, const std::string& usuario = "", const std::string& nodo = "");
         std::string generarSessionId(const std::string& usuario, const std::string& nodo);
+        
+        // Encola una operación sobre el robot y espera su resultado. Si la cola la
+        // rechaza o la descarta, el motivo queda en 'motivoRechazo'.
+        bool ejecutarEnRobot(PrioridadComando prioridad, const std::string& origen,
+                             const std::function<bool()>& accion, std::string* motivoRechazo = nullptr);
+        // Descarta lo pendiente en la cola, corta la ejecución en el acto y envía
+        // M5/M84 directo al puerto (espera, como mucho, al comando que lo ocupa)
+        bool paradaEmergencia(const std::string& origen);
+        
+        // Copia de una sesión, apta para consultar desde cualquier hilo
+        bool obtenerSesion(const std::string& sessionId, SesionUsuario& sesion);
+        // Suma un comando correcto o erróneo a la sesión, si sigue abierta
+        void contarComando(const std::string& sessionId, bool exito);
+        // Instantánea de todas las sesiones para los reportes
+        std::map<std::string, SesionUsuario> copiaSesiones();
+        
+        void asignarPropietarioEjecucion(const std::string& sessionId);
+        bool puedeControlarEjecucion(const std::string& sessionId, const SesionUsuario& sesion);
     };
 
     // Método de autenticación
@@ -225,6 +262,52 @@ namespace Rpc {
         std::string help();
     };
 
+    // Método control de la ejecución en curso (pausa, reanudación, detención, paso a paso)
+    class MetodoControlEjecucion : public XmlRpc::XmlRpcServerMethod {
+    private:
+        ServidorRpc* servidor;
+    public:
+        MetodoControlEjecucion(XmlRpc::XmlRpcServer* S, ServidorRpc* srv) 
+            : XmlRpc::XmlRpcServerMethod("ControlEjecucion", S), servidor(srv) {}
+        void execute(XmlRpc::XmlRpcValue& params, XmlRpc::XmlRpcValue& result);
+        std::string help();
+    };
+
+    // Método parada de emergencia (cualquier sesión válida)
+    class MetodoParadaEmergencia : public XmlRpc::XmlRpcServerMethod {
+    private:
+        ServidorRpc* servidor;
+    public:
+        MetodoParadaEmergencia(XmlRpc::XmlRpcServer* S, ServidorRpc* srv) 
+            : XmlRpc::XmlRpcServerMethod("ParadaEmergencia", S), servidor(srv) {}
+        void execute(XmlRpc::XmlRpcValue& params, XmlRpc::XmlRpcValue& result);
+        std::string help();
+    };
+
+    // Método suscripción al estado (larga espera). En el servidor principal se
+    // registra sin espera para no bloquear al resto de los clientes.
+    class MetodoSuscribirEstado : public XmlRpc::XmlRpcServerMethod {
+    private:
+        ServidorRpc* servidor;
+        bool permitirEspera;
+    public:
+        MetodoSuscribirEstado(XmlRpc::XmlRpcServer* S, ServidorRpc* srv, bool permitirEspera) 
+            : XmlRpc::XmlRpcServerMethod("SuscribirEstado", S), servidor(srv), permitirEspera(permitirEspera) {}
+        void execute(XmlRpc::XmlRpcValue& params, XmlRpc::XmlRpcValue& result);
+        std::string help();
+    };
+
+    // Método simular archivo G-code (estimación sin mover el robot)
+    class MetodoSimularArchivo : public XmlRpc::XmlRpcServerMethod {
+    private:
+        ServidorRpc* servidor;
+    public:
+        MetodoSimularArchivo(XmlRpc::XmlRpcServer* S, ServidorRpc* srv) 
+            : XmlRpc::XmlRpcServerMethod("SimularArchivo", S), servidor(srv) {}
+        void execute(XmlRpc::XmlRpcValue& params, XmlRpc::XmlRpcValue& result);
+        std::string help();
+    };
+
     // --- NUEVA CLASE RPC A AGREGAR ---
     /**
      * @class MetodoReporteLogCsv
@@ -255,6 +338,20 @@ namespace Rpc {
         void execute(XmlRpc::XmlRpcValue& params, XmlRpc::XmlRpcValue& result);
         std::string help();
     };
+    /**
+     * @class MetodoExportarLog
+     * @brief Método RPC para exportar el log filtrado a CSV, JSON o XML en el servidor.
+     */
+    class MetodoExportarLog : public XmlRpc::XmlRpcServerMethod {
+    private:
+        ServidorRpc* servidor;
+    public:
+        MetodoExportarLog(XmlRpc::XmlRpcServer* s, ServidorRpc* srv)
+            : XmlRpc::XmlRpcServerMethod("ExportarLog", s), servidor(srv) {}
+
+        void execute(XmlRpc::XmlRpcValue& params, XmlRpc::XmlRpcValue& result);
+        std::string help();
+    };
     // --- FIN DE LA NUEVA CLASE ---
 
 } // namespace Rpc
@@ -0,0 +1,127 @@
+#include "SimplificadorTrayectoria.h"
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+// Tolerancia fija para considerar que tres puntos están sobre la misma recta
+static const double EPSILON_COLINEAL = 1e-6;
+
+SimplificadorTrayectoria::SimplificadorTrayectoria(double tolerancia)
+    : tolerancia_(tolerancia) {
+}
+
+// Distancia de p al segmento ab: la proyección se acota a los extremos
+double SimplificadorTrayectoria::distanciaASegmento(const Punto3D& p, const Punto3D& a, const Punto3D& b) {
+    double abx = b.x - a.x, aby = b.y - a.y, abz = b.z - a.z;
+    double apx = p.x - a.x, apy = p.y - a.y, apz = p.z - a.z;
+    double largo2 = abx * abx + aby * aby + abz * abz;
+
+    double t = 0.0;
+    if (largo2 > 0.0) {
+        t = std::min(1.0, std::max(0.0, (apx * abx + apy * aby + apz * abz) / largo2));
+    }
+
+    double dx = apx - t * abx, dy = apy - t * aby, dz = apz - t * abz;
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+std::vector<std::size_t> SimplificadorTrayectoria::fusionarColineales(const std::vector<Punto3D>& puntos) const {
+    std::vector<std::size_t> conservados;
+    conservados.push_back(0);
+
+    // Cada tramo de puntos colineales se compara con la recta de su primer segmento
+    // real (el primero que sale del último conservado con largo mayor que
+    // EPSILON_COLINEAL), no con la cuerda hasta el punto siguiente: así el desvío de
+    // los puntos descartados no se acumula a lo largo del tramo. La distancia es a la
+    // recta; los retrocesos se detectan aparte con la proyección (avance)
+    bool hayRecta = false;
+    double dx = 0.0, dy = 0.0, dz = 0.0; // dirección unitaria de la recta
+    double avance = 0.0;                 // proyección del último punto sobre la recta
+
+    for (std::size_t i = 1; i + 1 < puntos.size(); ++i) {
+        const Punto3D& a = puntos[conservados.back()];
+        if (!hayRecta) {
+            double ex = puntos[i].x - a.x, ey = puntos[i].y - a.y, ez = puntos[i].z - a.z;
+            double largo = std::sqrt(ex * ex + ey * ey + ez * ez);
+            if (largo <= EPSILON_COLINEAL) {
+                continue; // punto repetido: se descarta
+            }
+            dx = ex / largo;
+            dy = ey / largo;
+            dz = ez / largo;
+            avance = largo;
+            hayRecta = true;
+        }
+
+        // Se descarta el punto si el siguiente sigue sobre la recta y sin retroceder
+        const Punto3D& sig = puntos[i + 1];
+        double qx = sig.x - a.x, qy = sig.y - a.y, qz = sig.z - a.z;
+        double t = qx * dx + qy * dy + qz * dz;
+        double px = qx - t * dx, py = qy - t * dy, pz = qz - t * dz;
+        if (std::sqrt(px * px + py * py + pz * pz) <= EPSILON_COLINEAL && t >= avance - EPSILON_COLINEAL) {
+            avance = std::max(avance, t);
+        } else {
+            conservados.push_back(i);
+            hayRecta = false;
+        }
+    }
+
+    conservados.push_back(puntos.size() - 1);
+    return conservados;
+}
+
+std::vector<std::size_t> SimplificadorTrayectoria::douglasPeucker(const std::vector<Punto3D>& puntos,
+                                                                 const std::vector<std::size_t>& candidatos) const {
+    const std::size_t n = candidatos.size();
+    std::vector<bool> conservar(n, false);
+    conservar.front() = true;
+    conservar.back() = true;
+
+    // Versión iterativa para no desbordar la pila con trayectorias largas
+    std::vector<std::pair<std::size_t, std::size_t>> pendientes;
+    pendientes.push_back({0, n - 1});
+
+    while (!pendientes.empty()) {
+        std::size_t inicio = pendientes.back().first;
+        std::size_t fin = pendientes.back().second;
+        pendientes.pop_back();
+
+        double maxDistancia = 0.0;
+        std::size_t maxIndice = inicio;
+        for (std::size_t k = inicio + 1; k < fin; ++k) {
+            double d = distanciaASegmento(puntos[candidatos[k]], puntos[candidatos[inicio]], puntos[candidatos[fin]]);
+            if (d > maxDistancia) {
+                maxDistancia = d;
+                maxIndice = k;
+            }
+        }
+
+        if (maxDistancia > tolerancia_) {
+            conservar[maxIndice] = true;
+            pendientes.push_back({inicio, maxIndice});
+            pendientes.push_back({maxIndice, fin});
+        }
+    }
+
+    std::vector<std::size_t> resultado;
+    for (std::size_t k = 0; k < n; ++k) {
+        if (conservar[k]) {
+            resultado.push_back(candidatos[k]);
+        }
+    }
+    return resultado;
+}
+
+std::vector<std::size_t> SimplificadorTrayectoria::simplificar(const std::vector<Punto3D>& puntos) const {
+    if (puntos.size() <= 2) {
+        std::vector<std::size_t> todos(puntos.size());
+        for (std::size_t i = 0; i < puntos.size(); ++i) todos[i] = i;
+        return todos;
+    }
+
+    std::vector<std::size_t> candidatos = fusionarColineales(puntos);
+    if (tolerancia_ <= 0.0 || candidatos.size() <= 2) {
+        return candidatos;
+    }
+    return douglasPeucker(puntos, candidatos);
+}
@@ -0,0 +1,44 @@
+#ifndef SIMPLIFICADORTRAYECTORIA_H
+#define SIMPLIFICADORTRAYECTORIA_H
+
+#include <vector>
+#include <cstddef>
+#include "Geometria.h"
+
+struct ResultadoSimplificacion {
+    std::size_t puntosOriginales;
+    std::size_t puntosResultantes;
+
+    ResultadoSimplificacion() : puntosOriginales(0), puntosResultantes(0) {}
+
+    double reduccionPorcentual() const {
+        return puntosOriginales == 0 ? 0.0
+            : 100.0 * static_cast<double>(puntosOriginales - puntosResultantes) / static_cast<double>(puntosOriginales);
+    }
+};
+
+// Reduce polilíneas 3D: primero fusiona puntos colineales (o repetidos) y luego
+// aplica Douglas-Peucker con la tolerancia dada. El primer y el último punto se conservan.
+// Cada punto descartado queda, como mucho, a la tolerancia del segmento conservado que
+// lo reemplaza; la distancia se mide al segmento, no a la recta, así un punto que
+// vuelve atrás sobre la misma recta no se pierde.
+class SimplificadorTrayectoria {
+private:
+    double tolerancia_; // mm, distancia máxima de un punto descartado a su segmento
+
+    static double distanciaASegmento(const Punto3D& p, const Punto3D& a, const Punto3D& b);
+    std::vector<std::size_t> fusionarColineales(const std::vector<Punto3D>& puntos) const;
+    std::vector<std::size_t> douglasPeucker(const std::vector<Punto3D>& puntos,
+                                            const std::vector<std::size_t>& candidatos) const;
+
+public:
+    explicit SimplificadorTrayectoria(double tolerancia = 0.05);
+
+    // Devuelve los índices (ordenados) de los puntos que se conservan
+    std::vector<std::size_t> simplificar(const std::vector<Punto3D>& puntos) const;
+
+    double obtenerTolerancia() const { return tolerancia_; }
+    void configurarTolerancia(double tolerancia) { tolerancia_ = tolerancia; }
+};
+
+#endif
@@ -0,0 +1,152 @@
+#include "ValidadorLote.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VALIDADOR_X86 1
+#endif
+
+namespace {
+
+// Límites del envolvente ya elevados al cuadrado
+struct Envolvente {
+    double zMin, zMax;
+    double r2Min, r2Max;
+};
+
+Envolvente envolventeRobot(const EspacioTrabajo& espacio) {
+    Envolvente e;
+    e.zMin = Z_MIN;
+    e.zMax = Z_MAX;
+    e.r2Min = espacio.obtenerR2Min();
+    e.r2Max = espacio.obtenerR2Max();
+    return e;
+}
+
+void envolventeEscalar(const Envolvente& e, const double* x, const double* y, const double* z,
+                       std::size_t inicio, std::size_t n, std::uint8_t* dentro) {
+    for (std::size_t i = inicio; i < n; ++i) {
+        double r2 = x[i] * x[i] + y[i] * y[i];
+        dentro[i] = (z[i] >= e.zMin && z[i] <= e.zMax && r2 >= e.r2Min && r2 <= e.r2Max) ? 1 : 0;
+    }
+}
+
+#ifdef VALIDADOR_X86
+void envolventeSSE2(const Envolvente& e, const double* x, const double* y, const double* z,
+                    std::size_t n, std::uint8_t* dentro) {
+    const __m128d zMin = _mm_set1_pd(e.zMin), zMax = _mm_set1_pd(e.zMax);
+    const __m128d r2Min = _mm_set1_pd(e.r2Min), r2Max = _mm_set1_pd(e.r2Max);
+
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d vx = _mm_loadu_pd(x + i), vy = _mm_loadu_pd(y + i), vz = _mm_loadu_pd(z + i);
+        __m128d r2 = _mm_add_pd(_mm_mul_pd(vx, vx), _mm_mul_pd(vy, vy));
+
+        __m128d ok = _mm_and_pd(_mm_cmpge_pd(vz, zMin), _mm_cmple_pd(vz, zMax));
+        ok = _mm_and_pd(ok, _mm_and_pd(_mm_cmpge_pd(r2, r2Min), _mm_cmple_pd(r2, r2Max)));
+
+        int mascara = _mm_movemask_pd(ok);
+        dentro[i] = mascara & 1;
+        dentro[i + 1] = (mascara >> 1) & 1;
+    }
+    envolventeEscalar(e, x, y, z, i, n, dentro);
+}
+
+__attribute__((target("avx")))
+void envolventeAVX(const Envolvente& e, const double* x, const double* y, const double* z,
+                   std::size_t n, std::uint8_t* dentro) {
+    const __m256d zMin = _mm256_set1_pd(e.zMin), zMax = _mm256_set1_pd(e.zMax);
+    const __m256d r2Min = _mm256_set1_pd(e.r2Min), r2Max = _mm256_set1_pd(e.r2Max);
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d vx = _mm256_loadu_pd(x + i), vy = _mm256_loadu_pd(y + i), vz = _mm256_loadu_pd(z + i);
+        __m256d r2 = _mm256_add_pd(_mm256_mul_pd(vx, vx), _mm256_mul_pd(vy, vy));
+
+        __m256d ok = _mm256_and_pd(_mm256_cmp_pd(vz, zMin, _CMP_GE_OQ), _mm256_cmp_pd(vz, zMax, _CMP_LE_OQ));
+        ok = _mm256_and_pd(ok, _mm256_and_pd(_mm256_cmp_pd(r2, r2Min, _CMP_GE_OQ), _mm256_cmp_pd(r2, r2Max, _CMP_LE_OQ)));
+
+        int mascara = _mm256_movemask_pd(ok);
+        for (int k = 0; k < 4; ++k) {
+            dentro[i + k] = (mascara >> k) & 1;
+        }
+    }
+    envolventeEscalar(e, x, y, z, i, n, dentro);
+}
+
+bool cpuConAVX() {
+    static const bool disponible = __builtin_cpu_supports("avx");
+    return disponible;
+}
+#endif
+
+} // namespace
+
+ValidadorLote::ValidadorLote(const EspacioTrabajo& espacio) : espacio_(espacio) {
+}
+
+void ValidadorLote::reservar(std::size_t puntos) {
+    x_.reserve(puntos);
+    y_.reserve(puntos);
+    z_.reserve(puntos);
+    origen_.reserve(puntos);
+}
+
+void ValidadorLote::limpiar() {
+    x_.clear();
+    y_.clear();
+    z_.clear();
+    origen_.clear();
+}
+
+void ValidadorLote::agregar(double x, double y, double z, std::size_t origen) {
+    x_.push_back(x);
+    y_.push_back(y);
+    z_.push_back(z);
+    origen_.push_back(origen);
+}
+
+const char* ValidadorLote::implementacionDisponible() {
+#ifdef VALIDADOR_X86
+    return cpuConAVX() ? "AVX" : "SSE2";
+#else
+    return "escalar";
+#endif
+}
+
+ResultadoValidacionLote ValidadorLote::validar() {
+    ResultadoValidacionLote resultado;
+    const std::size_t n = x_.size();
+    resultado.implementacion = implementacionDisponible();
+    if (n == 0) {
+        return resultado;
+    }
+
+    envolvente_.resize(n);
+    const Envolvente e = envolventeRobot(espacio_);
+
+    // Pasada 1: envolvente para todo el lote (el mismo criterio que validarPosicion)
+#ifdef VALIDADOR_X86
+    if (cpuConAVX()) {
+        envolventeAVX(e, x_.data(), y_.data(), z_.data(), n, envolvente_.data());
+    } else {
+        envolventeSSE2(e, x_.data(), y_.data(), z_.data(), n, envolvente_.data());
+    }
+#else
+    envolventeEscalar(e, x_.data(), y_.data(), z_.data(), 0, n, envolvente_.data());
+#endif
+
+    // Pasada 2: el primer punto fuera en orden de programa
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!envolvente_[i]) {
+            resultado.valido = false;
+            resultado.puntoInvalido = i;
+            resultado.origenInvalido = origen_[i];
+            resultado.posicionInvalida = Punto3D(x_[i], y_[i], z_[i]);
+            resultado.puntosEvaluados = i + 1;
+            return resultado;
+        }
+    }
+
+    resultado.puntosEvaluados = n;
+    return resultado;
+}
@@ -0,0 +1,52 @@
+#ifndef VALIDADORLOTE_H
+#define VALIDADORLOTE_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "EspacioTrabajo.h"
+#include "Geometria.h"
+
+struct ResultadoValidacionLote {
+    bool valido;
+    std::size_t puntosEvaluados;
+    std::size_t puntoInvalido;   // índice del primer punto inválido (si !valido)
+    std::size_t origenInvalido;  // índice del comando que generó ese punto
+    Punto3D posicionInvalida;
+    const char* implementacion;  // "AVX", "SSE2" o "escalar"
+    bool arcoInvalido;           // el comando origen es un arco sin geometría válida (no hay punto fuera)
+
+    ResultadoValidacionLote()
+        : valido(true), puntosEvaluados(0), puntoInvalido(0), origenInvalido(0), implementacion("escalar"),
+          arcoInvalido(false) {}
+};
+
+// Valida trayectorias completas antes de enviarlas al robot. Los puntos se guardan
+// como estructura de arrays (x, y, z) para que una primera pasada SIMD compruebe
+// el envolvente (Z y anillo radial al cuadrado); después se busca en orden el
+// primer punto fuera, de modo que el que se informa es el primero del programa.
+class ValidadorLote {
+private:
+    const EspacioTrabajo& espacio_;
+
+    std::vector<double> x_, y_, z_;
+    std::vector<std::size_t> origen_;
+
+    // Buffer de trabajo de la pasada SIMD
+    std::vector<std::uint8_t> envolvente_;
+
+public:
+    explicit ValidadorLote(const EspacioTrabajo& espacio);
+
+    void reservar(std::size_t puntos);
+    void limpiar();
+    void agregar(double x, double y, double z, std::size_t origen);
+    std::size_t obtenerTamano() const { return x_.size(); }
+
+    ResultadoValidacionLote validar();
+
+    // Implementación SIMD elegida en tiempo de ejecución según la CPU
+    static const char* implementacionDisponible();
+};
+
+#endif
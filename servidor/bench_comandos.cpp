@@ -0,0 +1,120 @@
+// Mide la memoria y las reservas de un programa G-Code cargado con la
+// representación compacta de ComandoG contra la anterior (dos std::string por
+// comando más posición, centro, radio y velocidad en double) sobre un programa
+// sintético con algunas líneas que deben conservar su texto.
+// Uso: make benches && ./bench_comandos [lineas]   (por defecto 100000)
+#include "GestorCodigoG.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <malloc.h>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::size_t reservas = 0;
+
+const char *RUTA = "bench_comandos.gcode";
+
+struct ComandoAnterior {
+    std::string comando;
+    std::string descripcion;
+    Posicion posicion;
+    Posicion centro;
+    double radio;
+    double velocidad;
+    unsigned char ejesPresentes;
+    bool valido;
+    bool enlazado;
+};
+
+// Movimientos dentro del espacio de trabajo; cada 1000 líneas un M106 S255 y cada
+// 500 un arco, como en un programa de CAM
+void generar(std::size_t lineas) {
+    std::ofstream f(RUTA, std::ios::trunc);
+    for (std::size_t i = 0; i < lineas; ++i) {
+        if (i % 1000 == 0) f << "M106 S255\n";
+        f << "G1 X" << (100 + i % 50) << " Y" << (50 + i % 30) << "." << (i % 7) << " Z100 F1500 ; paso\n";
+        if (i % 500 == 0) f << "G2 X" << (102 + i % 50) << " Y" << (50 + i % 30) << "." << (i % 7) << " I1 J0\n";
+    }
+}
+
+std::size_t heap() {
+    struct mallinfo2 m = mallinfo2();
+    return m.uordblks + m.hblkhd;
+}
+
+// La representación anterior con los textos que guardaba (la línea completa y
+// la descripción) para los mismos comandos cargados
+std::vector<ComandoAnterior> cargarAnterior(const ProgramaG &programa) {
+    std::vector<ComandoAnterior> anterior;
+    std::ifstream f(RUTA);
+    std::string linea;
+    std::size_t i = 0;
+    while (std::getline(f, linea) && i < programa.size()) {
+        if (linea.empty() || linea[0] == ';') continue;
+        const ComandoG &cmd = programa[i++];
+        ComandoAnterior c;
+        c.comando = linea;
+        c.descripcion = cmd.descripcion();
+        c.posicion = cmd.posicion();
+        c.centro = cmd.centro();
+        c.radio = cmd.radio();
+        c.velocidad = cmd.velocidad();
+        c.ejesPresentes = cmd.palabras & (EJE_X | EJE_Y | EJE_Z);
+        c.valido = cmd.valido;
+        c.enlazado = cmd.enlazado;
+        anterior.push_back(std::move(c));
+    }
+    anterior.shrink_to_fit();
+    return anterior;
+}
+
+} // namespace
+
+void *operator new(std::size_t n) {
+    ++reservas;
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+int main(int argc, char **argv) {
+    std::size_t lineas = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    generar(lineas);
+
+    GestorCodigoG gestor("/dev/null");
+    gestor.configurarCacheProgramas(0); // sólo la copia cargada
+
+    std::size_t heap0 = heap(), reservas0 = reservas;
+    auto t = std::chrono::steady_clock::now();
+    std::streambuf *salida = std::cout.rdbuf(nullptr);
+    bool ok = gestor.cargarArchivoGCode(RUTA);
+    std::cout.rdbuf(salida);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+    if (!ok) {
+        std::cerr << "No se pudo cargar " << RUTA << std::endl;
+        return 1;
+    }
+    std::size_t reservasActual = reservas - reservas0, heapActual = heap() - heap0;
+
+    ProgramaG programa = gestor.obtenerTrayectoriaActual();
+    heap0 = heap();
+    reservas0 = reservas;
+    std::vector<ComandoAnterior> anterior = cargarAnterior(programa);
+    std::size_t reservasAnterior = reservas - reservas0, heapAnterior = heap() - heap0;
+
+    std::cout << programa.size() << " comandos (" << lineas << " líneas de movimiento)\n"
+              << "  anterior: " << sizeof(ComandoAnterior) << " B/comando, " << reservasAnterior << " reservas, "
+              << heapAnterior / 1024 << " KB\n"
+              << "  actual:   " << sizeof(ComandoG) << " B/comando, " << reservasActual << " reservas, "
+              << heapActual / 1024 << " KB (textos conservados: " << programa.textos.bytes() << " B), carga "
+              << ms << " ms\n";
+    std::remove(RUTA);
+    return anterior.size() == programa.size() ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+// Compara filtrarLog contra la implementación anterior (copiar cada línea,
+// pasarla a minúsculas y buscar con std::string::find) sobre un log sintético.
+// Uso: make benches && ./bench_filtrar_log [MB]   (por defecto 256)
+#include "GestorReportes.h"
+#include "BuscadorTexto.h"
+#include "SegmentosLog.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char *RUTA_LOG = "bench_filtrar_log.csv";
+
+double segundosDesde(std::chrono::steady_clock::time_point inicio) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+}
+
+std::size_t generarLog(std::size_t megas) {
+    const char *usuarios[] = {"admin", "juan", "maria", "Bob", "operador1"};
+    const char *codigos[] = {"200", "200", "200", "ERROR", "OK"};
+    const char *ordenes[] = {"G1 X%d Y%d F1500", "G0 X%d Y%d - Movimiento rapido", "M3 S%d%d", "G28 - Home X%d Y%d"};
+    std::ofstream ofs(RUTA_LOG, std::ios::trunc);
+    std::size_t bytes = 0, lineas = 0;
+    char detalle[64], linea[256];
+    while (bytes < megas * 1024 * 1024) {
+        std::snprintf(detalle, sizeof(detalle), ordenes[lineas % 4], static_cast<int>(lineas % 997),
+                      static_cast<int>(lineas % 331));
+        int n = std::snprintf(linea, sizeof(linea),
+                              "\"2025-%02d-%02d %02d:%02d:%02d\",\"REQUEST\",\"%s\",\"%s\",\"192.168.1.%d\",\"%s\",\"RPC\"\n",
+                              static_cast<int>(1 + lineas / 2000000 % 12), static_cast<int>(1 + lineas / 80000 % 28),
+                              static_cast<int>(lineas / 3600 % 24), static_cast<int>(lineas / 60 % 60),
+                              static_cast<int>(lineas % 60), detalle, usuarios[lineas % 5],
+                              static_cast<int>(lineas % 250), codigos[lineas % 5]);
+        ofs.write(linea, n);
+        bytes += static_cast<std::size_t>(n);
+        ++lineas;
+    }
+    return lineas;
+}
+
+// filtrarLog tal como estaba antes del motor de búsqueda
+std::size_t filtrarAnterior(const std::string &filtro1, const std::string &filtro2) {
+    std::vector<std::string> resultados;
+    std::ifstream ifs(RUTA_LOG);
+    std::string linea;
+    std::string f1 = filtro1; std::string f2 = filtro2;
+    std::transform(f1.begin(), f1.end(), f1.begin(), ::tolower);
+    std::transform(f2.begin(), f2.end(), f2.begin(), ::tolower);
+    while (std::getline(ifs, linea)) {
+        std::string low = linea;
+        std::transform(low.begin(), low.end(), low.begin(), ::tolower);
+        bool m1 = f1.empty() || (low.find(f1) != std::string::npos);
+        bool m2 = f2.empty() || (low.find(f2) != std::string::npos);
+        if (m1 && m2) resultados.push_back(linea);
+    }
+    return resultados.size();
+}
+
+// Sólo el motor de búsqueda sobre el texto, como en los segmentos sin columnas
+std::size_t filtrarPorBloques(const std::string &filtro1, const std::string &filtro2) {
+    FiltroLineas filtro({filtro1, filtro2});
+    std::vector<std::string> resultados;
+    leerBloquesLog(RUTA_LOG, false, [&](const char *texto, std::size_t n) {
+        filtro.recorrer(texto, n, [&](const char *linea, std::size_t largo) {
+            resultados.emplace_back(linea, largo);
+            return true;
+        });
+    });
+    return resultados.size();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::size_t megas = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+    std::cout << "=== BENCHMARK FILTRAR LOG ===" << std::endl;
+
+    auto t = std::chrono::steady_clock::now();
+    std::size_t lineas = generarLog(megas);
+    std::cout << "Log sintético: " << megas << " MB, " << lineas << " líneas (" << segundosDesde(t) << " s)" << std::endl;
+
+    std::remove((std::string(RUTA_LOG) + ".col").c_str());
+    t = std::chrono::steady_clock::now();
+    GestorReportes gestor(RUTA_LOG);
+    std::cout << "Indexado columnar inicial: " << segundosDesde(t) << " s" << std::endl;
+
+    const std::pair<std::string, std::string> consultas[] = {
+        {"RAPIDO", "bob"},      // frecuente
+        {"x996 y", "maria"},    // poco frecuente
+        {"inexistente", ""},    // sin resultados
+    };
+    bool ok = true;
+    for (const auto &c : consultas) {
+        std::cout << "\nFiltros: '" << c.first << "' '" << c.second << "'" << std::endl;
+
+        t = std::chrono::steady_clock::now();
+        std::size_t anterior = filtrarAnterior(c.first, c.second);
+        double sAnterior = segundosDesde(t);
+
+        t = std::chrono::steady_clock::now();
+        std::size_t bloques = filtrarPorBloques(c.first, c.second);
+        double sBloques = segundosDesde(t);
+
+        t = std::chrono::steady_clock::now();
+        std::size_t actual = gestor.filtrarLog(c.first, c.second).size();
+        double sActual = segundosDesde(t);
+
+        std::printf("  anterior (getline+tolower+find): %8zu líneas %8.3f s %8.1f MB/s\n", anterior, sAnterior, megas / sAnterior);
+        std::printf("  por bloques (texto, SIMD):       %8zu líneas %8.3f s %8.1f MB/s  x%.1f\n", bloques, sBloques,
+                    megas / sBloques, sAnterior / sBloques);
+        std::printf("  filtrarLog (columnar):           %8zu líneas %8.3f s %8.1f MB/s  x%.1f\n", actual, sActual,
+                    megas / sActual, sAnterior / sActual);
+        if (anterior != bloques || anterior != actual) {
+            std::cout << "  ERROR: los resultados no coinciden" << std::endl;
+            ok = false;
+        }
+    }
+
+    std::remove(RUTA_LOG);
+    std::remove((std::string(RUTA_LOG) + ".col").c_str());
+    std::remove((std::string(RUTA_LOG) + ".manifiesto").c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+// Compara los parsers de JSON y XML de GestorArchivos contra la implementación
+// anterior (copiar el texto, quitar saltos de línea, substr por objeto y std::find
+// de cada clave en los encabezados) sobre tablas sintéticas.
+// Uso: make benches && ./bench_tablas [filas]   (por defecto 1000000). Los
+// objetos del servidor de un "make" sin más están sin optimizar: no sirven para medir.
+#include "GestorArchivos.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const char *RUTA_JSON = "bench_tablas.json";
+const char *RUTA_XML = "bench_tablas.xml";
+const int COLUMNAS = 12;
+
+using Fila = std::vector<std::string>;
+struct Tabla {
+    std::vector<std::string> encabezados;
+    std::vector<Fila> filas;
+};
+
+double segundosDesde(std::chrono::steady_clock::time_point inicio) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+}
+
+std::string nombreColumna(int c) {
+    return "columna_" + std::to_string(c);
+}
+
+// Cada tanto una fila trae las claves en otro orden, como un JSON escrito a mano
+void generar(std::size_t filas) {
+    std::ofstream json(RUTA_JSON, std::ios::trunc);
+    std::ofstream xml(RUTA_XML, std::ios::trunc);
+    json << "[\n";
+    xml << "<rows>\n";
+    for (std::size_t r = 0; r < filas; ++r) {
+        json << (r ? ",\n  {" : "  {");
+        xml << "  <row>\n";
+        for (int k = 0; k < COLUMNAS; ++k) {
+            int c = (r % 10 == 9) ? COLUMNAS - 1 - k : k;
+            std::string valor = std::to_string((r * 31 + static_cast<std::size_t>(c) * 7) % 100000);
+            json << (k ? ", \"" : "\"") << nombreColumna(c) << "\":\"" << valor << '"';
+            xml << "    <col name=\"" << nombreColumna(c) << "\">" << valor << "</col>\n";
+        }
+        json << '}';
+        xml << "  </row>\n";
+    }
+    json << "\n]";
+    xml << "</rows>";
+}
+
+// --------- Implementación anterior ---------
+std::string trim(const std::string &s) {
+    std::size_t i = 0, j = s.size();
+    while (i < j && std::isspace(static_cast<unsigned char>(s[i]))) ++i;
+    while (j > i && std::isspace(static_cast<unsigned char>(s[j - 1]))) --j;
+    return s.substr(i, j - i);
+}
+
+std::vector<std::string> split(const std::string &s, char delim) {
+    std::vector<std::string> out;
+    std::string item;
+    std::istringstream iss(s);
+    while (std::getline(iss, item, delim)) out.push_back(item);
+    if (!s.empty() && s.back() == delim) out.push_back("");
+    return out;
+}
+
+void agregarFila(Tabla &t, const std::vector<std::pair<std::string, std::string>> &pares) {
+    if (pares.empty()) return;
+    if (t.encabezados.empty()) {
+        for (auto &p : pares) t.encabezados.push_back(p.first);
+    }
+    Fila r(t.encabezados.size(), "");
+    for (auto &p : pares) {
+        auto it = std::find(t.encabezados.begin(), t.encabezados.end(), p.first);
+        if (it != t.encabezados.end()) r[std::distance(t.encabezados.begin(), it)] = p.second;
+    }
+    t.filas.push_back(r);
+}
+
+Tabla parseJSONAnterior(const std::string &text) {
+    std::string s = text;
+    s.erase(std::remove(s.begin(), s.end(), '\n'), s.end());
+    s.erase(std::remove(s.begin(), s.end(), '\r'), s.end());
+    Tabla t;
+    std::size_t pos = 0;
+    while ((pos = s.find('{', pos)) != std::string::npos) {
+        std::size_t end = s.find('}', pos);
+        if (end == std::string::npos) break;
+        std::string obj = s.substr(pos + 1, end - pos - 1);
+        pos = end + 1;
+
+        std::vector<std::pair<std::string, std::string>> pares;
+        std::string token;
+        bool inStr = false;
+        for (std::size_t i = 0; i <= obj.size(); ++i) {
+            char c = (i < obj.size() ? obj[i] : ',');
+            if (c == '"' && (i == 0 || obj[i - 1] != '\\')) inStr = !inStr;
+            if (!inStr && c == ',') {
+                if (!trim(token).empty()) {
+                    auto kv = split(token, ':');
+                    if (kv.size() >= 2) {
+                        std::string k = trim(kv[0]);
+                        std::string v = trim(token.substr(token.find(':') + 1));
+                        if (k.size() >= 2 && k.front() == '"' && k.back() == '"') k = k.substr(1, k.size() - 2);
+                        if (v.size() >= 2 && v.front() == '"' && v.back() == '"') v = v.substr(1, v.size() - 2);
+                        pares.push_back({k, v});
+                    }
+                }
+                token.clear();
+            } else {
+                token.push_back(c);
+            }
+        }
+        agregarFila(t, pares);
+    }
+    return t;
+}
+
+Tabla parseXMLAnterior(const std::string &text) {
+    std::string s = text;
+    s.erase(std::remove(s.begin(), s.end(), '\n'), s.end());
+    s.erase(std::remove(s.begin(), s.end(), '\r'), s.end());
+    Tabla t;
+    std::size_t pos = 0;
+    while ((pos = s.find("<row>", pos)) != std::string::npos) {
+        std::size_t endRow = s.find("</row>", pos);
+        if (endRow == std::string::npos) break;
+        std::string rowBlock = s.substr(pos + 5, endRow - (pos + 5));
+        pos = endRow + 6;
+
+        std::size_t p2 = 0;
+        std::vector<std::pair<std::string, std::string>> cols;
+        while ((p2 = rowBlock.find("<col", p2)) != std::string::npos) {
+            std::size_t namePos = rowBlock.find("name=\"", p2);
+            if (namePos == std::string::npos) break;
+            namePos += 6;
+            std::size_t nameEnd = rowBlock.find("\"", namePos);
+            if (nameEnd == std::string::npos) break;
+            std::string header = rowBlock.substr(namePos, nameEnd - namePos);
+            std::size_t gt = rowBlock.find(">", nameEnd);
+            if (gt == std::string::npos) break;
+            std::size_t colEnd = rowBlock.find("</col>", gt);
+            if (colEnd == std::string::npos) break;
+            cols.push_back({header, rowBlock.substr(gt + 1, colEnd - gt - 1)});
+            p2 = colEnd + 6;
+        }
+        agregarFila(t, cols);
+    }
+    return t;
+}
+
+std::string leerArchivo(const char *ruta) {
+    std::ifstream ifs(ruta, std::ios::binary);
+    std::ostringstream oss;
+    oss << ifs.rdbuf();
+    return oss.str();
+}
+
+bool iguales(const Tabla &anterior, const TablaColumnas &actual) {
+    if (anterior.filas.size() != actual.filas || anterior.encabezados.size() != actual.encabezados.size()) return false;
+    for (std::size_t c = 0; c < actual.encabezados.size(); ++c) {
+        if (anterior.encabezados[c] != actual.encabezados[c]) return false;
+        for (std::size_t r = 0; r < actual.filas; ++r) {
+            if (anterior.filas[r][c] != actual.columnas[c][r]) return false;
+        }
+    }
+    return true;
+}
+
+// Un ostream que descarta todo, para medir exportar sin el costo del disco
+class Descarte : public std::streambuf {
+protected:
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+    int overflow(int c) override { return c; }
+};
+
+bool medir(const char *ruta, Tabla (*anterior)(const std::string &)) {
+    std::cout << "\n" << ruta << std::endl;
+
+    auto t = std::chrono::steady_clock::now();
+    Tabla viejo = anterior(leerArchivo(ruta));
+    double sAnterior = segundosDesde(t);
+
+    GestorArchivos archivo(ruta);
+    TablaColumnas tabla;
+    t = std::chrono::steady_clock::now();
+    archivo.getTabla(tabla);
+    double sTabla = segundosDesde(t);
+
+    Descarte descarte;
+    std::ostream destino(&descarte);
+    t = std::chrono::steady_clock::now();
+    archivo.exportar(destino, 'c');
+    double sExportar = segundosDesde(t);
+
+    std::printf("  anterior (find+substr):   %8zu filas %8.3f s\n", viejo.filas.size(), sAnterior);
+    std::printf("  getTabla (una pasada):    %8zu filas %8.3f s  x%.1f\n", tabla.filas, sTabla, sAnterior / sTabla);
+    std::printf("  exportar a CSV (lotes):   %8s       %8.3f s\n", "", sExportar);
+    if (!iguales(viejo, tabla)) {
+        std::cout << "  ERROR: las tablas no coinciden" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::size_t filas = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::cout << "=== BENCHMARK TABLAS JSON/XML ===" << std::endl;
+
+    auto t = std::chrono::steady_clock::now();
+    generar(filas);
+    std::cout << "Tablas sintéticas: " << filas << " filas x " << COLUMNAS << " columnas (" << segundosDesde(t) << " s)"
+              << std::endl;
+
+    bool ok = medir(RUTA_JSON, parseJSONAnterior);
+    ok = medir(RUTA_XML, parseXMLAnterior) && ok;
+
+    for (const char *ruta : {RUTA_JSON, RUTA_XML}) std::remove(ruta);
+    return ok ? 0 : 1;
+}
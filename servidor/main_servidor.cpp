@@ -6,6 +6,7 @@
 #include <memory>             // <--- Requerido para el hilo
 #include <iomanip>            // <--- Para std::setw (reportes)
 #include <vector>             // <--- Para std::vector (reportes)
+#include <functional>         // <--- Para las operaciones encoladas
 
 using namespace Rpc;
 
@@ -41,10 +42,21 @@ void mostrarMenuCli() {
     std::cout << "  gripper_off       - Desactivar efector final (gripper)" << std::endl;
     std::cout << "  motores_on        - Activar motores (M17)" << std::endl;
     std::cout << "  motores_off       - Desactivar motores (M18)" << std::endl;
+    std::cout << "  emergencia        - Parada de emergencia (corta la ejecucion y la cola)" << std::endl;
     std::cout << "  modo              - Configura modo (manual/auto, abs/rel)" << std::endl;
     std::cout << "  --- Modo Automático y Aprendizaje ---" << std::endl;
     std::cout << "  ejecutar          - Ejecuta un archivo G-Code local del servidor" << std::endl;
+    std::cout << "  pausar / reanudar - Pausa o reanuda la ejecucion en curso" << std::endl;
+    std::cout << "  detener           - Detiene la ejecucion en curso" << std::endl;
+    std::cout << "  paso              - Ejecuta un comando (ejecucion pausada)" << std::endl;
+    std::cout << "  estado_ejecucion  - Muestra el estado, el comando actual y la cola" << std::endl;
     std::cout << "  aprender          - Inicia el sub-menu de aprendizaje de trayectoria" << std::endl;
+    std::cout << "  telemetria        - Configura el periodo de sondeo de posicion (M114)" << std::endl;
+    std::cout << "  simplificar       - Configura la tolerancia de simplificacion de trayectorias" << std::endl;
+    std::cout << "  planificar        - Activa o desactiva el planificador de velocidades" << std::endl;
+    std::cout << "  cache_programas   - Muestra la cache de programas y configura su memoria" << std::endl;
+    std::cout << "  simular           - Estima duracion y recorrido de un archivo sin mover el robot" << std::endl;
+    std::cout << "  latencias         - Configura los tiempos de firmware que usa la simulacion" << std::endl;
     std::cout << "  --- Reportes ---" << std::endl;
     std::cout << "  reporte_sesiones  - Muestra las sesiones RPC activas" << std::endl;
     std::cout << "  reporte_log       - Filtra y muestra el log CSV del servidor" << std::endl;
@@ -61,26 +73,41 @@ void limpiarBufferCin() {
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 }
 
+/**
+ * @brief Pasa una operación de la CLI por la cola de comandos del robot,
+ * con el mismo arbitraje de prioridades que las peticiones RPC.
+ */
+bool enCola(ServidorRpc* srv, const std::function<bool()>& accion,
+            PrioridadComando prioridad = PrioridadComando::MANUAL) {
+    std::string motivo;
+    bool exito = srv->ejecutarEnRobot(prioridad, "admin_cli@localhost", accion, &motivo);
+    if (!motivo.empty()) {
+        std::cout << ">> Peticion rechazada por la cola de comandos: " << motivo << std::endl;
+    }
+    return exito;
+}
+
 /**
  * @brief Procesa un comando ingresado en la CLI local. (ACTUALIZADO)
- * Llama directamente a los gestores del servidor.
+ * Llama a los gestores del servidor; las operaciones sobre el robot pasan
+ * por la misma cola de comandos que las peticiones RPC.
  */
 void ejecutarComandoCli(const std::string& cmd, ServidorRpc* srv) {
     // Usamos los gestores internos del objeto 'servidor'
     // para asegurar que usamos la misma lógica que el RPC
     
     if (cmd == "conectar") {
-        if (srv->gestorRobot->conectarRobot())
+        if (enCola(srv, [&] { return srv->gestorRobot->conectarRobot(); }))
             std::cout << ">> Robot conectado." << std::endl;
         else
             std::cout << ">> Error conectando robot." << std::endl;
     
     } else if (cmd == "desconectar") {
-        srv->gestorRobot->desconectarRobot();
-        std::cout << ">> Robot desconectado." << std::endl;
+        if (enCola(srv, [&] { srv->gestorRobot->desconectarRobot(); return true; }))
+            std::cout << ">> Robot desconectado." << std::endl;
     
     } else if (cmd == "home") {
-        if (srv->gestorRobot->irAPosicionOrigen())
+        if (enCola(srv, [&] { return srv->gestorRobot->irAPosicionOrigen(); }))
             std::cout << ">> Robot en Home." << std::endl;
         else
             std::cout << ">> Error moviendo a Home (asegurese de 'conectar' primero)." << std::endl;
@@ -90,31 +117,31 @@ void ejecutarComandoCli(const std::string& cmd, ServidorRpc* srv) {
         std::cout << "  Ingrese X: "; std::cin >> x;
         std::cout << "  Ingrese Y: "; std::cin >> y;
         std::cout << "  Ingrese Z: "; std::cin >> z;
-        if (srv->gestorRobot->moverEfectorSinVelocidad(x, y, z))
+        if (enCola(srv, [&] { return srv->gestorRobot->moverEfectorSinVelocidad(x, y, z); }))
             std::cout << ">> Movimiento ejecutado." << std::endl;
         else
             std::cout << ">> Error en movimiento (fuera de rango o no conectado)." << std::endl;
     
     } else if (cmd == "gripper_on") {
-        if (srv->gestorRobot->activarEfectorFinal())
+        if (enCola(srv, [&] { return srv->gestorRobot->activarEfectorFinal(); }))
             std::cout << ">> Efector activado." << std::endl;
         else
             std::cout << ">> Error activando efector." << std::endl;
     
     } else if (cmd == "gripper_off") {
-        if (srv->gestorRobot->desactivarEfectorFinal())
+        if (enCola(srv, [&] { return srv->gestorRobot->desactivarEfectorFinal(); }))
             std::cout << ">> Efector desactivado." << std::endl;
         else
             std::cout << ">> Error desactivando efector." << std::endl;
     
     } else if (cmd == "motores_on") {
-        if (srv->gestorRobot->ejecutarComandoGDirecto("M17")) 
+        if (enCola(srv, [&] { return srv->gestorRobot->ejecutarComandoGDirecto("M17"); })) 
             std::cout << ">> Motores activados." << std::endl;
         else
             std::cout << ">> Error activando motores." << std::endl;
 
     } else if (cmd == "motores_off") {
-        if (srv->gestorRobot->ejecutarComandoGDirecto("M18"))
+        if (enCola(srv, [&] { return srv->gestorRobot->ejecutarComandoGDirecto("M18"); }))
             std::cout << ">> Motores desactivados." << std::endl;
         else
             std::cout << ">> Error desactivando motores." << std::endl;
@@ -142,14 +169,17 @@ void ejecutarComandoCli(const std::string& cmd, ServidorRpc* srv) {
         std::cout << "  Modo de Trabajo (manual/automatico): "; std::cin >> modoT;
         std::cout << "  Modo de Coordenadas (absoluto/relativo): "; std::cin >> modoC;
 
-        bool exito = true;
-        if (modoT == "manual") exito &= srv->gestorRobot->configurarModoTrabajo(ModoTrabajo::MANUAL);
-        else if (modoT == "automatico") exito &= srv->gestorRobot->configurarModoTrabajo(ModoTrabajo::AUTOMATICO);
-        else exito = false;
+        bool exito = enCola(srv, [&] {
+            bool ok = true;
+            if (modoT == "manual") ok &= srv->gestorRobot->configurarModoTrabajo(ModoTrabajo::MANUAL);
+            else if (modoT == "automatico") ok &= srv->gestorRobot->configurarModoTrabajo(ModoTrabajo::AUTOMATICO);
+            else ok = false;
 
-        if (modoC == "absoluto") exito &= srv->gestorRobot->configurarModoCoordenadas(ModoCoordenas::ABSOLUTO);
-        else if (modoC == "relativo") exito &= srv->gestorRobot->configurarModoCoordenadas(ModoCoordenas::RELATIVO);
-        else exito = false;
+            if (modoC == "absoluto") ok &= srv->gestorRobot->configurarModoCoordenadas(ModoCoordenas::ABSOLUTO);
+            else if (modoC == "relativo") ok &= srv->gestorRobot->configurarModoCoordenadas(ModoCoordenas::RELATIVO);
+            else ok = false;
+            return ok;
+        });
         
         if (exito) std::cout << ">> Modo configurado: " << modoT << " / " << modoC << std::endl;
         else std::cout << ">> Error: Valores de modo invalidos." << std::endl;
@@ -159,10 +189,55 @@ void ejecutarComandoCli(const std::string& cmd, ServidorRpc* srv) {
         std::string nombreArchivo;
         std::cout << "  Nombre del archivo G-Code a ejecutar (ej: mi_trayectoria.gcode): ";
         std::cin >> nombreArchivo;
-        if (srv->gestorRobot->cargarArchivoGCode(nombreArchivo))
-            std::cout << ">> Archivo '" << nombreArchivo << "' ejecutado." << std::endl;
+        if (enCola(srv, [&] {
+                GestorCodigoG& robot = *srv->gestorRobot;
+                if (robot.convieneCargaIncremental(nombreArchivo)) return robot.iniciarEjecucionIncremental(nombreArchivo);
+                return robot.cargarArchivoGCode(nombreArchivo) && robot.iniciarEjecucion();
+            }, PrioridadComando::ARCHIVO)) {
+            srv->asignarPropietarioEjecucion(""); // iniciada desde la consola: sólo los administradores la controlan por RPC
+            std::cout << ">> Ejecucion de '" << nombreArchivo << "' iniciada (pausar/reanudar/detener/paso/estado_ejecucion)." << std::endl;
+        } else {
+            std::cout << ">> Error ejecutando archivo (no encontrado, ejecucion en curso o robot no en modo auto)." << std::endl;
+        }
+    }
+
+    else if (cmd == "pausar") {
+        if (srv->gestorRobot->pausarEjecucion()) std::cout << ">> Pausa solicitada (se detiene al terminar el tramo en curso)." << std::endl;
+        else std::cout << ">> No hay ejecucion en curso." << std::endl;
+    }
+
+    else if (cmd == "reanudar") {
+        if (srv->gestorRobot->reanudarEjecucion()) std::cout << ">> Ejecucion reanudada." << std::endl;
+        else std::cout << ">> La ejecucion no esta pausada." << std::endl;
+    }
+
+    else if (cmd == "detener") {
+        if (srv->gestorRobot->detenerEjecucion()) std::cout << ">> Detencion solicitada." << std::endl;
+        else std::cout << ">> No hay ejecucion en curso." << std::endl;
+    }
+
+    else if (cmd == "emergencia") {
+        bool exito = srv->paradaEmergencia("admin_cli@localhost");
+        if (exito)
+            std::cout << ">> PARADA DE EMERGENCIA: efector y motores desactivados (hacer 'home' antes de mover)." << std::endl;
         else
-            std::cout << ">> Error ejecutando archivo (no encontrado o robot no en modo auto)." << std::endl;
+            std::cout << ">> Parada de emergencia con errores de comunicacion." << std::endl;
+    }
+
+    else if (cmd == "paso") {
+        if (srv->gestorRobot->ejecutarPasoAPaso()) std::cout << ">> Paso solicitado." << std::endl;
+        else std::cout << ">> No se pudo ejecutar el paso." << std::endl;
+    }
+
+    else if (cmd == "estado_ejecucion") {
+        std::cout << ">> Estado: " << GestorCodigoG::nombreEstadoEjecucion(srv->gestorRobot->obtenerEstadoEjecucion())
+                  << " | Comando " << (srv->gestorRobot->obtenerContadorPrograma() + 1) << "/"
+                  << srv->gestorRobot->obtenerTotalComandos()
+                  << " | " << srv->gestorRobot->obtenerMensajeEjecucion() << std::endl;
+        EstadisticasCola cola = srv->colaRobot->obtenerEstadisticas();
+        std::cout << ">> Cola: " << cola.pendientes[0] << " emergencia, " << cola.pendientes[1] << " manual, "
+                  << cola.pendientes[2] << " archivo pendientes | ejecutadas " << cola.ejecutadas
+                  << ", rechazadas " << cola.rechazadas << ", descartadas " << cola.descartadas << std::endl;
     }
 
     else if (cmd == "aprender") {
@@ -174,7 +249,7 @@ void ejecutarComandoCli(const std::string& cmd, ServidorRpc* srv) {
         if (subCmd == "iniciar") {
             std::string nombre;
             std::cout << "    Nombre de la trayectoria: "; std::cin >> nombre;
-            if(srv->gestorRobot->iniciarAprendizajeTrayectoria(nombre))
+            if(enCola(srv, [&] { return srv->gestorRobot->iniciarAprendizajeTrayectoria(nombre); }))
                 std::cout << ">> Aprendizaje iniciado. Archivo: " << nombre << "_admin_cli.gcode" << std::endl;
             else
                 std::cout << ">> Error al iniciar aprendizaje." << std::endl;
@@ -185,13 +260,13 @@ void ejecutarComandoCli(const std::string& cmd, ServidorRpc* srv) {
             std::cout << "    Ingrese Y: "; std::cin >> y;
             std::cout << "    Ingrese Z: "; std::cin >> z;
             std::cout << "    Ingrese Vel (F): "; std::cin >> vel;
-            if(srv->gestorRobot->agregarPasoTrayectoria(x, y, z, vel))
+            if(enCola(srv, [&] { return srv->gestorRobot->agregarPasoTrayectoria(x, y, z, vel); }))
                 std::cout << ">> Paso agregado a la trayectoria." << std::endl;
             else
                 std::cout << ">> Error al agregar paso (aprendizaje no iniciado?)." << std::endl;
 
         } else if (subCmd == "finalizar") {
-            if(srv->gestorRobot->finalizarAprendizajeTrayectoria())
+            if(enCola(srv, [&] { return srv->gestorRobot->finalizarAprendizajeTrayectoria(); }))
                 std::cout << ">> Aprendizaje finalizado y archivo guardado." << std::endl;
             else
                 std::cout << ">> Error al finalizar." << std::endl;
@@ -200,12 +275,86 @@ void ejecutarComandoCli(const std::string& cmd, ServidorRpc* srv) {
         }
     }
 
+    else if (cmd == "telemetria") {
+        int periodo;
+        std::cout << "  Periodo de sondeo de posicion en ms (0 para desactivar): "; std::cin >> periodo;
+        srv->gestorRobot->configurarTelemetria(periodo);
+        if (periodo > 0) std::cout << ">> Telemetria cada " << periodo << " ms." << std::endl;
+        else std::cout << ">> Telemetria desactivada (se informa la posicion comandada)." << std::endl;
+    }
+
+    else if (cmd == "simplificar") {
+        double tolerancia;
+        std::cout << "  Tolerancia en mm (0 para desactivar): "; std::cin >> tolerancia;
+        if (tolerancia > 0) {
+            srv->gestorRobot->configurarSimplificacion(tolerancia, true);
+            std::cout << ">> Simplificacion activada (tolerancia " << tolerancia << " mm)." << std::endl;
+        } else {
+            srv->gestorRobot->configurarSimplificacion(0, false);
+            std::cout << ">> Simplificacion desactivada." << std::endl;
+        }
+    }
+
+    else if (cmd == "planificar") {
+        std::string op;
+        std::cout << "  Planificador de velocidades (activar/desactivar): "; std::cin >> op;
+        bool activar = (op == "activar");
+        srv->gestorRobot->activarPlanificacion(activar);
+        std::cout << ">> Planificador " << (activar ? "activado" : "desactivado") << "." << std::endl;
+    }
+
+    else if (cmd == "cache_programas") {
+        EstadisticasCacheProgramas e = srv->gestorRobot->obtenerEstadisticasCache();
+        std::cout << ">> Cache de programas: " << e.programas << " programas, " << (e.bytes >> 10) << " KB de "
+                  << (e.bytesMaximos >> 20) << " MB | aciertos " << e.aciertos << ", fallos " << e.fallos
+                  << ", descartes " << e.descartes << std::endl;
+        long megas;
+        std::cout << "  Memoria maxima en MB (0 desactiva, -1 sin cambios): "; std::cin >> megas;
+        if (megas >= 0) {
+            srv->gestorRobot->configurarCacheProgramas(static_cast<size_t>(megas) << 20);
+            std::cout << ">> Cache de programas: " << megas << " MB." << std::endl;
+        }
+    }
+
+    else if (cmd == "latencias") {
+        LatenciasFirmware l = srv->gestorRobot->obtenerLatencias();
+        std::cout << ">> Latencias actuales (sin calibrar): respuesta " << l.respuestaMs << " ms, pausa entre comandos "
+                  << l.pausaEntreComandosMs << " ms, homing " << l.homingMs << " ms" << std::endl;
+        std::cout << "  Respuesta del firmware en ms: "; std::cin >> l.respuestaMs;
+        std::cout << "  Duracion de G28 en ms: "; std::cin >> l.homingMs;
+        if (std::cin && l.respuestaMs >= 0 && l.homingMs >= 0) {
+            srv->gestorRobot->configurarLatencias(l);
+            std::cout << ">> Latencias de simulacion actualizadas." << std::endl;
+        } else {
+            std::cin.clear();
+            std::cout << ">> Error: Valores invalidos." << std::endl;
+        }
+    }
+
+    else if (cmd == "simular") {
+        std::string nombreArchivo;
+        std::cout << "  Nombre del archivo G-Code a simular: ";
+        std::cin >> nombreArchivo;
+        ResultadoSimulacion sim = srv->gestorRobot->simularArchivoGCode(nombreArchivo);
+        if (sim.valido) {
+            std::cout << ">> Simulacion de '" << nombreArchivo << "': " << sim.comandos << " comandos, "
+                      << sim.tramos << " lineas al firmware" << std::endl;
+            std::cout << "   Duracion estimada: " << sim.duracionSegundos << " s (movimiento "
+                      << sim.tiempoMovimientoSegundos << " s, latencias " << sim.tiempoLatenciaSegundos << " s)" << std::endl;
+            std::cout << "   Recorrido: " << sim.longitudRecorridoMm << " mm | Alcance maximo: "
+                      << sim.alcanceMaximoMm << " mm" << std::endl;
+        } else {
+            std::cout << ">> Error en la simulacion: " << sim.mensaje << std::endl;
+        }
+    }
+
     else if (cmd == "reporte_sesiones") {
         std::cout << ">> --- Reporte de Sesiones RPC Activas ---" << std::endl;
-        std::cout << "Total de sesiones: " << srv->sesionesActivas.size() << std::endl;
+        std::map<std::string, SesionUsuario> sesiones = srv->copiaSesiones();
+        std::cout << "Total de sesiones: " << sesiones.size() << std::endl;
         std::cout << "------------------------------------------" << std::endl;
         int i = 1;
-        for (const auto& par : srv->sesionesActivas) {
+        for (const auto& par : sesiones) {
             const SesionUsuario& s = par.second;
             std::cout << "  Sesion " << i++ << ": " << s.usuario << "@" << s.nodoOrigen << std::endl;
             std::cout << "    Comandos OK: " << s.comandosEjecutados << " | Errores: " << s.comandosErroneos << std::endl;
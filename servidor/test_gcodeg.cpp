@@ -1,6 +1,295 @@
 #include "GestorCodigoG.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
 #include <iostream>
+#include <poll.h>
 #include <string>
+#include <thread>
+#include <unistd.h>
+
+// --- Pruebas no interactivas (./test_gcodeg --pruebas) ---
+
+static int fallos = 0;
+
+static void comprobar(bool condicion, const std::string& descripcion) {
+    std::cout << (condicion ? "  ✓ " : "  ✗ ") << descripcion << std::endl;
+    if (!condicion) ++fallos;
+}
+
+// Cada prueba usa su propio archivo: la caché de programas reconoce los
+// archivos por inodo, tamaño y fecha
+static std::string escribirPrograma(const std::string& nombre, const std::string& contenido) {
+    std::string ruta = "prueba_gcodeg_" + nombre + ".gcode";
+    std::ofstream(ruta) << contenido;
+    return ruta;
+}
+
+static std::string textoComando(const GestorCodigoG& gestor, size_t indice) {
+    ProgramaG programa = gestor.obtenerTrayectoriaActual();
+    return indice < programa.size() ? programa.texto(programa[indice]) : "";
+}
+
+// Un eje omitido conserva su valor modal; planificar no debe perderlo
+static void probarPlanificador() {
+    std::cout << "\n1. PLANIFICADOR" << std::endl;
+    GestorCodigoG gestor("/dev/null/sin_puerto");
+    comprobar(gestor.planificacionActiva(), "activo por defecto");
+    std::string ruta = escribirPrograma("disperso", "G1 X150 Y50 Z100 F1500\nG1 X160\n");
+    comprobar(gestor.cargarArchivoGCode(ruta), "carga del programa con ejes omitidos");
+    gestor.planificarTrayectoria();
+    comprobar(textoComando(gestor, 1) == "G1 X160 Y50 Z100 F1500", "G1 X160 sale con Y, Z y F modales");
+    std::remove(ruta.c_str());
+
+    // En G91 las cotas son desplazamientos: el planificador no las reescribe
+    ruta = escribirPrograma("relativo_plan",
+                            "G1 X150 Y50 Z100 F1500\nG1 X160 Y50 Z100\nG91\nG1 X5\nG90\nG1 X180 Y50 Z100\n");
+    comprobar(gestor.cargarArchivoGCode(ruta), "carga del programa con G91");
+    gestor.planificarTrayectoria();
+    ProgramaG programa = gestor.obtenerTrayectoriaActual();
+    comprobar(programa.size() == 6 && programa[3].fPlan == 0 && programa.texto(programa[3]) == "G1 X5",
+              "el movimiento relativo queda sin planificar");
+    comprobar(programa.size() == 6 && programa[1].fPlan != 0 && programa[5].fPlan != 0,
+              "los absolutos de antes y después se planifican");
+    std::remove(ruta.c_str());
+}
+
+// ComandoG::texto() regenera la línea a partir de los campos guardados
+static void probarTextoComando() {
+    std::cout << "\n2. TEXTO DE LOS COMANDOS" << std::endl;
+    GestorCodigoG gestor("/dev/null/sin_puerto");
+    std::string ruta = escribirPrograma("texto", "G1 X10.5 Y-3.25 Z100 F1500\nM106 S255\nG0 X150 Y50 Z100\n");
+    comprobar(gestor.cargarArchivoGCode(ruta), "carga del programa");
+    comprobar(textoComando(gestor, 0) == "G1 X10.5 Y-3.25 Z100 F1500", "G1 con decimales y negativos");
+    comprobar(textoComando(gestor, 1) == "M106 S255", "comando M conservado tal cual");
+    comprobar(textoComando(gestor, 2) == "G0 X150 Y50 Z100", "G0 sin velocidad");
+    std::remove(ruta.c_str());
+    
+    ruta = escribirPrograma("palabras", "G1 X Y5\nG1 X1 X2\n");
+    comprobar(gestor.cargarArchivoGCode(ruta), "carga con palabras dudosas");
+    comprobar(gestor.obtenerTrayectoriaActual().size() == 1, "palabra repetida rechazada");
+    comprobar(textoComando(gestor, 0) == "G1 X Y5", "palabra sin dígitos conservada");
+    std::remove(ruta.c_str());
+    
+    gestor.iniciarAprendizajeTrayectoria("/dev/null/sin_dir/tray");
+    gestor.agregarPasoTrayectoria(150, 50, 100, 1000);
+    comprobar(!gestor.finalizarAprendizajeTrayectoria(""), "guardar en ruta imposible falla");
+}
+
+// Los colineales absolutos se fusionan; los relativos no se tocan
+static void probarSimplificador() {
+    std::cout << "\n3. SIMPLIFICADOR" << std::endl;
+    GestorCodigoG gestor("/dev/null/sin_puerto");
+    gestor.configurarSimplificacion(0.05, false);
+    std::string ruta = escribirPrograma("relativo_simpl",
+                                        "G1 X150 Y50 Z100 F1500\nG1 X155 Y50 Z100\nG1 X160 Y50 Z100\n"
+                                        "G1 X165 Y50 Z100\nG91\nG1 X5\nG1 X5\nG1 X5\n");
+    comprobar(gestor.cargarArchivoGCode(ruta), "carga del programa con G91");
+    ResultadoSimplificacion r = gestor.simplificarTrayectoria();
+    ProgramaG programa = gestor.obtenerTrayectoriaActual();
+    size_t relativos = 0;
+    for (size_t i = 0; i < programa.size(); ++i) {
+        if (programa.texto(programa[i]) == "G1 X5") ++relativos;
+    }
+    comprobar(r.puntosResultantes < r.puntosOriginales, "los colineales absolutos se reducen");
+    comprobar(relativos == 3, "los tres movimientos relativos se conservan");
+    comprobar(programa.size() > 0 && programa.texto(programa[programa.size() - 4]) == "G91", "G91 sigue antes de ellos");
+    std::remove(ruta.c_str());
+    
+    // El punto que se pasa y vuelve queda sobre la recta de la cuerda, pero lejos del segmento
+    ruta = escribirPrograma("retroceso_simpl", "G1 X150 Y50 Z100 F1500\nG1 X150 Y50 Z100\nG1 X170 Y50 Z100\n"
+                                       "G1 X160 Y50 Z100\n");
+    comprobar(gestor.cargarArchivoGCode(ruta), "carga del programa con retroceso");
+    gestor.simplificarTrayectoria();
+    comprobar(gestor.obtenerTrayectoriaActual().size() == 4, "el retroceso sobre la misma recta se conserva");
+    std::remove(ruta.c_str());
+}
+
+// Un arco en G91 recorre lo mismo que su equivalente absoluto
+static void probarArcoRelativo() {
+    std::cout << "\n4. ARCOS EN G91" << std::endl;
+    GestorCodigoG gestor("/dev/null/sin_puerto");
+    std::string relativo = escribirPrograma("arco_relativo", "G1 X150 Y0 Z100 F1000\nG91\nG2 X10 Y0 I5 J0\n");
+    std::string absoluto = escribirPrograma("arco_absoluto", "G1 X150 Y0 Z100 F1000\nG2 X160 Y0 I5 J0\n");
+    ResultadoSimulacion r = gestor.simularArchivoGCode(relativo);
+    ResultadoSimulacion a = gestor.simularArchivoGCode(absoluto);
+    comprobar(r.valido && a.valido, "ambos programas son válidos");
+    comprobar(std::fabs(r.longitudRecorridoMm - a.longitudRecorridoMm) < 1e-6,
+              "misma longitud recorrida (" + std::to_string(r.longitudRecorridoMm) + " mm)");
+    std::remove(relativo.c_str());
+    std::remove(absoluto.c_str());
+}
+
+// Dos nombres enlazados al mismo contenido (como los del AlmacenGCode) comparten
+// la entrada de la caché
+static void probarCacheEnlaces() {
+    std::cout << "\n5. CACHÉ DE PROGRAMAS CON ENLACES" << std::endl;
+    GestorCodigoG gestor("/dev/null/sin_puerto");
+    std::string ruta = escribirPrograma("cache_a", "G1 X150 Y50 Z100 F1500\nG1 X160 Y50 Z100\n");
+    std::string enlace = "prueba_gcodeg_cache_b.gcode";
+    std::remove(enlace.c_str());
+    comprobar(link(ruta.c_str(), enlace.c_str()) == 0, "enlace duro al mismo archivo");
+    comprobar(gestor.cargarArchivoGCode(ruta), "carga por el primer nombre");
+    std::uint64_t aciertos = gestor.obtenerEstadisticasCache().aciertos;
+    comprobar(gestor.cargarArchivoGCode(enlace), "carga por el segundo nombre");
+    comprobar(gestor.obtenerEstadisticasCache().aciertos == aciertos + 1, "el segundo nombre acierta en la caché");
+    comprobar(gestor.obtenerEstadisticasCache().programas == 1, "una sola entrada para los dos nombres");
+    std::remove(ruta.c_str());
+    std::remove(enlace.c_str());
+}
+
+// Firmware simulado en el otro extremo de un pseudoterminal: responde "ok" a
+// cada línea (y la posición a M114) y cuenta los movimientos recibidos y los
+// que llegan después de un M84
+class FirmwareSimulado {
+public:
+    bool abrir() {
+        maestro_ = posix_openpt(O_RDWR | O_NOCTTY);
+        if (maestro_ < 0 || grantpt(maestro_) != 0 || unlockpt(maestro_) != 0) return false;
+        const char* nombre = ptsname(maestro_);
+        if (!nombre) return false;
+        puerto_ = nombre;
+        hilo_ = std::thread(&FirmwareSimulado::bucle, this);
+        return true;
+    }
+    ~FirmwareSimulado() {
+        detener_ = true;
+        if (hilo_.joinable()) hilo_.join();
+        if (maestro_ >= 0) close(maestro_);
+    }
+    const std::string& puerto() const { return puerto_; }
+    int movimientos() const { return movimientos_; }
+    int apagados() const { return apagados_; }
+    int movimientosTrasApagar() const { return movimientosTrasApagar_; }
+
+private:
+    int maestro_ = -1;
+    std::string puerto_;
+    std::thread hilo_;
+    std::atomic<bool> detener_{false};
+    std::atomic<int> movimientos_{0};
+    std::atomic<int> apagados_{0};
+    std::atomic<int> movimientosTrasApagar_{0};
+
+    void bucle() {
+        std::string pendiente;
+        char buf[256];
+        while (!detener_) {
+            pollfd pfd{maestro_, POLLIN, 0};
+            if (poll(&pfd, 1, 50) <= 0 || !(pfd.revents & POLLIN)) continue;
+            ssize_t n = read(maestro_, buf, sizeof(buf));
+            if (n <= 0) continue;
+            pendiente.append(buf, static_cast<size_t>(n));
+            size_t fin;
+            while ((fin = pendiente.find('\n')) != std::string::npos) {
+                std::string linea = pendiente.substr(0, fin);
+                pendiente.erase(0, fin + 1);
+                if (linea.compare(0, 2, "G1") == 0 || linea.compare(0, 2, "G0") == 0) {
+                    ++movimientos_;
+                    if (apagados_ > 0) ++movimientosTrasApagar_;
+                }
+                if (linea.compare(0, 3, "M84") == 0) ++apagados_;
+                std::string respuesta = linea.compare(0, 4, "M114") == 0
+                    ? "X:0.00 Y:0.00 Z:0.00 E:0.00 Count X:0 Y:0 Z:0\nok\n"
+                    : "ok\n";
+                if (write(maestro_, respuesta.data(), respuesta.size()) < 0) return;
+            }
+        }
+    }
+};
+
+// Un archivo que falla la validación no arranca ni envía ningún movimiento
+static void probarErrorCargaIncremental() {
+    std::cout << "\n6. CARGA INCREMENTAL CON UN COMANDO INVÁLIDO" << std::endl;
+    FirmwareSimulado firmware;
+    if (!firmware.abrir()) {
+        comprobar(false, "pseudoterminal para el firmware simulado");
+        return;
+    }
+    std::string ruta = escribirPrograma("incremental",
+                                        "G1 X150 Y50 Z100 F1500\nG1 X160 Y50 Z100\nG1 X9999 Y50 Z100\nG1 X170 Y50 Z100\n");
+    {
+        GestorCodigoG gestor(firmware.puerto());
+        gestor.configurarTelemetria(0);
+        comprobar(gestor.conectarRobot(), "conexión con el firmware simulado");
+        comprobar(gestor.obtenerTelemetria()->medidaValida, "la posición inicial (M114) se publica sin sondeo");
+        gestor.configurarModoTrabajo(ModoTrabajo::AUTOMATICO);
+        int movimientosPrevios = firmware.movimientos();
+        comprobar(!gestor.iniciarEjecucionIncremental(ruta), "la ejecución no se inicia");
+        comprobar(gestor.obtenerMensajeEjecucion().find("comando 3") != std::string::npos,
+                  "el mensaje señala el comando 3: " + gestor.obtenerMensajeEjecucion());
+        comprobar(gestor.obtenerEstadoEjecucion() == EstadoEjecucion::INACTIVO, "el estado sigue inactivo");
+        comprobar(firmware.movimientos() == movimientosPrevios, "no se envió ningún movimiento");
+        
+        // Más allá del primer bloque (256 comandos) la ejecución arranca sin leer el
+        // resto y se detiene antes del bloque que contiene el error
+        std::string programa;
+        for (int i = 0; i < 300; ++i) programa += (i % 2 ? "G1 X160 Y50 Z100\n" : "G1 X150 Y50 Z100 F1500\n");
+        programa += "G1 X9999 Y50 Z100\n";
+        std::string rutaLarga = escribirPrograma("incremental_largo", programa);
+        movimientosPrevios = firmware.movimientos();
+        comprobar(gestor.iniciarEjecucionIncremental(rutaLarga), "la ejecución larga se inicia");
+        comprobar(!gestor.esperarFinEjecucion(), "y termina con error");
+        comprobar(gestor.obtenerMensajeEjecucion().find("comando 301") != std::string::npos,
+                  "el mensaje señala el comando 301: " + gestor.obtenerMensajeEjecucion());
+        comprobar(firmware.movimientos() - movimientosPrevios == 256,
+                  "sólo se envió el primer bloque (" + std::to_string(firmware.movimientos() - movimientosPrevios) + ")");
+        std::remove(rutaLarga.c_str());
+    }
+    std::remove(ruta.c_str());
+}
+
+// La parada corta una ejecución en curso y M5/M84 son lo último que recibe el robot
+static void probarParadaEmergencia() {
+    std::cout << "\n7. PARADA DE EMERGENCIA DURANTE LA EJECUCIÓN" << std::endl;
+    FirmwareSimulado firmware;
+    if (!firmware.abrir()) {
+        comprobar(false, "pseudoterminal para el firmware simulado");
+        return;
+    }
+    std::string programa;
+    for (int i = 0; i < 60; ++i) programa += (i % 2 ? "G1 X160 Y50 Z100\n" : "G1 X150 Y50 Z100 F1500\n");
+    std::string ruta = escribirPrograma("parada", programa);
+    {
+        GestorCodigoG gestor(firmware.puerto());
+        gestor.configurarTelemetria(0);
+        comprobar(gestor.conectarRobot(), "conexión con el firmware simulado");
+        gestor.configurarModoTrabajo(ModoTrabajo::AUTOMATICO);
+        int previos = firmware.movimientos();
+        comprobar(gestor.cargarArchivoGCode(ruta) && gestor.iniciarEjecucion(), "la ejecución se inicia");
+        for (int espera = 0; espera < 100 && firmware.movimientos() - previos < 3; ++espera) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        comprobar(gestor.paradaEmergencia(), "la parada envía M5 y M84");
+        comprobar(gestor.obtenerEstadoEjecucion() == EstadoEjecucion::INACTIVO, "la ejecución quedó detenida");
+        int enviados = firmware.movimientos() - previos;
+        comprobar(enviados >= 3 && enviados < 60, "se cortó a mitad del programa (" + std::to_string(enviados) + " de 60)");
+        comprobar(firmware.apagados() == 1 && firmware.movimientosTrasApagar() == 0,
+                  "ningún movimiento llegó después de M84");
+    }
+    std::remove(ruta.c_str());
+}
+
+static int ejecutarPruebas() {
+    std::cout << "=== PRUEBAS GESTOR CÓDIGO G ===" << std::endl;
+    probarPlanificador();
+    probarTextoComando();
+    probarSimplificador();
+    probarArcoRelativo();
+    probarCacheEnlaces();
+    probarErrorCargaIncremental();
+    probarParadaEmergencia();
+    std::cout << "\n" << (fallos == 0 ? "Todas las comprobaciones pasaron"
+                                      : std::to_string(fallos) + " comprobaciones fallaron") << std::endl;
+    return fallos == 0 ? 0 : 1;
+}
+
+// --- Menú interactivo ---
 
 void mostrarMenu() {
     std::cout << "\n=== GESTOR CÓDIGO G - MENU PRINCIPAL ===" << std::endl;
@@ -27,7 +316,11 @@ void mostrarMenu() {
     std::cout << "Opción: ";
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--pruebas") {
+        return ejecutarPruebas();
+    }
+    
     GestorCodigoG gestor;
     int opcion;
     
@@ -1,5 +1,193 @@
 #include "GestorReportes.h"
+#include "BuscadorTexto.h"
+#include "GestorArchivos.h"
+#include <cstdio>
+#include <fstream>
+#include <filesystem>
 #include <iostream>
+#include <string>
+#include <vector>
+
+static int fallos = 0;
+
+static void comprobar(bool condicion, const std::string &descripcion) {
+    std::cout << (condicion ? "  ✓ " : "  ✗ ") << descripcion << std::endl;
+    if (!condicion) ++fallos;
+}
+
+// El log, sus segmentos rotados, su log columnar y su manifiesto
+static void borrarLog(const std::string &ruta) {
+    std::error_code ec;
+    for (const auto &entrada : std::filesystem::directory_iterator(".", ec)) {
+        if (entrada.path().filename().string().rfind(ruta, 0) == 0) std::filesystem::remove(entrada.path(), ec);
+    }
+}
+
+// Las líneas de 'leidas' son "paso 0", "paso 1"... en orden y sin repetir
+static bool pasosEnOrden(const std::vector<std::string> &leidas, int total) {
+    if (leidas.size() != static_cast<std::size_t>(total)) return false;
+    for (int i = 0; i < total; ++i) {
+        if (leidas[i].find("\"paso " + std::to_string(i) + "\"") == std::string::npos) return false;
+    }
+    return true;
+}
+
+// Un cursor tomado antes de rotar sigue valiendo después, primero sobre el
+// segmento rotado sin comprimir y después sobre su .gz
+static void probarPaginacionConRotacion() {
+    std::cout << "\n7. PAGINACIÓN CON ROTACIÓN" << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+    const std::string ruta = "test_reportes_paginas.csv";
+    borrarLog(ruta);
+    {
+        GestorReportes gestor(ruta);
+        for (int i = 0; i < 20; ++i) gestor.registrarPeticion("paso " + std::to_string(i), "ana", "nodo", "200");
+        ConsultaLog consulta = GestorReportes::crearConsulta("", "", "ana");
+        PaginaLog pagina;
+        std::vector<std::string> leidas;
+        comprobar(gestor.paginaLog(consulta, "", 8, pagina) && pagina.hayMas, "primera página antes de rotar");
+        leidas.insert(leidas.end(), pagina.lineas.begin(), pagina.lineas.end());
+
+        comprobar(gestor.rotarLog(), "rotación con un cursor a mitad del segmento");
+        for (int i = 20; i < 30; ++i) gestor.registrarPeticion("paso " + std::to_string(i), "ana", "nodo", "200");
+        bool cursoresValidos = true;
+        while (pagina.hayMas && cursoresValidos) {
+            cursoresValidos = gestor.paginaLog(consulta, pagina.cursor, 8, pagina);
+            leidas.insert(leidas.end(), pagina.lineas.begin(), pagina.lineas.end());
+        }
+        comprobar(cursoresValidos, "los cursores siguen valiendo tras rotar");
+        comprobar(pasosEnOrden(leidas, 30), "cada línea una vez y en orden a través del segmento rotado");
+
+        gestor.esperarCompresion();
+        std::vector<SegmentoLog> segmentos = gestor.segmentosLog();
+        comprobar(segmentos.size() == 1 && segmentoComprimido(segmentos[0]), "el segmento rotado quedó comprimido");
+        leidas.clear();
+        std::string cursor;
+        do {
+            if (!gestor.paginaLog(consulta, cursor, 7, pagina)) break;
+            leidas.insert(leidas.end(), pagina.lineas.begin(), pagina.lineas.end());
+            cursor = pagina.cursor;
+        } while (pagina.hayMas);
+        comprobar(pasosEnOrden(leidas, 30), "el mismo recorrido sobre el segmento comprimido");
+    }
+    borrarLog(ruta);
+}
+
+// Búsqueda byte a byte, sin distinguir mayúsculas sólo en A-Z
+static std::size_t buscarReferencia(const std::string &texto, const std::string &patron, std::size_t desde) {
+    auto minuscula = [](char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c; };
+    for (std::size_t i = desde; i + patron.size() <= texto.size(); ++i) {
+        std::size_t j = 0;
+        while (j < patron.size() && minuscula(texto[i + j]) == minuscula(patron[j])) ++j;
+        if (j == patron.size()) return i;
+    }
+    return PatronBusqueda::NO_ENCONTRADO;
+}
+
+// PatronBusqueda (16 bytes por vez con SSE2) da lo mismo que la referencia desde
+// cada posición de partida
+static bool coincideConReferencia(const std::string &texto, const std::string &patron) {
+    PatronBusqueda buscador(patron);
+    for (std::size_t desde = 0; desde <= texto.size(); ++desde) {
+        if (buscador.buscar(texto.data(), texto.size(), desde) != buscarReferencia(texto, patron, desde)) return false;
+    }
+    return true;
+}
+
+static void probarBusquedaSinMayusculas() {
+    std::cout << "\n8. BÚSQUEDA SIN MAYÚSCULAS" << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+    const std::string relleno(48, '.');
+
+    const std::string largo = "desconexion-inesperada-del-robot";
+    comprobar(coincideConReferencia(relleno + "DESCONEXION-inesperada-DEL-robot" + relleno + "desconexion-inesperada-del-robo",
+                                    largo),
+              "patrón de más de 16 bytes");
+
+    bool cruzaBloque = true;
+    for (std::size_t pos = 0; pos < 40; ++pos) {
+        std::string texto = relleno;
+        texto.replace(pos, 5, "ErRoR");
+        cruzaBloque = cruzaBloque && coincideConReferencia(texto, "error")
+                      && PatronBusqueda("error").buscar(texto.data(), texto.size()) == pos;
+    }
+    comprobar(cruzaBloque, "coincidencia en cada posición, también a caballo entre bloques de 16");
+
+    comprobar(coincideConReferencia("abcERROR", "error") &&
+                  PatronBusqueda("error").buscar("abcERROR", 8) == 3,
+              "coincidencia al final de un texto de menos de 16 bytes");
+
+    comprobar(coincideConReferencia(relleno + "@abc[" + relleno, "`abc{") &&
+                  coincideConReferencia(relleno + "`abc{" + relleno, "@ABC[") &&
+                  !PatronBusqueda("`abc{").contenidoEn(relleno + "@abc[" + relleno),
+              "no-letras que difieren en 0x20 ('@' y '`', '[' y '{') no coinciden");
+
+    const std::string utf8 = relleno + "acción ACCIÓN \xC1\x88\xB4 \xE1\x88\xB4" + relleno;
+    comprobar(coincideConReferencia(utf8, "ACCIÓN") && coincideConReferencia(utf8, "acción") &&
+                  coincideConReferencia(utf8, "\xE1\x88\xB4") && coincideConReferencia(utf8, "ión a"),
+              "bytes UTF-8 se comparan tal cual");
+}
+
+// Las celdas de un CSV como texto, fila por fila
+static std::vector<std::vector<std::string>> filasCSV(const std::string &ruta) {
+    std::vector<std::vector<std::string>> filas;
+    GestorArchivos archivo(ruta);
+    TablaColumnas tabla;
+    if (!archivo.getTabla(tabla)) return filas;
+    filas.emplace_back(tabla.encabezados.begin(), tabla.encabezados.end());
+    for (std::size_t f = 0; f < tabla.filas; ++f) {
+        filas.emplace_back();
+        for (std::size_t c = 0; c < tabla.anchos[f]; ++c) filas.back().emplace_back(tabla.columnas[c][f]);
+    }
+    return filas;
+}
+
+// El parseo en trozos paralelos da lo mismo que el secuencial aunque el corte
+// caiga dentro de un campo entre comillas con saltos de línea o "" escapadas
+static void probarTrozosCSV() {
+    std::cout << "\n9. CSV EN TROZOS PARALELOS" << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+    const std::string ruta = "test_reportes_trozos.csv";
+    const std::string registros = "1,\"linea uno\nlinea dos\",10\n"
+                                  "2,\"dice \"\"hola\"\" y \"\"chau\"\"\",20\n"
+                                  "3,\"mezcla \"\"a\"\"\n\"\"b\"\"\n\",30\n"
+                                  "4,simple,40\n"
+                                  "5,\"\",50\n"
+                                  "6,\"fin \"\"exacto\"\"\",60\n";
+    std::ofstream(ruta, std::ios::binary) << "id,texto,valor\n" << registros;
+
+    GestorArchivos::configurarTrozoCSV(1 << 30);
+    const auto secuencial = filasCSV(ruta);
+    comprobar(secuencial.size() == 7 && secuencial[1].size() == 3 && secuencial[3].size() == 3,
+              "el parseo secuencial da 6 registros de 3 campos");
+
+    // Con cada tamaño de trozo los cortes caen en cada byte de los registros:
+    // partiendo un campo con salto de línea o un "", o justo al final de uno
+    bool iguales = true;
+    for (std::size_t trozo = 1; trozo <= registros.size() + 1 && iguales; ++trozo) {
+        GestorArchivos::configurarTrozoCSV(trozo);
+        iguales = filasCSV(ruta) == secuencial;
+        if (!iguales) std::cout << "    difiere con trozos de " << trozo << " bytes" << std::endl;
+    }
+    comprobar(iguales, "cortes en cada byte: igual que el secuencial");
+
+    // Con el tamaño real (1 MB): el primer corte cae en "linea uno", antes del
+    // salto de línea entre comillas del registro 1
+    GestorArchivos::configurarTrozoCSV(0);
+    const std::size_t hasta = (1u << 20) - 5;
+    std::string relleno;
+    while (relleno.size() + 12 + 5 <= hasta) relleno += "0,relleno,0\n";
+    relleno += "0," + std::string(hasta - relleno.size() - 5, 'x') + ",0\n";
+    {
+        std::ofstream csv(ruta, std::ios::binary | std::ios::trunc);
+        csv << "id,texto,valor\n" << relleno << registros << relleno;
+    }
+    const auto paralelo = filasCSV(ruta);
+    GestorArchivos::configurarTrozoCSV(1 << 30);
+    comprobar(paralelo.size() > 7 && paralelo == filasCSV(ruta), "archivo de más de 1 MB: igual que el secuencial");
+    GestorArchivos::configurarTrozoCSV(0);
+    std::remove(ruta.c_str());
+}
 
 int main() {
     std::cout << "=== TEST GESTOR REPORTES ===" << std::endl;
@@ -41,5 +229,11 @@ int main() {
     std::cout << std::string(60, '=') << std::endl;
     std::cout << gestor.reporteAdminPorCodigo("200") << std::endl;
     
-    return 0;
+    probarPaginacionConRotacion();
+    probarBusquedaSinMayusculas();
+    probarTrozosCSV();
+    
+    std::cout << "\n" << (fallos == 0 ? "Todas las comprobaciones pasaron" : std::to_string(fallos) + " comprobaciones fallaron")
+              << std::endl;
+    return fallos == 0 ? 0 : 1;
 }